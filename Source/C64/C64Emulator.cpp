@@ -11,9 +11,11 @@
 
 #include "C64Config.h"
 #include <CodeAnalyser/CodeAnalysisJson.h>
+#include <CodeAnalyser/CodeAnalysisBinary.h>
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include "CodeAnalyser/UI/CharacterMapViewer.h"
 #include <Debug/DebugLog.h>
+#include <chrono>
 
 #include "FileLoaders/CRTFile.h"
 
@@ -214,10 +216,11 @@ void FC64Emulator::SetupCodeAnalysisLabels()
 {
 	// Add IO Labels to code analysis
 	FCodeAnalysisBank* pIOBank = CodeAnalysis.GetBank(BankIds.IOArea);
-	AddVICRegisterLabels(pIOBank->Pages[0]);  // Page $D000-$D3ff
-	AddSIDRegisterLabels(pIOBank->Pages[1]);  // Page $D400-$D7ff
-	pIOBank->Pages[2].SetLabelAtAddress("ColourRAM", ELabelType::Data, 0x0000,true);    // Colour RAM $D800
-	AddCIARegisterLabels(pIOBank->Pages[3]);  // Page $DC00-$Dfff
+	FCodeAnalysisPage* pIOPages = CodeAnalysis.GetBankPagesForWrite(*pIOBank);
+	AddVICRegisterLabels(pIOPages[0]);  // Page $D000-$D3ff
+	AddSIDRegisterLabels(pIOPages[1]);  // Page $D400-$D7ff
+	pIOPages[2].SetLabelAtAddress("ColourRAM", ELabelType::Data, 0x0000,true);    // Colour RAM $D800
+	AddCIARegisterLabels(pIOPages[3]);  // Page $DC00-$Dfff
 
 	// Add Stack??
 }
@@ -280,6 +283,8 @@ void FC64Emulator::UpdateCodeAnalysisPages(uint8_t cpuPort)
 // Note : can be passed nullptr on a reset
 bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 {
+	ProjectWriter.WaitUntilIdle();	// make sure any save in progress has finished before reading files back
+
 	const std::string windowTitle = pProjectConfig != nullptr ? kAppTitle + " - " + pProjectConfig->Name : kAppTitle;
 	SetWindowTitle(windowTitle.c_str());
 
@@ -311,6 +316,7 @@ bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameDat
 		const std::string dataFName = root + "GameData/" + pProjectConfig->Name + ".bin";
 
 		std::string analysisJsonFName = root + "AnalysisJson/" + pProjectConfig->Name + ".json";
+		std::string analysisBinFName = root + "AnalysisBin/" + pProjectConfig->Name + ".abin";
 		std::string graphicsSetsJsonFName = root + "GraphicsSets/" + pProjectConfig->Name + ".json";
 		std::string analysisStateFName = root + "AnalysisState/" + pProjectConfig->Name + ".astate";
 		std::string saveStateFName = root + "SaveStates/" + pProjectConfig->Name + ".state";
@@ -320,6 +326,7 @@ bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameDat
 		if (FileExists((gameRoot + "Config.json").c_str()))
 		{
 			analysisJsonFName = gameRoot + "Analysis.json";
+			analysisBinFName = gameRoot + "Analysis.abin";
 			graphicsSetsJsonFName = gameRoot + "GraphicsSets.json";
 			analysisStateFName = gameRoot + "AnalysisState.bin";
 			saveStateFName = gameRoot + "SaveState.bin";
@@ -334,11 +341,8 @@ bool FC64Emulator::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameDat
 		}
 
 
-		if (FileExists(analysisJsonFName.c_str()))
-		{
-			ImportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+		if (ImportAnalysisBinaryOrJson(CodeAnalysis, analysisBinFName.c_str(), analysisJsonFName.c_str()))
 			ImportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
-		}
 
 		// Set memory banks
 		UpdateCodeAnalysisPages(C64Emu.cpu_port);
@@ -576,6 +580,7 @@ bool FC64Emulator::SaveProject(void)
 	const std::string root = pGlobalConfig->WorkspaceRoot + pCurrentProjectConfig->Name + "/";
 	const std::string configFName = root + "Config.json";
 	const std::string analysisJsonFName = root + "Analysis.json";
+	const std::string analysisBinFName = root + "Analysis.abin";
 	const std::string graphicsSetsJsonFName = root + "GraphicsSets.json";
 	const std::string analysisStateFName = root + "AnalysisState.bin";
 	const std::string saveStateFName = root + "SaveState.bin";
@@ -594,8 +599,16 @@ bool FC64Emulator::SaveProject(void)
 	AddGameConfig(pCurrentProjectConfig);
 	SaveGameConfigToFile(*pCurrentProjectConfig, configFName.c_str());
 
-	SaveMachineState(saveStateFName.c_str());
-	ExportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+	SaveMachineState(saveStateFName.c_str());	// cartridge data is written straight to the file so this stays synchronous
+
+	// snapshot the analysis here, the files get written on the project writer thread
+	const auto snapshotStartTime = std::chrono::high_resolution_clock::now();
+	FFileWriteBatch saveBatch;
+	saveBatch.Name = pCurrentProjectConfig->Name;
+	AddAnalysisToSaveBatch(saveBatch, analysisBinFName, analysisJsonFName);
+	saveBatch.SnapshotTimeMS = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - snapshotStartTime).count();
+	ProjectWriter.QueueBatch(std::move(saveBatch));
+
 	ExportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
 
 	ExportAnalysisJson(CodeAnalysis, kROMAnalysisFilename, true);	// Do this on a config?
@@ -611,6 +624,7 @@ void FC64Emulator::Shutdown()
 		pGlobalConfig->LastGame = pCurrentProjectConfig->Name;
 		SaveProject();
 	}
+	ProjectWriter.WaitUntilIdle();
 
 	pGlobalConfig->Save(kGlobalConfigFilename);
 
@@ -705,27 +719,34 @@ void	FC64Emulator::WindowsMenuAdditions(void)
 }
 
 
-void FC64Emulator::Tick()
+// Run the emulator & code analysis for a frame - no UI
+void FC64Emulator::ExecuteFrame(uint32_t microSeconds)
 {
-	FEmuBase::Tick();
+	CodeAnalysis.OnFrameStart();
+	//StoreRegisters_6502(CodeAnalysis);
 
-	FDebugger& debugger = CodeAnalysis.Debugger;
+	c64_exec(&C64Emu, microSeconds);
 
-	Display.Tick();
+	CodeAnalysis.OnFrameEnd();
 
-	if (debugger.IsStopped() == false)
-	{
-		const float frameTime = (float)std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * 1.0f;// speccyInstance.ExecSpeedScale;
-	
-		CodeAnalysis.OnFrameStart();
-		//StoreRegisters_6502(CodeAnalysis);
+	UpdateFileLoadPhase();
+}
 
-		c64_exec(&C64Emu, (uint32_t)std::max(static_cast<uint32_t>(frameTime), uint32_t(1)));
+void FC64Emulator::SaveRewindState(void* pState)
+{
+	c64_save_snapshot(&C64Emu, (c64_t*)pState);
+}
 
-		CodeAnalysis.OnFrameEnd();
-	}
-	DrawDockingView();
+void FC64Emulator::LoadRewindState(const void* pState)
+{
+	c64_load_snapshot(&C64Emu, C64_SNAPSHOT_VERSION, (c64_t*)pState);
+	UpdateCodeAnalysisPages(C64Emu.cpu_port);
+	LastMemPort = C64Emu.cpu_port & 7;
+}
 
+// Step the file loading state machine - loads the file once BASIC is ready and then runs it
+void FC64Emulator::UpdateFileLoadPhase()
+{
 	switch(FileLoadPhase)
 	{
 		case EFileLoadPhase::BasicReady:
@@ -754,6 +775,27 @@ void FC64Emulator::Tick()
 		default:
 			break;
 	}
+}
+
+void FC64Emulator::Tick()
+{
+	FEmuBase::Tick();
+
+	FDebugger& debugger = CodeAnalysis.Debugger;
+
+	Display.Tick();
+
+	if (debugger.IsStopped() == false)
+	{
+		const float frameTime = (float)std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * 1.0f;// speccyInstance.ExecSpeedScale;
+	
+		ExecuteUIFrame((uint32_t)std::max(static_cast<uint32_t>(frameTime), uint32_t(1)));
+	}
+	else
+	{
+		UpdateFileLoadPhase();	// file loading carries on while the debugger is stopped
+	}
+	DrawDockingView();
 
 #if 0
 	gfx_draw(c64_display_width(&c64), c64_display_height(&c64));
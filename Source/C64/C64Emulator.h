@@ -101,8 +101,14 @@ public:
 	void    Shutdown() override;
 	void	DrawEmulatorUI() override;
 	void    Tick() override;
+	void    ExecuteFrame(uint32_t microSeconds) override;
+	uint32_t	GetMachineFrameMicroSeconds() const override { return 19950; }	// PAL - 312 lines of 63 cycles @ 985248Hz
 	void    Reset() override;
+	size_t	GetRewindStateSize() const override { return sizeof(c64_t); }
+	void	SaveRewindState(void* pState) override;
+	void	LoadRewindState(const void* pState) override;
 	void	FixupAddressRefs();
+	void	UpdateFileLoadPhase();
 
 	void	FileMenuAdditions(void) override;
 	void	SystemMenuAdditions(void) override;
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <chrono>
 
 #define SAVE_NEW_DIRS 1
 
@@ -17,6 +18,8 @@
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include <CodeAnalyser/AssemblerExport.h>
 #include "CodeAnalyser/CodeAnalysisJson.h"
+#include "CodeAnalyser/CodeAnalysisBinary.h"
+#include "Util/MemoryBuffer.h"
 #include "CPCGameConfig.h"
 #include "Debug/DebugLog.h"
 #include "CPCChipsImpl.h"
@@ -1129,6 +1132,7 @@ void FCPCEmu::Shutdown()
 	FEmuBase::Shutdown();
 
 	SaveProject();	// save on close
+	ProjectWriter.WaitUntilIdle();
 
 	// Save Global Config - move to function?
 
@@ -1150,6 +1154,8 @@ bool FCPCEmu::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 {
 	FCPCProjectConfig* pCPCProjectConfig = (FCPCProjectConfig*)pProjectConfig;
 
+	ProjectWriter.WaitUntilIdle();	// make sure any save in progress has finished before reading files back
+
 #ifndef NDEBUG
 	LOGINFO("Start game '%s'", pProjectConfig->Name.c_str());
 #endif
@@ -1198,6 +1204,7 @@ bool FCPCEmu::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 		const std::string root = pGlobalConfig->WorkspaceRoot;
 
 		std::string analysisJsonFName = root + "AnalysisJson/" + pProjectConfig->Name + ".json";
+		std::string analysisBinFName = root + "AnalysisBin/" + pProjectConfig->Name + ".abin";
 		std::string graphicsSetsJsonFName = root + "GraphicsSets/" + pProjectConfig->Name + ".json";
 		std::string analysisStateFName = root + "AnalysisState/" + pProjectConfig->Name + ".astate";
 		std::string saveStateFName = root + "SaveStates/" + pProjectConfig->Name + ".state";
@@ -1207,6 +1214,7 @@ bool FCPCEmu::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 		if (FileExists((gameRoot + "Config.json").c_str()))
 		{
 			analysisJsonFName = gameRoot + "Analysis.json";
+			analysisBinFName = gameRoot + "Analysis.abin";
 			graphicsSetsJsonFName = gameRoot + "GraphicsSets.json";
 			analysisStateFName = gameRoot + "AnalysisState.bin";
 			saveStateFName = gameRoot + "SaveState.bin";
@@ -1229,11 +1237,8 @@ bool FCPCEmu::LoadProject(FProjectConfig* pProjectConfig, bool bLoadGameData)
 			return false;
 		}
 		
-		if (FileExists(analysisJsonFName.c_str()))
-		{
-			ImportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+		if (ImportAnalysisBinaryOrJson(CodeAnalysis, analysisBinFName.c_str(), analysisJsonFName.c_str()))
 			ImportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
-		}
 
 		pGraphicsViewer->LoadGraphicsSets(graphicsSetsJsonFName.c_str());
 
@@ -1326,35 +1331,28 @@ const uint32_t kMachineStateMagic = 0xBeefCafe;
 const uint32_t kMachineStateVersion = 0;
 static cpc_t g_SaveSlot;
 
-bool FCPCEmu::SaveGameState(const char* fname)
+// machine state is written to a buffer so the file can be written out on another thread
+void FCPCEmu::SaveGameState(FMemoryBuffer& buffer)
 {
-	// save game snapshot
-	FILE* fp = fopen(fname, "wb");
-	if (fp != nullptr)
-	{
-		// write magic
-		fwrite(&kMachineStateMagic, sizeof(kMachineStateMagic), 1, fp);
-		fwrite(&kMachineStateVersion, sizeof(kMachineStateVersion), 1, fp);
+	buffer.Init(sizeof(cpc_t) + 64);
 
-		// save backup state in edit mode
-		if (GetCodeAnalysis().bAllowEditing)
-		{
-			const uint32_t snapshotVersion = CPC_SNAPSHOT_VERSION;
-			fwrite(&snapshotVersion, sizeof(snapshotVersion), 1, fp);
-			fwrite(&BackupState, sizeof(cpc_t), 1, fp);
-		}
-		else
-		{
-			const uint32_t snapshotVersionNo = cpc_save_snapshot(&CPCEmuState, &g_SaveSlot);
-			fwrite(&snapshotVersionNo, sizeof(snapshotVersionNo), 1, fp);
-			fwrite(&g_SaveSlot, sizeof(cpc_t), 1, fp);
-		}
+	// write magic
+	buffer.Write(kMachineStateMagic);
+	buffer.Write(kMachineStateVersion);
 
-		fclose(fp);
-		return true;
+	// save backup state in edit mode
+	if (GetCodeAnalysis().bAllowEditing)
+	{
+		const uint32_t snapshotVersion = CPC_SNAPSHOT_VERSION;
+		buffer.Write(snapshotVersion);
+		buffer.WriteBytes(&BackupState, sizeof(cpc_t));
+	}
+	else
+	{
+		const uint32_t snapshotVersionNo = cpc_save_snapshot(&CPCEmuState, &g_SaveSlot);
+		buffer.Write(snapshotVersionNo);
+		buffer.WriteBytes(&g_SaveSlot, sizeof(cpc_t));
 	}
-
-	return false;
 }
 
 bool FCPCEmu::LoadGameState(const char* fname)
@@ -1400,6 +1398,7 @@ bool FCPCEmu::SaveProject(void)
 		const std::string root = pGlobalConfig->WorkspaceRoot + pProjectConfig->Name + "/";
 		const std::string configFName = root + "Config.json";
 		const std::string analysisJsonFName = root + "Analysis.json";
+		const std::string analysisBinFName = root + "Analysis.abin";
 		const std::string graphicsSetsJsonFName = root + "GraphicsSets.json";
 		const std::string analysisStateFName = root + "AnalysisState.bin";
 		const std::string saveStateFName = root + "SaveState.bin";
@@ -1410,12 +1409,14 @@ bool FCPCEmu::SaveProject(void)
 		const std::string configFName = root + "Configs/" + pGameConfig->Name + ".json";
 		//const std::string dataFName = root + "GameData/" + pGameConfig->Name + ".bin";
 		const std::string analysisJsonFName = root + "AnalysisJson/" + pGameConfig->Name + ".json";
+		const std::string analysisBinFName = root + "AnalysisBin/" + pGameConfig->Name + ".abin";
 		const std::string graphicsSetsJsonFName = root + "GraphicsSets/" + pGameConfig->Name + ".json";
 		const std::string analysisStateFName = root + "AnalysisState/" + pGameConfig->Name + ".astate";
 		const std::string saveStateFName = root + "SaveStates/" + pGameConfig->Name + ".state";
 		EnsureDirectoryExists(std::string(root + "Configs").c_str());
 		EnsureDirectoryExists(std::string(root + "GameData").c_str());
 		EnsureDirectoryExists(std::string(root + "AnalysisJson").c_str());
+		EnsureDirectoryExists(std::string(root + "AnalysisBin").c_str());
 		EnsureDirectoryExists(std::string(root + "GraphicsSets").c_str());
 		EnsureDirectoryExists(std::string(root + "AnalysisState").c_str());
 		EnsureDirectoryExists(std::string(root + "SaveStates").c_str());
@@ -1432,8 +1433,18 @@ bool FCPCEmu::SaveProject(void)
 		}
 
 		SaveGameConfigToFile(*pProjectConfig, configFName.c_str());
-		SaveGameState(saveStateFName.c_str());
-		ExportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+
+		// snapshot the machine state & analysis here, the files get written on the project writer thread
+		const auto snapshotStartTime = std::chrono::high_resolution_clock::now();
+		FFileWriteBatch saveBatch;
+		saveBatch.Name = pProjectConfig->Name;
+		std::shared_ptr<FMemoryBuffer> pSaveState = std::make_shared<FMemoryBuffer>();
+		SaveGameState(*pSaveState);
+		saveBatch.AddFile(saveStateFName, pSaveState);
+		AddAnalysisToSaveBatch(saveBatch, analysisBinFName, analysisJsonFName);
+		saveBatch.SnapshotTimeMS = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - snapshotStartTime).count();
+		ProjectWriter.QueueBatch(std::move(saveBatch));
+
 		ExportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
 		//ExportGameJson(this, analysisJsonFName.c_str());
 		pGraphicsViewer->SaveGraphicsSets(graphicsSetsJsonFName.c_str());
@@ -1512,6 +1523,21 @@ void FCPCEmu::Reset()
 	CodeAnalysis.Debugger.Continue();
 }
 
+// Run the emulator & code analysis for a frame - no UI
+void FCPCEmu::ExecuteFrame(uint32_t microSeconds)
+{
+	CodeAnalysis.OnFrameStart();
+	
+	StoreRegisters_Z80(CodeAnalysis);
+
+	cpc_exec(&CPCEmuState, microSeconds);
+	
+	// sam todo
+	//FrameTraceViewer.CaptureFrame();
+
+	CodeAnalysis.OnFrameEnd();
+}
+
 void FCPCEmu::Tick()
 {
 	FEmuBase::Tick();
@@ -1525,16 +1551,7 @@ void FCPCEmu::Tick()
 		const float frameTime = std::min(1000000.0f / ImGui::GetIO().Framerate, 32000.0f) * ExecSpeedScale;
 		const uint32_t microSeconds = std::max(static_cast<uint32_t>(frameTime), uint32_t(1));
 
-		CodeAnalysis.OnFrameStart();
-		
-		StoreRegisters_Z80(CodeAnalysis);
-
-		cpc_exec(&CPCEmuState, microSeconds);
-		
-		// sam todo
-		//FrameTraceViewer.CaptureFrame();
-
-		CodeAnalysis.OnFrameEnd();
+		ExecuteUIFrame(microSeconds);
 	}
 	
 	UpdateCharacterSets(CodeAnalysis);
@@ -1554,6 +1571,17 @@ void FCPCEmu::OnExitEditMode(void)
 	cpc_load_snapshot(&CPCEmuState, CPC_SNAPSHOT_VERSION, &BackupState);
 }
 
+void FCPCEmu::SaveRewindState(void* pState)
+{
+	cpc_save_snapshot(&CPCEmuState, (cpc_t*)pState);
+}
+
+void FCPCEmu::LoadRewindState(const void* pState)
+{
+	cpc_load_snapshot(&CPCEmuState, CPC_SNAPSHOT_VERSION, (cpc_t*)pState);
+	UpdateBankMappings();
+}
+
 // These functions are used to add to the bottom of the menus
 void	FCPCEmu::FileMenuAdditions(void)
 {
@@ -59,6 +59,7 @@ struct FProjectConfig;
 struct FViewerConfig;
 class FViewerBase;
 class FScreenPixMemDescGenerator;
+class FMemoryBuffer;
 struct FCPCConfig;
 struct FCPCProjectConfig;
 
@@ -110,13 +111,18 @@ public:
 	bool				SaveProject() override;
 	void				Reset() override;
 	void				Tick() override;
+	void				ExecuteFrame(uint32_t microSeconds) override;
+	uint32_t			GetMachineFrameMicroSeconds() const override { return 19968; }	// 312 lines of 64us
 	bool				LoadLua() override;
 	void				DrawEmulatorUI(void) override;
 	void				OnEnterEditMode(void) override;
 	void				OnExitEditMode(void) override;
+	size_t				GetRewindStateSize() const override { return sizeof(cpc_t); }
+	void				SaveRewindState(void* pState) override;
+	void				LoadRewindState(const void* pState) override;
 	// ~FEmuBase End
 
-	bool				SaveGameState(const char* fname);
+	void				SaveGameState(FMemoryBuffer& buffer);
 	bool				LoadGameState(const char* fname);
 
 	void				OnInstructionExecuted(int ticks, uint64_t pins);
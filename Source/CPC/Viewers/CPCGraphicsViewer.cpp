@@ -241,7 +241,7 @@ void FCPCGraphicsViewer::UpdateScreenPixelImage(void)
 				if ((p & 0x3) == 0)
 				{
 					screenByte = pBank->Memory[curBnkOffset];
-					const FCodeAnalysisPage& page = pBank->Pages[curBnkOffset >> FCodeAnalysisPage::kPageShift];
+					const FCodeAnalysisPage& page = state.GetBankPage(*pBank, curBnkOffset >> FCodeAnalysisPage::kPageShift);
 					heatMapCol = GetHeatmapColourForMemoryAddress(page, curBnkOffset, state.CurrentFrameNo, HeatmapThreshold);
 
 					curBnkOffset++;
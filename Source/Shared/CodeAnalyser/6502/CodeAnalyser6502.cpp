@@ -308,3 +308,11 @@ bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t o
 	return false;
 }
 
+// Work out which instructions RegisterCodeExecuted6502 needs to see - keep in sync with the switch above
+void ClassifyExecutedInstruction6502(const FCodeAnalysisState& state, uint16_t pc, FDecodedInstruction& decoded)
+{
+	const uint8_t opcode = state.ReadByte(pc);
+
+	decoded.bCheckWhenExecuted = opcode == 0x20 || opcode == 0x40 || opcode == 0x60;	// JSR, RTI, RTS
+	decoded.bCheckWhenPrevious = false;
+}
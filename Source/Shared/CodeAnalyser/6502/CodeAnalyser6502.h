@@ -9,4 +9,5 @@ bool CheckPointerRefInstruction6502(const FCodeAnalysisState& state, uint16_t pc
 bool CheckJumpInstruction6502(const FCodeAnalysisState& state, uint16_t pc, uint16_t* out_addr);
 bool CheckCallInstruction6502(const FCodeAnalysisState& state, uint16_t pc);
 bool CheckStopInstruction6502(const FCodeAnalysisState& state, uint16_t pc);
-bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t oldpc);
\ No newline at end of file
+bool RegisterCodeExecuted6502(FCodeAnalysisState& state, uint16_t pc, uint16_t oldpc);
+void ClassifyExecutedInstruction6502(const FCodeAnalysisState& state, uint16_t pc, struct FDecodedInstruction& decoded);
\ No newline at end of file
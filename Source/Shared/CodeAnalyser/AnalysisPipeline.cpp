@@ -0,0 +1,89 @@
+#include "AnalysisPipeline.h"
+#include "CodeAnalysisPage.h"
+
+#include <chrono>
+
+void FAnalysisPipeline::Start()
+{
+	if (bRunning)
+		return;
+
+	bStopWorker = false;
+	Worker = std::thread(&FAnalysisPipeline::WorkerThread, this);
+	bRunning = true;
+}
+
+void FAnalysisPipeline::Stop()
+{
+	if (bRunning == false)
+		return;
+
+	WaitUntilIdle();
+	bStopWorker = true;
+	Worker.join();
+	bRunning = false;
+}
+
+void FAnalysisPipeline::PushDataAccess(const FDataAccessEvent& event)
+{
+	// if the worker has fallen behind we have to wait for it
+	while (Queue.Push(event) == false)
+		std::this_thread::yield();
+	NoPushed++;
+}
+
+void FAnalysisPipeline::WaitUntilIdle()
+{
+	while (NoProcessed.load(std::memory_order_acquire) != NoPushed)
+		std::this_thread::yield();
+}
+
+void FAnalysisPipeline::WorkerThread()
+{
+	int noIdlePolls = 0;
+	FDataAccessEvent event;
+
+	while (bStopWorker == false)
+	{
+		if (Queue.Pop(event))
+		{
+			ApplyDataAccess(event);
+			NoProcessed.fetch_add(1, std::memory_order_release);
+			noIdlePolls = 0;
+		}
+		else if (++noIdlePolls < 1000)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			// emulator is probably paused so don't burn a core
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void FAnalysisPipeline::ApplyDataAccess(const FDataAccessEvent& event)
+{
+	FCodeAnalysisPage* pPage = event.pPage;
+	FDataInfo* pDataInfo = &pPage->DataInfo[event.PageAddress];
+
+	if (event.bWrite)
+	{
+		pPage->WriteCount[event.PageAddress]++;
+		pPage->LastFrameWritten[event.PageAddress] = event.FrameNo;
+		pDataInfo->EditWrites().RegisterAccess(event.PC);
+
+		if (event.pCodeInfo)
+			event.pCodeInfo->Writes.RegisterAccess(event.DataAddress);
+	}
+	else
+	{
+		pPage->ReadCount[event.PageAddress]++;
+		pPage->LastFrameRead[event.PageAddress] = event.FrameNo;
+		pDataInfo->EditReads().RegisterAccess(event.PC);
+
+		if (event.pCodeInfo)
+			event.pCodeInfo->Reads.RegisterAccess(event.DataAddress);
+	}
+}
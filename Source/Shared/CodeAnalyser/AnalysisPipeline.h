@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "CodeAnalyserTypes.h"
+#include "Util/SPSCQueue.h"
+
+struct FCodeAnalysisPage;
+struct FCodeInfo;
+
+// Data access with its pages & items already resolved by the emulation thread
+struct FDataAccessEvent
+{
+	FCodeAnalysisPage*	pPage = nullptr;
+	FCodeInfo*			pCodeInfo = nullptr;	// code info for the instruction doing the access
+	FAddressRef			PC;
+	FAddressRef			DataAddress;
+	uint16_t			PageAddress = 0;
+	bool				bWrite = false;
+	int					FrameNo = 0;
+};
+
+// Applies data accesses to the analysis pages on a worker thread
+// The emulation thread does the lookups & SMC checks then pushes events, the worker does the counting & reference tracking
+// Anything that reads the access info must call WaitUntilIdle first - this is done in FCodeAnalysisState::OnFrameEnd
+class FAnalysisPipeline
+{
+public:
+	~FAnalysisPipeline() { Stop(); }
+
+	void	Start();
+	void	Stop();
+	bool	IsRunning() const { return bRunning; }
+
+	void	PushDataAccess(const FDataAccessEvent& event);
+	void	WaitUntilIdle();
+
+	uint64_t	GetNoEventsProcessed() const { return NoProcessed; }
+
+private:
+	void	WorkerThread();
+	static void	ApplyDataAccess(const FDataAccessEvent& event);
+
+	FSPSCQueue<FDataAccessEvent>	Queue;
+	std::thread				Worker;
+	std::atomic<bool>		bStopWorker = false;
+	bool					bRunning = false;
+	uint64_t				NoPushed = 0;	// emulation thread only
+	std::atomic<uint64_t>	NoProcessed = 0;
+};
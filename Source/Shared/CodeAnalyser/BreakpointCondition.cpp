@@ -0,0 +1,407 @@
+#include "BreakpointCondition.h"
+
+#include <cctype>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Expression syntax - C operators & precedence
+//	Numbers:	decimal, $hex, #hex or 0xhex
+//	Registers:	any register the debugger knows about e.g. A, HL, IX, X, Y, plus PC
+//	Memory:		[expr] reads a byte, (HL) or ($5B00) also read a byte like Z80 assembler
+//				only word registers & hex numbers in brackets are reads, (100) is just 100
+//	hits:		times the breakpoint has been hit, including this one
+//	frame:		current frame number
+//	Operators:	|| && | ^ & == != < <= > >= << >> + - * / % and unary ! - ~
+
+enum class EConditionOp : uint8_t
+{
+	PushConst,		// followed by 4 byte value
+	PushRegister,	// followed by 1 byte register id
+	PushHitCount,
+	PushFrameNo,
+	ReadMemory,
+
+	Negate,
+	LogicalNot,
+	BitwiseNot,
+
+	Multiply,
+	Divide,
+	Modulo,
+	Add,
+	Subtract,
+	ShiftLeft,
+	ShiftRight,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+	Equal,
+	NotEqual,
+	BitwiseAnd,
+	BitwiseXor,
+	BitwiseOr,
+	LogicalAnd,
+	LogicalOr,
+};
+
+struct FConditionBinaryOp
+{
+	const char*		Token;
+	EConditionOp	Op;
+	int				Precedence;	// higher binds tighter
+};
+
+// two character tokens come first so they match before their one character prefixes
+static const FConditionBinaryOp g_ConditionBinaryOps[] =
+{
+	{ "||", EConditionOp::LogicalOr, 1 },
+	{ "&&", EConditionOp::LogicalAnd, 2 },
+	{ "==", EConditionOp::Equal, 6 },
+	{ "!=", EConditionOp::NotEqual, 6 },
+	{ "<=", EConditionOp::LessEqual, 7 },
+	{ ">=", EConditionOp::GreaterEqual, 7 },
+	{ "<<", EConditionOp::ShiftLeft, 8 },
+	{ ">>", EConditionOp::ShiftRight, 8 },
+	{ "|", EConditionOp::BitwiseOr, 3 },
+	{ "^", EConditionOp::BitwiseXor, 4 },
+	{ "&", EConditionOp::BitwiseAnd, 5 },
+	{ "<", EConditionOp::Less, 7 },
+	{ ">", EConditionOp::Greater, 7 },
+	{ "+", EConditionOp::Add, 9 },
+	{ "-", EConditionOp::Subtract, 9 },
+	{ "*", EConditionOp::Multiply, 10 },
+	{ "/", EConditionOp::Divide, 10 },
+	{ "%", EConditionOp::Modulo, 10 },
+};
+
+// Recursive descent parser emitting the bytecode as it goes
+class FConditionCompiler
+{
+public:
+	FConditionCompiler(const char* pExpression, const IBreakpointConditionContext& context, std::vector<uint8_t>& code)
+		: pCur(pExpression), Context(context), Code(code) {}
+
+	bool Compile(std::string& outError)
+	{
+		bool bSuccess = ParseExpression(0);
+		SkipWhitespace();
+		if (bSuccess && *pCur != 0)
+			bSuccess = SetError("Unexpected '%c'", *pCur);
+
+		outError = Error;
+		return bSuccess;
+	}
+
+private:
+	bool ParseExpression(int minPrecedence)
+	{
+		if (ParseUnary() == false)
+			return false;
+
+		while (true)
+		{
+			SkipWhitespace();
+			const FConditionBinaryOp* pOp = MatchBinaryOp();
+			if (pOp == nullptr || pOp->Precedence < minPrecedence)
+				return true;
+
+			pCur += strlen(pOp->Token);
+			if (ParseExpression(pOp->Precedence + 1) == false)
+				return false;
+
+			Emit(pOp->Op, -1);
+		}
+	}
+
+	bool ParseUnary()
+	{
+		SkipWhitespace();
+		EConditionOp op;
+		if (*pCur == '!')
+			op = EConditionOp::LogicalNot;
+		else if (*pCur == '-')
+			op = EConditionOp::Negate;
+		else if (*pCur == '~')
+			op = EConditionOp::BitwiseNot;
+		else
+			return ParsePrimary();
+
+		pCur++;
+		if (ParseUnary() == false)
+			return false;
+		Emit(op, 0);
+		return true;
+	}
+
+	bool ParsePrimary()
+	{
+		SkipWhitespace();
+		const size_t operandStart = Code.size();
+
+		if (*pCur == '(' || *pCur == '[')
+		{
+			const char closeChar = *pCur == '(' ? ')' : ']';
+			pCur++;
+			if (ParseExpression(0) == false)
+				return false;
+			SkipWhitespace();
+			if (*pCur != closeChar)
+				return SetError("Expected '%c'", closeChar);
+			pCur++;
+
+			// (HL) & ($4000) are memory reads, any other brackets are just grouping
+			const bool bAddressInBrackets = AddressOperandStart == operandStart && AddressOperandEnd == Code.size();
+			if (closeChar == ']' || bAddressInBrackets)
+				Emit(EConditionOp::ReadMemory, 0);
+			return true;
+		}
+
+		if (isdigit(*pCur) || *pCur == '$' || *pCur == '#')
+		{
+			const bool bHex = *pCur == '$' || *pCur == '#' || (pCur[0] == '0' && (pCur[1] == 'x' || pCur[1] == 'X'));
+			int32_t value = 0;
+			if (ParseNumber(value) == false)
+				return false;
+			Emit(EConditionOp::PushConst, 1);
+			EmitBytes(&value, sizeof(value));
+			if (bHex)	// decimal numbers are counts rather than addresses
+				SetAddressOperand(operandStart);
+			return true;
+		}
+
+		if (isalpha(*pCur) || *pCur == '_')
+		{
+			char name[16];
+			int nameLen = 0;
+			while (isalnum(*pCur) || *pCur == '_')
+			{
+				if (nameLen == sizeof(name) - 1)
+					return SetError("Name too long");
+				name[nameLen++] = (char)toupper(*pCur++);
+			}
+			name[nameLen] = 0;
+
+			uint8_t regId = 0;
+			bool bWord = false;
+			if (strcmp(name, "HITS") == 0)
+			{
+				Emit(EConditionOp::PushHitCount, 1);
+			}
+			else if (strcmp(name, "FRAME") == 0)
+			{
+				Emit(EConditionOp::PushFrameNo, 1);
+			}
+			else if (Context.GetConditionRegisterId(name, regId, bWord))
+			{
+				Emit(EConditionOp::PushRegister, 1);
+				EmitBytes(&regId, sizeof(regId));
+				if (bWord)
+					SetAddressOperand(operandStart);
+			}
+			else
+			{
+				return SetError("Unknown register '%s'", name);
+			}
+			return true;
+		}
+
+		if (*pCur == 0)
+			return SetError("Unexpected end of expression");
+		return SetError("Unexpected '%c'", *pCur);
+	}
+
+	bool ParseNumber(int32_t& outValue)
+	{
+		int base = 10;
+		if (*pCur == '$' || *pCur == '#')
+		{
+			base = 16;
+			pCur++;
+		}
+		else if (pCur[0] == '0' && (pCur[1] == 'x' || pCur[1] == 'X'))
+		{
+			base = 16;
+			pCur += 2;
+		}
+
+		if (isxdigit(*pCur) == false || (base == 10 && isdigit(*pCur) == false))
+			return SetError("Invalid number");
+
+		int64_t value = 0;
+		while (isalnum(*pCur))
+		{
+			const int digit = isdigit(*pCur) ? *pCur - '0' : toupper(*pCur) - 'A' + 10;
+			if (digit >= base)
+				return SetError("Invalid number");
+			value = value * base + digit;
+			if (value > INT32_MAX)
+				return SetError("Number too large");
+			pCur++;
+		}
+		outValue = (int32_t)value;
+		return true;
+	}
+
+	const FConditionBinaryOp* MatchBinaryOp() const
+	{
+		for (const FConditionBinaryOp& op : g_ConditionBinaryOps)
+		{
+			if (strncmp(pCur, op.Token, strlen(op.Token)) == 0)
+				return &op;
+		}
+		return nullptr;
+	}
+
+	// operand that becomes a memory read when it's on its own in brackets
+	void SetAddressOperand(size_t start)
+	{
+		AddressOperandStart = start;
+		AddressOperandEnd = Code.size();
+	}
+
+	void Emit(EConditionOp op, int stackChange)
+	{
+		Code.push_back((uint8_t)op);
+		StackDepth += stackChange;
+		if (StackDepth > MaxStackDepth)
+			MaxStackDepth = StackDepth;
+	}
+
+	void EmitBytes(const void* pData, size_t size)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		Code.insert(Code.end(), pBytes, pBytes + size);
+	}
+
+	void SkipWhitespace()
+	{
+		while (isspace(*pCur))
+			pCur++;
+	}
+
+	bool SetError(const char* pFormat, ...)
+	{
+		char errorText[64];
+		va_list args;
+		va_start(args, pFormat);
+		vsnprintf(errorText, sizeof(errorText), pFormat, args);
+		va_end(args);
+		Error = errorText;
+		return false;
+	}
+
+public:
+	int		MaxStackDepth = 0;
+
+private:
+	const char*							pCur;
+	const IBreakpointConditionContext&	Context;
+	std::vector<uint8_t>&				Code;
+	std::string							Error;
+	int									StackDepth = 0;
+	size_t								AddressOperandStart = SIZE_MAX;
+	size_t								AddressOperandEnd = SIZE_MAX;
+};
+
+bool FBreakpointCondition::Compile(const char* pExpression, const IBreakpointConditionContext& context, std::string& outError)
+{
+	Code.clear();
+	outError.clear();
+
+	const char* pText = pExpression;
+	while (isspace(*pText))
+		pText++;
+	if (*pText == 0)	// no condition
+		return true;
+
+	FConditionCompiler compiler(pText, context, Code);
+	bool bSuccess = compiler.Compile(outError);
+	if (bSuccess && compiler.MaxStackDepth > kMaxStackDepth)
+	{
+		outError = "Expression too complex";
+		bSuccess = false;
+	}
+
+	if (bSuccess == false)
+		Code.clear();
+	return bSuccess;
+}
+
+bool FBreakpointCondition::Evaluate(const IBreakpointConditionContext& context, int hitCount) const
+{
+	if (Code.empty())
+		return true;
+
+	int32_t stack[kMaxStackDepth];
+	int sp = 0;
+	const uint8_t* pCode = Code.data();
+	const uint8_t* pCodeEnd = pCode + Code.size();
+
+	while (pCode < pCodeEnd)
+	{
+		const EConditionOp op = (EConditionOp)*pCode++;
+		switch (op)
+		{
+		case EConditionOp::PushConst:
+			memcpy(&stack[sp++], pCode, sizeof(int32_t));
+			pCode += sizeof(int32_t);
+			break;
+		case EConditionOp::PushRegister:
+			stack[sp++] = context.GetConditionRegisterValue(*pCode++);
+			break;
+		case EConditionOp::PushHitCount:
+			stack[sp++] = hitCount;
+			break;
+		case EConditionOp::PushFrameNo:
+			stack[sp++] = context.GetConditionFrameNo();
+			break;
+		case EConditionOp::ReadMemory:
+			stack[sp - 1] = context.GetConditionMemoryValue((uint16_t)stack[sp - 1]);
+			break;
+
+		case EConditionOp::Negate:
+			stack[sp - 1] = (int32_t)(0u - (uint32_t)stack[sp - 1]);
+			break;
+		case EConditionOp::LogicalNot:
+			stack[sp - 1] = !stack[sp - 1];
+			break;
+		case EConditionOp::BitwiseNot:
+			stack[sp - 1] = ~stack[sp - 1];
+			break;
+
+		default:	// binary operators
+		{
+			const int32_t rhs = stack[--sp];
+			int32_t& lhs = stack[sp - 1];
+			switch (op)
+			{
+			case EConditionOp::Multiply:		lhs = (int32_t)((uint32_t)lhs * (uint32_t)rhs); break;
+			case EConditionOp::Divide:			lhs = rhs == 0 ? 0 : (rhs == -1 ? (int32_t)(0u - (uint32_t)lhs) : lhs / rhs); break;
+			case EConditionOp::Modulo:			lhs = rhs == 0 || rhs == -1 ? 0 : lhs % rhs; break;
+			case EConditionOp::Add:				lhs = (int32_t)((uint32_t)lhs + (uint32_t)rhs); break;
+			case EConditionOp::Subtract:		lhs = (int32_t)((uint32_t)lhs - (uint32_t)rhs); break;
+			case EConditionOp::ShiftLeft:		lhs = (int32_t)((uint32_t)lhs << (rhs & 31)); break;
+			case EConditionOp::ShiftRight:		lhs = lhs >> (rhs & 31); break;
+			case EConditionOp::Less:			lhs = lhs < rhs; break;
+			case EConditionOp::LessEqual:		lhs = lhs <= rhs; break;
+			case EConditionOp::Greater:			lhs = lhs > rhs; break;
+			case EConditionOp::GreaterEqual:	lhs = lhs >= rhs; break;
+			case EConditionOp::Equal:			lhs = lhs == rhs; break;
+			case EConditionOp::NotEqual:		lhs = lhs != rhs; break;
+			case EConditionOp::BitwiseAnd:		lhs = lhs & rhs; break;
+			case EConditionOp::BitwiseXor:		lhs = lhs ^ rhs; break;
+			case EConditionOp::BitwiseOr:		lhs = lhs | rhs; break;
+			case EConditionOp::LogicalAnd:		lhs = lhs && rhs; break;
+			case EConditionOp::LogicalOr:		lhs = lhs || rhs; break;
+			default: break;
+			}
+		}
+		break;
+		}
+	}
+
+	return stack[0] != 0;
+}
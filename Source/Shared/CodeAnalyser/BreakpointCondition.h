@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Machine state a breakpoint condition can read, implemented by the debugger
+class IBreakpointConditionContext
+{
+public:
+	virtual ~IBreakpointConditionContext() = default;
+
+	// called when compiling so the register name lookup is only done once
+	virtual bool		GetConditionRegisterId(const char* pRegName, uint8_t& outId, bool& bOutWord) const = 0;
+
+	virtual uint16_t	GetConditionRegisterValue(uint8_t regId) const = 0;
+	virtual uint8_t		GetConditionMemoryValue(uint16_t address) const = 0;
+	virtual int			GetConditionFrameNo() const = 0;
+};
+
+// A breakpoint condition such as "A == 3 && (HL) > $80" or "hits > 100"
+// Compiled once to a small stack based bytecode so evaluating it on every hit doesn't parse or allocate
+// See BreakpointCondition.cpp for the expression syntax
+class FBreakpointCondition
+{
+public:
+	bool	Compile(const char* pExpression, const IBreakpointConditionContext& context, std::string& outError);
+	void	Clear() { Code.clear(); }
+	bool	IsEmpty() const { return Code.empty(); }
+
+	// an empty condition always passes
+	bool	Evaluate(const IBreakpointConditionContext& context, int hitCount) const;
+
+	static const int kMaxStackDepth = 16;
+private:
+	std::vector<uint8_t>	Code;
+};
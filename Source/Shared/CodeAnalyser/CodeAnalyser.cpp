@@ -1,7 +1,9 @@
 #include "CodeAnalyser.h"
+#include "MemorySearch.h"
 
 #include <cstdint>
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <stdio.h>
 #include <string.h>
@@ -10,6 +12,7 @@
 
 #include "Util/Misc.h"
 #include "Util/GraphicsView.h"
+#include "Util/ThreadPool.h"
 #include "UI/ImageViewer.h"
 
 #include "Z80/CodeAnalyserZ80.h"
@@ -34,27 +37,78 @@ int16_t	FCodeAnalysisState::CreateBank(const char* bankName, int noKb,uint8_t* p
 	const int16_t bankId = GetNextBankId();
 	assert(bankId == (int16_t)Banks.size());
 	const int noPages = noKb;
+	assert(noPages <= kNoPagesInAddressSpace);	// DirtyPageMask needs a bit per page
 
 	FCodeAnalysisBank& newBank = Banks.emplace_back();
 	newBank.Id = bankId;
 	newBank.NoPages = noPages;
 	newBank.SizeMask = (noPages * FCodeAnalysisPage::kPageSize) - 1;
 	newBank.Memory = pBankMem;
-	newBank.Pages = new FCodeAnalysisPage[noPages];
 	newBank.Name = bankName;
 	newBank.bMachineROM = bMachineROM;
 	newBank.bFixed = bFixed;
 	newBank.PrimaryMappedPage = initialAddress / 1024;	// byte addres to 1kb page address
+
+	// pages get allocated on first use but their ids are fixed now so they are stable in save files
 	for (int pageNo = 0; pageNo < noPages; pageNo++)
 	{
-		newBank.Pages[pageNo].Initialise();
 		char pageName[32];
 		snprintf(pageName,32, "%s:%d", bankName, pageNo);
-		RegisterPage(&newBank.Pages[pageNo], pageName);
+		const int16_t pageId = ReservePageId(pageName);
+		if (pageNo == 0)
+			newBank.FirstPageId = pageId;
 	}
 	return bankId;
 }
 
+void FCodeAnalysisState::AllocateBankPages(FCodeAnalysisBank& bank)
+{
+	if (bank.Pages != nullptr)
+		return;
+
+	bank.Pages = new FCodeAnalysisPage[bank.NoPages];
+	for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
+	{
+		FCodeAnalysisPage& page = bank.Pages[pageNo];
+		page.Initialise();
+		page.PageId = bank.FirstPageId + pageNo;
+		RegisteredPages[page.PageId] = &page;
+	}
+
+	// make sure the item list gets built
+	bank.bIsDirty = true;
+	bCodeAnalysisDataDirty = true;
+}
+
+const FCodeAnalysisPage& FCodeAnalysisState::GetEmptyPage()
+{
+	static const FCodeAnalysisPage emptyPage = []
+	{
+		FCodeAnalysisPage page;
+		page.Initialise();
+		return page;
+	}();
+	return emptyPage;
+}
+
+FCodeAnalysisPage* FCodeAnalysisState::GetPage(int16_t id)
+{
+	if (RegisteredPages[id] == nullptr)
+	{
+		// find the bank that reserved this page id
+		for (FCodeAnalysisBank& bank : Banks)
+		{
+			if (id >= bank.FirstPageId && id < bank.FirstPageId + bank.NoPages)
+			{
+				AllocateBankPages(bank);
+				break;
+			}
+		}
+	}
+
+	return RegisteredPages[id];
+}
+
 bool FCodeAnalysisState::FreeBanksFrom(int16_t bankId)
 {
 	Banks.resize(bankId);
@@ -102,20 +156,21 @@ bool FCodeAnalysisState::MapBank(int16_t bankId, int startPageNo, EBankAccess ac
 	}
 
 	pBank->MapToPage(startPageNo, access);
+	FCodeAnalysisPage* pBankPages = GetBankPagesForWrite(*pBank);
 	for (int bankPageNo = 0; bankPageNo < pBank->NoPages; bankPageNo++)
 	{
 		// Set Read Page
 		if(access == EBankAccess::Read || access == EBankAccess::ReadWrite)
 		{
 			MappedReadBanks[startPageNo + bankPageNo] = bankId;
-			SetCodeAnalysisReadPage(startPageNo + bankPageNo, &pBank->Pages[bankPageNo]);	// Read
+			SetCodeAnalysisReadPage(startPageNo + bankPageNo, &pBankPages[bankPageNo]);	// Read
 		}
 
 		// Set Write Page
 		if (access == EBankAccess::Write || access == EBankAccess::ReadWrite)
 		{
 			MappedWriteBanks[startPageNo + bankPageNo] = bankId;
-			SetCodeAnalysisWritePage(startPageNo + bankPageNo, &pBank->Pages[bankPageNo]);	// Write
+			SetCodeAnalysisWritePage(startPageNo + bankPageNo, &pBankPages[bankPageNo]);	// Write
 		}
 	}
 	bMemoryRemapped = true;
@@ -172,6 +227,32 @@ bool FCodeAnalysisState::IsAddressValid(FAddressRef addr) const
 	return true;
 }
 
+void FCodeAnalysisState::SetCodeAnalysisRangeDirty(FAddressRef startAddrRef, int noBytes)
+{
+	bCodeAnalysisDataDirty = true;
+	FCodeAnalysisBank* pBank = GetBank(startAddrRef.BankId);
+	if (pBank == nullptr || noBytes <= 0)
+		return;
+
+	const int bankOffset = (uint16_t)(startAddrRef.Address - pBank->GetMappedAddress());
+	const int firstPageNo = bankOffset >> FCodeAnalysisPage::kPageShift;
+	const int lastPageNo = (bankOffset + noBytes - 1) >> FCodeAnalysisPage::kPageShift;
+	if (firstPageNo >= pBank->NoPages)
+	{
+		pBank->bIsDirty = true;
+		return;
+	}
+
+	for (int pageNo = firstPageNo; pageNo <= lastPageNo && pageNo < pBank->NoPages; pageNo++)
+		pBank->DirtyPageMask |= 1ull << pageNo;
+
+	// the rest of the range is in whichever bank is mapped after this one
+	const int bytesInBank = pBank->GetSizeBytes() - bankOffset;
+	const int nextAddress = pBank->GetMappedAddress() + pBank->GetSizeBytes();
+	if (noBytes > bytesInBank && nextAddress < kAddressSize)
+		SetCodeAnalysisRangeDirty(AddressRefFromPhysicalAddress((uint16_t)nextAddress), noBytes - bytesInBank);
+}
+
 bool FCodeAnalysisState::MapBankForAnalysis(FCodeAnalysisBank& bank)
 {
 	for (int i = 0; i < kNoPagesInAddressSpace; i++)
@@ -186,12 +267,13 @@ bool FCodeAnalysisState::MapBankForAnalysis(FCodeAnalysisBank& bank)
 
 	const int startPageNo = bank.PrimaryMappedPage;
 	assert(startPageNo != -1);
+	FCodeAnalysisPage* pBankPages = GetBankPagesForWrite(bank);
 	for (int bankPageNo = 0; bankPageNo < bank.NoPages; bankPageNo++)
 	{
 		MappedReadBanks[startPageNo + bankPageNo] = bank.Id;
 		MappedWriteBanks[startPageNo + bankPageNo] = bank.Id;
 		MappedMem[startPageNo + bankPageNo] = &bank.Memory[bankPageNo * FCodeAnalysisPage::kPageSize];
-		SetCodeAnalysisRWPage(startPageNo + bankPageNo, &bank.Pages[bankPageNo], &bank.Pages[bankPageNo]);	// Read/Write
+		SetCodeAnalysisRWPage(startPageNo + bankPageNo, &pBankPages[bankPageNo], &pBankPages[bankPageNo]);	// Read/Write
 	}
 
 	return true;
@@ -203,12 +285,13 @@ void FCodeAnalysisState::UnMapAnalysisBanks()
 	{
 		MappedReadBanks[i] = MappedReadBanksBackup[i];
 		MappedWriteBanks[i] = MappedWriteBanksBackup[i];
-		const FCodeAnalysisBank* pMappedBank = GetBank(MappedReadBanks[i]);
+		FCodeAnalysisBank* pMappedBank = GetBank(MappedReadBanks[i]);
 		assert(pMappedBank->PrimaryMappedPage != -1);
 		if (MappedMem[i] != nullptr)
 		{
 			const int mappedPage = i - pMappedBank->PrimaryMappedPage;
-			SetCodeAnalysisRWPage(i, &pMappedBank->Pages[mappedPage], &pMappedBank->Pages[mappedPage]);	// Read/Write
+			FCodeAnalysisPage* pBankPages = GetBankPagesForWrite(*pMappedBank);
+			SetCodeAnalysisRWPage(i, &pBankPages[mappedPage], &pBankPages[mappedPage]);	// Read/Write
 			MappedMem[i] = nullptr;
 		}
 	}
@@ -237,8 +320,17 @@ bool FCodeAnalysisState::ToggleDataBreakpointAtAddress(FAddressRef addr, uint16_
 
 
 std::vector<FAddressRef> FCodeAnalysisState::FindAllMemoryPatterns(const uint8_t* pData, size_t dataSize, bool bCheckMachineROM, bool bPhysicalOnly)
+{
+	return FindAllMemoryPatterns(FSearchPattern(pData, dataSize), bCheckMachineROM, bPhysicalOnly);
+}
+
+std::vector<FAddressRef> FCodeAnalysisState::FindAllMemoryPatterns(const FSearchPattern& pattern, bool bCheckMachineROM, bool bPhysicalOnly)
 {
 	std::vector<FAddressRef> results;
+	std::vector<size_t> offsets;
+	FSinglePatternSearch search;
+	search.SetPattern(pattern);
+
 	// iterate through banks
 	for (auto& bank : Banks)
 	{
@@ -248,30 +340,38 @@ std::vector<FAddressRef> FCodeAnalysisState::FindAllMemoryPatterns(const uint8_t
 		if (bank.IsMapped() == false && bPhysicalOnly)
 			continue;
 
-		const int bankByteSize = bank.GetSizeBytes();
-		for (int bAddr = 0; bAddr < bankByteSize - dataSize; bAddr++)
-		{
-			bool bFound = true;
-			for (int byteNo = 0; byteNo < dataSize; byteNo++)
-			{
-				const uint8_t byte = bank.Memory[bAddr + byteNo];
-				if (byte != pData[byteNo])
-				{
-					bFound = false;
-					break;
-				}
-			}
-
-			if (bFound)
-			{
-				results.push_back(FAddressRef(bank.Id, bAddr + bank.GetMappedAddress()));
-			}
-		}
+		offsets.clear();
+		search.FindInMemory(bank.Memory, bank.GetSizeBytes(), offsets);
+		for (size_t offset : offsets)
+			results.push_back(FAddressRef(bank.Id, (uint16_t)(offset + bank.GetMappedAddress())));
 	}
 
 	return results;	
 }
 
+// Find all of a set of patterns with a single pass over each bank
+std::vector<FFoundPattern> FCodeAnalysisState::FindAllMemoryPatterns(const FMultiPatternSearch& patterns, bool bCheckMachineROM, bool bPhysicalOnly)
+{
+	std::vector<FFoundPattern> results;
+	std::vector<FPatternMatch> matches;
+
+	for (auto& bank : Banks)
+	{
+		if (bank.bMachineROM && bCheckMachineROM == false)
+			continue;
+
+		if (bank.IsMapped() == false && bPhysicalOnly)
+			continue;
+
+		matches.clear();
+		patterns.FindInMemory(bank.Memory, bank.GetSizeBytes(), matches);
+		for (const FPatternMatch& match : matches)
+			results.push_back({ FAddressRef(bank.Id, (uint16_t)(match.Offset + bank.GetMappedAddress())), match.PatternIndex });
+	}
+
+	return results;
+}
+
 bool IsAscii(uint8_t byte)
 {
 	return byte >= 32 && byte <= 126;
@@ -292,41 +392,87 @@ bool IsAlphanumeric(char c)
 	return IsLetter(c) || IsNumber(c);
 }
 
-bool IsVowel(char c)
-{
-	const char vowels[] = {'a','e','i','o','u'};
-	const char lc = tolower(c);
-	for (int i = 0; i < sizeof(vowels); i++)
-	{
-		if (lc == vowels[i])
-			return true;
-	}
+// Character classes for the string search, indexed by byte with the high bit stripped
+static const uint8_t kStringChar = 1 << 0;
+static const uint8_t kStringCharVowel = 1 << 1;
 
-	return false;
+static constexpr std::array<uint8_t, 128> MakeStringCharClassTable()
+{
+	std::array<uint8_t, 128> table = {};
+	for (int c = 'A'; c <= 'Z'; c++)
+		table[c] = table[c + ('a' - 'A')] = kStringChar;
+	for (int c = '0'; c <= '9'; c++)
+		table[c] = kStringChar;
+	for (char c : { ' ',',','!','.','?','\'','`','"','@','$','-' })	// punctuation
+		table[c] = kStringChar;
+	for (char c : { 'a','e','i','o','u' })
+		table[c] = table[c - ('a' - 'A')] = kStringChar | kStringCharVowel;
+	return table;
 }
 
-bool IsPunctuation(char c)
+static constexpr std::array<uint8_t, 128> kStringCharClasses = MakeStringCharClassTable();
+
+// Find strings in a single bank - this runs on worker threads so it reads the pages directly and mustn't allocate them
+static void FindStringsInBank(const FCodeAnalysisBank& bank, std::vector<FFoundString>& results)
 {
-	const char punctuation[] = { ' ',',','!','.','?','\'','`','"','@','$','-'};
-	for (int i = 0; i < sizeof(punctuation); i++)
+	FAddressRef stringStart;
+	int vowelCount = 0;
+	std::string foundString;
+
+	const int bankByteSize = bank.GetSizeBytes();
+	for (int bAddr = 0; bAddr < bankByteSize; bAddr++)
 	{
-		if (c == punctuation[i])
-			return true;
-	}
+		// Skip code, non-text data & anything that's been written to
+		if (bank.Pages != nullptr)	// unallocated banks have no analysis so everything's a byte
+		{
+			const FCodeAnalysisPage& page = bank.Pages[bAddr >> FCodeAnalysisPage::kPageShift];
+			const int pageAddr = bAddr & FCodeAnalysisPage::kPageMask;
+			if (page.CodeInfo[pageAddr] != nullptr)
+				continue;
+			const EDataType dataType = page.DataInfo[pageAddr].DataType;
+			if (dataType != EDataType::Byte && dataType != EDataType::Text)
+				continue;
+			if (page.LastFrameWritten[pageAddr] != -1)
+				continue;
+		}
 
-	return false;
-}
+		const uint8_t byte = bank.Memory[bAddr];
+		const char c = (char)(byte & 0x7f);
+		const uint8_t charClass = kStringCharClasses[(uint8_t)c];
+		bool bTerminated = (byte & 0x80) != 0;	// high bit terminated strings
 
-bool IsValidStringChar(char c)
-{
-	return IsAlphanumeric(c) || IsPunctuation(c);
+		if (charClass & kStringChar)
+		{
+			if (stringStart.IsValid() == false)	// string start
+				stringStart = FAddressRef(bank.Id, bank.GetMappedAddress() + bAddr);
+
+			if (charClass & kStringCharVowel)
+				vowelCount++;
+			foundString.push_back(c);
+		}
+		else
+		{
+			bTerminated = true;
+		}
+
+		// Any part of a rejected string would also fail the filter so there's no need to go back & rescan it
+		if (bTerminated && foundString.empty() == false)
+		{
+			// Run through (simple) acceptance filter
+			if (foundString.size() > 2 && vowelCount > 0)
+				results.push_back({ stringStart, foundString });
+
+			stringStart.SetInvalid();
+			vowelCount = 0;
+			foundString.clear();
+		}
+	}
 }
 
 std::vector<FFoundString> FCodeAnalysisState::FindAllStrings(bool bCheckMachineROM, bool bPhysicalOnly)
 {
-	std::vector<FFoundString> results;
-
-	for (auto& bank : Banks)
+	std::vector<const FCodeAnalysisBank*> searchBanks;
+	for (const auto& bank : Banks)
 	{
 		if (bank.bMachineROM && bCheckMachineROM == false)
 			continue;
@@ -334,78 +480,19 @@ std::vector<FFoundString> FCodeAnalysisState::FindAllStrings(bool bCheckMachineR
 		if (bank.IsMapped() == false && bPhysicalOnly)
 			continue;
 
-		FAddressRef stringStart;	
-		int stringLength = 0;
-		int vowelCount = 0;
-		std::string foundString;
-
-		const int bankByteSize = bank.GetSizeBytes();
-		int stringStartBankPos = 0;
-		
-		for(int bAddr = 0; bAddr < bankByteSize;bAddr++)
-		{
-			FAddressRef addressRef(bank.Id, bank.GetMappedAddress() + bAddr);
-			char c = bank.Memory[bAddr];
-			bool bTerminated = false;
-
-			// Check for code & skip
-			const FCodeInfo* pCodeInfo = GetCodeInfoForAddress(addressRef);
-			if (pCodeInfo != nullptr)
-				continue;
-
-			// check data
-			const FDataInfo* pDataInfo = GetDataInfoForAddress(addressRef);
-			if (pDataInfo->DataType != EDataType::Byte && pDataInfo->DataType != EDataType::Text)
-				continue;
-			if (pDataInfo->LastFrameWritten != -1)
-				continue;
-
-			if (c & (1 << 7))	// high bit terminated strings
-			{
-				c = c & ~(1 << 7);
-				bTerminated = true;
-			}
-
-			if(IsValidStringChar(c))
-			{
-				if (stringStart.IsValid() == false)	// string start
-				{
-					stringStart = addressRef;
-					stringStartBankPos = bAddr;
-					stringLength = 0;
-				}
-
-				stringLength++;
-				if (IsVowel(c))
-					vowelCount++;
-				foundString.push_back(c);
+		searchBanks.push_back(&bank);
+	}
 
-				//if (stringLength == 4 && vowelCount == 0)	// string of 4 chars must have a vowel
-				//	bTerminated = true;
-			}
-			else
-			{
-				bTerminated = true;
-			}
+	// search banks in parallel then merge in bank order
+	std::vector<std::vector<FFoundString>> bankResults(searchBanks.size());
+	GetSharedThreadPool().ParallelFor((int)searchBanks.size(), [&searchBanks, &bankResults](int bankNo)
+	{
+		FindStringsInBank(*searchBanks[bankNo], bankResults[bankNo]);
+	});
 
-			if(bTerminated && foundString.empty() == false)
-			{
-				// Run through (simple) acceptance filter
-				if (stringLength > 2 && vowelCount > 0)
-				{
-					results.push_back({ stringStart, foundString });
-				}
-				else
-				{
-					bAddr = stringStartBankPos;	// wind back to start of string
-				}
-				stringStart.SetInvalid();;
-				stringLength = 0;
-				vowelCount = 0;
-				foundString.clear();
-			}
-		}
-	}
+	std::vector<FFoundString> results;
+	for (auto& foundStrings : bankResults)
+		results.insert(results.end(), std::make_move_iterator(foundStrings.begin()), std::make_move_iterator(foundStrings.end()));
 
 	return results;
 }
@@ -521,7 +608,7 @@ bool CheckStopInstruction(FCodeAnalysisState& state, uint16_t pc)
 // this function assumes the text is mapped in
 std::string GetItemText(const FCodeAnalysisState& state, FAddressRef address)
 {
-	FDataInfo* pDataInfo = state.GetDataInfoForAddress(address);
+	const FDataInfo* pDataInfo = state.GetDataInfoForAddress(address);
 	std::string textString;
 
 	if (pDataInfo->DataType != EDataType::Text)
@@ -565,7 +652,7 @@ FLabelInfo* GenerateLabelForAddress(FCodeAnalysisState &state, FAddressRef addre
 			break;
 		case ELabelType::Data:
 		{
-			FDataInfo* pDataInfo = state.GetDataInfoForAddress(address);
+			const FDataInfo* pDataInfo = state.GetDataInfoForAddress(address);
 			if(pDataInfo->DataType == EDataType::InstructionOperand)
 				snprintf(label, kLabelSize, "operand_%04X", address.Address);
 			else
@@ -600,9 +687,8 @@ FLabelInfo* GenerateLabelForAddress(FCodeAnalysisState &state, FAddressRef addre
 	}
 
 	pLabel->InitialiseName(label);
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
 	state.SetLabelForAddress(address, pLabel);
+	AddLabelToGlobalInfo(state, pLabel, address);
 	state.SetCodeAnalysisDirty(address);
 	return pLabel;	
 }
@@ -630,6 +716,7 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 		pCodeInfo = FCodeInfo::Allocate();
 		state.SetCodeInfoForAddress(pc, pCodeInfo);
 	}	
+	pCodeInfo->Decoded.bValid = false;
 
 	// does this function branch?
 	uint16_t jumpAddr;
@@ -696,55 +783,125 @@ uint16_t WriteCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc)
 	return newPC;
 }
 
-// return if we should continue
-bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
+void ClassifyExecutedInstruction(const FCodeAnalysisState& state, uint16_t pc, FDecodedInstruction& decoded)
 {
-	FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
+	if (state.CPUInterface->CPUType == ECPUType::Z80)
+		ClassifyExecutedInstructionZ80(state, pc, decoded);
+	else if (state.CPUInterface->CPUType == ECPUType::M6502)
+		ClassifyExecutedInstruction6502(state, pc, decoded);
+}
+
+// Decode the parts of an instruction the per-instruction analysis needs
+void DecodeInstruction(FCodeAnalysisState& state, uint16_t pc, FDecodedInstruction& decoded)
+{
+	decoded.PC = pc;
+	decoded.bHasJump = CheckJumpInstruction(state, pc, &decoded.JumpAddress);
+	decoded.bHasPointerRef = CheckPointerRefInstruction(state, pc, &decoded.PointerAddress);
+	ClassifyExecutedInstruction(state, pc, decoded);
+	decoded.ByteSize = 0;
+	decoded.bValid = false;
+}
+
+// Cache the decoded instruction on the code info, SMC is never cached as its operands are expected to change
+void StoreDecodedInstruction(FCodeAnalysisState& state, FCodeInfo* pCodeInfo, const FDecodedInstruction& decoded)
+{
+	FDecodedInstruction& cached = pCodeInfo->Decoded;
+	cached = decoded;
+	if (pCodeInfo->bSelfModifyingCode || pCodeInfo->ByteSize == 0 || pCodeInfo->ByteSize > sizeof(cached.Bytes))
+		return;
+
+	cached.ByteSize = (uint8_t)pCodeInfo->ByteSize;
+	for (int i = 0; i < cached.ByteSize; i++)
+		cached.Bytes[i] = state.ReadByte(decoded.PC + i);
+	cached.bValid = true;
+}
+
+// Check the cached decode still matches what's in memory at pc
+bool IsDecodedInstructionValid(FCodeAnalysisState& state, const FCodeInfo* pCodeInfo, uint16_t pc)
+{
+	const FDecodedInstruction& decoded = pCodeInfo->Decoded;
+	if (decoded.bValid == false || decoded.PC != pc || pCodeInfo->bSelfModifyingCode)
+		return false;
+
+	for (int i = 0; i < decoded.ByteSize; i++)
+	{
+		if (state.ReadByte(pc + i) != decoded.Bytes[i])
+			return false;
+	}
+	return true;
+}
+
+void RegisterInstructionReferences(FCodeAnalysisState& state, FCodeInfo* pCodeInfo, const FDecodedInstruction& decoded)
+{
+	const uint16_t pc = decoded.PC;
 
-	// Register Code accesses
-	// 
 	// set jump reference
-	uint16_t jumpPhysAddr;
-	if (CheckJumpInstruction(state, pc, &jumpPhysAddr))
+	if (decoded.bHasJump)
 	{
-		const FAddressRef jumpAddr = state.AddressRefFromPhysicalAddress(jumpPhysAddr);
+		const FAddressRef jumpAddr = state.AddressRefFromPhysicalAddress(decoded.JumpAddress);
 		assert(state.IsAddressValid(jumpAddr));
 
-		FLabelInfo* pLabel = state.GetLabelForPhysicalAddress(jumpPhysAddr);
+		FLabelInfo* pLabel = state.GetLabelForPhysicalAddress(decoded.JumpAddress);
 		if (pLabel != nullptr)
 			pLabel->References.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
 		if (pCodeInfo != nullptr)
 			pCodeInfo->OperandAddress = jumpAddr;
-
 	}
 
 	// set pointer reference
-	uint16_t ptr;
-	if (CheckPointerRefInstruction(state, pc, &ptr))
+	if (decoded.bHasPointerRef)
 	{
-		FLabelInfo* pLabel = state.GetLabelForPhysicalAddress(ptr); // NOTE: we have to use the physical address because of banks mapped twice
+		FLabelInfo* pLabel = state.GetLabelForPhysicalAddress(decoded.PointerAddress); // NOTE: we have to use the physical address because of banks mapped twice
 		if (pLabel != nullptr)
 			pLabel->References.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
 
 		if (pCodeInfo != nullptr)
-			pCodeInfo->OperandAddress = state.AddressRefFromPhysicalAddress(ptr);
+			pCodeInfo->OperandAddress = state.AddressRefFromPhysicalAddress(decoded.PointerAddress);
 	}
+}
+
+// return if we should continue
+bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
+{
+	FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
+
+	// fast path - instruction has already been decoded & hasn't changed
+	if (pCodeInfo != nullptr && IsDecodedInstructionValid(state, pCodeInfo, pc))
+	{
+		RegisterInstructionReferences(state, pCodeInfo, pCodeInfo->Decoded);
+		return false;
+	}
+
+	// Register Code accesses
+	FDecodedInstruction decoded;
+	DecodeInstruction(state, pc, decoded);
+	RegisterInstructionReferences(state, pCodeInfo, decoded);
 
 	const char* pOldComment = nullptr;
 	if (pCodeInfo != nullptr)
 	{
-		if(pCodeInfo->bSelfModifyingCode)	// check SMC
+		// the operand writes are being updated on the analysis thread so recheck SMC when it's synced
+		if (pCodeInfo->bSelfModifyingCode && state.AnalysisPipeline.IsRunning())
+		{
+			if (pCodeInfo->bSMCCheckQueued == false)
+			{
+				pCodeInfo->bSMCCheckQueued = true;
+				state.DeferredSMCChecks.push_back(state.AddressRefFromPhysicalAddress(pc));
+			}
+		}
+		else if(pCodeInfo->bSelfModifyingCode)	// check SMC
 		{
 			pCodeInfo->bSelfModifyingCode = false;
 			for(uint16_t operandAddr = 0;operandAddr<pCodeInfo->ByteSize;operandAddr++)
 			{
 				FDataInfo* pOpDataInfo = state.GetReadDataInfoForAddress(pc + operandAddr);
-				if(pOpDataInfo->Writes.IsEmpty() == false)
+				if(pOpDataInfo->GetWrites().IsEmpty() == false)
 				{
 					pCodeInfo->bSelfModifyingCode = true;
 				}					
 			}
 		}
+		StoreDecodedInstruction(state, pCodeInfo, decoded);
 		return false;
 	}
 
@@ -754,6 +911,7 @@ bool AnalyseAtPC(FCodeAnalysisState &state, uint16_t& pc)
 	pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
 	if (pOldComment != nullptr)	// restore old comment
 		pCodeInfo->Comment = std::string(pOldComment);
+	StoreDecodedInstruction(state, pCodeInfo, decoded);
 
 	if (CheckStopInstruction(state, pc) || newPC < pc)
 		return false;
@@ -777,10 +935,18 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t oldpc
 	AnalyseAtPC(state, pc);
 
 	FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
-	if (pCodeInfo != nullptr)
+	if (pCodeInfo != nullptr && state.Debugger.IsReplaying() == false)	// replayed instructions were counted first time round
 	{
 		pCodeInfo->FrameLastExecuted = state.CurrentFrameNo;
 		pCodeInfo->ExecutionCount++;
+
+		// skip the CPU specific handler when neither instruction affects the stack or callstack
+		if (pCodeInfo->Decoded.bValid && pCodeInfo->Decoded.PC == pc && pCodeInfo->Decoded.bCheckWhenExecuted == false)
+		{
+			const FCodeInfo* pOldCodeInfo = state.GetCodeInfoForPhysicalAddress(oldpc);
+			if (pOldCodeInfo != nullptr && IsDecodedInstructionValid(state, pOldCodeInfo, oldpc) && pOldCodeInfo->Decoded.bCheckWhenPrevious == false)
+				return false;
+		}
 	}
 
 	if (state.CPUInterface->CPUType == ECPUType::Z80)
@@ -805,14 +971,36 @@ void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr)
 		LOGINFO("Access 0x%04X at PC:", g_DbgReadAddress, pc);
 	}
 
+	if (state.Debugger.IsReplaying())	// already counted when first executed
+		return;
+
+	if (state.bRecordDataAccesses && state.AnalysisPipeline.IsRunning() == false)
+	{
+		state.RecordDataAccess(pc, dataAddr, false);
+		return;
+	}
+
 	if (state.GetCodeInfoForPhysicalAddress(dataAddr) == nullptr)	// don't register instruction data reads
 	{
-		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(dataAddr);
-		if(pDataInfo->DataType != EDataType::InstructionOperand)
+		FCodeAnalysisPage* pPage = state.GetReadPage(dataAddr);
+		const uint16_t pageAddr = dataAddr & FCodeAnalysisPage::kPageMask;
+		FDataInfo* pDataInfo = &pPage->DataInfo[pageAddr];
+		if (pDataInfo->DataType != EDataType::InstructionOperand && state.AnalysisPipeline.IsRunning())
+		{
+			FDataAccessEvent event;
+			event.pPage = pPage;
+			event.pCodeInfo = state.GetCodeInfoForPhysicalAddress(pc);
+			event.PC = state.AddressRefFromPhysicalAddress(pc);
+			event.DataAddress = state.AddressRefFromPhysicalReadAddress(dataAddr);
+			event.PageAddress = pageAddr;
+			event.FrameNo = state.CurrentFrameNo;
+			state.AnalysisPipeline.PushDataAccess(event);
+		}
+		else if(pDataInfo->DataType != EDataType::InstructionOperand)
 		{
-			pDataInfo->ReadCount++;
-			pDataInfo->LastFrameRead = state.CurrentFrameNo;
-			pDataInfo->Reads.RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
+			pPage->ReadCount[pageAddr]++;
+			pPage->LastFrameRead[pageAddr] = state.CurrentFrameNo;
+			pDataInfo->EditReads().RegisterAccess(state.AddressRefFromPhysicalAddress(pc));
 		
 			FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(state.AddressRefFromPhysicalAddress(pc));
 			if (pCodeInfo)
@@ -823,11 +1011,19 @@ void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr)
 
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc,uint16_t dataAddr,uint8_t value)
 {
+	if (state.Debugger.IsReplaying())	// already counted when first executed
+		return;
+
+	if (state.bRecordDataAccesses && state.AnalysisPipeline.IsRunning() == false)
+	{
+		state.RecordDataAccess(pc, dataAddr, true);
+		return;
+	}
+
 	const FAddressRef pcAddr = state.AddressRefFromPhysicalAddress(pc);
-	FDataInfo* pDataInfo = state.GetWriteDataInfoForAddress(dataAddr);
-	pDataInfo->WriteCount++;
-	pDataInfo->LastFrameWritten = state.CurrentFrameNo;
-	pDataInfo->Writes.RegisterAccess(pcAddr);
+	FCodeAnalysisPage* pPage = state.GetWritePage(dataAddr);
+	const uint16_t pageAddr = dataAddr & FCodeAnalysisPage::kPageMask;
+	FDataInfo* pDataInfo = &pPage->DataInfo[pageAddr];
 
 	// check for SMC
 	if (pDataInfo->DataType == EDataType::InstructionOperand)
@@ -839,12 +1035,106 @@ void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc,uint16_t dataAddr,
 	}
 
 	FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(pcAddr);
+
+	if (state.AnalysisPipeline.IsRunning())
+	{
+		FDataAccessEvent event;
+		event.pPage = pPage;
+		event.pCodeInfo = pCodeInfo;
+		event.PC = pcAddr;
+		event.DataAddress = state.AddressRefFromPhysicalWriteAddress(dataAddr);
+		event.PageAddress = pageAddr;
+		event.bWrite = true;
+		event.FrameNo = state.CurrentFrameNo;
+		state.AnalysisPipeline.PushDataAccess(event);
+		return;
+	}
+
+	pPage->WriteCount[pageAddr]++;
+	pPage->LastFrameWritten[pageAddr] = state.CurrentFrameNo;
+	pDataInfo->EditWrites().RegisterAccess(pcAddr);
+
 	if(pCodeInfo)
 	{
 		pCodeInfo->Writes.RegisterAccess(state.AddressRefFromPhysicalWriteAddress(dataAddr));
 	}
 }
 
+void FCodeAnalysisState::RecordDataAccess(uint16_t pc, uint16_t dataAddr, bool bWrite)
+{
+	const FAddressRef pcAddr = AddressRefFromPhysicalAddress(pc);
+	const FAddressRef dataAddrRef = bWrite ? AddressRefFromPhysicalWriteAddress(dataAddr) : AddressRefFromPhysicalReadAddress(dataAddr);
+
+	// loops hit the same addresses over & over, just count those
+	// the cache slot is only trusted if the record it points to matches, so it doesn't need clearing between frames
+	const uint32_t hash = ((uint32_t)pc * 0x9E3779B1u) ^ ((uint32_t)dataAddr * 0x85EBCA77u) ^ (bWrite ? 0xC2B2AE3Du : 0);
+	uint32_t& recordIndex = DataAccessRecordCache[(hash >> 16) & (kDataAccessRecordCacheSize - 1)];
+	if (recordIndex >= DataAccessRecords.size() ||
+		DataAccessRecords[recordIndex].PC != pcAddr ||
+		DataAccessRecords[recordIndex].DataAddress != dataAddrRef ||
+		DataAccessRecords[recordIndex].bWrite != bWrite)
+	{
+		recordIndex = (uint32_t)DataAccessRecords.size();
+		FDataAccessRecord& newRecord = DataAccessRecords.emplace_back();
+		newRecord.PC = pcAddr;
+		newRecord.DataAddress = dataAddrRef;
+		newRecord.bWrite = bWrite;
+	}
+
+	FDataAccessRecord& record = DataAccessRecords[recordIndex];
+	record.FrameNo = CurrentFrameNo;
+	record.Count++;
+}
+
+// Process the data accesses that have been recorded this frame
+void FCodeAnalysisState::FlushDataAccessRecords()
+{
+	for (const FDataAccessRecord& record : DataAccessRecords)
+	{
+		FCodeAnalysisPage* pPage = GetPageForAddress(record.DataAddress);
+		if (pPage == nullptr)
+			continue;
+
+		const uint16_t pageAddr = record.DataAddress.Address & FCodeAnalysisPage::kPageMask;
+		FDataInfo* pDataInfo = &pPage->DataInfo[pageAddr];
+
+		FCodeInfo* pCodeInfo = GetCodeInfoForAddress(record.PC);
+
+		if (record.bWrite)
+		{
+			pPage->WriteCount[pageAddr] += record.Count;
+			pPage->LastFrameWritten[pageAddr] = record.FrameNo;
+			pDataInfo->EditWrites().RegisterAccess(record.PC);
+
+			// check for SMC
+			if (pDataInfo->DataType == EDataType::InstructionOperand)
+			{
+				FCodeInfo* pCodeWrittenTo = GetCodeInfoForAddress(pDataInfo->InstructionAddress);
+				if (pCodeWrittenTo != nullptr)
+					pCodeWrittenTo->bSelfModifyingCode = true;
+			}
+
+			if (pCodeInfo)
+				pCodeInfo->Writes.RegisterAccess(record.DataAddress);
+		}
+		else
+		{
+			// don't register instruction data reads
+			if (GetCodeInfoForAddress(record.DataAddress) != nullptr || pDataInfo->DataType == EDataType::InstructionOperand)
+				continue;
+
+			pPage->ReadCount[pageAddr] += record.Count;
+			pPage->LastFrameRead[pageAddr] = record.FrameNo;
+			pDataInfo->EditReads().RegisterAccess(record.PC);
+
+			if (pCodeInfo)
+				pCodeInfo->Reads.RegisterAccess(record.DataAddress);
+		}
+	}
+
+	DataAccessRecords.clear();
+}
+
 // TODO: this needs to be rewritten for banks
 void ReAnalyseCode(FCodeAnalysisState &state)
 {
@@ -862,7 +1152,7 @@ void ReAnalyseCode(FCodeAnalysisState &state)
 				pOperandData->ByteSize = 1;
 				pOperandData->DataType = EDataType::InstructionOperand;
 				pOperandData->InstructionAddress = state.AddressRefFromPhysicalAddress(addr);
-				if (pOperandData->Writes.IsEmpty() == false)
+				if (pOperandData->GetWrites().IsEmpty() == false)
 					pCodeInfo->bSelfModifyingCode = true;
 				if (i > 0)	// make sure other entries after are null
 					state.SetCodeInfoForAddress(addr + i, nullptr);
@@ -887,16 +1177,21 @@ void ReAnalyseCode(FCodeAnalysisState &state)
 // Do we want to do this with every page?
 void ResetReferenceInfo(FCodeAnalysisState &state)
 {
+	// clear the access stats a page at a time
+	for (int pageNo = 0; pageNo < FCodeAnalysisState::kNoPagesInAddressSpace; pageNo++)
+	{
+		const uint16_t pageAddr = pageNo * FCodeAnalysisPage::kPageSize;
+		FCodeAnalysisPage* pReadPage = state.GetReadPage(pageAddr);
+		std::fill(pReadPage->LastFrameRead, pReadPage->LastFrameRead + FCodeAnalysisPage::kPageSize, -1);
+		std::fill(pReadPage->LastFrameWritten, pReadPage->LastFrameWritten + FCodeAnalysisPage::kPageSize, -1);
+		FCodeAnalysisPage* pWritePage = state.GetWritePage(pageAddr);
+		std::fill(pWritePage->LastWriter, pWritePage->LastWriter + FCodeAnalysisPage::kPageSize, FAddressRef());
+	}
+
 	for (int i = 0; i < (1 << 16); i++)
 	{
 		FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(i);
-		if (pDataInfo != nullptr)
-		{
-			pDataInfo->LastFrameRead = -1;
-			pDataInfo->Reads.Reset();
-			pDataInfo->LastFrameWritten = -1;
-			pDataInfo->Writes.Reset();
-		}
+		pDataInfo->References.Reset();
 
 		FLabelInfo* pLabelInfo = state.GetLabelForPhysicalAddress(i);
 		if (pLabelInfo != nullptr)
@@ -912,9 +1207,6 @@ void ResetReferenceInfo(FCodeAnalysisState &state)
 			pCodeInfo->Reads.Reset();
 			pCodeInfo->Writes.Reset();
 		}
-
-
-		state.SetLastWriterForAddress(i,  FAddressRef());
 	}
 }
 
@@ -928,9 +1220,7 @@ FLabelInfo* AddLabel(FCodeAnalysisState &state, uint16_t address,const char *nam
 	pLabel->ByteSize = 1;
 	pLabel->Global = type == ELabelType::Function;
 	state.SetLabelForPhysicalAddress(address, pLabel);
-
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
+	AddLabelToGlobalInfo(state, pLabel, state.AddressRefFromPhysicalAddress(address));
 
 	return pLabel;
 }
@@ -944,9 +1234,7 @@ FLabelInfo* AddLabel(FCodeAnalysisState& state, FAddressRef address, const char*
 	pLabel->ByteSize = 1;
 	pLabel->Global = type == ELabelType::Function;
 	state.SetLabelForAddress(address, pLabel);
-
-	if (pLabel->Global)
-		GenerateGlobalInfo(state);
+	AddLabelToGlobalInfo(state, pLabel, address);
 
 	return pLabel;
 }
@@ -970,13 +1258,20 @@ FCommentBlock* AddCommentBlock(FCodeAnalysisState& state, FAddressRef addressRef
 // Generate Global Info for items in address space
 void GenerateGlobalInfo(FCodeAnalysisState &state)
 {
+	if (state.LabelBatchDepth > 0)
+	{
+		state.bGlobalInfoDirty = true;
+		return;
+	}
+
+	state.bGlobalInfoDirty = false;
 	state.GlobalDataItems.clear();
 	state.GlobalFunctions.clear();
 
 	// Make global list from what's in all banks
 	for (auto& bank : state.GetBanks())
 	{
-		if (bank.PrimaryMappedPage == -1)
+		if (bank.PrimaryMappedPage == -1 || bank.Pages == nullptr)
 			continue;
 
 		for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
@@ -1019,6 +1314,92 @@ void GenerateGlobalInfo(FCodeAnalysisState &state)
 	state.bRebuildFilteredGlobalFunctions = true;
 }
 
+// Global lists are in bank then address order, same as GenerateGlobalInfo produces
+static void InsertGlobalItem(std::vector<FCodeAnalysisItem>& itemList, FLabelInfo* pLabel, FAddressRef address)
+{
+	auto insertIt = std::lower_bound(itemList.begin(), itemList.end(), address, [](const FCodeAnalysisItem& item, FAddressRef addr)
+	{
+		if (item.AddressRef.BankId != addr.BankId)
+			return item.AddressRef.BankId < addr.BankId;
+		return item.AddressRef.Address < addr.Address;
+	});
+
+	if (insertIt != itemList.end() && insertIt->AddressRef == address)
+		insertIt->Item = pLabel;	// replacing a label
+	else
+		itemList.emplace(insertIt, pLabel, address);
+}
+
+// Update the global lists for a label that has been added or changed type
+void AddLabelToGlobalInfo(FCodeAnalysisState& state, FLabelInfo* pLabel, FAddressRef address)
+{
+	const bool bGlobalData = pLabel->LabelType == ELabelType::Data && pLabel->Global;
+	const bool bFunction = pLabel->LabelType == ELabelType::Function;
+	if (bGlobalData == false && bFunction == false)
+		return;
+
+	if (state.LabelBatchDepth > 0)
+	{
+		state.bGlobalInfoDirty = true;
+		return;
+	}
+
+	// only mapped banks are in the global lists
+	const FCodeAnalysisBank* pBank = state.GetBank(address.BankId);
+	if (pBank == nullptr || pBank->PrimaryMappedPage == -1 || pBank->Pages == nullptr)
+		return;
+
+	// GenerateGlobalInfo lists banks at their primary mapping, the bank may be mapped elsewhere at the moment
+	const uint16_t bankAddr = address.Address - pBank->GetMappedAddress();
+	const uint16_t bankPageNo = (bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask;
+	const FAddressRef globalAddress(address.BankId, pBank->GetMappedAddress() + bankPageNo * FCodeAnalysisPage::kPageSize + (bankAddr & FCodeAnalysisPage::kPageMask));
+
+	if (bGlobalData)
+	{
+		InsertGlobalItem(state.GlobalDataItems, pLabel, globalAddress);
+		state.bRebuildFilteredGlobalDataItems = true;
+	}
+	else
+	{
+		InsertGlobalItem(state.GlobalFunctions, pLabel, globalAddress);
+		state.bRebuildFilteredGlobalFunctions = true;
+	}
+}
+
+void RemoveLabelFromGlobalInfo(FCodeAnalysisState& state, const FLabelInfo* pLabel)
+{
+	if (state.LabelBatchDepth > 0)
+	{
+		state.bGlobalInfoDirty = true;
+		return;
+	}
+
+	auto removeLabel = [pLabel](std::vector<FCodeAnalysisItem>& itemList)
+	{
+		auto removeIt = std::remove_if(itemList.begin(), itemList.end(), [pLabel](const FCodeAnalysisItem& item) { return item.Item == pLabel; });
+		const bool bRemoved = removeIt != itemList.end();
+		itemList.erase(removeIt, itemList.end());
+		return bRemoved;
+	};
+
+	if (removeLabel(state.GlobalDataItems))
+		state.bRebuildFilteredGlobalDataItems = true;
+	if (removeLabel(state.GlobalFunctions))
+		state.bRebuildFilteredGlobalFunctions = true;
+}
+
+void BeginLabelBatch(FCodeAnalysisState& state)
+{
+	state.LabelBatchDepth++;
+}
+
+void EndLabelBatch(FCodeAnalysisState& state)
+{
+	assert(state.LabelBatchDepth > 0);
+	if (--state.LabelBatchDepth == 0 && state.bGlobalInfoDirty)
+		GenerateGlobalInfo(state);
+}
+
 FCodeAnalysisState::FCodeAnalysisState()
 {
 	for (int i = 0; i < kNoPagesInAddressSpace; i++)
@@ -1041,12 +1422,18 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 	InitImageViewers();
 	InitCharacterSets();
 	
+	AnalysisPipeline.Stop();	// restarted on the next frame if enabled
+	DeferredSMCChecks.clear();
 	FLabelInfo::ResetLabelNames();
 	ItemList.clear();
+	DataAccessRecords.clear();
 
 	// reset registered pages
 	for (FCodeAnalysisPage* pPage : GetRegisteredPages())
 	{
+		if (pPage == nullptr)	// not allocated yet
+			continue;
+
 		pPage->Reset();
 		//pPage->bUsed = false;
 
@@ -1070,6 +1457,7 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 	FLabelInfo::FreeAll();
 	FCodeInfo::FreeAll();
 	FCommentBlock::FreeAll();
+	GetStringPool().Reset();	// nothing refers to the label names or disassembly text now
 
 	for (int i = 0; i < FCodeAnalysisState::kNoViewStates; i++)
 	{
@@ -1108,6 +1496,7 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 	KeyConfig[(int)EKey::StepFrame] = ImGuiKey_F6;
 	KeyConfig[(int)EKey::StepScreenWrite] = ImGuiKey_F7;
 	KeyConfig[(int)EKey::Breakpoint] = ImGuiKey_F9;
+	KeyConfig[(int)EKey::StepBack] = ImGuiKey_F8;
 
 	Debugger.Init(this);
 	MemoryAnalyser.Init(this);
@@ -1119,11 +1508,24 @@ void FCodeAnalysisState::Init(FEmuBase* pEmu)
 // Start/End handlers for host (imgui) frame
 void FCodeAnalysisState::OnFrameStart()
 {
+	if (bAnalysisThread && AnalysisPipeline.IsRunning() == false)
+	{
+		FlushDataAccessRecords();
+		AnalysisPipeline.Start();
+	}
+	else if (bAnalysisThread == false)
+	{
+		AnalysisPipeline.Stop();
+	}
+
 	Debugger.StartFrame();
 }
 
 void FCodeAnalysisState::OnFrameEnd()
 {
+	AnalysisPipeline.WaitUntilIdle();	// access info is safe to read after this
+	CheckDeferredSMC();
+	FlushDataAccessRecords();
 	UpdateRegionDescs();
 	MemoryAnalyser.FrameTick();
 	IOAnalyser.FrameTick();
@@ -1133,6 +1535,30 @@ void FCodeAnalysisState::OnFrameEnd()
 	}
 }
 
+// Recheck the SMC instructions that were skipped while the analysis thread was updating the write trackers
+void FCodeAnalysisState::CheckDeferredSMC()
+{
+	for (const FAddressRef& pcAddr : DeferredSMCChecks)
+	{
+		FCodeInfo* pCodeInfo = GetCodeInfoForAddress(pcAddr);
+		if (pCodeInfo == nullptr)
+			continue;
+
+		pCodeInfo->bSMCCheckQueued = false;
+		pCodeInfo->bSelfModifyingCode = false;
+		FAddressRef operandAddr = pcAddr;
+		for (int operandNo = 0; operandNo < pCodeInfo->ByteSize; operandNo++)
+		{
+			const FDataInfo* pOpDataInfo = GetDataInfoForAddress(operandAddr);
+			if (pOpDataInfo != nullptr && pOpDataInfo->GetWrites().IsEmpty() == false)
+				pCodeInfo->bSelfModifyingCode = true;
+			if (AdvanceAddressRef(operandAddr) == false)
+				break;
+		}
+	}
+	DeferredSMCChecks.clear();
+}
+
 // Start/End handlers for machine frame
 void	FCodeAnalysisState::OnMachineFrameStart()
 {
@@ -1149,8 +1575,8 @@ void	FCodeAnalysisState::OnMachineFrameEnd()
 
 void FCodeAnalysisState::OnCPUTick(uint64_t pins)
 {
-	// Only Z80 has IO operations
-	if(CPUInterface->CPUType == ECPUType::Z80)
+	// Only Z80 has IO operations, replayed ones were registered first time round
+	if(CPUInterface->CPUType == ECPUType::Z80 && Debugger.IsReplaying() == false)
 	{
 		// Handle IO operations
 		if (pins & Z80_IORQ)
@@ -1172,16 +1598,18 @@ void FixupDataInfoAddressRefs(const FCodeAnalysisState& state, FDataInfo* pDataI
 {
 	// Because this is a union, it will also fixup GraphicsSetRef and CharSetAddress
 	FixupAddressRef(state, pDataInfo->InstructionAddress);
-	FixupAddressRef(state, pDataInfo->LastWriter);
-	FixupAddressRefList(state, pDataInfo->Reads.GetReferences());
-	FixupAddressRefList(state, pDataInfo->Writes.GetReferences());
+	if (pDataInfo->HasReferences())
+	{
+		FixupAddressRefList(state, pDataInfo->EditReads());
+		FixupAddressRefList(state, pDataInfo->EditWrites());
+	}
 }
 
 void FixupCodeInfoAddressRefs(const FCodeAnalysisState& state, FCodeInfo* pCodeInfo)
 {
 	FixupAddressRef(state, pCodeInfo->OperandAddress);
-	FixupAddressRefList(state, pCodeInfo->Reads.GetReferences());
-	FixupAddressRefList(state, pCodeInfo->Writes.GetReferences());
+	FixupAddressRefList(state, pCodeInfo->Reads);
+	FixupAddressRefList(state, pCodeInfo->Writes);
 }
 
 void FCodeAnalysisState::FixupAddressRefs()
@@ -1213,11 +1641,14 @@ void FCodeAnalysisState::FixupAddressRefs()
 		if (FCodeInfo* pWriteCode = GetCodeInfoForAddress(wAddressRef))
 			FixupCodeInfoAddressRefs(*this, pWriteCode);
 
-		if (FDataInfo* pWriteData = GetDataInfoForAddress(wAddressRef))
+		if (FDataInfo* pWriteData = EditDataInfoForAddress(wAddressRef))
 			FixupDataInfoAddressRefs(*this, pWriteData);
 
+		if (FCodeAnalysisPage* pWritePage = GetPageForAddress(wAddressRef))
+			FixupAddressRef(*this, pWritePage->LastWriter[addr & FCodeAnalysisPage::kPageMask]);
+
 		if (FLabelInfo* pWriteLabel = GetLabelForAddress(wAddressRef))
-			FixupAddressRefList(*this, pWriteLabel->References.GetReferences());
+			FixupAddressRefList(*this, pWriteLabel->References);
 
 		if (wAddressRef.BankId != rAddressRef.BankId)
 		{
@@ -1225,11 +1656,14 @@ void FCodeAnalysisState::FixupAddressRefs()
 			if (FCodeInfo* pReadCode = GetCodeInfoForAddress(rAddressRef))
 				FixupCodeInfoAddressRefs(*this, pReadCode);
 
-			if (FDataInfo* pReadData = GetDataInfoForAddress(rAddressRef))
+			if (FDataInfo* pReadData = EditDataInfoForAddress(rAddressRef))
 				FixupDataInfoAddressRefs(*this, pReadData);
 
+			if (FCodeAnalysisPage* pReadPage = GetPageForAddress(rAddressRef))
+				FixupAddressRef(*this, pReadPage->LastWriter[addr & FCodeAnalysisPage::kPageMask]);
+
 			if (FLabelInfo* pReadLabel = GetLabelForAddress(wAddressRef))
-				FixupAddressRefList(*this, pReadLabel->References.GetReferences());
+				FixupAddressRefList(*this, pReadLabel->References);
 		}
 
 		addr++;
@@ -1265,7 +1699,7 @@ void SetItemText(FCodeAnalysisState &state, const FCodeAnalysisItem& item)
 			pDataItem->ByteSize = 0;	// reset byte counter
 
 			FAddressRef charAddr = item.AddressRef;
-			FDataInfo* pDataInfo = state.GetDataInfoForAddress(charAddr);
+			const FDataInfo* pDataInfo = state.GetDataInfoForAddress(charAddr);
 			while (pDataInfo != nullptr && pDataInfo->DataType == EDataType::Byte)
 			{
 				const uint8_t val = state.ReadByte(charAddr);
@@ -1343,9 +1777,7 @@ void RemoveLabelAtAddress(FCodeAnalysisState &state, FAddressRef address)
 	if (pLabelInfo != nullptr)
 	{
 		state.SetLabelForAddress(address, nullptr);
-		// Remove from globals
-		if (pLabelInfo->Global || pLabelInfo->LabelType == ELabelType::Function)
-			GenerateGlobalInfo(state);
+		RemoveLabelFromGlobalInfo(state, pLabelInfo);
 
 		state.SetCodeAnalysisDirty(address);
 	}
@@ -1431,3 +1863,8 @@ void FixupAddressRefList(const FCodeAnalysisState& state, std::vector<FAddressRe
 		FixupAddressRef(state, addr);
 	}
 }
+
+void FixupAddressRefList(const FCodeAnalysisState& state, FItemReferenceTracker& refs)
+{
+	refs.FixupReferences([&state](FAddressRef& addr) { FixupAddressRef(state, addr); });
+}
@@ -12,6 +12,7 @@
 #include "Debugger.h"
 #include "MemoryAnalyser.h"
 #include "IOAnalyser.h"
+#include "AnalysisPipeline.h"
 #include <Misc/GlobalConfig.h>
 #include "Commands/FormatDataCommand.h"
 
@@ -20,6 +21,8 @@ class FGraphicsView;
 class FCodeAnalysisState;
 class FEmuBase;
 class FDataTypes;
+struct FSearchPattern;
+class FMultiPatternSearch;
 
 enum class ELabelType;
 
@@ -54,6 +57,18 @@ struct FMemoryAccess
 	FAddressRef	PC;
 };
 
+// Compact data access record used when data accesses are recorded per frame rather than registered as they happen
+// Addresses are resolved to banks at the time of access so bank switches mid-frame are handled
+// Repeated accesses by the same instruction to the same address share a record unless another access evicts it from the record cache
+struct FDataAccessRecord
+{
+	FAddressRef	PC;
+	FAddressRef	DataAddress;
+	uint32_t	FrameNo : 31;	// frame of the last access
+	uint32_t	bWrite : 1;
+	uint32_t	Count = 0;
+};
+
 enum class EKey
 {
 	SetItemData,
@@ -77,6 +92,7 @@ enum class EKey
 	StepFrame,
 	StepScreenWrite,
 	Breakpoint,
+	StepBack,
 
 	Count
 };
@@ -256,13 +272,15 @@ struct FCodeAnalysisBank
 	std::unordered_set<int>	MappedWritePages;
 	int					PrimaryMappedPage = -1;	// the page this bank is normally mapped to
 	uint8_t*			Memory = nullptr;	// pointer to memory bank occupies
-	FCodeAnalysisPage*	Pages = nullptr;
+	FCodeAnalysisPage*	Pages = nullptr;	// allocated on first map or write - see FCodeAnalysisState::GetBankPagesForWrite
+	int16_t				FirstPageId = -1;	// page ids are reserved when the bank is created
 	std::string			Name;
 	std::string			Description;	// where we can describe what the bank is used for
 	//bool				bReadOnly = false;
 	bool				bMachineROM = false;
 	bool				bFixed = false;	// bank is never remapped
-	bool				bIsDirty = false;
+	bool				bIsDirty = false;	// whole item list needs rebuilding
+	uint64_t			DirtyPageMask = 0;	// pages that need their items rebuilding
 	bool				bEverBeenMapped = false;
 	bool				bHidden = false;
 	std::vector<FCodeAnalysisItem>		ItemList;
@@ -301,7 +319,7 @@ struct FCodeAnalysisBank
 	}
 
 	bool		AddressValid(uint16_t addr) const { return addr >= GetMappedAddress() && addr < GetMappedAddress() + (NoPages * FCodeAnalysisPage::kPageSize);	}
-	bool		IsUsed() const { return Pages[0].bUsed; }
+	bool		IsUsed() const { return Pages != nullptr && Pages[0].bUsed; }
 	bool		IsMapped() const { return Mapping!= EBankAccess::None; }
 	EBankAccess	GetBankMapping() const { return Mapping;}
 	uint16_t	GetMappedAddress() const { return PrimaryMappedPage * FCodeAnalysisPage::kPageSize; }
@@ -324,10 +342,15 @@ public:
 	void	Init(FEmuBase* pEmu);
 	void	OnFrameStart();
 	void	OnFrameEnd();
+	void	CheckDeferredSMC();
 	void	OnMachineFrameStart();
 	void	OnMachineFrameEnd();
 	void	OnCPUTick(uint64_t pins);
 
+	// Recorded data accesses - used when bRecordDataAccesses is set
+	void	RecordDataAccess(uint16_t pc, uint16_t dataAddr, bool bWrite);
+	void	FlushDataAccessRecords();
+
 	const FEmuBase* GetEmulator() const { return pEmulator; }
 	FEmuBase* GetEmulator() { return pEmulator; }
     
@@ -409,7 +432,20 @@ public:
 	
 	int GetNoPages() const { return (int)RegisteredPages.size();}
 	bool IsValidPageId(int16_t id) const { return id >=0 && id < RegisteredPages.size(); }
-	FCodeAnalysisPage* GetPage(int16_t id) { return RegisteredPages[id]; }
+	FCodeAnalysisPage* GetPage(int16_t id);
+
+	// Read a page of a bank - banks that haven't been touched yet return a shared empty page rather than allocating
+	const FCodeAnalysisPage& GetBankPage(const FCodeAnalysisBank& bank, int pageNo) const
+	{
+		return bank.Pages != nullptr ? bank.Pages[pageNo] : GetEmptyPage();
+	}
+
+	// Get a bank's pages to modify, allocating them if the bank has not been touched yet
+	FCodeAnalysisPage* GetBankPagesForWrite(FCodeAnalysisBank& bank)
+	{
+		AllocateBankPages(bank);
+		return bank.Pages;
+	}
 
 	// Advance an address ref by a number of bytes, may go to next bank in physical memory
 	bool AdvanceAddressRef(FAddressRef& addressRef, int amount = 1) const
@@ -435,7 +471,13 @@ public:
 	{
 		FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
 		if (pBank != nullptr)
-			pBank->bIsDirty = true;
+		{
+			const int bankPageNo = (uint16_t)(addrRef.Address - pBank->GetMappedAddress()) >> FCodeAnalysisPage::kPageShift;
+			if (bankPageNo < pBank->NoPages)
+				pBank->DirtyPageMask |= 1ull << bankPageNo;
+			else
+				pBank->bIsDirty = true;
+		}
 		bCodeAnalysisDataDirty = true;
 	}
 
@@ -444,6 +486,8 @@ public:
 		SetCodeAnalysisDirty({ GetBankFromAddress(address),address });
 	}
 
+	void	SetCodeAnalysisRangeDirty(FAddressRef startAddrRef, int noBytes);	// every page the range touches
+
 	void	SetAddressRangeDirty()
 	{
 		for (int i = 0; i < kNoPagesInAddressSpace; i++)
@@ -483,6 +527,13 @@ public:
 public:
 
 	bool					bRegisterDataAccesses = true;
+	bool					bRecordDataAccesses = false;	// record accesses in a per-frame buffer & process them in bulk at the end of the frame
+	std::vector<FDataAccessRecord>	DataAccessRecords;
+	static const int		kDataAccessRecordCacheSize = 4096;	// power of 2
+	uint32_t				DataAccessRecordCache[kDataAccessRecordCacheSize] = { 0 };	// hashed PC, data address & direction -> record index, collisions just start a new record
+	bool					bAnalysisThread = false;	// apply data accesses on a worker thread, synced at the end of the frame
+	FAnalysisPipeline		AnalysisPipeline;
+	std::vector<FAddressRef>	DeferredSMCChecks;	// SMC instructions to recheck once the pipeline has synced
 
 	std::vector<FCodeAnalysisItem>	ItemList;
 
@@ -492,6 +543,10 @@ public:
 	std::vector<FCodeAnalysisItem>	GlobalFunctions;
 	bool						bRebuildFilteredGlobalFunctions = true;
 
+	// the global lists are kept up to date as labels change, during a batch the changes are deferred to one rebuild at the end
+	int							LabelBatchDepth = 0;
+	bool						bGlobalInfoDirty = false;
+
 	static const int kNoViewStates = 4;
 	FCodeAnalysisViewState	ViewState[kNoViewStates];	// new multiple view states
 	int						FocussedWindowId = 0;
@@ -546,7 +601,7 @@ public:
 	FLabelInfo* GetLabelForAddress(FAddressRef addrRef)
 	{
 		const FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
-		if (pBank != nullptr)
+		if (pBank != nullptr && pBank->Pages != nullptr)	// unallocated banks have nothing in them
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
@@ -573,7 +628,7 @@ public:
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
-			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].Labels[bankAddr & FCodeAnalysisPage::kPageMask] = pLabel;
+			GetBankPagesForWrite(*pBank)[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].Labels[bankAddr & FCodeAnalysisPage::kPageMask] = pLabel;
 		}
 	}
 
@@ -581,7 +636,7 @@ public:
 	FCommentBlock* GetCommentBlockForAddress(FAddressRef addrRef)
 	{
 		const FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
-		if (pBank != nullptr)
+		if (pBank != nullptr && pBank->Pages != nullptr)	// unallocated banks have nothing in them
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
@@ -599,7 +654,7 @@ public:
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
-			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CommentBlocks[bankAddr & FCodeAnalysisPage::kPageMask] = pCommentBlock;
+			GetBankPagesForWrite(*pBank)[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CommentBlocks[bankAddr & FCodeAnalysisPage::kPageMask] = pCommentBlock;
 		}
 		//GetReadPage(addr)->CommentBlocks[addr & kPageMask] = pCommentBlock;
 	}
@@ -609,7 +664,7 @@ public:
 	FCodeInfo* GetCodeInfoForAddress(FAddressRef addrRef)
 	{
 		const FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
-		if (pBank != nullptr)
+		if (pBank != nullptr && pBank->Pages != nullptr)	// unallocated banks have nothing in them
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
@@ -629,18 +684,50 @@ public:
 		{
 			const uint16_t bankAddr = addrRef.Address - (pBank->PrimaryMappedPage * FCodeAnalysisPage::kPageSize);
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
-			pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CodeInfo[bankAddr & FCodeAnalysisPage::kPageMask] = pCodeInfo;
+			GetBankPagesForWrite(*pBank)[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].CodeInfo[bankAddr & FCodeAnalysisPage::kPageMask] = pCodeInfo;
 		}
 	}
 
-	FDataInfo* GetDataInfoForAddress(FAddressRef addrRef) const
+	FCodeAnalysisPage* GetPageForAddress(FAddressRef addrRef) const
+	{
+		const FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
+		if (pBank != nullptr && pBank->Pages != nullptr)	// unallocated banks have nothing in them
+		{
+			const uint16_t bankAddr = addrRef.Address - pBank->GetMappedAddress();
+			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);
+			return &pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask];
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+
+	// Read only lookup, doesn't allocate the bank's pages
+	const FDataInfo* GetDataInfoForAddress(FAddressRef addrRef) const
 	{
 		const FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
 		if (pBank != nullptr)
 		{
 			const uint16_t bankAddr = addrRef.Address - pBank->GetMappedAddress();
 			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
-			return &pBank->Pages[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].DataInfo[bankAddr & FCodeAnalysisPage::kPageMask];
+			return &GetBankPage(*pBank, (bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask).DataInfo[bankAddr & FCodeAnalysisPage::kPageMask];
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+
+	// Lookup for modifying the data info, allocates the bank's pages if needed
+	FDataInfo* EditDataInfoForAddress(FAddressRef addrRef)
+	{
+		FCodeAnalysisBank* pBank = GetBank(addrRef.BankId);
+		if (pBank != nullptr)
+		{
+			const uint16_t bankAddr = addrRef.Address - pBank->GetMappedAddress();
+			assert(bankAddr < pBank->NoPages * FCodeAnalysisPage::kPageSize);	// This assert gets caused by banks being mapped into more than one location in physical memory
+			return &GetBankPagesForWrite(*pBank)[(bankAddr >> FCodeAnalysisPage::kPageShift) & pBank->SizeMask].DataInfo[bankAddr & FCodeAnalysisPage::kPageMask];
 		}
 		else
 		{
@@ -654,14 +741,23 @@ public:
 	const FDataInfo* GetWriteDataInfoForAddress(uint16_t addr) const { return  &GetWritePage(addr)->DataInfo[addr & kPageMask]; }
 	FDataInfo* GetWriteDataInfoForAddress(uint16_t addr) { return &GetWritePage(addr)->DataInfo[addr & kPageMask]; }
 	
-	FAddressRef GetLastWriterForAddress(uint16_t addr) const { return GetWritePage(addr)->DataInfo[addr & kPageMask].LastWriter; }
-	void SetLastWriterForAddress(uint16_t addr, FAddressRef lastWriter) { GetWritePage(addr)->DataInfo[addr & kPageMask].LastWriter = lastWriter; }
+	FAddressRef GetLastWriterForAddress(uint16_t addr) const { return GetWritePage(addr)->LastWriter[addr & kPageMask]; }
+	void SetLastWriterForAddress(uint16_t addr, FAddressRef lastWriter) { GetWritePage(addr)->LastWriter[addr & kPageMask] = lastWriter; }
+
+	// data access stats - these live in the page arrays rather than FDataInfo
+	FAddressRef GetLastWriterForAddress(FAddressRef addrRef) const { const FCodeAnalysisPage* pPage = GetPageForAddress(addrRef); return pPage ? pPage->LastWriter[addrRef.Address & kPageMask] : FAddressRef(); }
+	int GetLastFrameReadForAddress(FAddressRef addrRef) const { const FCodeAnalysisPage* pPage = GetPageForAddress(addrRef); return pPage ? pPage->LastFrameRead[addrRef.Address & kPageMask] : -1; }
+	int GetLastFrameWrittenForAddress(FAddressRef addrRef) const { const FCodeAnalysisPage* pPage = GetPageForAddress(addrRef); return pPage ? pPage->LastFrameWritten[addrRef.Address & kPageMask] : -1; }
+	int GetLastFrameReadForPhysicalAddress(uint16_t addr) const { return GetReadPage(addr)->LastFrameRead[addr & kPageMask]; }
+	int GetLastFrameWrittenForPhysicalAddress(uint16_t addr) const { return GetWritePage(addr)->LastFrameWritten[addr & kPageMask]; }
 
 	FMachineState* GetMachineState(uint16_t addr) { return GetReadPage(addr)->MachineState[addr & kPageMask];}
 	void SetMachineStateForAddress(uint16_t addr, FMachineState* pMachineState) { GetReadPage(addr)->MachineState[addr & kPageMask] = pMachineState; }
 
 	//FAddressRef FindMemoryPattern(uint8_t* pData, size_t dataSize);
 	std::vector<FAddressRef> FindAllMemoryPatterns(const uint8_t* pData, size_t dataSize, bool bROM, bool bPhysicalOnly);
+	std::vector<FAddressRef> FindAllMemoryPatterns(const FSearchPattern& pattern, bool bROM, bool bPhysicalOnly);
+	std::vector<FFoundPattern> FindAllMemoryPatterns(const FMultiPatternSearch& patterns, bool bROM, bool bPhysicalOnly);
 	std::vector<FFoundString> FindAllStrings(bool bROM, bool bPhysicalOnly);
 
 	//bool FindMemoryPatternInPhysicalMemory(uint8_t* pData, size_t dataSize, uint16_t offset, uint16_t& outAddr);
@@ -671,15 +767,14 @@ public:
 
 private:
 	// private methods
-	bool					RegisterPage(FCodeAnalysisPage* pPage, const char* pName)
+	int16_t					ReservePageId(const char* pName)
 	{
-		if (pPage->PageId != -1)
-			return false;
-		pPage->PageId = (int16_t)RegisteredPages.size();
-		RegisteredPages.push_back(pPage);
+		RegisteredPages.push_back(nullptr);	// filled in when the bank's pages are allocated
 		PageNames.push_back(pName);
-		return true;
+		return (int16_t)(RegisteredPages.size() - 1);
 	}
+	void					AllocateBankPages(FCodeAnalysisBank& bank);
+	static const FCodeAnalysisPage&	GetEmptyPage();
 	const char* GetPageName(int16_t id) { return PageNames[id].c_str(); }
 	int16_t					GetAddressReadPageId(uint16_t addr) { return GetReadPage(addr)->PageId; }
 	int16_t					GetAddressWritePageId(uint16_t addr) { return GetWritePage(addr)->PageId; }
@@ -737,6 +832,18 @@ bool RegisterCodeExecuted(FCodeAnalysisState &state, uint16_t pc, uint16_t oldpc
 void ReAnalyseCode(FCodeAnalysisState &state);
 uint16_t WriteCodeInfoForAddress(FCodeAnalysisState& state, uint16_t pc);
 void GenerateGlobalInfo(FCodeAnalysisState &state);
+void AddLabelToGlobalInfo(FCodeAnalysisState& state, FLabelInfo* pLabel, FAddressRef address);
+void RemoveLabelFromGlobalInfo(FCodeAnalysisState& state, const FLabelInfo* pLabel);
+void BeginLabelBatch(FCodeAnalysisState& state);
+void EndLabelBatch(FCodeAnalysisState& state);
+
+// Batches label changes for the lifetime of the scope, for bulk operations like imports
+struct FLabelBatchScope
+{
+	FLabelBatchScope(FCodeAnalysisState& state) : State(state) { BeginLabelBatch(State); }
+	~FLabelBatchScope() { EndLabelBatch(State); }
+	FCodeAnalysisState& State;
+};
 void RegisterDataRead(FCodeAnalysisState& state, uint16_t pc, uint16_t dataAddr);
 void RegisterDataWrite(FCodeAnalysisState &state, uint16_t pc, uint16_t dataAddr, uint8_t value);
 void UpdateCodeInfoForAddress(FCodeAnalysisState &state, uint16_t pc);
@@ -770,3 +877,4 @@ void CaptureMachineState(FMachineState* pMachineState, ICPUInterface* pCPUInterf
 
 void FixupAddressRef(const FCodeAnalysisState& state, FAddressRef& addr);
 void FixupAddressRefList(const FCodeAnalysisState& state, std::vector<FAddressRef>& addrList);
+void FixupAddressRefList(const FCodeAnalysisState& state, FItemReferenceTracker& refs);
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <cstring>
 #include <vector>
 #include <unordered_map>
+#include <utility>
+
+#include "Util/SlabAllocator.h"
+#include "Util/StringPool.h"
 
 // Enums
 
@@ -141,31 +146,95 @@ struct std::hash<FAddressRef>
 	}
 };
 
+struct FCPUFunctionCall
+{
+	FAddressRef		FunctionAddr;
+	FAddressRef		CallAddr;
+	FAddressRef		ReturnAddr;
+};
+
 struct FFoundString
 {
 	FAddressRef		Address;
 	std::string		String;
 };
 
+struct FFoundPattern
+{
+	FAddressRef		Address;
+	int				PatternIndex = -1;
+};
+
+// Lightweight view of a contiguous list of address refs
+struct FAddressRefView
+{
+	FAddressRefView(const FAddressRef* pBegin, const FAddressRef* pEnd) : pFirst(pBegin), pLast(pEnd) {}
+
+	const FAddressRef* begin() const { return pFirst; }
+	const FAddressRef* end() const { return pLast; }
+	size_t	size() const { return pLast - pFirst; }
+	bool	empty() const { return pFirst == pLast; }
+	const FAddressRef& operator[](size_t index) const { return pFirst[index]; }
+
+private:
+	const FAddressRef*	pFirst;
+	const FAddressRef*	pLast;
+};
+
+// Set of referencing addresses with a fixed maximum size
+// The first few references are stored inline, after that they move to an overflow block with a hash index.
+// When full the oldest references get overwritten in ring buffer fashion.
 class FItemReferenceTracker
 {
 public:
-	void Reset() 
+	static const int kMaxEntryCount = 32;
+	static const int kInlineCount = 4;
+
+	FItemReferenceTracker() = default;
+	FItemReferenceTracker(const FItemReferenceTracker& other) { *this = other; }
+	FItemReferenceTracker(FItemReferenceTracker&& other) noexcept { *this = std::move(other); }
+	~FItemReferenceTracker() { delete pOverflow; }
+
+	FItemReferenceTracker& operator=(const FItemReferenceTracker& other)
 	{
-		References.clear(); 
-		WriteCounter =0;	
+		if (this != &other)
+		{
+			Reset();
+			if (other.pOverflow != nullptr)
+				pOverflow = new FOverflow(*other.pOverflow);
+			memcpy(InlineRefs, other.InlineRefs, sizeof(InlineRefs));
+			Count = other.Count;
+			WriteCounter = other.WriteCounter;
+		}
+		return *this;
 	}
 
-	bool	HasReferenceTo(FAddressRef addrRef)
+	FItemReferenceTracker& operator=(FItemReferenceTracker&& other) noexcept
 	{
-		const auto size = References.size();
-		for (int i = 0; i < size; i++)
+		if (this != &other)
 		{
-			if (References[i] == addrRef)
-				return true;
+			Reset();
+			pOverflow = other.pOverflow;
+			memcpy(InlineRefs, other.InlineRefs, sizeof(InlineRefs));
+			Count = other.Count;
+			WriteCounter = other.WriteCounter;
+			other.pOverflow = nullptr;
+			other.Reset();
 		}
+		return *this;
+	}
 
-		return false;
+	void Reset() 
+	{
+		delete pOverflow;
+		pOverflow = nullptr;
+		Count = 0;
+		WriteCounter = 0;
+	}
+
+	bool	HasReferenceTo(FAddressRef addrRef) const
+	{
+		return FindReference(addrRef) != -1;
 	}
 
 	void	RegisterAccess(const FAddressRef& addrRef)
@@ -173,42 +242,223 @@ public:
 		if(HasReferenceTo(addrRef))	// already has reference
 			return;
 
-		if(WriteCounter < MaxEntryCount)
-			References.emplace_back(addrRef);
+		if (Count < kMaxEntryCount)
+		{
+			if (Count == kInlineCount)
+				MoveToOverflow();
+
+			GetData()[Count] = addrRef;
+			if (pOverflow != nullptr)
+				pOverflow->AddToIndex(addrRef, Count);
+			Count++;
+		}
 		else
-			References[WriteCounter % MaxEntryCount] = addrRef;
+		{
+			pOverflow->ReplaceReference(WriteCounter % kMaxEntryCount, addrRef);	// overwrite the oldest reference
+		}
 
 		WriteCounter++;
 	}
 
 	bool RemoveReference(const FAddressRef& addrRef)
 	{
-		for(auto it = References.begin();it!=References.end();++it)
+		const int index = FindReference(addrRef);
+		if (index == -1)
+			return false;
+
+		FAddressRef* pRefs = GetData();
+		for (int i = index; i < Count - 1; i++)
+			pRefs[i] = pRefs[i + 1];
+		Count--;
+
+		if (pOverflow != nullptr)
+			pOverflow->RebuildIndex(Count);
+		return true;
+	}
+
+	// Modify references in place e.g. when bank addresses change
+	template <typename FixupFunc>
+	void FixupReferences(FixupFunc fixup)
+	{
+		FAddressRef* pRefs = GetData();
+		for (int i = 0; i < Count; i++)
+			fixup(pRefs[i]);
+
+		if (pOverflow != nullptr)
+			pOverflow->RebuildIndex(Count);
+	}
+
+	bool IsEmpty() const { return Count == 0; }
+	int NumReferences() const { return Count; }
+	FAddressRefView GetReferences() const { return FAddressRefView(GetData(), GetData() + Count); }
+	const FAddressRef* begin() const { return GetData(); }
+	const FAddressRef* end() const { return GetData() + Count; }
+
+private:
+	static const int kIndexSize = 64;	// must be power of 2 and more than kMaxEntryCount
+
+	// heap storage for when there are more references than fit inline
+	struct FOverflow
+	{
+		FAddressRef	Refs[kMaxEntryCount];
+		uint8_t		Index[kIndexSize];	// open addressed hash of reference index + 1, 0 is empty
+
+		static uint32_t HashSlot(FAddressRef addrRef) { return (addrRef.Val * 0x9E3779B1u) >> 26; }	// top 6 bits
+
+		int		Find(FAddressRef addrRef) const
 		{
-			if(*it == addrRef)
+			for (uint32_t slot = HashSlot(addrRef); Index[slot] != 0; slot = (slot + 1) & (kIndexSize - 1))
 			{
-				References.erase(it);
-				return true;
+				if (Refs[Index[slot] - 1] == addrRef)
+					return Index[slot] - 1;
 			}
+			return -1;
 		}
 
-		return false;
+		void	AddToIndex(FAddressRef addrRef, int refIndex)
+		{
+			uint32_t slot = HashSlot(addrRef);
+			while (Index[slot] != 0)
+				slot = (slot + 1) & (kIndexSize - 1);
+			Index[slot] = (uint8_t)(refIndex + 1);
+		}
+
+		void	ReplaceReference(int refIndex, FAddressRef addrRef);	// out of line, keeps the RegisterAccess fast path tight
+
+		// backward shift deletion so probe chains stay unbroken without tombstones
+		void	RemoveFromIndex(FAddressRef addrRef)
+		{
+			uint32_t hole = HashSlot(addrRef);
+			while (Index[hole] != 0 && Refs[Index[hole] - 1] != addrRef)
+				hole = (hole + 1) & (kIndexSize - 1);
+			if (Index[hole] == 0)
+				return;
+
+			for (uint32_t slot = (hole + 1) & (kIndexSize - 1); Index[slot] != 0; slot = (slot + 1) & (kIndexSize - 1))
+			{
+				// an entry can fill the hole if the hole is between its home slot & where it is now
+				const uint32_t homeSlot = HashSlot(Refs[Index[slot] - 1]);
+				if (((slot - homeSlot) & (kIndexSize - 1)) >= ((slot - hole) & (kIndexSize - 1)))
+				{
+					Index[hole] = Index[slot];
+					hole = slot;
+				}
+			}
+			Index[hole] = 0;
+		}
+
+		void	RebuildIndex(int count)
+		{
+			memset(Index, 0, sizeof(Index));
+			for (int i = 0; i < count; i++)
+				AddToIndex(Refs[i], i);
+		}
+	};
+
+	const FAddressRef* GetData() const { return pOverflow != nullptr ? pOverflow->Refs : InlineRefs; }
+	FAddressRef* GetData() { return pOverflow != nullptr ? pOverflow->Refs : InlineRefs; }
+
+	int		FindReference(FAddressRef addrRef) const
+	{
+		if (pOverflow != nullptr)
+			return pOverflow->Find(addrRef);
+
+		for (int i = 0; i < Count; i++)
+		{
+			if (InlineRefs[i] == addrRef)
+				return i;
+		}
+		return -1;
+	}
+
+	void	MoveToOverflow()
+	{
+		pOverflow = new FOverflow;
+		memcpy(pOverflow->Refs, InlineRefs, Count * sizeof(FAddressRef));
+		pOverflow->RebuildIndex(Count);
+	}
+
+	FOverflow*	pOverflow = nullptr;
+	FAddressRef	InlineRefs[kInlineCount];
+	int16_t		Count = 0;
+	int			WriteCounter = 0;
+};
+
+
+// Owns a value that's only allocated once it's edited, most items never set it so it costs a pointer.
+// Copies are deep.
+template <typename T>
+class TSparseValue
+{
+public:
+	TSparseValue() = default;
+	TSparseValue(const TSparseValue& other) { *this = other; }
+	TSparseValue(TSparseValue&& other) noexcept { std::swap(pValue, other.pValue); }
+	~TSparseValue() { delete pValue; }
+
+	TSparseValue& operator=(const TSparseValue& other)
+	{
+		if (this != &other)
+		{
+			if (other.pValue == nullptr)
+				Reset();
+			else
+				Edit() = *other.pValue;
+		}
+		return *this;
 	}
-	bool IsEmpty() const { return References.empty(); }
-	int NumReferences() const { return (int)References.size(); }
-	const std::vector<FAddressRef>& GetReferences() const { return References; }
-	std::vector<FAddressRef>& GetReferences() { return References; }
+
+	TSparseValue& operator=(TSparseValue&& other) noexcept
+	{
+		std::swap(pValue, other.pValue);
+		return *this;
+	}
+
+	bool		IsSet() const { return pValue != nullptr; }
+	const T&	Get() const { return pValue != nullptr ? *pValue : GetDefault(); }
+	T&			Edit()
+	{
+		if (pValue == nullptr)
+			pValue = new T();
+		return *pValue;
+	}
+	void		Reset() { delete pValue; pValue = nullptr; }
+
 private:
-	int		MaxEntryCount = 32;
-	int		WriteCounter = 0;
-	std::vector<FAddressRef>	References;
+	static const T& GetDefault() { static const T defaultValue; return defaultValue; }
+
+	T*	pValue = nullptr;
 };
 
+// Item comment - only allocated for items that have one.
+// Has the read only std::string calls the analyser uses, use Edit() to get a modifiable string.
+class FItemComment : public TSparseValue<std::string>
+{
+public:
+	FItemComment& operator=(const std::string& text) { SetText(text.c_str()); return *this; }
+	FItemComment& operator=(const char* pText) { SetText(pText); return *this; }
+	FItemComment& operator+=(const std::string& text) { Edit() += text; return *this; }
+
+	operator const std::string& () const { return Get(); }
+	bool		empty() const { return Get().empty(); }
+	size_t		size() const { return Get().size(); }
+	const char*	c_str() const { return Get().c_str(); }
+	void		clear() { Reset(); }
+
+private:
+	void	SetText(const char* pText)
+	{
+		if (pText == nullptr || pText[0] == 0)
+			Reset();
+		else
+			Edit() = pText;
+	}
+};
 
 struct FItem
 {
 	EItemType		Type = EItemType::Unknown;
-	std::string		Comment;
+	FItemComment	Comment;
 	uint16_t		ByteSize = 0;
 };
 
@@ -217,26 +467,27 @@ struct FLabelInfo : FItem
 	static FLabelInfo* Allocate();
 	static FLabelInfo* Duplicate(const FLabelInfo* pSourceLabel);
 	static void FreeAll();
+	static FSlabAllocatorStats GetAllocationStats() { return Allocator.GetStats(); }
 
 	bool EnsureUniqueName(void)
 	{
-		auto labelIt = LabelUsage.find(Name);
+		auto labelIt = LabelUsage.find(Name.GetId());
 		if (labelIt == LabelUsage.end())
 		{
-			LabelUsage[Name] = 0;
+			LabelUsage[Name.GetId()] = 0;
 			return false;
 		}
 
 		char postFix[32];
-		snprintf(postFix, 32, "_%d", ++LabelUsage[Name]);
-		Name += std::string(postFix);
+		snprintf(postFix, 32, "_%d", ++labelIt->second);
+		Name = Name.GetString() + std::string(postFix);
 
 		return true;
 	}
 
-	bool RemoveLabelName(const std::string& labelName)
+	bool RemoveLabelName(FInternedString labelName)
 	{
-		auto labelIt = LabelUsage.find(labelName);
+		auto labelIt = LabelUsage.find(labelName.GetId());
 		//assert(labelIt != LabelUsage.end());	// shouldn't happen - it does though - investigate
 		if (labelIt == LabelUsage.end())
 			return false;
@@ -265,6 +516,7 @@ struct FLabelInfo : FItem
 		Edited = true;
 	}
 	const char*		GetName() const {return Name.c_str(); }
+	const std::string&	GetNameString() const { return Name.GetString(); }
 
 	bool					Global = false;
 	bool					Edited = false;	// has the name been changed since generation?
@@ -275,21 +527,41 @@ private:
 	FLabelInfo() { Type = EItemType::Label; }
 	~FLabelInfo() = default;
 
-	std::string				Name;
+	FInternedString			Name;
+
+	friend class TSlabAllocator<FLabelInfo>;
+	static TSlabAllocator<FLabelInfo>	Allocator;
+	static std::unordered_map<uint32_t, int>	LabelUsage;	// keyed on interned name id
 
-	static std::vector<FLabelInfo*>	AllocatedList;
-	static std::unordered_map<std::string, int>	LabelUsage;
+};
 
+// Predecoded instruction info so the per-instruction analysis doesn't need to decode every time it executes
+// Not serialised - it is rebuilt the first time an instruction is executed
+// Adds 16 bytes to every code info, keep it small
+struct FDecodedInstruction
+{
+	uint16_t	PC = 0;					// physical address it was decoded at
+	uint16_t	JumpAddress = 0;		// physical jump target
+	uint16_t	PointerAddress = 0;		// physical address of pointer operand
+	uint8_t		Bytes[4] = { 0 };		// instruction bytes when decoded, used to detect changes
+	uint8_t		ByteSize = 0;
+	bool		bValid = false;
+	bool		bHasJump = false;
+	bool		bHasPointerRef = false;
+	bool		bCheckWhenExecuted = true;	// needs the CPU specific execution handler when it's the current instruction
+	bool		bCheckWhenPrevious = true;	// needs the CPU specific execution handler when it's the previous instruction
 };
+static_assert(sizeof(FDecodedInstruction) <= 16, "FDecodedInstruction is stored on every code info");
 
 struct FCodeInfo : FItem
 {
 	static FCodeInfo* Allocate();
 	static void FreeAll();
+	static FSlabAllocatorStats GetAllocationStats() { return Allocator.GetStats(); }
 
 	EOperandType	OperandType = EOperandType::Unknown;
 	int				StructId = -1;
-	std::string		Text;				// Disassembly text
+	FInternedString	Text;				// Disassembly text - interned as most instructions share their text
 	FAddressRef		OperandAddress;	// optional operand address
 	int				FrameLastExecuted = -1;
 	int				ExecutionCount = 0;
@@ -302,6 +574,7 @@ struct FCodeInfo : FItem
 			bool			bSelfModifyingCode : 1;
 			bool			bUnused : 1;
 			bool			bIsCall : 1;
+			bool			bSMCCheckQueued : 1;	// in FCodeAnalysisState::DeferredSMCChecks, cleared at frame end
 		};
 		uint32_t	Flags = 0;
 	};
@@ -312,11 +585,14 @@ struct FCodeInfo : FItem
 	FItemReferenceTracker	Reads;	// addresses read by this instruction
 	FItemReferenceTracker	Writes;	// addresses written to by this function
 
+	FDecodedInstruction		Decoded;
+
 private:
 	FCodeInfo() :FItem() { Type = EItemType::Code; }
 	~FCodeInfo() = default;
 
-	static std::vector<FCodeInfo*>	AllocatedList;
+	friend class TSlabAllocator<FCodeInfo>;
+	static TSlabAllocator<FCodeInfo>	Allocator;
 };
 
 // struct for additional image data
@@ -347,14 +623,15 @@ struct FDataInfo : FItem
 		DataType = EDataType::Byte;
 		DisplayType = EDataItemDisplayType::Unknown;
 		Comment.clear();
-		ReadCount = 0;
-		LastFrameRead = -1;
-		Reads.Reset();
-		WriteCount = 0;
-		LastFrameWritten = -1;
-		Writes.Reset();
+		References.Reset();
 	}
 
+	const FItemReferenceTracker&	GetReads() const { return References.Get().Reads; }
+	const FItemReferenceTracker&	GetWrites() const { return References.Get().Writes; }
+	FItemReferenceTracker&			EditReads() { return References.Edit().Reads; }
+	FItemReferenceTracker&			EditWrites() { return References.Edit().Writes; }
+	bool							HasReferences() const { return References.IsSet(); }
+
 	EDataType				DataType = EDataType::Byte;
 	EDataItemDisplayType	DisplayType = EDataItemDisplayType::Unknown;
 
@@ -395,16 +672,14 @@ struct FDataInfo : FItem
 		int			SubTypeId;
 	};
 
-	// Reads
-	int						ReadCount = 0;
-	int						LastFrameRead = -1;
-	FItemReferenceTracker	Reads;	// address and counts of data access instructions
-
-	// Writes
-	int						WriteCount = 0;
-	int						LastFrameWritten = -1;
-	FItemReferenceTracker	Writes;	// address and counts of data access instructions
-	FAddressRef				LastWriter;
+	// Read/write counts, last frame accessed & last writer live in FCodeAnalysisPage arrays
+	// The reference trackers are only allocated for data that has been accessed
+	struct FReferences
+	{
+		FItemReferenceTracker	Reads;	// address and counts of data access instructions
+		FItemReferenceTracker	Writes;	// address and counts of data access instructions
+	};
+	TSparseValue<FReferences>	References;
 };
 
 struct FCommentBlock : FItem
@@ -412,11 +687,14 @@ struct FCommentBlock : FItem
 	static FCommentBlock* Allocate();
 	static FCommentBlock* Duplicate(const FCommentBlock* pSourceCommentBlock);
 	static void FreeAll();
+	static FSlabAllocatorStats GetAllocationStats() { return Allocator.GetStats(); }
 
 private:
 	FCommentBlock() : FItem() { Type = EItemType::CommentBlock; }
 	~FCommentBlock() = default;
-	static std::vector<FCommentBlock*>	AllocatedList;
+
+	friend class TSlabAllocator<FCommentBlock>;
+	static TSlabAllocator<FCommentBlock>	Allocator;
 };
 
 struct FCommentLine : FItem
@@ -442,6 +720,17 @@ struct FCommentLine : FItem
 
 				AllocatedList.clear();
 			}
+			void Free(FCommentLine* pLine)
+			{
+				auto it = std::find(AllocatedList.begin(), AllocatedList.end(), pLine);
+				if (it == AllocatedList.end())
+					return;
+
+				*it = AllocatedList.back();
+				AllocatedList.pop_back();
+				FreeList.push_back(pLine);
+			}
+			size_t GetNoAllocated() const { return AllocatedList.size(); }
 		private:
 			std::vector<FCommentLine*>	AllocatedList;
 			std::vector<FCommentLine*>	FreeList;
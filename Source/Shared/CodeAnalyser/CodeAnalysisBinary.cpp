@@ -0,0 +1,913 @@
+#include "CodeAnalysisBinary.h"
+#include "CodeAnalyser.h"
+#include "CodeAnalysisJson.h"
+#include "CodeAnalysisPage.h"
+#include "DataTypes.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Util/GraphicsView.h"
+#include "Util/FileUtil.h"
+#include "Util/MemoryBuffer.h"
+#include "Debug/DebugLog.h"
+#include <zlib.h>
+#include <json.hpp>
+using json = nlohmann::json;
+
+// File layout
+//
+// Header:	Magic, Version, Flags (all uint32)
+// Chunks:	Id (FourCC), Flags, RawSize, StoredSize (all uint32) followed by StoredSize bytes
+//			chunk data is zlib compressed when the compressed flag is set
+//			unknown chunks are skipped so newer versions can add them
+//
+// BANK:	one per saved bank, self contained so it can be written & read on its own
+//			Id, Description, NoPages, string table then columns of each item type
+//			addresses are bank relative & delta encoded, integers are varints
+// MISC:	palettes & data types as compact json - these are small
+// CSET:	character sets
+// CMAP:	character maps
+// END :	terminator
+
+void FixupPostLoad(FCodeAnalysisState& state);	// CodeAnalysisJson.cpp
+
+constexpr uint32_t MakeChunkId(char a, char b, char c, char d)
+{
+	return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+const uint32_t kAnalysisBinaryMagic = MakeChunkId('A', 'B', 'I', 'N');
+const uint32_t kAnalysisBinaryVersion = 1;
+const uint32_t kCompressedFlag = 1;
+
+const uint32_t kBankChunkId = MakeChunkId('B', 'A', 'N', 'K');
+const uint32_t kMiscChunkId = MakeChunkId('M', 'I', 'S', 'C');
+const uint32_t kCharacterSetChunkId = MakeChunkId('C', 'S', 'E', 'T');
+const uint32_t kCharacterMapChunkId = MakeChunkId('C', 'M', 'A', 'P');
+const uint32_t kEndChunkId = MakeChunkId('E', 'N', 'D', ' ');
+
+const size_t kMinCompressSize = 64;	// not worth compressing below this
+const uint64_t kMaxCompressionRatio = 1032;	// deflate can't do better than this
+
+// Low level helpers
+
+void WriteBinaryString(FMemoryBuffer& buffer, const std::string& str)
+{
+	buffer.WriteVarInt((uint32_t)str.size());
+	buffer.WriteBytes(str.c_str(), str.size());
+}
+
+// Read a count of items that follow - every item takes at least a byte so a count larger than
+// the rest of the buffer means the data is corrupt, check before anything gets sized from it
+bool ReadItemCount(FMemoryBuffer& buffer, uint32_t& outCount)
+{
+	outCount = buffer.ReadVarInt();
+	if (outCount > buffer.GetBytesRemaining())
+	{
+		LOGERROR("Analysis binary: count of %u is more than the %u bytes left", outCount, (uint32_t)buffer.GetBytesRemaining());
+		outCount = 0;
+		return false;
+	}
+	return true;
+}
+
+std::string ReadBinaryString(FMemoryBuffer& buffer)
+{
+	uint32_t length = 0;
+	std::string str;
+	if (ReadItemCount(buffer, length) && length > 0)
+	{
+		str.resize(length);
+		buffer.ReadBytes(&str[0], length);
+	}
+	return str;
+}
+
+void WriteAddressRef(FMemoryBuffer& buffer, FAddressRef addressRef)
+{
+	buffer.WriteSignedVarInt(addressRef.BankId);
+	buffer.WriteVarInt(addressRef.Address);
+}
+
+FAddressRef ReadAddressRef(FMemoryBuffer& buffer)
+{
+	const int16_t bankId = (int16_t)buffer.ReadSignedVarInt();
+	const uint16_t address = (uint16_t)buffer.ReadVarInt();
+	return FAddressRef(bankId, address);
+}
+
+bool WriteChunk(FILE* fp, uint32_t chunkId, const FMemoryBuffer& chunkData, bool bCompress)
+{
+	const uint32_t rawSize = (uint32_t)chunkData.GetSize();
+	uint32_t storedSize = rawSize;
+	uint32_t flags = 0;
+	const void* pStoredData = chunkData.GetData();
+	std::vector<uint8_t> compressedData;
+
+	if (bCompress && rawSize >= kMinCompressSize)
+	{
+		uLongf compressedSize = compressBound(rawSize);
+		compressedData.resize(compressedSize);
+		if (compress2(compressedData.data(), &compressedSize, (const Bytef*)chunkData.GetData(), rawSize, Z_BEST_SPEED) == Z_OK && compressedSize < rawSize)
+		{
+			storedSize = (uint32_t)compressedSize;
+			flags |= kCompressedFlag;
+			pStoredData = compressedData.data();
+		}
+	}
+
+	const uint32_t header[4] = { chunkId, flags, rawSize, storedSize };
+	if (fwrite(header, sizeof(header), 1, fp) != 1)
+		return false;
+	if (storedSize > 0 && fwrite(pStoredData, storedSize, 1, fp) != 1)
+		return false;
+	return true;
+}
+
+// read the next chunk, returns false at end of file or on error
+// sizes are checked against what's left of the file before any buffers are sized from them
+bool ReadChunk(FILE* fp, size_t fileSize, uint32_t& chunkId, FMemoryBuffer& chunkData)
+{
+	uint32_t header[4];
+	if (fread(header, sizeof(header), 1, fp) != 1)
+		return false;
+
+	chunkId = header[0];
+	const uint32_t flags = header[1];
+	const uint32_t rawSize = header[2];
+	const uint32_t storedSize = header[3];
+
+	const long filePos = ftell(fp);
+	if (filePos < 0 || storedSize > fileSize - (size_t)filePos)
+	{
+		LOGERROR("Analysis binary: chunk size of %u is more than the rest of the file", storedSize);
+		return false;
+	}
+	const uint64_t maxRawSize = (flags & kCompressedFlag) ? (uint64_t)storedSize * kMaxCompressionRatio : storedSize;
+	if (rawSize > maxRawSize)
+	{
+		LOGERROR("Analysis binary: chunk raw size of %u doesn't match stored size of %u", rawSize, storedSize);
+		return false;
+	}
+
+	std::vector<uint8_t> storedData(storedSize);
+	if (storedSize > 0 && fread(storedData.data(), storedSize, 1, fp) != 1)
+	{
+		LOGERROR("Analysis binary: chunk truncated");
+		return false;
+	}
+
+	if (flags & kCompressedFlag)
+	{
+		std::vector<uint8_t> rawData(rawSize);
+		uLongf uncompressedSize = rawSize;
+		if (uncompress(rawData.data(), &uncompressedSize, storedData.data(), storedSize) != Z_OK || uncompressedSize != rawSize)
+		{
+			LOGERROR("Analysis binary: failed to decompress chunk");
+			return false;
+		}
+		chunkData.Init(rawData.data(), rawSize);
+	}
+	else
+	{
+		chunkData.Init(storedData.data(), storedSize);
+	}
+
+	return true;
+}
+
+// String table - index 0 is reserved for the empty string as most comments are empty
+class FStringTableWriter
+{
+public:
+	uint32_t	Add(const std::string& str)
+	{
+		if (str.empty())
+			return 0;
+
+		auto it = Lookup.find(str);
+		if (it != Lookup.end())
+			return it->second;
+
+		Strings.push_back(str);
+		const uint32_t index = (uint32_t)Strings.size();
+		Lookup[str] = index;
+		return index;
+	}
+
+	void	Write(FMemoryBuffer& buffer) const
+	{
+		buffer.WriteVarInt((uint32_t)Strings.size());
+		for (const std::string& str : Strings)
+			WriteBinaryString(buffer, str);
+	}
+
+private:
+	std::vector<std::string>					Strings;
+	std::unordered_map<std::string, uint32_t>	Lookup;
+};
+
+class FStringTableReader
+{
+public:
+	bool	Read(FMemoryBuffer& buffer)
+	{
+		uint32_t noStrings = 0;
+		if (ReadItemCount(buffer, noStrings) == false)
+			return false;
+		Strings.resize(noStrings);
+		for (uint32_t stringNo = 0; stringNo < noStrings; stringNo++)
+			Strings[stringNo] = ReadBinaryString(buffer);
+		return true;
+	}
+
+	const std::string&	Get(uint32_t index) const
+	{
+		static const std::string emptyString;
+		if (index == 0 || index > Strings.size())
+			return emptyString;
+		return Strings[index - 1];
+	}
+
+private:
+	std::vector<std::string>	Strings;
+};
+
+// Banks
+
+template <class T>
+using FBankItemList = std::vector<std::pair<uint32_t, const T*>>;	// bank offset, item
+
+struct FBankItems
+{
+	FBankItemList<FCommentBlock>	CommentBlocks;
+	FBankItemList<FLabelInfo>		Labels;
+	FBankItemList<FCodeInfo>		CodeInfo;
+	FBankItemList<FDataInfo>		DataInfo;
+};
+
+// data infos are only saved if they deviate from the normal, same rules as the json
+bool IsDataInfoDefault(const FDataInfo& dataInfo)
+{
+	return dataInfo.DataType == EDataType::Byte &&
+		dataInfo.DisplayType == EDataItemDisplayType::Unknown &&
+		dataInfo.ByteSize == 1 &&
+		dataInfo.Flags == 0 &&
+		dataInfo.Comment.empty() &&
+		dataInfo.PaletteNo == -1 &&
+		dataInfo.StructByteOffset == 0;
+}
+
+bool DataInfoHasAddressRef(const FDataInfo& dataInfo)
+{
+	return dataInfo.DataType == EDataType::InstructionOperand || dataInfo.DataType == EDataType::CharacterMap || dataInfo.DataType == EDataType::Bitmap;
+}
+
+// walk the pages the same way WritePageToJson does
+void GatherBankItems(const FCodeAnalysisBank& bank, FBankItems& items)
+{
+	for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
+	{
+		const FCodeAnalysisPage& page = bank.Pages[pageNo];
+		const uint32_t pageOffset = pageNo * FCodeAnalysisPage::kPageSize;
+		int pageAddr = 0;
+
+		while (pageAddr < FCodeAnalysisPage::kPageSize)
+		{
+			const uint32_t bankOffset = pageOffset + pageAddr;
+
+			const FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
+			if (pCommentBlock != nullptr && pCommentBlock->Comment.empty() == false)
+				items.CommentBlocks.push_back({ bankOffset, pCommentBlock });
+
+			const FLabelInfo* pLabelInfo = page.Labels[pageAddr];
+			if (pLabelInfo != nullptr)
+				items.Labels.push_back({ bankOffset, pLabelInfo });
+
+			const FCodeInfo* pCodeInfoItem = page.CodeInfo[pageAddr];
+			if (pCodeInfoItem != nullptr)
+			{
+				items.CodeInfo.push_back({ bankOffset, pCodeInfoItem });
+				if (pCodeInfoItem->bSelfModifyingCode == false)
+					pageAddr += pCodeInfoItem->ByteSize > 0 ? pCodeInfoItem->ByteSize : 1;
+			}
+
+			// we do want data info for SMC operands
+			if (pCodeInfoItem == nullptr || pCodeInfoItem->bSelfModifyingCode == true)
+			{
+				const FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
+				if (IsDataInfoDefault(*pDataInfo) == false)
+					items.DataInfo.push_back({ bankOffset, pDataInfo });
+				pageAddr += pDataInfo->ByteSize > 0 ? pDataInfo->ByteSize : 1;
+			}
+		}
+	}
+}
+
+template <class T>
+void WriteAddressColumn(FMemoryBuffer& buffer, const FBankItemList<T>& itemList)
+{
+	buffer.WriteVarInt((uint32_t)itemList.size());
+	uint32_t lastOffset = 0;
+	for (const auto& item : itemList)
+	{
+		buffer.WriteVarInt(item.first - lastOffset);
+		lastOffset = item.first;
+	}
+}
+
+bool ReadAddressColumn(FMemoryBuffer& buffer, std::vector<uint32_t>& outOffsets)
+{
+	uint32_t noItems = 0;
+	if (ReadItemCount(buffer, noItems) == false)
+		return false;
+
+	outOffsets.resize(noItems);
+	uint32_t offset = 0;
+	for (uint32_t& itemOffset : outOffsets)
+	{
+		offset += buffer.ReadVarInt();
+		itemOffset = offset;
+	}
+	return true;
+}
+
+void WriteBankChunkData(const FCodeAnalysisBank& bank, FMemoryBuffer& chunkData)
+{
+	FBankItems items;
+	GatherBankItems(bank, items);
+
+	// columns are written first so the string table can be built as we go
+	FStringTableWriter stringTable;
+	FMemoryBuffer columns;
+	columns.Init(64 * 1024);
+
+	WriteAddressColumn(columns, items.CommentBlocks);
+	for (const auto& item : items.CommentBlocks)
+		columns.WriteVarInt(stringTable.Add(item.second->Comment));
+
+	WriteAddressColumn(columns, items.Labels);
+	for (const auto& item : items.Labels)
+		columns.WriteVarInt(stringTable.Add(item.second->GetName()));
+	for (const auto& item : items.Labels)
+		columns.WriteVarInt(((uint32_t)item.second->LabelType << 1) | (item.second->Global ? 1 : 0));
+	for (const auto& item : items.Labels)
+		columns.WriteVarInt(stringTable.Add(item.second->Comment));
+
+	WriteAddressColumn(columns, items.CodeInfo);
+	for (const auto& item : items.CodeInfo)
+		columns.WriteVarInt(item.second->ByteSize);
+	for (const auto& item : items.CodeInfo)
+		columns.WriteVarInt(item.second->Flags);
+	for (const auto& item : items.CodeInfo)
+		columns.WriteVarInt((uint32_t)item.second->OperandType);
+	for (const auto& item : items.CodeInfo)
+		columns.WriteSignedVarInt(item.second->StructId);
+	for (const auto& item : items.CodeInfo)
+		columns.WriteVarInt(stringTable.Add(item.second->Comment));
+
+	WriteAddressColumn(columns, items.DataInfo);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt((uint32_t)item.second->DataType);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt((uint32_t)item.second->DisplayType);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt(item.second->ByteSize);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt(item.second->Flags);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt(stringTable.Add(item.second->Comment));
+	for (const auto& item : items.DataInfo)
+		columns.WriteSignedVarInt(item.second->PaletteNo);
+	for (const auto& item : items.DataInfo)
+		columns.WriteVarInt(item.second->StructByteOffset);	// shared with EmptyCharNo
+	for (const auto& item : items.DataInfo)
+	{
+		if (DataInfoHasAddressRef(*item.second))
+			WriteAddressRef(columns, item.second->InstructionAddress);	// shared with CharSetAddress & GraphicsSetRef
+	}
+
+	chunkData.WriteVarInt((uint32_t)bank.Id);
+	WriteBinaryString(chunkData, bank.Description);
+	chunkData.WriteVarInt((uint32_t)bank.NoPages);
+	stringTable.Write(chunkData);
+	chunkData.WriteBytes(columns.GetData(), columns.GetSize());
+}
+
+// Bank contents, parsed in full before anything is added to the analysis
+struct FLoadedLabel
+{
+	uint32_t	Offset = 0;
+	std::string	Name;
+	std::string	Comment;
+	bool		bGlobal = false;
+	ELabelType	LabelType = ELabelType::Data;
+};
+
+struct FLoadedCodeInfo
+{
+	uint32_t	Offset = 0;
+	uint16_t	ByteSize = 0;
+	uint32_t	Flags = 0;
+	EOperandType	OperandType = EOperandType::Unknown;
+	int			StructId = -1;
+	std::string	Comment;
+};
+
+struct FLoadedBank
+{
+	int16_t		BankId = -1;
+	std::string	Description;
+	int			NoPages = 0;
+	std::vector<std::pair<uint32_t, std::string>>	CommentBlocks;
+	std::vector<FLoadedLabel>		Labels;
+	std::vector<FLoadedCodeInfo>	CodeInfos;
+	std::vector<uint32_t>			DataInfoOffsets;
+	std::vector<FDataInfo>			DataInfos;
+};
+
+bool ParseBankChunkData(FMemoryBuffer& chunkData, FLoadedBank& bank)
+{
+	bank.BankId = (int16_t)chunkData.ReadVarInt();
+	bank.Description = ReadBinaryString(chunkData);
+	bank.NoPages = (int)chunkData.ReadVarInt();
+
+	FStringTableReader stringTable;
+	if (stringTable.Read(chunkData) == false)
+		return false;
+
+	// Comment blocks
+	std::vector<uint32_t> commentBlockOffsets;
+	if (ReadAddressColumn(chunkData, commentBlockOffsets) == false)
+		return false;
+	for (const uint32_t offset : commentBlockOffsets)
+		bank.CommentBlocks.push_back({ offset, stringTable.Get(chunkData.ReadVarInt()) });
+
+	// Labels
+	std::vector<uint32_t> labelOffsets;
+	if (ReadAddressColumn(chunkData, labelOffsets) == false)
+		return false;
+	bank.Labels.resize(labelOffsets.size());
+	for (size_t labelNo = 0; labelNo < labelOffsets.size(); labelNo++)
+	{
+		bank.Labels[labelNo].Offset = labelOffsets[labelNo];
+		bank.Labels[labelNo].Name = stringTable.Get(chunkData.ReadVarInt());
+	}
+	for (FLoadedLabel& label : bank.Labels)
+	{
+		const uint32_t labelFlags = chunkData.ReadVarInt();
+		label.bGlobal = (labelFlags & 1) != 0;
+		label.LabelType = (ELabelType)(labelFlags >> 1);
+	}
+	for (FLoadedLabel& label : bank.Labels)
+		label.Comment = stringTable.Get(chunkData.ReadVarInt());
+
+	// Code
+	std::vector<uint32_t> codeInfoOffsets;
+	if (ReadAddressColumn(chunkData, codeInfoOffsets) == false)
+		return false;
+	bank.CodeInfos.resize(codeInfoOffsets.size());
+	for (size_t codeInfoNo = 0; codeInfoNo < codeInfoOffsets.size(); codeInfoNo++)
+	{
+		bank.CodeInfos[codeInfoNo].Offset = codeInfoOffsets[codeInfoNo];
+		bank.CodeInfos[codeInfoNo].ByteSize = (uint16_t)chunkData.ReadVarInt();
+	}
+	for (FLoadedCodeInfo& codeInfo : bank.CodeInfos)
+		codeInfo.Flags = chunkData.ReadVarInt();
+	for (FLoadedCodeInfo& codeInfo : bank.CodeInfos)
+		codeInfo.OperandType = (EOperandType)chunkData.ReadVarInt();
+	for (FLoadedCodeInfo& codeInfo : bank.CodeInfos)
+		codeInfo.StructId = chunkData.ReadSignedVarInt();
+	for (FLoadedCodeInfo& codeInfo : bank.CodeInfos)
+		codeInfo.Comment = stringTable.Get(chunkData.ReadVarInt());
+
+	// Data
+	if (ReadAddressColumn(chunkData, bank.DataInfoOffsets) == false)
+		return false;
+	bank.DataInfos.resize(bank.DataInfoOffsets.size());
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.DataType = (EDataType)chunkData.ReadVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.DisplayType = (EDataItemDisplayType)chunkData.ReadVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.ByteSize = (uint16_t)chunkData.ReadVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.Flags = chunkData.ReadVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.Comment = stringTable.Get(chunkData.ReadVarInt());
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.PaletteNo = chunkData.ReadSignedVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+		dataInfo.StructByteOffset = (uint8_t)chunkData.ReadVarInt();
+	for (FDataInfo& dataInfo : bank.DataInfos)
+	{
+		if (DataInfoHasAddressRef(dataInfo))
+			dataInfo.InstructionAddress = ReadAddressRef(chunkData);
+	}
+
+	if (chunkData.HasReadOverrun())
+	{
+		LOGERROR("Analysis binary: bank %d chunk is truncated", bank.BankId);
+		return false;
+	}
+	return true;
+}
+
+void ApplyLoadedBank(FCodeAnalysisState& state, const FLoadedBank& loadedBank)
+{
+	FCodeAnalysisBank* pBank = state.GetBank(loadedBank.BankId);
+	if (pBank == nullptr)
+	{
+		LOGWARNING("Analysis binary: bank %d not found, skipping", loadedBank.BankId);
+		return;
+	}
+
+	pBank->Description = loadedBank.Description;
+	FCodeAnalysisPage* pPages = state.GetBankPagesForWrite(*pBank);
+	for (int pageNo = 0; pageNo < loadedBank.NoPages && pageNo < pBank->NoPages; pageNo++)
+		pPages[pageNo].bUsed = true;
+
+	// out of range items are skipped
+	const uint32_t bankSize = pBank->NoPages * FCodeAnalysisPage::kPageSize;
+	auto getPage = [pPages](uint32_t offset) -> FCodeAnalysisPage& { return pPages[offset / FCodeAnalysisPage::kPageSize]; };
+	auto getPageAddr = [](uint32_t offset) { return offset % FCodeAnalysisPage::kPageSize; };
+
+	for (const auto& commentBlock : loadedBank.CommentBlocks)
+	{
+		if (commentBlock.first >= bankSize)
+			continue;
+		FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
+		pCommentBlock->Comment = commentBlock.second;
+		getPage(commentBlock.first).CommentBlocks[getPageAddr(commentBlock.first)] = pCommentBlock;
+	}
+
+	for (const FLoadedLabel& label : loadedBank.Labels)
+	{
+		if (label.Offset >= bankSize)
+			continue;
+		FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
+		pLabelInfo->InitialiseName(label.Name.c_str());
+		pLabelInfo->Global = label.bGlobal;
+		pLabelInfo->LabelType = label.LabelType;
+		pLabelInfo->Comment = label.Comment;
+		getPage(label.Offset).Labels[getPageAddr(label.Offset)] = pLabelInfo;
+	}
+
+	for (const FLoadedCodeInfo& codeInfo : loadedBank.CodeInfos)
+	{
+		if (codeInfo.Offset >= bankSize)
+			continue;
+		FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
+		pCodeInfo->ByteSize = codeInfo.ByteSize;
+		pCodeInfo->Flags = codeInfo.Flags;
+		pCodeInfo->OperandType = codeInfo.OperandType;
+		pCodeInfo->StructId = codeInfo.StructId;
+		pCodeInfo->Comment = codeInfo.Comment;
+		getPage(codeInfo.Offset).CodeInfo[getPageAddr(codeInfo.Offset)] = pCodeInfo;
+	}
+
+	for (size_t dataInfoNo = 0; dataInfoNo < loadedBank.DataInfos.size(); dataInfoNo++)
+	{
+		const uint32_t offset = loadedBank.DataInfoOffsets[dataInfoNo];
+		if (offset >= bankSize)
+			continue;
+
+		const FDataInfo& loadedInfo = loadedBank.DataInfos[dataInfoNo];
+		FDataInfo& dataInfo = getPage(offset).DataInfo[getPageAddr(offset)];
+		dataInfo.DataType = loadedInfo.DataType;
+		dataInfo.DisplayType = loadedInfo.DisplayType;
+		dataInfo.ByteSize = loadedInfo.ByteSize;
+		dataInfo.Flags = loadedInfo.Flags;
+		dataInfo.Comment = loadedInfo.Comment;
+		dataInfo.PaletteNo = loadedInfo.PaletteNo;
+		dataInfo.StructByteOffset = loadedInfo.StructByteOffset;
+		if (DataInfoHasAddressRef(loadedInfo))
+			dataInfo.InstructionAddress = loadedInfo.InstructionAddress;
+	}
+}
+
+// Character sets & maps
+
+void WriteCharacterSetChunkData(FMemoryBuffer& chunkData)
+{
+	chunkData.WriteVarInt((uint32_t)GetNoCharacterSets());
+	for (int i = 0; i < GetNoCharacterSets(); i++)
+	{
+		const FCharSetCreateParams& params = GetCharacterSetFromIndex(i)->Params;
+		WriteAddressRef(chunkData, params.Address);
+		WriteAddressRef(chunkData, params.AttribsAddress);
+		chunkData.WriteVarInt((uint32_t)params.MaskInfo);
+		chunkData.WriteVarInt((uint32_t)params.ColourInfo);
+		chunkData.WriteVarInt(params.bDynamic ? 1 : 0);
+		chunkData.WriteVarInt((uint32_t)params.BitmapFormat);
+		chunkData.WriteSignedVarInt(params.PaletteNo);
+	}
+}
+
+bool ParseCharacterSetChunkData(FMemoryBuffer& chunkData, std::vector<FCharSetCreateParams>& outCharacterSets)
+{
+	uint32_t noCharacterSets = 0;
+	if (ReadItemCount(chunkData, noCharacterSets) == false)
+		return false;
+	outCharacterSets.resize(noCharacterSets);
+	for (FCharSetCreateParams& params : outCharacterSets)
+	{
+		params.Address = ReadAddressRef(chunkData);
+		params.AttribsAddress = ReadAddressRef(chunkData);
+		params.MaskInfo = (EMaskInfo)chunkData.ReadVarInt();
+		params.ColourInfo = (EColourInfo)chunkData.ReadVarInt();
+		params.bDynamic = chunkData.ReadVarInt() != 0;
+		params.BitmapFormat = (EBitmapFormat)chunkData.ReadVarInt();
+		params.PaletteNo = chunkData.ReadSignedVarInt();
+	}
+	return chunkData.HasReadOverrun() == false;
+}
+
+void WriteCharacterMapChunkData(FMemoryBuffer& chunkData)
+{
+	chunkData.WriteVarInt((uint32_t)GetNoCharacterMaps());
+	for (int i = 0; i < GetNoCharacterMaps(); i++)
+	{
+		const FCharMapCreateParams& params = GetCharacterMapFromIndex(i)->Params;
+		WriteAddressRef(chunkData, params.Address);
+		chunkData.WriteVarInt(params.Width);
+		chunkData.WriteVarInt(params.Height);
+		chunkData.WriteVarInt(params.Stride);
+		WriteAddressRef(chunkData, params.CharacterSet);
+		chunkData.WriteVarInt(params.IgnoreCharacter);
+	}
+}
+
+bool ParseCharacterMapChunkData(FMemoryBuffer& chunkData, std::vector<FCharMapCreateParams>& outCharacterMaps)
+{
+	uint32_t noCharacterMaps = 0;
+	if (ReadItemCount(chunkData, noCharacterMaps) == false)
+		return false;
+	outCharacterMaps.resize(noCharacterMaps);
+	for (FCharMapCreateParams& params : outCharacterMaps)
+	{
+		params.Address = ReadAddressRef(chunkData);
+		params.Width = (int)chunkData.ReadVarInt();
+		params.Height = (int)chunkData.ReadVarInt();
+		params.Stride = (int)chunkData.ReadVarInt();
+		params.CharacterSet = ReadAddressRef(chunkData);
+		params.IgnoreCharacter = (uint8_t)chunkData.ReadVarInt();
+	}
+	return chunkData.HasReadOverrun() == false;
+}
+
+// Palettes & data types are small so they stay as json
+
+void WriteMiscChunkData(FCodeAnalysisState& state, FMemoryBuffer& chunkData)
+{
+	json miscJson;
+	SavePalettesToJson(miscJson);
+
+	const FDataTypes* pDataTypes = state.GetDataTypes();
+	if (pDataTypes != nullptr)
+	{
+		json dataTypesJson;
+		pDataTypes->WriteToJson(dataTypesJson);
+		miscJson["DataTypes"] = dataTypesJson;
+	}
+
+	WriteBinaryString(chunkData, miscJson.dump());
+}
+
+bool ParseMiscChunkData(FMemoryBuffer& chunkData, json& outMiscJson)
+{
+	outMiscJson = json::parse(ReadBinaryString(chunkData), nullptr, false);
+	if (outMiscJson.is_discarded())
+	{
+		LOGERROR("Analysis binary: could not parse misc chunk");
+		return false;
+	}
+	return true;
+}
+
+void ApplyMiscJson(FCodeAnalysisState& state, const json& miscJson)
+{
+	LoadPalettesFromJson(miscJson);
+
+	FDataTypes* pDataTypes = state.GetDataTypes();
+	if (pDataTypes != nullptr && miscJson.contains("DataTypes"))
+		pDataTypes->ReadFromJson(miscJson["DataTypes"]);
+}
+
+// Export
+// The analysis is first gathered into uncompressed chunks, this is quick & the snapshot owns all its
+// data so it can be compressed & written out on another thread while the analysis carries on changing
+
+void AddSnapshotChunk(FAnalysisBinarySnapshot& snapshot, uint32_t chunkId, FMemoryBuffer&& chunkData)
+{
+	FAnalysisBinaryChunk chunk;
+	chunk.Id = chunkId;
+	chunk.Data = std::move(chunkData);
+	snapshot.Chunks.push_back(std::move(chunk));
+}
+
+void BuildAnalysisBinarySnapshot(FCodeAnalysisState& state, FAnalysisBinarySnapshot& snapshot)
+{
+	snapshot.Chunks.clear();
+
+	const auto& banks = state.GetBanks();
+	for (int bankNo = 0; bankNo < banks.size(); bankNo++)
+	{
+		const FCodeAnalysisBank& bank = banks[bankNo];
+		if (bank.bMachineROM || bank.Pages == nullptr)	// skip machine ROM & unallocated banks
+			continue;
+
+		FMemoryBuffer chunkData;
+		chunkData.Init(64 * 1024);
+		WriteBankChunkData(bank, chunkData);
+		AddSnapshotChunk(snapshot, kBankChunkId, std::move(chunkData));
+	}
+
+	// palettes go before character sets as they may be needed to create them
+	FMemoryBuffer miscData;
+	miscData.Init();
+	WriteMiscChunkData(state, miscData);
+	AddSnapshotChunk(snapshot, kMiscChunkId, std::move(miscData));
+
+	FMemoryBuffer characterSetData;
+	characterSetData.Init();
+	WriteCharacterSetChunkData(characterSetData);
+	AddSnapshotChunk(snapshot, kCharacterSetChunkId, std::move(characterSetData));
+
+	FMemoryBuffer characterMapData;
+	characterMapData.Init();
+	WriteCharacterMapChunkData(characterMapData);
+	AddSnapshotChunk(snapshot, kCharacterMapChunkId, std::move(characterMapData));
+}
+
+bool WriteAnalysisBinarySnapshot(const FAnalysisBinarySnapshot& snapshot, FILE* fp, bool bCompress)
+{
+	const uint32_t header[3] = { kAnalysisBinaryMagic, kAnalysisBinaryVersion, bCompress ? kCompressedFlag : 0 };
+	bool bSuccess = fwrite(header, sizeof(header), 1, fp) == 1;
+
+	for (size_t chunkNo = 0; bSuccess && chunkNo < snapshot.Chunks.size(); chunkNo++)
+		bSuccess = WriteChunk(fp, snapshot.Chunks[chunkNo].Id, snapshot.Chunks[chunkNo].Data, bCompress);
+
+	if (bSuccess)
+	{
+		FMemoryBuffer endData;
+		endData.Init();
+		bSuccess = WriteChunk(fp, kEndChunkId, endData, false);
+	}
+
+	return bSuccess;
+}
+
+bool ExportAnalysisBinary(FCodeAnalysisState& state, const char* pFileName, bool bCompress)
+{
+	FAnalysisBinarySnapshot snapshot;
+	BuildAnalysisBinarySnapshot(state, snapshot);
+
+	FILE* fp = fopen(pFileName, "wb");
+	if (fp == nullptr)
+	{
+		LOGERROR("Could not open '%s' for writing", pFileName);
+		return false;
+	}
+
+	const bool bSuccess = WriteAnalysisBinarySnapshot(snapshot, fp, bCompress);
+	fclose(fp);
+
+	if (bSuccess == false)
+		LOGERROR("Error writing analysis to '%s'", pFileName);
+	return bSuccess;
+}
+
+// Everything in the file, parsed & checked before any of it is applied
+struct FLoadedAnalysisBinary
+{
+	std::vector<FLoadedBank>			Banks;
+	std::vector<json>					MiscJson;
+	std::vector<FCharSetCreateParams>	CharacterSets;
+	std::vector<FCharMapCreateParams>	CharacterMaps;
+};
+
+// Import
+// The whole file is read & parsed first so a corrupt or truncated file leaves the analysis untouched
+
+static bool LoadAnalysisBinary(const char* pFileName, FLoadedAnalysisBinary& loaded)
+{
+	FILE* fp = fopen(pFileName, "rb");
+	if (fp == nullptr)
+		return false;
+
+	fseek(fp, 0, SEEK_END);
+	const long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	uint32_t header[3];
+	if (fileSize < 0 || fread(header, sizeof(header), 1, fp) != 1 || header[0] != kAnalysisBinaryMagic)
+	{
+		LOGERROR("'%s' is not an analysis binary file", pFileName);
+		fclose(fp);
+		return false;
+	}
+
+	if (header[1] > kAnalysisBinaryVersion)
+	{
+		LOGERROR("'%s' is version %d, only version %d or lower is supported", pFileName, header[1], kAnalysisBinaryVersion);
+		fclose(fp);
+		return false;
+	}
+
+	bool bSuccess = true;
+	uint32_t chunkId = 0;
+	FMemoryBuffer chunkData;
+	while (bSuccess && ReadChunk(fp, (size_t)fileSize, chunkId, chunkData))
+	{
+		if (chunkId == kEndChunkId)
+			break;
+
+		switch (chunkId)
+		{
+		case kBankChunkId:
+			loaded.Banks.emplace_back();
+			bSuccess = ParseBankChunkData(chunkData, loaded.Banks.back());
+			break;
+		case kMiscChunkId:
+			loaded.MiscJson.emplace_back();
+			bSuccess = ParseMiscChunkData(chunkData, loaded.MiscJson.back());
+			break;
+		case kCharacterSetChunkId:
+			bSuccess = ParseCharacterSetChunkData(chunkData, loaded.CharacterSets);
+			break;
+		case kCharacterMapChunkId:
+			bSuccess = ParseCharacterMapChunkData(chunkData, loaded.CharacterMaps);
+			break;
+		default:	// unknown chunk - skip
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	if (bSuccess && chunkId != kEndChunkId)
+	{
+		LOGERROR("Analysis binary '%s' is incomplete", pFileName);
+		bSuccess = false;
+	}
+
+	return bSuccess;
+}
+
+bool ImportAnalysisBinary(FCodeAnalysisState& state, const char* pFileName)
+{
+	FLoadedAnalysisBinary loaded;
+	if (LoadAnalysisBinary(pFileName, loaded) == false)
+		return false;
+
+	for (const FLoadedBank& bank : loaded.Banks)
+		ApplyLoadedBank(state, bank);
+
+	for (const json& miscJson : loaded.MiscJson)
+		ApplyMiscJson(state, miscJson);
+
+	for (FCharSetCreateParams& params : loaded.CharacterSets)
+	{
+		FixupAddressRef(state, params.Address);
+		params.ColourLUT = state.Config.CharacterColourLUT;
+		CreateCharacterSetAt(state, params);
+	}
+
+	for (FCharMapCreateParams& params : loaded.CharacterMaps)
+	{
+		FixupAddressRef(state, params.Address);
+		CreateCharacterMap(state, params);
+	}
+
+	FixupPostLoad(state);
+	return true;
+}
+
+bool ImportAnalysisBinaryOrJson(FCodeAnalysisState& state, const char* pBinaryFileName, const char* pJsonFileName)
+{
+	// the json may have been edited or saved by an older version since the binary was written
+	const bool bBinaryFirst = IsFileNewerThan(pJsonFileName, pBinaryFileName) == false;
+	const char* pFirstFileName = bBinaryFirst ? pBinaryFileName : pJsonFileName;
+	const char* pSecondFileName = bBinaryFirst ? pJsonFileName : pBinaryFileName;
+
+	for (const char* pFileName : { pFirstFileName, pSecondFileName })
+	{
+		if (FileExists(pFileName) == false)
+			continue;
+
+		const bool bLoaded = pFileName == pBinaryFileName ? ImportAnalysisBinary(state, pFileName) : ImportAnalysisJson(state, pFileName);
+		if (bLoaded)
+		{
+			LOGINFO("Loaded analysis from '%s'", pFileName);
+			return true;
+		}
+		LOGWARNING("Failed to load analysis from '%s'", pFileName);
+	}
+
+	return false;
+}
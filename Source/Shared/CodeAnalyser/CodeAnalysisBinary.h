@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Util/MemoryBuffer.h"
+
+class FCodeAnalysisState;
+
+struct FAnalysisBinaryChunk
+{
+	uint32_t		Id = 0;
+	FMemoryBuffer	Data;	// uncompressed
+};
+
+// The analysis gathered into chunks ready to be written out, owns all its data so it can be written on another thread
+struct FAnalysisBinarySnapshot
+{
+	std::vector<FAnalysisBinaryChunk>	Chunks;
+};
+
+// Chunked binary project format - see CodeAnalysisBinary.cpp for the layout
+bool ExportAnalysisBinary(FCodeAnalysisState& state, const char* pFileName, bool bCompress = true);
+bool ImportAnalysisBinary(FCodeAnalysisState& state, const char* pFileName);
+bool ImportAnalysisBinaryOrJson(FCodeAnalysisState& state, const char* pBinaryFileName, const char* pJsonFileName);	// loads the newer of the two, falls back to the other
+
+void BuildAnalysisBinarySnapshot(FCodeAnalysisState& state, FAnalysisBinarySnapshot& snapshot);
+bool WriteAnalysisBinarySnapshot(const FAnalysisBinarySnapshot& snapshot, FILE* fp, bool bCompress = true);
@@ -4,28 +4,27 @@
 #include "DataTypes.h"
 
 #include <stdint.h>
+#include <stdio.h>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Util/GraphicsView.h"
 #include "Debug/DebugLog.h"
-#include <iostream>
 #include <json.hpp>
+#include <rapidjson/reader.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/error/en.h>
 using json = nlohmann::json;
 
 void WritePageToJson(const FCodeAnalysisPage& page, json& jsonDoc);
-void ReadPageFromJson(FCodeAnalysisState& state, FCodeAnalysisPage& page, const json& jsonDoc);
-FCommentBlock* CreateCommentBlockFromJson(const json& commentBlockJson);
-FCodeInfo* CreateCodeInfoFromJson(const json& codeInfoJson);
-FLabelInfo* CreateLabelInfoFromJson(const json& labelInfoJson);
-void LoadDataInfoFromJson(FCodeAnalysisState& state, FDataInfo* pDataInfo, const json& dataInfoJson);
 void FixupPostLoad(FCodeAnalysisState& state);
 
-bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bool bExportMachineROM)
+void BuildAnalysisJson(FCodeAnalysisState& state, json& jsonGameData, bool bExportMachineROM)
 {
-	json jsonGameData;
-
 	int pagesWritten = 0;
 	const auto& banks = state.GetBanks();
 
@@ -43,7 +42,7 @@ bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bo
 		//bankJson["PrimaryMappedPage"] = bank.PrimaryMappedPage;
 		jsonGameData["Banks"].push_back(bankJson);
 
-		for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
+		for (int pageNo = 0; bank.Pages != nullptr && pageNo < bank.NoPages; pageNo++)	// unallocated banks have nothing to save
 		{
 			const FCodeAnalysisPage& page = bank.Pages[pageNo];
 			//if (page.bUsed)
@@ -103,7 +102,19 @@ bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bo
         pDataTypes->WriteToJson(dataTypesJson);
         jsonGameData["DataTypes"] = dataTypesJson;
     }
-    
+}
+
+bool WriteAnalysisJson(const json& jsonGameData, FILE* fp)
+{
+	const std::string jsonText = jsonGameData.dump(4) + "\n";
+	return fwrite(jsonText.c_str(), jsonText.size(), 1, fp) == 1;
+}
+
+bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bool bExportMachineROM)
+{
+	json jsonGameData;
+	BuildAnalysisJson(state, jsonGameData, bExportMachineROM);
+
 	// Write file out
 	std::ofstream outFileStream(pJsonFileName);
 	if (outFileStream.is_open())
@@ -115,115 +126,520 @@ bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bo
 	return false;
 }
 
-bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
+// Import
+// Analysis files can be many megabytes so they are read with a SAX parser rather than into a DOM.
+// Items in the page & legacy item lists are read into flat records & created as they are parsed.
+// Everything else is small so it's gathered into a json document & processed once the file is read.
+
+enum class EJsonItemField
 {
-	std::ifstream inFileStream(pJsonFileName);
-	if (inFileStream.is_open() == false)
-		return false;
+	Address,
+	Name,
+	Comment,
+	Global,
+	LabelType,
+	ByteSize,
+	SMC,
+	OperandType,
+	StructId,
+	Flags,
+	DataType,
+	DisplayType,
+	InstructionAddress,
+	InstructionAddressRef,
+	PaletteNo,
+	StructByteOffset,
+	CharSetAddress,
+	CharSetAddressRef,
+	EmptyCharNo,
+	GraphicsSetRef,
+
+	Count,
+	Unknown = Count
+};
+
+enum class EJsonItemList
+{
+	CommentBlocks,
+	LabelInfo,
+	CodeInfo,
+	DataInfo,
 
-	json jsonGameData;
+	Count,
+	None = Count
+};
 
-	inFileStream >> jsonGameData;
-	inFileStream.close();
+EJsonItemField GetJsonItemField(const std::string& key)
+{
+	static const std::unordered_map<std::string, EJsonItemField> fieldLUT =
+	{
+		{ "Address", EJsonItemField::Address },
+		{ "Name", EJsonItemField::Name },
+		{ "Comment", EJsonItemField::Comment },
+		{ "Global", EJsonItemField::Global },
+		{ "LabelType", EJsonItemField::LabelType },
+		{ "ByteSize", EJsonItemField::ByteSize },
+		{ "SMC", EJsonItemField::SMC },
+		{ "OperandType", EJsonItemField::OperandType },
+		{ "StructId", EJsonItemField::StructId },
+		{ "Flags", EJsonItemField::Flags },
+		{ "DataType", EJsonItemField::DataType },
+		{ "DisplayType", EJsonItemField::DisplayType },
+		{ "InstructionAddress", EJsonItemField::InstructionAddress },
+		{ "InstructionAddressRef", EJsonItemField::InstructionAddressRef },
+		{ "PaletteNo", EJsonItemField::PaletteNo },
+		{ "StructByteOffset", EJsonItemField::StructByteOffset },
+		{ "CharSetAddress", EJsonItemField::CharSetAddress },
+		{ "CharSetAddressRef", EJsonItemField::CharSetAddressRef },
+		{ "EmptyCharNo", EJsonItemField::EmptyCharNo },
+		{ "GraphicsSetRef", EJsonItemField::GraphicsSetRef },
+	};
+
+	auto fieldIt = fieldLUT.find(key);
+	return fieldIt != fieldLUT.end() ? fieldIt->second : EJsonItemField::Unknown;
+}
 
-	if (jsonGameData.contains("Banks"))
+EJsonItemList GetJsonItemList(const std::string& key)
+{
+	if (key == "CommentBlocks")
+		return EJsonItemList::CommentBlocks;
+	if (key == "LabelInfo")
+		return EJsonItemList::LabelInfo;
+	if (key == "CodeInfo")
+		return EJsonItemList::CodeInfo;
+	if (key == "DataInfo")
+		return EJsonItemList::DataInfo;
+	return EJsonItemList::None;
+}
+
+// The fields of an item we know about
+struct FJsonItemRecord
+{
+	void	Reset() { PresentMask = 0; Name.clear(); Comment.clear(); }
+	bool	Has(EJsonItemField field) const { return (PresentMask & (1 << (int)field)) != 0; }
+	int64_t	Get(EJsonItemField field) const { return Values[(int)field]; }
+	void	Set(EJsonItemField field, int64_t value) { Values[(int)field] = value; PresentMask |= 1 << (int)field; }
+
+	uint32_t	PresentMask = 0;
+	int64_t		Values[(int)EJsonItemField::Count] = { 0 };
+	std::string	Name;
+	std::string	Comment;
+};
+
+FCommentBlock* CreateCommentBlockFromRecord(const FJsonItemRecord& record)
+{
+	FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
+	pCommentBlock->Comment = record.Comment;
+	return pCommentBlock;
+}
+
+FCodeInfo* CreateCodeInfoFromRecord(const FJsonItemRecord& record)
+{
+	FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
+	pCodeInfo->ByteSize = (uint16_t)record.Get(EJsonItemField::ByteSize);
+
+	if (record.Has(EJsonItemField::SMC))
+		pCodeInfo->bSelfModifyingCode = record.Get(EJsonItemField::SMC) != 0;
+
+	if (record.Has(EJsonItemField::OperandType))
+		pCodeInfo->OperandType = (EOperandType)record.Get(EJsonItemField::OperandType);
+
+	// hack patch for previous mistake - remove
+	if(pCodeInfo->OperandType == EOperandType::Struct)
+		pCodeInfo->OperandType = EOperandType::Unknown;
+
+	if (record.Has(EJsonItemField::StructId))
+		pCodeInfo->StructId = (int)record.Get(EJsonItemField::StructId);
+
+	if (record.Has(EJsonItemField::Flags))
+		pCodeInfo->Flags = (uint32_t)record.Get(EJsonItemField::Flags);
+
+	if (record.Has(EJsonItemField::Comment))
+		pCodeInfo->Comment = record.Comment;
+
+	return pCodeInfo;
+}
+
+FLabelInfo* CreateLabelInfoFromRecord(const FJsonItemRecord& record)
+{
+	FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
+
+	pLabelInfo->InitialiseName(record.Name.c_str());
+	if (record.Has(EJsonItemField::Global))
+		pLabelInfo->Global = true;
+
+	if (record.Has(EJsonItemField::LabelType))
+		pLabelInfo->LabelType = (ELabelType)record.Get(EJsonItemField::LabelType);
+	if (record.Has(EJsonItemField::Comment))
+		pLabelInfo->Comment = record.Comment;
+
+	return pLabelInfo;
+}
+
+void LoadDataInfoFromRecord(FCodeAnalysisState& state, FDataInfo* pDataInfo, const FJsonItemRecord& record)
+{
+	if (record.Has(EJsonItemField::DataType))
+		pDataInfo->DataType = (EDataType)record.Get(EJsonItemField::DataType);
+	if (record.Has(EJsonItemField::OperandType))	// old field
+		pDataInfo->DisplayType = (EDataItemDisplayType)record.Get(EJsonItemField::OperandType);
+	if (record.Has(EJsonItemField::DisplayType))
+		pDataInfo->DisplayType = (EDataItemDisplayType)record.Get(EJsonItemField::DisplayType);
+	if (record.Has(EJsonItemField::InstructionAddress))
+		pDataInfo->InstructionAddress = state.AddressRefFromPhysicalAddress((uint16_t)record.Get(EJsonItemField::InstructionAddress));
+	if (record.Has(EJsonItemField::InstructionAddressRef))
+		pDataInfo->InstructionAddress.Val = (uint32_t)record.Get(EJsonItemField::InstructionAddressRef);
+	if (record.Has(EJsonItemField::ByteSize))
+		pDataInfo->ByteSize = (uint16_t)record.Get(EJsonItemField::ByteSize);
+	if (record.Has(EJsonItemField::Flags))
+		pDataInfo->Flags = (uint32_t)record.Get(EJsonItemField::Flags);
+	if (record.Has(EJsonItemField::Comment))
+		pDataInfo->Comment = record.Comment;
+	if (record.Has(EJsonItemField::PaletteNo))
+		pDataInfo->PaletteNo = (int)record.Get(EJsonItemField::PaletteNo);
+	if (record.Has(EJsonItemField::StructByteOffset))
+		pDataInfo->StructByteOffset = (uint8_t)record.Get(EJsonItemField::StructByteOffset);
+
+	// Charmap specific
+	if (pDataInfo->DataType == EDataType::CharacterMap)
 	{
-		for (const auto& bankJson : jsonGameData["Banks"])
-		{
-			FCodeAnalysisBank* pBank = state.GetBank(bankJson["Id"]);
-			if (pBank != nullptr)
-			{
-				if (bankJson.contains("Description"))
-					pBank->Description = bankJson["Description"];
-				//if (bankJson.contains("Used"))
-				//	pBank-> = bankJson["Used"];
-				//pBank->PrimaryMappedPage = bankJson["PrimaryMappedPage"];
-			}
-		}
+		if (record.Has(EJsonItemField::CharSetAddress))	// legacy
+			pDataInfo->CharSetAddress = state.AddressRefFromPhysicalAddress((uint16_t)record.Get(EJsonItemField::CharSetAddress));
+		if (record.Has(EJsonItemField::CharSetAddressRef))
+			pDataInfo->CharSetAddress.Val = (uint32_t)record.Get(EJsonItemField::CharSetAddressRef);
+		if (record.Has(EJsonItemField::EmptyCharNo))
+			pDataInfo->EmptyCharNo = (uint8_t)record.Get(EJsonItemField::EmptyCharNo);
+	}
+	else if (pDataInfo->DataType == EDataType::Bitmap)
+	{
+		if (record.Has(EJsonItemField::GraphicsSetRef))
+			pDataInfo->GraphicsSetRef.Val = (uint32_t)record.Get(EJsonItemField::GraphicsSetRef);
+
+		if (pDataInfo->DisplayType == EDataItemDisplayType::Unknown)	// load fixup
+			pDataInfo->DisplayType = EDataItemDisplayType::Bitmap;
 	}
-	if (jsonGameData.contains("Pages"))
+}
+
+// Items in a page are addressed relative to the page
+void ReadPageItemFromRecord(FCodeAnalysisState& state, FCodeAnalysisPage& page, EJsonItemList list, const FJsonItemRecord& record)
+{
+	const uint16_t pageAddr = (uint16_t)record.Get(EJsonItemField::Address);
+	if (record.Has(EJsonItemField::Address) == false || pageAddr >= FCodeAnalysisPage::kPageSize)
+		return;
+
+	switch (list)
+	{
+	case EJsonItemList::CommentBlocks:
+		page.CommentBlocks[pageAddr] = CreateCommentBlockFromRecord(record);
+		break;
+	case EJsonItemList::LabelInfo:
+		page.Labels[pageAddr] = CreateLabelInfoFromRecord(record);
+		break;
+	case EJsonItemList::CodeInfo:
+		page.CodeInfo[pageAddr] = CreateCodeInfoFromRecord(record);
+		break;
+	case EJsonItemList::DataInfo:
+		LoadDataInfoFromRecord(state, &page.DataInfo[pageAddr], record);
+		break;
+	default:
+		break;
+	}
+}
+
+// Legacy item lists from before pages were saved, addresses are physical
+void ReadLegacyItemFromRecord(FCodeAnalysisState& state, EJsonItemList list, const FJsonItemRecord& record)
+{
+	if (record.Has(EJsonItemField::Address) == false)
+		return;
+
+	const uint16_t addr = (uint16_t)record.Get(EJsonItemField::Address);
+
+	switch (list)
 	{
-		for (const auto& pageJson : jsonGameData["Pages"])
+	case EJsonItemList::CommentBlocks:
+		state.SetCommentBlockForAddress(state.AddressRefFromPhysicalAddress(addr), CreateCommentBlockFromRecord(record));
+		break;
+	case EJsonItemList::LabelInfo:
+		state.SetLabelForPhysicalAddress(addr, CreateLabelInfoFromRecord(record));
+		break;
+	case EJsonItemList::CodeInfo:
+	{
+		FCodeInfo* pCodeInfo = CreateCodeInfoFromRecord(record);
+		state.SetCodeInfoForAddress(addr, pCodeInfo);
+
+		// set operand data items
+		for (int codeByte = 1; codeByte < pCodeInfo->ByteSize; codeByte++)
 		{
-			const int pageId = pageJson["PageId"];
-			if(state.IsValidPageId(pageId) == false)
-				continue;
-			FCodeAnalysisPage* pPage = state.GetPage(pageId);
-			if (pPage != nullptr)
-			{
-				ReadPageFromJson(state,*pPage, pageJson);
-				pPage->bUsed = true;
-			}
+			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(addr + codeByte);
+			pDataInfo->DataType = EDataType::InstructionOperand;
+			pDataInfo->ByteSize = 1;
+			pDataInfo->InstructionAddress = state.AddressRefFromPhysicalAddress(addr);
 		}
 	}
+	break;
+	case EJsonItemList::DataInfo:
+		LoadDataInfoFromRecord(state, state.GetReadDataInfoForAddress(addr), record);
+		break;
+	default:
+		break;
+	}
+}
 
-	// Below is legacy and should be removed at some point
+// rapidjson SAX handler
+class FAnalysisJsonReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FAnalysisJsonReader>
+{
+public:
+	FAnalysisJsonReader(FCodeAnalysisState& state) : State(state) {}
 
-	// info on last writer
-	if (jsonGameData.contains("LastWriterStart"))
+	const json&	GetDocument() const { return Document; }
+
+	bool Null() { return AddJsonValue(nullptr); }
+	bool Bool(bool b) { return Value(b); }
+	bool Int(int i) { return Value(i); }
+	bool Uint(unsigned u) { return Value(u); }
+	bool Int64(int64_t i) { return Value(i); }
+	bool Uint64(uint64_t u) { return Value(u); }
+	bool Double(double d) { return Value(d); }
+
+	bool String(const char* pStr, rapidjson::SizeType length, bool)
 	{
-		const int lwStart = jsonGameData["LastWriterStart"];
+		if (Stack.empty())
+			return false;
 
-		const json& lastWriterArray = jsonGameData["LastWriter"];
-		const int noWriters = (int)lastWriterArray.size();
-		for (int i = 0; i < noWriters; i++)
-			state.SetLastWriterForAddress(lwStart + i, state.AddressRefFromPhysicalAddress(lastWriterArray[i]));
+		if (Stack.back().Type == EFrame::Item)
+		{
+			if (CurrentField == EJsonItemField::Name)
+				Record.Name.assign(pStr, length);
+			else if (CurrentField == EJsonItemField::Comment)
+				Record.Comment.assign(pStr, length);
+			else
+				return true;
+			Record.Set(CurrentField, 0);
+			return true;
+		}
+
+		return AddJsonValue(std::string(pStr, length));
+	}
+
+	bool Key(const char* pStr, rapidjson::SizeType length, bool)
+	{
+		CurrentKey.assign(pStr, length);
+		if (Stack.empty() == false && Stack.back().Type == EFrame::Item)
+			CurrentField = GetJsonItemField(CurrentKey);
+		return true;
 	}
 
-	if (jsonGameData.contains("CommentBlocks"))
+	bool StartObject() { return StartContainer(false); }
+	bool EndObject(rapidjson::SizeType) { return EndContainer(); }
+	bool StartArray() { return StartContainer(true); }
+	bool EndArray(rapidjson::SizeType) { return EndContainer(); }
+
+private:
+	enum class EFrame
+	{
+		Root,
+		PagesArray,
+		Page,
+		ItemArray,
+		Item,
+		Document,	// building into the json document
+		Skip,
+	};
+
+	struct FFrame
 	{
-		for (const auto& commentBlockJson : jsonGameData["CommentBlocks"])
+		EFrame			Type = EFrame::Skip;
+		EJsonItemList	ItemList = EJsonItemList::None;
+		json*			pJson = nullptr;
+	};
+
+	template <class T>
+	bool Value(T value)
+	{
+		if (Stack.empty())
+			return false;
+
+		switch (Stack.back().Type)
 		{
-			const uint16_t addr = commentBlockJson["Address"];
-			FCommentBlock* pCommentBlock = CreateCommentBlockFromJson(commentBlockJson);
-			state.SetCommentBlockForAddress(state.AddressRefFromPhysicalAddress(addr), pCommentBlock);
+		case EFrame::Item:
+			if (CurrentField != EJsonItemField::Unknown)
+				Record.Set(CurrentField, (int64_t)value);
+			return true;
+		case EFrame::Page:
+			if (CurrentKey == "PageId")
+				PageId = (int)value;
+			return true;
+		default:
+			return AddJsonValue(value);
 		}
 	}
 
-	if (jsonGameData.contains("CodeInfo"))
+	// add a value to the document if we're building it
+	template <class T>
+	bool AddJsonValue(T&& value)
+	{
+		if (Stack.empty())
+			return false;
+
+		const FFrame& frame = Stack.back();
+		if (frame.Type == EFrame::Root)
+			Document[CurrentKey] = std::forward<T>(value);
+		else if (frame.Type == EFrame::Document && frame.pJson->is_array())
+			frame.pJson->push_back(std::forward<T>(value));
+		else if (frame.Type == EFrame::Document)
+			(*frame.pJson)[CurrentKey] = std::forward<T>(value);
+		return true;
+	}
+
+	bool StartContainer(bool bArray)
 	{
-		for (const auto codeInfoJson : jsonGameData["CodeInfo"])
+		if (Stack.empty())
+		{
+			if (bArray)	// should be an object at the root
+				return false;
+			Stack.push_back({ EFrame::Root });
+			return true;
+		}
+
+		const FFrame& parent = Stack.back();
+		FFrame frame;
+		switch (parent.Type)
 		{
-			if(codeInfoJson.contains("Address") == false)
+		case EFrame::Root:
+			if (bArray && CurrentKey == "Pages")
 			{
-				std::cout << codeInfoJson;
-				continue;
+				frame.Type = EFrame::PagesArray;
 			}
-			const uint16_t addr = codeInfoJson["Address"];
-			FCodeInfo* pCodeInfo = CreateCodeInfoFromJson(codeInfoJson);
-			state.SetCodeInfoForAddress(addr, pCodeInfo);
-
-			// set operand data items
-			for (int codeByte = 1; codeByte < pCodeInfo->ByteSize; codeByte++)
+			else if (bArray && GetJsonItemList(CurrentKey) != EJsonItemList::None)
+			{
+				frame.Type = EFrame::ItemArray;
+				frame.ItemList = GetJsonItemList(CurrentKey);
+			}
+			else
+			{
+				frame.Type = EFrame::Document;
+				frame.pJson = &(Document[CurrentKey] = bArray ? json::array() : json::object());
+			}
+			break;
+		case EFrame::PagesArray:
+			if (bArray == false)
 			{
-				FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(addr + codeByte);
-				pDataInfo->DataType = EDataType::InstructionOperand;
-				pDataInfo->ByteSize = 1;
-				pDataInfo->InstructionAddress = state.AddressRefFromPhysicalAddress(addr);
+				frame.Type = EFrame::Page;
+				PageId = -1;
+				for (auto& pageItems : PageItems)
+					pageItems.clear();
 			}
+			break;
+		case EFrame::Page:
+			if (bArray && GetJsonItemList(CurrentKey) != EJsonItemList::None)
+			{
+				frame.Type = EFrame::ItemArray;
+				frame.ItemList = GetJsonItemList(CurrentKey);
+			}
+			break;
+		case EFrame::ItemArray:
+			if (bArray == false)
+			{
+				frame.Type = EFrame::Item;
+				frame.ItemList = parent.ItemList;
+				Record.Reset();
+				CurrentField = EJsonItemField::Unknown;
+			}
+			break;
+		case EFrame::Document:
+			frame.Type = EFrame::Document;
+			if (parent.pJson->is_array())
+			{
+				parent.pJson->push_back(bArray ? json::array() : json::object());
+				frame.pJson = &parent.pJson->back();
+			}
+			else
+			{
+				frame.pJson = &((*parent.pJson)[CurrentKey] = bArray ? json::array() : json::object());
+			}
+			break;
+		default:
+			break;
 		}
+
+		Stack.push_back(frame);
+		return true;
 	}
 
-	if (jsonGameData.contains("LabelInfo"))
+	bool EndContainer()
 	{
-		for (const auto labelInfoJson : jsonGameData["LabelInfo"])
+		if (Stack.empty())
+			return false;
+
+		const FFrame frame = Stack.back();
+		Stack.pop_back();
+
+		if (frame.Type == EFrame::Item)
 		{
-			const uint16_t addr = labelInfoJson["Address"];
-			FLabelInfo* pLabelInfo = CreateLabelInfoFromJson(labelInfoJson);
-			state.SetLabelForPhysicalAddress(addr, pLabelInfo);
+			const bool bInPage = Stack.size() > 1 && Stack[Stack.size() - 2].Type == EFrame::Page;
+			if (bInPage)	// page id could come after the items so hold on to them until the page is done
+				PageItems[(int)frame.ItemList].push_back(std::move(Record));
+			else
+				ReadLegacyItemFromRecord(State, frame.ItemList, Record);
+		}
+		else if (frame.Type == EFrame::Page && State.IsValidPageId(PageId))
+		{
+			FCodeAnalysisPage* pPage = State.GetPage(PageId);
+			if (pPage != nullptr)
+			{
+				for (int listNo = 0; listNo < (int)EJsonItemList::Count; listNo++)
+				{
+					for (const FJsonItemRecord& record : PageItems[listNo])
+						ReadPageItemFromRecord(State, *pPage, (EJsonItemList)listNo, record);
+				}
+				pPage->bUsed = true;
+			}
 		}
+
+		return true;
 	}
 
-	if (jsonGameData.contains("DataInfo"))
+	FCodeAnalysisState&		State;
+	json					Document;
+	std::vector<FFrame>		Stack;
+	std::string				CurrentKey;
+	EJsonItemField			CurrentField = EJsonItemField::Unknown;
+	FJsonItemRecord			Record;
+	int						PageId = -1;
+	std::vector<FJsonItemRecord>	PageItems[(int)EJsonItemList::Count];
+};
+
+// process the parts of the file that aren't item lists
+void ImportAnalysisJsonDocument(FCodeAnalysisState& state, const json& jsonGameData)
+{
+	if (jsonGameData.contains("Banks"))
 	{
-		for (const auto dataInfoJson : jsonGameData["DataInfo"])
+		for (const auto& bankJson : jsonGameData["Banks"])
 		{
-			const int address = dataInfoJson["Address"];
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(address);
-			LoadDataInfoFromJson(state, pDataInfo, dataInfoJson);
+			FCodeAnalysisBank* pBank = state.GetBank(bankJson["Id"]);
+			if (pBank != nullptr)
+			{
+				if (bankJson.contains("Description"))
+					pBank->Description = bankJson["Description"];
+				//if (bankJson.contains("Used"))
+				//	pBank-> = bankJson["Used"];
+				//pBank->PrimaryMappedPage = bankJson["PrimaryMappedPage"];
+			}
 		}
 	}
 
+	// Below is legacy and should be removed at some point
+
+	// info on last writer
+	if (jsonGameData.contains("LastWriterStart"))
+	{
+		const int lwStart = jsonGameData["LastWriterStart"];
+
+		const json& lastWriterArray = jsonGameData["LastWriter"];
+		const int noWriters = (int)lastWriterArray.size();
+		for (int i = 0; i < noWriters; i++)
+			state.SetLastWriterForAddress(lwStart + i, state.AddressRefFromPhysicalAddress(lastWriterArray[i]));
+	}
+
 	// Read in palettes.
 	// May be needed to create the character set.
 	LoadPalettesFromJson(jsonGameData);
@@ -292,6 +708,30 @@ bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
         pDataTypes->ReadFromJson(jsonGameData["DataTypes"]);
     }
 
+}
+
+
+bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName)
+{
+	FILE* fp = fopen(pJsonFileName, "rb");
+	if (fp == nullptr)
+		return false;
+
+	std::vector<char> readBuffer(64 * 1024);
+	rapidjson::FileReadStream inStream(fp, readBuffer.data(), readBuffer.size());
+	FAnalysisJsonReader jsonReader(state);
+	rapidjson::Reader reader;
+	const rapidjson::ParseResult result = reader.Parse(inStream, jsonReader);
+	fclose(fp);
+
+	if (result.IsError())
+	{
+		LOGERROR("Error parsing '%s' at offset %d: %s", pJsonFileName, (int)result.Offset(), rapidjson::GetParseError_En(result.Code()));
+		return false;
+	}
+
+	ImportAnalysisJsonDocument(state, jsonReader.GetDocument());
+
 	FixupPostLoad(state);
 
 	return true;
@@ -389,112 +829,6 @@ void WriteCommentBlockToJson(uint16_t addr, const FCommentBlock* pCommentBlock,
 	jsonDoc["CommentBlocks"].push_back(commentBlockJson);
 }
 
-FCommentBlock* CreateCommentBlockFromJson(const json& commentBlockJson)
-{
-	FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
-	//pCommentBlock->Address = commentBlockJson["Address"];
-	pCommentBlock->Comment = commentBlockJson["Comment"];
-	return pCommentBlock;
-}
-
-FCodeInfo* CreateCodeInfoFromJson(const json& codeInfoJson)
-{
-	FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
-	pCodeInfo->ByteSize = codeInfoJson["ByteSize"];
-
-	if (codeInfoJson.contains("SMC"))
-		pCodeInfo->bSelfModifyingCode = (bool)codeInfoJson["SMC"];
-
-	if (codeInfoJson.contains("OperandType"))
-		pCodeInfo->OperandType = codeInfoJson["OperandType"];
-
-	// hack patch for previous mistake - remove
-	if(pCodeInfo->OperandType == EOperandType::Struct)
-		pCodeInfo->OperandType = EOperandType::Unknown;
-
-	if (codeInfoJson.contains("StructId"))
-		pCodeInfo->StructId = codeInfoJson["StructId"];
-
-	if (codeInfoJson.contains("Flags"))
-		pCodeInfo->Flags = codeInfoJson["Flags"];
-
-	if (codeInfoJson.contains("Comment"))
-		pCodeInfo->Comment = codeInfoJson["Comment"];
-
-	return pCodeInfo;
-}
-
-FLabelInfo* CreateLabelInfoFromJson(const json& labelInfoJson)
-{
-	FLabelInfo* pLabelInfo = FLabelInfo::Allocate();
-
-	pLabelInfo->InitialiseName(((std::string)labelInfoJson["Name"]).c_str());
-	if (labelInfoJson.contains("Global"))
-		pLabelInfo->Global = true;
-
-	if (labelInfoJson.contains("LabelType"))
-		pLabelInfo->LabelType = (ELabelType)(int)labelInfoJson["LabelType"];
-	if (labelInfoJson.contains("Comment"))
-		pLabelInfo->Comment = labelInfoJson["Comment"];
-
-	// Moved to binary file
-	/*if (labelInfoJson.contains("References"))
-	{
-		for (const auto& reference : labelInfoJson["References"])
-		{
-			pLabelInfo->References.RegisterAccess(reference);
-		}
-	}*/
-
-	return pLabelInfo;
-}
-
-void LoadDataInfoFromJson(FCodeAnalysisState& state, FDataInfo* pDataInfo, const json& dataInfoJson)
-{
-	if (dataInfoJson.contains("DataType"))
-		pDataInfo->DataType = (EDataType)(int)dataInfoJson["DataType"];
-	if (dataInfoJson.contains("OperandType"))	// old field
-		pDataInfo->DisplayType = (EDataItemDisplayType)(int)dataInfoJson["OperandType"];
-	if (dataInfoJson.contains("DisplayType"))
-		pDataInfo->DisplayType = (EDataItemDisplayType)(int)dataInfoJson["DisplayType"];
-	if (dataInfoJson.contains("InstructionAddress"))
-		pDataInfo->InstructionAddress = state.AddressRefFromPhysicalAddress(dataInfoJson["InstructionAddress"]);
-	if (dataInfoJson.contains("InstructionAddressRef"))
-		pDataInfo->InstructionAddress.Val = dataInfoJson["InstructionAddressRef"];
-	if (dataInfoJson.contains("ByteSize"))
-		pDataInfo->ByteSize = dataInfoJson["ByteSize"];
-	if (dataInfoJson.contains("Flags"))
-		pDataInfo->Flags = dataInfoJson["Flags"];
-	if (dataInfoJson.contains("Comment"))
-		pDataInfo->Comment = dataInfoJson["Comment"];
-	if (dataInfoJson.contains("PaletteNo"))
-		pDataInfo->PaletteNo = dataInfoJson["PaletteNo"];
-	if(dataInfoJson.contains("StructByteOffset"))
-		pDataInfo->StructByteOffset = dataInfoJson["StructByteOffset"];
-
-// Charmap specific
-	if (pDataInfo->DataType == EDataType::CharacterMap)
-	{
-		if (dataInfoJson.contains("CharSetAddress"))
-			pDataInfo->CharSetAddress = state.AddressRefFromPhysicalAddress(dataInfoJson["CharSetAddress"]);	// legacy
-		if (dataInfoJson.contains("CharSetAddressRef"))
-			pDataInfo->CharSetAddress.Val = dataInfoJson["CharSetAddressRef"];
-		if (dataInfoJson.contains("EmptyCharNo"))
-			pDataInfo->EmptyCharNo = dataInfoJson["EmptyCharNo"];
-	}
-	else if (pDataInfo->DataType == EDataType::Bitmap)
-	{
-		if (dataInfoJson.contains("GraphicsSetRef"))
-			pDataInfo->GraphicsSetRef.Val = dataInfoJson["GraphicsSetRef"];
-
-		if (pDataInfo->DisplayType == EDataItemDisplayType::Unknown)	// load fixup
-			pDataInfo->DisplayType = EDataItemDisplayType::Bitmap;
-	}
-}
-
-
-
-
 // write a 1K page to Json
 // the plan is to move to this so we can support 128K games
 void WritePageToJson(const FCodeAnalysisPage& page, json& jsonDoc)
@@ -535,49 +869,6 @@ void WritePageToJson(const FCodeAnalysisPage& page, json& jsonDoc)
 }
 
 
-void ReadPageFromJson(FCodeAnalysisState &state, FCodeAnalysisPage& page, const json& jsonDoc)
-{
-	if (jsonDoc.contains("CommentBlocks"))
-	{
-		for (const auto commentBlockJson : jsonDoc["CommentBlocks"])
-		{
-			const uint16_t pageAddr = commentBlockJson["Address"];
-			FCommentBlock* pCommentBlock = CreateCommentBlockFromJson(commentBlockJson);
-			page.CommentBlocks[pageAddr] = pCommentBlock;
-		}
-	}
-
-	if (jsonDoc.contains("LabelInfo"))
-	{
-		for (const auto labelInfoJson : jsonDoc["LabelInfo"])
-		{
-			const uint16_t pageAddr = labelInfoJson["Address"];
-			FLabelInfo* pLabelInfo = CreateLabelInfoFromJson(labelInfoJson);
-			page.Labels[pageAddr] = pLabelInfo;
-		}
-	}
-
-	if (jsonDoc.contains("CodeInfo"))
-	{
-		for (const auto codeInfoJson : jsonDoc["CodeInfo"])
-		{
-			const uint16_t pageAddr = codeInfoJson["Address"];
-			FCodeInfo* pCodeInfo = CreateCodeInfoFromJson(codeInfoJson);
-			page.CodeInfo[pageAddr] = pCodeInfo;
-		}
-	}
-
-	if (jsonDoc.contains("DataInfo"))
-	{
-		for (const auto dataInfoJson : jsonDoc["DataInfo"])
-		{
-			const uint16_t pageAddr = dataInfoJson["Address"];
-			FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
-			LoadDataInfoFromJson(state, pDataInfo, dataInfoJson);
-		}
-	}
-}
-
 // This is called after all the json is loaded to fix up any data referencing
 void FixupPostLoad(FCodeAnalysisState& state)
 {
@@ -585,6 +876,9 @@ void FixupPostLoad(FCodeAnalysisState& state)
 	for (FCodeAnalysisBank& bank : banks)
 	{
 		assert(bank.PrimaryMappedPage !=-1);
+		if (bank.Pages == nullptr)	// not allocated, so nothing loaded into it
+			continue;
+
 		for(int pageNo=0;pageNo < bank.NoPages;pageNo++)
 		{
 			FCodeAnalysisPage& page = bank.Pages[pageNo];
@@ -594,9 +888,9 @@ void FixupPostLoad(FCodeAnalysisState& state)
 				const FDataInfo& dataInfo = page.DataInfo[addr];
 				FAddressRef dataRef = FAddressRef(bank.Id,addr + (bank.PrimaryMappedPage + pageNo) * FCodeAnalysisPage::kPageSize);
 				
-				for (int readRef = 0; readRef < dataInfo.Reads.NumReferences(); readRef++)
+				for (int readRef = 0; readRef < dataInfo.GetReads().NumReferences(); readRef++)
 				{
-					FAddressRef ref = dataInfo.Reads.GetReferences()[readRef];
+					FAddressRef ref = dataInfo.GetReads().GetReferences()[readRef];
 					FCodeInfo*pCodeInfo = state.GetCodeInfoForAddress(ref);
 					//assert(pCodeInfo!=nullptr);
 					if (pCodeInfo != nullptr)
@@ -605,9 +899,9 @@ void FixupPostLoad(FCodeAnalysisState& state)
 						LOGWARNING("Code at 0x%04X reading from 0x%04X not found", ref.Address, dataRef.Address);
 				}
 
-				for (int writeRef = 0; writeRef < dataInfo.Writes.NumReferences(); writeRef++)
+				for (int writeRef = 0; writeRef < dataInfo.GetWrites().NumReferences(); writeRef++)
 				{
-					const FAddressRef ref = dataInfo.Writes.GetReferences()[writeRef];
+					const FAddressRef ref = dataInfo.GetWrites().GetReferences()[writeRef];
 					FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(ref);
 					//assert(pCodeInfo != nullptr);
 					if(pCodeInfo != nullptr)
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <cstdio>
+#include <json_fwd.hpp>
+
 class FCodeAnalysisState;
 
 bool ExportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName, bool bROMS = false);
 bool ImportAnalysisJson(FCodeAnalysisState& state, const char* pJsonFileName);
+
+// Split export so the json document can be written out on another thread
+void BuildAnalysisJson(FCodeAnalysisState& state, nlohmann::json& jsonGameData, bool bROMS = false);
+bool WriteAnalysisJson(const nlohmann::json& jsonGameData, FILE* fp);
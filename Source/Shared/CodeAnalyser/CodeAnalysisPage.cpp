@@ -5,38 +5,40 @@
 #include "Util/GraphicsView.h"
 #include <cassert>
 #include <string.h>
+#include <algorithm>
 
 //#include "json.hpp"
-std::vector<FCodeInfo*>		FCodeInfo::AllocatedList;
-std::vector<FLabelInfo*>				FLabelInfo::AllocatedList;
-std::unordered_map<std::string, int>	FLabelInfo::LabelUsage;
-std::vector<FCommentBlock*>	FCommentBlock::AllocatedList;
+TSlabAllocator<FCodeInfo>		FCodeInfo::Allocator;
+TSlabAllocator<FLabelInfo>		FLabelInfo::Allocator;
+std::unordered_map<uint32_t, int>		FLabelInfo::LabelUsage;
+TSlabAllocator<FCommentBlock>	FCommentBlock::Allocator;
 
 FImageData::~FImageData() 
 { 
 	delete GraphicsView; 
 }
 
+// Used when the tracker is full to overwrite a reference in ring buffer fashion
+void FItemReferenceTracker::FOverflow::ReplaceReference(int refIndex, FAddressRef addrRef)
+{
+	RemoveFromIndex(Refs[refIndex]);
+	Refs[refIndex] = addrRef;
+	AddToIndex(addrRef, refIndex);
+}
+
 FCodeInfo* FCodeInfo::Allocate()
 {
-	FCodeInfo* pCodeInfo = new FCodeInfo;
-	AllocatedList.push_back(pCodeInfo);
-	return pCodeInfo;
+	return Allocator.Allocate();
 }
 
 void FCodeInfo::FreeAll()
 {
-	for (auto it : AllocatedList)
-		delete it;
-
-	AllocatedList.clear();
+	Allocator.FreeAll();
 }
 
 FLabelInfo* FLabelInfo::Allocate()
 {
-	FLabelInfo* pLabelInfo = new FLabelInfo;
-	AllocatedList.push_back(pLabelInfo);
-	return pLabelInfo;
+	return Allocator.Allocate();
 }
 
 FLabelInfo* FLabelInfo::Duplicate(const FLabelInfo* pSourceLabel)
@@ -51,25 +53,17 @@ FLabelInfo* FLabelInfo::Duplicate(const FLabelInfo* pSourceLabel)
 
 void FLabelInfo::FreeAll()
 {
-	for (auto it : AllocatedList)
-		delete it;
-
-	AllocatedList.clear();
+	Allocator.FreeAll();
 }
 
 FCommentBlock* FCommentBlock::Allocate()
 {
-	FCommentBlock* pCommentBlock = new FCommentBlock;
-	AllocatedList.push_back(pCommentBlock);
-	return pCommentBlock;
+	return Allocator.Allocate();
 }
 
 void FCommentBlock::FreeAll()
 {
-	for (auto it : AllocatedList)
-		delete it;
-
-	AllocatedList.clear();
+	Allocator.FreeAll();
 }
 
 FCommentBlock* FCommentBlock::Duplicate(const FCommentBlock* pSourceCommentBlock)
@@ -97,6 +91,17 @@ void FCodeAnalysisPage::Initialise()
 		dataInfo.ByteSize = 1;
 		dataInfo.DataType = EDataType::Byte;
 	}
+
+	ResetDataAccessStats();
+}
+
+void FCodeAnalysisPage::ResetDataAccessStats(void)
+{
+	memset(ReadCount, 0, sizeof(ReadCount));
+	memset(WriteCount, 0, sizeof(WriteCount));
+	std::fill(LastFrameRead, LastFrameRead + kPageSize, -1);
+	std::fill(LastFrameWritten, LastFrameWritten + kPageSize, -1);
+	std::fill(LastWriter, LastWriter + kPageSize, FAddressRef());
 }
 
 
@@ -210,8 +215,8 @@ void FCodeAnalysisPage::WriteToBuffer(FMemoryBuffer& buffer)
 			WriteItemToBuffer(dataInfo, buffer);
 
 			buffer.Write<uint8_t>((uint8_t)dataInfo.DataType);
-			WriteReferencesToBuffer(dataInfo.Reads, buffer);
-			WriteReferencesToBuffer(dataInfo.Writes, buffer);
+			WriteReferencesToBuffer(dataInfo.GetReads(), buffer);
+			WriteReferencesToBuffer(dataInfo.GetWrites(), buffer);
 		}
 	}
 	buffer.Write<uint16_t>(0xffff);	// terminator
@@ -282,8 +287,8 @@ bool FCodeAnalysisPage::ReadFromBuffer(FMemoryBuffer& buffer)
 		ReadItemFromBuffer(dataInfo, buffer);
 		dataInfo.Address = BaseAddress + pageAddr;
 		dataInfo.DataType = (EDataType)buffer.Read<uint8_t>();
-		ReadReferencesFromBuffer(dataInfo.Reads, buffer);
-		ReadReferencesFromBuffer(dataInfo.Writes, buffer);
+		ReadReferencesFromBuffer(dataInfo.EditReads(), buffer);
+		ReadReferencesFromBuffer(dataInfo.EditWrites(), buffer);
 	}
 
 	return true;
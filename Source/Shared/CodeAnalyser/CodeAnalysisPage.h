@@ -25,6 +25,7 @@ struct FCodeAnalysisPage
 {
 	void Initialise();
 	void Reset(void);
+	void ResetDataAccessStats(void);
 	//void WriteToBuffer(FMemoryBuffer& buffer);
 	//bool ReadFromBuffer(FMemoryBuffer& buffer);
 
@@ -41,4 +42,12 @@ struct FCodeAnalysisPage
 	FCommentBlock*	CommentBlocks[kPageSize];
 
 	FMachineState*	MachineState[kPageSize];
+
+	// Data access stats - kept in flat arrays so the per-access hot path & heatmap sweeps
+	// only touch a few contiguous ints rather than striding over whole FDataInfo items
+	int				ReadCount[kPageSize];
+	int				LastFrameRead[kPageSize];
+	int				WriteCount[kPageSize];
+	int				LastFrameWritten[kPageSize];
+	FAddressRef		LastWriter[kPageSize];
 };
\ No newline at end of file
@@ -41,27 +41,27 @@ void WritePageState(const FCodeAnalysisPage& page, FILE* fp)
 			const FDataInfo* pDataInfo = &page.DataInfo[pageAddr];
 
 			// check if we need to write
-			if (pDataInfo->Reads.GetReferences().empty() == false ||
-				pDataInfo->Writes.GetReferences().empty() == false ||
-				pDataInfo->LastWriter.IsValid())
+			if (pDataInfo->GetReads().GetReferences().empty() == false ||
+				pDataInfo->GetWrites().GetReferences().empty() == false ||
+				page.LastWriter[pageAddr].IsValid())
 			{
 				const uint16_t itemId = pageAddr | kDataId;
 				fwrite(&itemId, sizeof(itemId), 1, fp);
 
 				// Reads
-				tempU16 = (uint16_t)pDataInfo->Reads.GetReferences().size();
+				tempU16 = (uint16_t)pDataInfo->GetReads().GetReferences().size();
 				fwrite(&tempU16, sizeof(tempU16), 1, fp);
-				for (const auto& read : pDataInfo->Reads.GetReferences())
+				for (const auto& read : pDataInfo->GetReads().GetReferences())
 					fwrite(&read.Val, sizeof(read.Val), 1, fp);
 
 				// Writes
-				tempU16 = (uint16_t)pDataInfo->Writes.GetReferences().size();
+				tempU16 = (uint16_t)pDataInfo->GetWrites().GetReferences().size();
 				fwrite(&tempU16, sizeof(tempU16), 1, fp);
-				for (const auto& write : pDataInfo->Writes.GetReferences())
+				for (const auto& write : pDataInfo->GetWrites().GetReferences())
 					fwrite(&write.Val, sizeof(write.Val), 1, fp);
 
 				// Last Writer
-				fwrite(&pDataInfo->LastWriter.Val, sizeof(pDataInfo->LastWriter), 1, fp);
+				fwrite(&page.LastWriter[pageAddr].Val, sizeof(page.LastWriter[pageAddr]), 1, fp);
 			}
 
 			//pageAddr += pDataInfo->ByteSize;
@@ -111,26 +111,25 @@ void ReadPageState(FCodeAnalysisPage& page, FILE* fp)
 
 			// Reads
 			fread(&count, sizeof(count), 1, fp);
-			dataItem.Reads.Reset();
+			dataItem.References.Reset();
 			for (int i = 0; i < count; i++)
 			{
 				FAddressRef ref;
 				fread(&ref.Val, sizeof(ref.Val), 1, fp);
-				dataItem.Reads.RegisterAccess(ref);
+				dataItem.EditReads().RegisterAccess(ref);
 			}
 
 			// Writes
 			fread(&count, sizeof(count), 1, fp);
-			dataItem.Writes.Reset();
 			for (int i = 0; i < count; i++)
 			{
 				FAddressRef ref;
 				fread(&ref.Val, sizeof(ref.Val), 1, fp);
-				dataItem.Writes.RegisterAccess(ref);
+				dataItem.EditWrites().RegisterAccess(ref);
 			}
 
 			// Last Writer
-			fread(&dataItem.LastWriter.Val, sizeof(dataItem.LastWriter.Val), 1, fp);
+			fread(&page.LastWriter[pageAddr].Val, sizeof(page.LastWriter[pageAddr].Val), 1, fp);
 		}
 
 		fread(&itemId, sizeof(itemId), 1, fp);
@@ -153,7 +152,7 @@ bool ExportAnalysisState(FCodeAnalysisState& state, const char* pAnalysisBinFile
 	for (int bankNo = 0; bankNo < banks.size(); bankNo++)
 	{
 		const FCodeAnalysisBank& bank = banks[bankNo];
-		if (bank.bMachineROM)	// skip machine ROM banks
+		if (bank.bMachineROM || bank.Pages == nullptr)	// skip machine ROM & unallocated banks
 			continue;
 
 		for (int pageNo = 0; pageNo < bank.NoPages; pageNo++)
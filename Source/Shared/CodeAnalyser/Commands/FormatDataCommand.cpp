@@ -44,7 +44,7 @@ void FFormatDataCommand::Do(FCodeAnalysisState& state)
 		FAddressRef addressRef = firstAddress;
 		for (int itemNo = 0; itemNo < FormatOptions.NoItems; itemNo++)
 		{
-			FDataInfo* pDataInfo = state.GetDataInfoForAddress(addressRef);
+			FDataInfo* pDataInfo = state.EditDataInfoForAddress(addressRef);
 
 			UndoData.DataItems.push_back({ addressRef,*pDataInfo });
 
@@ -72,7 +72,7 @@ void FFormatDataCommand::Do(FCodeAnalysisState& state)
 					{
 						FAddressRef memberAddr = addressRef;
 						state.AdvanceAddressRef(memberAddr,member.ByteOffset);
-						FDataInfo* pMemberDataInfo = state.GetDataInfoForAddress(memberAddr);
+						FDataInfo* pMemberDataInfo = state.EditDataInfoForAddress(memberAddr);
 						pMemberDataInfo->DataType = member.DataType;
 						pMemberDataInfo->bStructMember = true;
 						pMemberDataInfo->SubTypeId = FormatOptions.StructId;
@@ -148,6 +148,7 @@ void FFormatDataCommand::Do(FCodeAnalysisState& state)
 			pLabel->ChangeName(labelText.c_str());
 
 		pLabel->Global = true;
+		AddLabelToGlobalInfo(state, pLabel, firstAddress);	// may have been renamed or made global
 	}
 
 	if (FormatOptions.AddCommentAtStart)
@@ -178,7 +179,12 @@ void FFormatDataCommand::Undo(FCodeAnalysisState& state)
 
 	for (auto& label : UndoData.Labels)
 	{
+		const FLabelInfo* pCurrentLabel = state.GetLabelForAddress(label.first);
+		if (pCurrentLabel != nullptr)
+			RemoveLabelFromGlobalInfo(state, pCurrentLabel);
 		state.SetLabelForAddress(label.first, label.second);
+		if (label.second != nullptr)
+			AddLabelToGlobalInfo(state, label.second, label.first);
 		state.SetCodeAnalysisDirty(label.first);
 	}
 
@@ -190,7 +196,7 @@ void FFormatDataCommand::Undo(FCodeAnalysisState& state)
 
 	for (auto& dataItem : UndoData.DataItems)
 	{
-		*state.GetDataInfoForAddress(dataItem.first) = dataItem.second;
+		*state.EditDataInfoForAddress(dataItem.first) = dataItem.second;
 		state.SetCodeAnalysisDirty(dataItem.first);
 	}
 
@@ -265,8 +271,8 @@ void FBatchFormatDataCommand::Do(FCodeAnalysisState& state)
 
 		FFormatDataCommand& cmd = SubCommands.emplace_back(options);
 		cmd.Do(state);
+		state.SetCodeAnalysisRangeDirty(options.StartAddress, options.ItemSize * options.NoItems);
 		state.AdvanceAddressRef(options.StartAddress, options.ItemSize * options.NoItems);
-		state.SetCodeAnalysisDirty(options.StartAddress);
 	}
 }
 
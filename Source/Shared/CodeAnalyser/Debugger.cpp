@@ -5,11 +5,16 @@
 #include <chips/z80.h>
 
 #include <imgui.h>
+#include <misc/cpp/imgui_stdlib.h>
 #include "UI/CodeAnalyserUI.h"
 #include "Z80/Z80Disassembler.h"
 #include "6502/M6502Disassembler.h"
 #include <Util/GraphicsView.h>
 #include "Misc/EmuBase.h"
+#include "Debug/DebugLog.h"
+#include <Util/FileUtil.h>
+
+#include <ctime>
 
 static const uint32_t	BPMask_Exec			= 0x0001;
 static const uint32_t	BPMask_DataWrite	= 0x0002;
@@ -40,11 +45,16 @@ void FDebugger::Init(FCodeAnalysisState* pCA)
     Watches.clear();
 	//Stacks.clear();
 	Breakpoints.clear();
+	MarkBreakpointsDirty();
+	ReverseDebugger.Init(pCodeAnalysis->GetEmulator());
 
 }
 
 void FDebugger::CPUTick(uint64_t pins)
 {
+	if (bBreakpointsDirty)
+		UpdateBreakpointMasks();
+
     const uint64_t risingPins = pins & (pins ^ LastTickPins);
     int trapId = kTrapId_None;
 
@@ -83,6 +93,10 @@ void FDebugger::CPUTick(uint64_t pins)
 		bNMI = risingPins & M6502_NMI;
 	}
 
+	// IO & interrupt pins are held for several ticks so breakpoint hits are only counted when they go active
+	const bool bIORequestEdge = (risingPins & Z80_IORQ) != 0;
+	const bool bIrqEdge = bIrq && !bLastTickIrq;
+
 	// setup breakpoint mask to check
 	BPMaskCheck |= bWrite ? BPMask_DataWrite : 0;
 	BPMaskCheck |= bRead ? BPMask_DataRead : 0;
@@ -92,9 +106,25 @@ void FDebugger::CPUTick(uint64_t pins)
     if (bNewOp)
     {
         PC = pCodeAnalysis->AddressRefFromPhysicalAddress(pins & 0xffff);
+		ReverseDebugger.OnInstruction(PC);
+		if (TraceRecorder.IsRecording() && IsReplaying() == false)
+			TraceRecorder.OnInstruction(PC);
 		trapId = OnInstructionExecuted(pins);
 	}
 
+	if (bWrite && ReverseDebugger.IsEnabled())
+		ReverseDebugger.OnMemoryWrite(addrRef, (uint8_t)(CPUType == ECPUType::Z80 ? Z80_GET_DATA(pins) : M6502_GET_DATA(pins)));
+
+	// a reverse step's replay was recorded when it first ran
+	if (TraceRecorder.IsRecording() && IsReplaying() == false)
+	{
+		if (bWrite)
+			TraceRecorder.OnMemoryWrite(addrRef, (uint8_t)(CPUType == ECPUType::Z80 ? Z80_GET_DATA(pins) : M6502_GET_DATA(pins)));
+		// IO pins are held for several ticks so only record when IORQ goes active
+		if ((bIORead || bIOWrite) && bIORequestEdge)
+			TraceRecorder.OnIO((uint16_t)addr, Z80_GET_DATA(pins), bIOWrite);
+	}
+
     // tick based stepping
     switch (StepMode)
     {
@@ -137,59 +167,59 @@ void FDebugger::CPUTick(uint64_t pins)
             break;
     }
 
-    // iterate through data breakpoints
-	// this can slow down if there are a lot of BPs
-	// Do a mask check
-	if (BPMaskCheck & BreakpointMask)
+	// data breakpoints are checked with the bitmap, the breakpoint list is only searched on a hit
+	// breakpoints were already hit on the way to the replay target so don't stop on them again
+	if ((BPMaskCheck & BreakpointMask) && StepMode != EDebugStepMode::Replay)
 	{
-		for (int i = 0; i < Breakpoints.size(); i++)
+		if ((bWrite || bRead) && DataBreakpointMap.IsSet(addrRef))
 		{
-			const FBreakpoint& bp = Breakpoints[i];
+			const int bpNo = FindDataBreakpoint(addrRef);
+			if (bpNo != -1 && CheckBreakpointCondition(Breakpoints[bpNo]))
+				trapId = kTrapId_BpBase + bpNo;
+		}
 
-			if (bp.bEnabled)
+		// iterate through the other breakpoints
+		if (BreakpointMask & (BPMask_IORead | BPMask_IOWrite | BPMask_IRQ | BPMask_NMI))
+		{
+			for (int i = 0; i < Breakpoints.size(); i++)
 			{
-				switch (bp.Type)
+				FBreakpoint& bp = Breakpoints[i];
+
+				if (bp.bEnabled)
 				{
-				case EBreakpointType::Data:
-					if ((bWrite || bRead) &&
-						addrRef.BankId == bp.Address.BankId &&
-						addrRef.Address >= bp.Address.Address &&
-						addrRef.Address < bp.Address.Address + bp.Size)
+					bool bHit = false;
+					switch (bp.Type)
 					{
-						trapId = kTrapId_BpBase + i;
+					case EBreakpointType::Irq:
+						bHit = bIrqEdge;
+						break;
+
+					case EBreakpointType::NMI:
+						bHit = bNMI;
+						break;
+
+						// In/Out - only for Z80
+					case EBreakpointType::In:
+						if (bIORead && bIORequestEdge)
+						{
+							const uint16_t mask = bp.Val;
+							bHit = (Z80_GET_ADDR(pins) & mask) == (bp.Address.Address & mask);
+						}
+						break;
+
+					case EBreakpointType::Out:
+						if (bIOWrite && bIORequestEdge)
+						{
+							const uint16_t mask = bp.Val;
+							bHit = (Z80_GET_ADDR(pins) & mask) == (bp.Address.Address & mask);
+						}
+						break;
+					default:
+						break;
 					}
-					break;
 
-				case EBreakpointType::Irq:
-					if (bIrq)
+					if (bHit && CheckBreakpointCondition(bp))
 						trapId = kTrapId_BpBase + i;
-					break;
-
-				case EBreakpointType::NMI:
-					if (bNMI)
-						trapId = kTrapId_BpBase + i;
-					break;
-
-					// In/Out - only for Z80
-				case EBreakpointType::In:
-					if (bIORead)
-					{
-						const uint16_t mask = bp.Val;
-						if ((Z80_GET_ADDR(pins) & mask) == (bp.Address.Address & mask))
-							trapId = kTrapId_BpBase + i;
-					}
-					break;
-
-				case EBreakpointType::Out:
-					if (bIOWrite)
-					{
-						const uint16_t mask = bp.Val;
-						if ((Z80_GET_ADDR(pins) & mask) == (bp.Address.Address & mask))
-							trapId = kTrapId_BpBase + i;
-					}
-					break;
-                default:
-                    break;
 				}
 			}
 		}
@@ -201,6 +231,7 @@ void FDebugger::CPUTick(uint64_t pins)
     }
 
     LastTickPins = pins;
+	bLastTickIrq = bIrq;
 }
 
 int FDebugger::OnInstructionExecuted(uint64_t pins)
@@ -219,6 +250,10 @@ int FDebugger::OnInstructionExecuted(uint64_t pins)
 			if (PC == StepOverPC)
 				trapId = kTrapId_Step;
 			break;
+		case EDebugStepMode::Replay:
+			if (--ReplayInstructionsRemaining == 0)
+				trapId = kTrapId_Step;
+			break;
         default:
             break;
 		}
@@ -227,14 +262,14 @@ int FDebugger::OnInstructionExecuted(uint64_t pins)
 	{
 		for (int i = 0; i < Breakpoints.size(); i++)
 		{
-			const FBreakpoint& bp = Breakpoints[i];
+			FBreakpoint& bp = Breakpoints[i];
 
 			if (bp.bEnabled)
 			{
 				switch (bp.Type)
 				{
 				case EBreakpointType::Exec:
-					if (PC == bp.Address)
+					if (PC == bp.Address && CheckBreakpointCondition(bp))
 					{
 						trapId = kTrapId_BpBase + i;
 					}
@@ -296,7 +331,7 @@ void FDebugger::OnScanlineStart(int scanlineNo)
 	//if (BreakpointMask & BPMask_Scanline)
 	{
 		// TODO: check for scanline breakpoint
-		if(scanlineNo == ScanlineBreakpoint)
+		if(scanlineNo == ScanlineBreakpoint && StepMode != EDebugStepMode::Replay)
 			Break();
 	}
 }
@@ -324,9 +359,22 @@ void FDebugger::OnMachineFrameEnd()
 void FDebugger::StartFrame() 
 { 
 	FrameTrace.clear();
+	if (ReverseDebugger.IsEnabled())
+	{
+		RewindDebuggerState.CallStack = CallStack;
+		RewindDebuggerState.FrameTraceSize = FrameTrace.size();
+		RewindDebuggerState.EventTraceSize = EventTrace.size();
+		ReverseDebugger.OnExecuteStart(RewindDebuggerState);
+	}
+	if (TraceRecorder.IsRecording())
+		TraceRecorder.OnFrameStart(pCodeAnalysis->CurrentFrameNo, PC);
+}
 
-	// Setup breakpoint mask 
+// Rebuild the breakpoint mask & data breakpoint map after the breakpoints have changed
+void FDebugger::UpdateBreakpointMasks()
+{
 	BreakpointMask = 0;
+	DataBreakpointMap.Clear();
 
 	for (int i = 0; i < Breakpoints.size(); i++)
 	{
@@ -342,6 +390,7 @@ void FDebugger::StartFrame()
 			case EBreakpointType::Data:
 				BreakpointMask |= BPMask_DataWrite;
 				BreakpointMask |= BPMask_DataRead;
+				DataBreakpointMap.AddRange(bp.Address, bp.Size);
 				break;
 			case EBreakpointType::In:
 				BreakpointMask |= BPMask_IORead;
@@ -360,6 +409,8 @@ void FDebugger::StartFrame()
 			}
 		}
 	}
+
+	bBreakpointsDirty = false;
 }
 
 bool FDebugger::FrameTick(void)
@@ -369,7 +420,7 @@ bool FDebugger::FrameTick(void)
 	return bDebuggerStopped;
 }
 
-static const uint32_t kVersionNo = 4;
+static const uint32_t kVersionNo = 5;
 
 // Load state - breakpoints, watches etc.
 void	FDebugger::LoadFromFile(FILE* fp)
@@ -390,6 +441,7 @@ void	FDebugger::LoadFromFile(FILE* fp)
 
 	// breakpoints
 	Breakpoints.clear();
+	MarkBreakpointsDirty();
 	fread(&num, sizeof(uint32_t), 1, fp);
 	for (int i = 0; i < (int)num; i++)
 	{
@@ -419,6 +471,21 @@ void	FDebugger::LoadFromFile(FILE* fp)
 
 	if (versionNo > 3)
 		fread(&ScanlineBreakpoint, sizeof(int), 1, fp);
+
+	// breakpoint conditions
+	if (versionNo > 4)
+	{
+		std::string condition;
+		for (FBreakpoint& bp : Breakpoints)
+		{
+			uint32_t length = 0;
+			fread(&length, sizeof(uint32_t), 1, fp);
+			condition.resize(length);
+			if (length > 0)
+				fread(condition.data(), length, 1, fp);
+			SetBreakpointCondition(bp, condition.c_str());
+		}
+	}
 }
 
 // Save state - breakpoints, watches etc.
@@ -462,6 +529,15 @@ void	FDebugger::SaveToFile(FILE* fp)
 
 	// Scanline BP
 	fwrite(&ScanlineBreakpoint, sizeof(int), 1, fp);
+
+	// breakpoint conditions
+	for (const FBreakpoint& bp : Breakpoints)
+	{
+		const uint32_t length = (uint32_t)bp.Condition.size();
+		fwrite(&length, sizeof(uint32_t), 1, fp);
+		if (length > 0)
+			fwrite(bp.Condition.data(), length, 1, fp);
+	}
 }
 
 
@@ -566,6 +642,104 @@ void	FDebugger::StepIOWrite()
 	bDebuggerStopped = false;
 }
 
+// Go back one instruction
+bool FDebugger::StepBack()
+{
+	if (bDebuggerStopped == false)
+		return false;
+	if (ReverseDebugger.IsEnabled() == false)
+	{
+		LOGWARNING("Turn on 'Record History' in the debugger's History tab to step back");
+		return false;
+	}
+
+	return ReverseToInstruction(ReverseDebugger.GetInstructionCount() - 1);
+}
+
+// Search the history for the last time an exec breakpoint was hit or a data breakpoint was written to & go back to it
+// Conditions aren't evaluated & reads aren't logged so only those are matched
+bool FDebugger::RunBackToBreakpoint()
+{
+	if (bDebuggerStopped == false)
+		return false;
+
+	std::vector<FAddressRef> execBreakpoints;
+	FDataBreakpointMap writeBreakpoints;
+	for (const FBreakpoint& bp : Breakpoints)
+	{
+		if (bp.bEnabled == false)
+			continue;
+		if (bp.Type == EBreakpointType::Exec)
+			execBreakpoints.push_back(bp.Address);
+		else if (bp.Type == EBreakpointType::Data)
+			writeBreakpoints.AddRange(bp.Address, bp.Size);
+	}
+
+	const uint64_t currentInstruction = ReverseDebugger.GetInstructionCount();
+	const std::deque<FRewindSegment>& segments = ReverseDebugger.GetSegments();
+	for (auto segmentIt = segments.rbegin(); segmentIt != segments.rend(); ++segmentIt)
+	{
+		const FRewindSegment& segment = *segmentIt;
+		uint64_t targetInstruction = 0;
+
+		// PCs[i] was recorded when the instruction count became FirstInstruction + i + 1
+		for (int i = (int)segment.PCs.size() - 1; i >= 0 && targetInstruction == 0; i--)
+		{
+			const uint64_t instructionNo = segment.FirstInstruction + i + 1;
+			if (instructionNo >= currentInstruction)
+				continue;
+			for (const FAddressRef& bpAddress : execBreakpoints)
+			{
+				if (segment.PCs[i] == bpAddress)
+				{
+					targetInstruction = instructionNo;
+					break;
+				}
+			}
+		}
+
+		// stop before the instruction that made the write
+		for (int i = (int)segment.Writes.size() - 1; i >= 0; i--)
+		{
+			const FRewindWrite& write = segment.Writes[i];
+			const uint64_t instructionNo = segment.FirstInstruction + write.InstructionNo;
+			if (instructionNo <= targetInstruction)
+				break;
+			if (instructionNo < currentInstruction && writeBreakpoints.IsSet(write.Address))
+			{
+				targetInstruction = instructionNo;
+				break;
+			}
+		}
+
+		if (targetInstruction != 0)
+			return ReverseToInstruction(targetInstruction);
+	}
+
+	return false;
+}
+
+// restore the history & let the emulator run forward to the instruction
+bool FDebugger::ReverseToInstruction(uint64_t instructionNo)
+{
+	uint64_t noInstructionsToReplay = 0;
+	if (ReverseDebugger.RestoreToInstruction(instructionNo, noInstructionsToReplay, RewindDebuggerState) == false)
+		return false;
+
+	// the replay adds back what happened between the restore point & the target
+	// the traces can only be cut back as they may have been cleared since
+	CallStack = RewindDebuggerState.CallStack;
+	if (FrameTrace.size() > RewindDebuggerState.FrameTraceSize)
+		FrameTrace.erase(FrameTrace.begin() + RewindDebuggerState.FrameTraceSize, FrameTrace.end());
+	if (EventTrace.size() > RewindDebuggerState.EventTraceSize)
+		EventTrace.erase(EventTrace.begin() + RewindDebuggerState.EventTraceSize, EventTrace.end());
+
+	ReplayInstructionsRemaining = noInstructionsToReplay;
+	StepMode = EDebugStepMode::Replay;
+	bDebuggerStopped = false;
+	return true;
+}
+
 // Breakpoints
 
 bool FDebugger::AddExecBreakpoint(FAddressRef addr)
@@ -574,6 +748,7 @@ bool FDebugger::AddExecBreakpoint(FAddressRef addr)
 		return false;
 
 	Breakpoints.emplace_back(addr, EBreakpointType::Exec);
+	MarkBreakpointsDirty();
 	return true;
 }
 
@@ -583,9 +758,57 @@ bool FDebugger::AddDataBreakpoint(FAddressRef addr, uint16_t size)
 		return false;
 
 	Breakpoints.emplace_back(addr, EBreakpointType::Data,size);
+	MarkBreakpointsDirty();
 	return true;
 }
 
+// conditions that fail to compile are logged & the breakpoint breaks every time
+bool FDebugger::SetBreakpointCondition(FBreakpoint& bp, const char* pCondition)
+{
+	bp.Condition = pCondition;
+	bp.HitCount = 0;
+	if (bp.CompiledCondition.Compile(pCondition, *this, bp.ConditionError))
+		return true;
+
+	LOGWARNING("Breakpoint condition '%s' at %s: %s", pCondition, NumStr(bp.Address.Address), bp.ConditionError.c_str());
+	return false;
+}
+
+// find the enabled data breakpoint covering an address
+int FDebugger::FindDataBreakpoint(FAddressRef addr) const
+{
+	for (int i = 0; i < Breakpoints.size(); i++)
+	{
+		const FBreakpoint& bp = Breakpoints[i];
+		if (bp.bEnabled && bp.Type == EBreakpointType::Data &&
+			addr.BankId == bp.Address.BankId &&
+			addr.Address >= bp.Address.Address &&
+			addr.Address < bp.Address.Address + bp.Size)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void FDataBreakpointMap::AddRange(FAddressRef start, uint16_t size)
+{
+	if (start.BankId < 0)
+		return;
+
+	if (start.BankId >= (int)BankBits.size())
+		BankBits.resize(start.BankId + 1);
+
+	std::vector<uint64_t>& bits = BankBits[start.BankId];
+	if (bits.empty())
+		bits.resize(65536 / 64, 0);
+
+	const int endAddress = std::min((int)start.Address + size, 65536);
+	for (int address = start.Address; address < endAddress; address++)
+		bits[address >> 6] |= 1ull << (address & 63);
+}
+
 bool FDebugger::RemoveBreakpoint(FAddressRef addr)
 {
 	for (int i = 0; i < Breakpoints.size(); i++)
@@ -594,6 +817,7 @@ bool FDebugger::RemoveBreakpoint(FAddressRef addr)
 		{
 			Breakpoints[i] = Breakpoints.back();
 			Breakpoints.pop_back();
+			MarkBreakpointsDirty();
 			return true;
 		}
 	}
@@ -606,6 +830,7 @@ bool FDebugger::ChangeBreakpointAddress(FAddressRef oldAddress, FAddressRef newA
 	if(pBP == nullptr || IsAddressBreakpointed(newAddress))	// return false if either address is invalid
 		return false;
 	pBP->Address = newAddress;
+	MarkBreakpointsDirty();
 	return true;
 }
 
@@ -748,6 +973,11 @@ void FDebugger::RegisterEvent(uint8_t type, FAddressRef pc, uint16_t address, ui
 
 	ScanlineEvents[scanlinePos] = type;
 	EventTrace.emplace_back(type, pc, address, value, scanlinePos);
+	if (IsReplaying())	// the trace was cut back to the restore point, everything else has already been done
+		return;
+
+	if (TraceRecorder.IsRecording())
+		TraceRecorder.OnEvent({ type, pc, address, value, scanlinePos });
 
 	if(bWriteEventComments)
 	{ 
@@ -861,6 +1091,100 @@ bool FDebugger::GetRegisterWordValue(const char* regName, uint16_t& outVal) cons
 	return false;
 }
 
+// registers conditions can use, the index is the id compiled into the condition
+enum EConditionRegister : uint8_t
+{
+	ConditionReg_A, ConditionReg_B, ConditionReg_C, ConditionReg_D, ConditionReg_E, ConditionReg_H, ConditionReg_L, ConditionReg_R, ConditionReg_I,
+	ConditionReg_X, ConditionReg_Y,
+	ConditionReg_BC, ConditionReg_DE, ConditionReg_HL, ConditionReg_IX, ConditionReg_IY, ConditionReg_SP,
+	ConditionReg_PC,
+
+	ConditionReg_Count
+};
+
+static const char* g_ConditionRegisterNames[ConditionReg_Count] =
+{
+	"A", "B", "C", "D", "E", "H", "L", "R", "I",
+	"X", "Y",
+	"BC", "DE", "HL", "IX", "IY", "SP",
+	"PC",
+};
+
+// the name lookup is done once when a condition is compiled
+bool FDebugger::GetConditionRegisterId(const char* pRegName, uint8_t& outId, bool& bOutWord) const
+{
+	uint8_t byteVal = 0;
+	uint16_t wordVal = 0;
+	if (strcmp(pRegName, "PC") == 0)
+		bOutWord = true;
+	else if (GetRegisterByteValue(pRegName, byteVal))
+		bOutWord = false;
+	else if (GetRegisterWordValue(pRegName, wordVal))
+		bOutWord = true;
+	else
+		return false;
+
+	for (int regNo = 0; regNo < ConditionReg_Count; regNo++)
+	{
+		if (strcmp(g_ConditionRegisterNames[regNo], pRegName) == 0)
+		{
+			outId = (uint8_t)regNo;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint16_t FDebugger::GetConditionRegisterValue(uint8_t regId) const
+{
+	if (regId == ConditionReg_PC)
+		return PC.Address;
+
+	if (CPUType == ECPUType::Z80)
+	{
+		switch (regId)
+		{
+		case ConditionReg_A: return pZ80->a;
+		case ConditionReg_B: return pZ80->b;
+		case ConditionReg_C: return pZ80->c;
+		case ConditionReg_D: return pZ80->d;
+		case ConditionReg_E: return pZ80->e;
+		case ConditionReg_H: return pZ80->h;
+		case ConditionReg_L: return pZ80->l;
+		case ConditionReg_R: return pZ80->r;
+		case ConditionReg_I: return pZ80->i;
+		case ConditionReg_BC: return pZ80->bc;
+		case ConditionReg_DE: return pZ80->de;
+		case ConditionReg_HL: return pZ80->hl;
+		case ConditionReg_IX: return pZ80->ix;
+		case ConditionReg_IY: return pZ80->iy;
+		case ConditionReg_SP: return pZ80->sp;
+		default: break;
+		}
+	}
+	else if (CPUType == ECPUType::M6502)
+	{
+		switch (regId)
+		{
+		case ConditionReg_A: return pM6502->A;
+		case ConditionReg_X: return pM6502->X;
+		case ConditionReg_Y: return pM6502->Y;
+		default: break;
+		}
+	}
+	return 0;
+}
+
+uint8_t FDebugger::GetConditionMemoryValue(uint16_t address) const
+{
+	return pCodeAnalysis->ReadByte(address);
+}
+
+int FDebugger::GetConditionFrameNo() const
+{
+	return pCodeAnalysis->CurrentFrameNo;
+}
+
 const char* FDebugger::GetRegisterStringValue(const char* regName) const
 {
 	uint8_t byteVal = 0;
@@ -1089,7 +1413,7 @@ void FDebugger::DrawWatches(void)
 
 	for (const auto& watch : Watches)
 	{
-		FDataInfo* pDataInfo = state.GetDataInfoForAddress(watch);
+		FDataInfo* pDataInfo = state.EditDataInfoForAddress(watch);
 		ImGui::PushID(watch.Val);
 		if (ImGui::Selectable("##watchselect", watch == SelectedWatch, 0))
 		{
@@ -1103,7 +1427,7 @@ void FDebugger::DrawWatches(void)
 			}
 			if (ImGui::Selectable("Toggle Breakpoint"))
 			{
-				FDataInfo* pInfo = state.GetDataInfoForAddress(SelectedWatch);
+				const FDataInfo* pInfo = state.GetDataInfoForAddress(SelectedWatch);
 				state.ToggleDataBreakpointAtAddress(SelectedWatch, pInfo->ByteSize);
 			}
 
@@ -1140,12 +1464,14 @@ void FDebugger::DrawBreakpoints(void)
 	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
 
 	static ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
-	if (ImGui::BeginTable("Breakpoints", 4, flags))
+	if (ImGui::BeginTable("Breakpoints", 6, flags))
 	{
 		ImGui::TableSetupColumn("Enabled", ImGuiTableColumnFlags_WidthFixed, 60);
 		ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthStretch);
 		ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed,50);
 		ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed,40);
+		ImGui::TableSetupColumn("Hits", ImGuiTableColumnFlags_WidthFixed,50);
+		ImGui::TableSetupColumn("Condition", ImGuiTableColumnFlags_WidthStretch);
 		ImGui::TableHeadersRow();
 
 		for (auto& bp : Breakpoints)
@@ -1153,7 +1479,8 @@ void FDebugger::DrawBreakpoints(void)
 			ImGui::PushID(bp.Address.Val);
 			ImGui::TableNextRow();
 			ImGui::TableSetColumnIndex(0);
-			ImGui::Checkbox("##Enabled", &bp.bEnabled);
+			if (ImGui::Checkbox("##Enabled", &bp.bEnabled))
+				MarkBreakpointsDirty();
 			ImGui::TableSetColumnIndex(1);
 			ImGui::Text("%s:", NumStr(bp.Address.Address));
 			DrawAddressLabel(state, viewState, bp.Address);
@@ -1161,6 +1488,25 @@ void FDebugger::DrawBreakpoints(void)
 			ImGui::Text("%s", GetBreakpointTypeText(bp.Type));
 			ImGui::TableSetColumnIndex(3);
 			ImGui::Text("%d", bp.Size);
+			ImGui::TableSetColumnIndex(4);
+			ImGui::Text("%d", bp.HitCount);
+			ImGui::TableSetColumnIndex(5);
+			ImGui::SetNextItemWidth(-FLT_MIN);
+			const bool bConditionError = bp.ConditionError.empty() == false;
+			if (bConditionError)
+				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+			if (ImGui::InputText("##Condition", &bp.Condition, ImGuiInputTextFlags_EnterReturnsTrue))
+				SetBreakpointCondition(bp, bp.Condition.c_str());
+			if (bConditionError)
+			{
+				ImGui::PopStyleColor();
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("%s", bp.ConditionError.c_str());
+			}
+			else if (ImGui::IsItemHovered() && bp.Condition.empty())
+			{
+				ImGui::SetTooltip("e.g. A == 3 && (HL) > $80, hits > 100 or frame > 50. Enter to apply");
+			}
 			ImGui::PopID();
 		}
 		ImGui::EndTable();
@@ -1376,6 +1722,100 @@ void FDebugger::DrawEvents(void)
 	}
 }
 
+void FDebugger::DrawReverseHistory(void)
+{
+	bool bRecord = ReverseDebugger.IsEnabled();
+	if (ImGui::Checkbox("Record History", &bRecord))
+		ReverseDebugger.SetEnabled(bRecord);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100.0f);
+	ImGui::InputInt("Max Segments", &ReverseDebugger.MaxSegments);
+	ReverseDebugger.MaxSegments = std::max(ReverseDebugger.MaxSegments, 2);
+
+	if (ImGui::Button("Step Back (F8)"))
+		StepBack();
+	ImGui::SameLine();
+	if (ImGui::Button("Run Back To Breakpoint"))
+		RunBackToBreakpoint();
+
+	const std::deque<FRewindSegment>& segments = ReverseDebugger.GetSegments();
+	const uint64_t noInstructions = segments.empty() ? 0 : ReverseDebugger.GetInstructionCount() - segments.front().FirstInstruction;
+	ImGui::Text("Instructions: %d", (int)noInstructions);
+	ImGui::Text("Segments: %d", (int)segments.size());
+	ImGui::Text("Memory: %dK", (int)(ReverseDebugger.GetMemoryUsage() / 1024));
+}
+
+bool FDebugger::StartTraceRecording()
+{
+	const FEmuBase* pEmu = pCodeAnalysis->GetEmulator();
+	if (pEmu == nullptr || pEmu->GetProjectConfig() == nullptr)
+		return false;
+
+	const std::string traceDir = pEmu->GetGameWorkspaceRoot() + "Traces/";
+	EnsureDirectoryExists(traceDir.c_str());
+
+	char timeStr[32];
+	const time_t now = time(nullptr);
+	strftime(timeStr, sizeof(timeStr), "%Y%m%d_%H%M%S", localtime(&now));
+	const std::string fileName = traceDir + timeStr + ".trace";
+	return TraceRecorder.StartRecording(fileName.c_str());
+}
+
+void FDebugger::DrawTraceRecording(void)
+{
+	FCodeAnalysisState& state = *pCodeAnalysis;
+
+	if (TraceRecorder.IsRecording())
+	{
+		if (ImGui::Button("Stop Recording"))
+			TraceRecorder.StopRecording();
+
+		const FTraceRecorderStats stats = TraceRecorder.GetStats();
+		ImGui::Text("Recording to: %s", TraceRecorder.GetFileName().c_str());
+		ImGui::Text("Frames: %d", stats.NoFrames);
+		ImGui::Text("Size: %dK (%dK uncompressed)", (int)(stats.StoredBytes / 1024), (int)(stats.RawBytes / 1024));
+		return;
+	}
+
+	if (ImGui::Button("Start Recording"))
+	{
+		TraceReader.Close();	// the file is about to be replaced
+		StartTraceRecording();
+	}
+
+	// query the last recording
+	const std::string& fileName = TraceRecorder.GetFileName();
+	if (fileName.empty())
+		return;
+
+	ImGui::Separator();
+	ImGui::Text("Trace: %s", fileName.c_str());
+	if (TraceReader.IsOpen() == false && TraceReader.Open(fileName.c_str()) == false)
+		return;
+
+	ImGui::Text("Frames %d - %d", TraceReader.GetFrameNo(0), TraceReader.GetFrameNo(TraceReader.GetNoFrames() - 1));
+	ImGui::SetNextItemWidth(100.0f);
+	ImGui::InputInt("Frame", &TraceQueryFrameNo);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100.0f);
+	ImGui::InputInt("Address", &TraceQueryAddress, 1, 8, ImGuiInputTextFlags_CharsHexadecimal);
+	TraceQueryAddress &= 0xffff;
+	ImGui::SameLine();
+	if (ImGui::Button("Find Writes"))
+	{
+		if (TraceReader.FindWritesToAddress(TraceQueryFrameNo, state.AddressRefFromPhysicalAddress((uint16_t)TraceQueryAddress), TraceQueryWrites) == false)
+			LOGWARNING("Frame %d is not in the trace", TraceQueryFrameNo);
+	}
+
+	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
+	for (const FTraceWrite& write : TraceQueryWrites)
+	{
+		ImGui::Text("%s written by", NumStr(write.Value));
+		ImGui::SameLine();
+		DrawAddressLabel(state, viewState, write.PC);
+	}
+}
+
 void FDebugger::DrawUI(void)
 {
 	if (ImGui::Button("Step IO Read"))
@@ -1428,6 +1868,18 @@ void FDebugger::DrawUI(void)
 			ImGui::EndTabItem();
 		}
 
+		if (ImGui::BeginTabItem("History"))
+		{
+			DrawReverseHistory();
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Recording"))
+		{
+			DrawTraceRecording();
+			ImGui::EndTabItem();
+		}
+
 		ImGui::EndTabBar();
 	}
 }
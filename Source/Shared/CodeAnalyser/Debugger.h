@@ -1,9 +1,13 @@
 #pragma once
 
 #include <CodeAnalyser/CodeAnalyserTypes.h>
+#include <CodeAnalyser/BreakpointCondition.h>
+#include <CodeAnalyser/ReverseDebugger.h>
+#include <CodeAnalyser/TraceRecorder.h>
 
 #include <chips/z80.h>
 #include <chips/m6502.h>
+#include <string>
 #include <vector>
 
 #include <stdio.h>
@@ -28,6 +32,7 @@ enum class EDebugStepMode
 	IOWrite,
 	Interrupt,
 	NMI,
+	Replay,	// running forward to an instruction after restoring history
 };
 
 // only add to end otherwise you'll break the file format
@@ -57,6 +62,29 @@ struct FBreakpoint
 	EBreakpointType	Type = EBreakpointType::None;
 	bool			bEnabled = true;
 	uint16_t		Size = 1;
+
+	std::string				Condition;		// only break when this is true, empty to always break
+	std::string				ConditionError;
+	FBreakpointCondition	CompiledCondition;
+	int						HitCount = 0;	// not saved
+};
+
+// Bit per address for each bank with data breakpoints so checking a memory access is a single bit test
+// Data breakpoints trigger on reads & writes so one map covers both
+class FDataBreakpointMap
+{
+public:
+	void	Clear() { BankBits.clear(); }
+	void	AddRange(FAddressRef start, uint16_t size);
+	bool	IsSet(FAddressRef addr) const
+	{
+		if (addr.BankId < 0 || addr.BankId >= (int)BankBits.size())
+			return false;
+		const std::vector<uint64_t>& bits = BankBits[addr.BankId];
+		return bits.empty() == false && ((bits[addr.Address >> 6] >> (addr.Address & 63)) & 1);
+	}
+private:
+	std::vector<std::vector<uint64_t>>	BankBits;	// indexed by bank id, empty for banks without data breakpoints
 };
 
 struct FWatch : public FAddressRef
@@ -66,13 +94,6 @@ struct FWatch : public FAddressRef
 	FWatch(int16_t bankId, uint16_t address) : FAddressRef(bankId, address) {}
 };
 
-struct FCPUFunctionCall
-{
-	FAddressRef		FunctionAddr;
-	FAddressRef		CallAddr;
-	FAddressRef		ReturnAddr;
-};
-
 /*struct FStackInfo
 {
 	FStackInfo(uint16_t basePtr) :BasePtr(basePtr) {}
@@ -100,7 +121,7 @@ struct FEvent
 typedef void (*ShowEventInfoCB)(FCodeAnalysisState& state, const FEvent& event);
 
 
-class FDebugger
+class FDebugger : public IBreakpointConditionContext
 {
 public:
 	void	Init(FCodeAnalysisState* pCodeAnalysis);
@@ -124,6 +145,8 @@ public:
 	void	StepScreenWrite();
 	void	StepIORead();
 	void	StepIOWrite();
+	bool	StepBack();
+	bool	RunBackToBreakpoint();
 	void	SetPC(FAddressRef newPC) { PC = newPC; }
 
 	// Breakpoints
@@ -136,6 +159,12 @@ public:
 	void	SetScanlineBreakpoint(int scanline) { ScanlineBreakpoint = scanline;}
 	void	ClearScanlineBreakpoint(void) { ScanlineBreakpoint = -1;}
 	int		GetScanlineBreakpoint() const { return ScanlineBreakpoint;}
+	bool	SetBreakpointCondition(FBreakpoint& bp, const char* pCondition);
+	void	MarkBreakpointsDirty() { bBreakpointsDirty = true; }	// call after changing a breakpoint's address, size or enabled state directly
+	void	UpdateBreakpointMasks();
+	bool	AreBreakpointsDirty() const { return bBreakpointsDirty; }
+	const FDataBreakpointMap& GetDataBreakpointMap() const { return DataBreakpointMap; }
+	int		FindDataBreakpoint(FAddressRef addr) const;	// enabled data breakpoint covering an address, -1 if none
 	
 	// Watches
 	void	AddWatch(FWatch watch);
@@ -164,6 +193,14 @@ public:
 
 	std::vector<FCPUFunctionCall>& GetCallstack() { return CallStack; }
 
+	// Reverse debugging
+	FReverseDebugger&	GetReverseDebugger() { return ReverseDebugger; }
+	bool	IsReplaying() const { return StepMode == EDebugStepMode::Replay; }
+
+	// Trace recording
+	FTraceRecorder&	GetTraceRecorder() { return TraceRecorder; }
+	bool	StartTraceRecording();
+
 	// Queries
 	bool	IsStopped() const { return bDebuggerStopped; }
 	bool	IsAddressBreakpointed(FAddressRef addr) const;
@@ -173,6 +210,12 @@ public:
 	bool GetRegisterByteValue(const char* regName, uint8_t& outVal) const;
 	bool GetRegisterWordValue(const char* regName, uint16_t& outVal) const;
 
+	// IBreakpointConditionContext
+	bool		GetConditionRegisterId(const char* pRegName, uint8_t& outId, bool& bOutWord) const override;
+	uint16_t	GetConditionRegisterValue(uint8_t regId) const override;
+	uint8_t		GetConditionMemoryValue(uint16_t address) const override;
+	int			GetConditionFrameNo() const override;
+
 	bool* GetDebuggerStoppedPtr() { return &bDebuggerStopped; }
 
 	// UI
@@ -182,11 +225,19 @@ public:
 	void	DrawWatches(void);
 	void	DrawBreakpoints(void);
 	void	DrawEvents(void);
+	void	DrawReverseHistory(void);
+	void	DrawTraceRecording(void);
 	void	DrawUI(void);
 
 	void FixupAddresRefs(void);
 private:
 	int		GetFrameTraceItemIndex(FAddressRef address);
+	bool	ReverseToInstruction(uint64_t instructionNo);
+	bool	CheckBreakpointCondition(FBreakpoint& bp)
+	{
+		bp.HitCount++;
+		return bp.CompiledCondition.Evaluate(*this, bp.HitCount);
+	}
 
 private:
 	FCodeAnalysisState*	pCodeAnalysis = nullptr;
@@ -195,13 +246,25 @@ private:
 	z80_t*			pZ80 = nullptr;
 	m6502_t*		pM6502 = nullptr;
 	uint64_t		LastTickPins = 0;
+	bool			bLastTickIrq = false;
 	FAddressRef		PC;
 	bool			bDebuggerStopped = false;
 	EDebugStepMode	StepMode = EDebugStepMode::None;
 	FAddressRef		StepOverPC;
+	uint64_t		ReplayInstructionsRemaining = 0;
+
+	FReverseDebugger			ReverseDebugger;
+	FRewindDebuggerState		RewindDebuggerState;	// kept to reuse the call stack allocation
+	FTraceRecorder				TraceRecorder;
+	FTraceReader				TraceReader;
+	int							TraceQueryFrameNo = 0;
+	int							TraceQueryAddress = 0;
+	std::vector<FTraceWrite>	TraceQueryWrites;
 
 	std::vector<FBreakpoint>	Breakpoints;
 	uint32_t					BreakpointMask = 0;
+	FDataBreakpointMap			DataBreakpointMap;
+	bool						bBreakpointsDirty = true;	// rebuild the mask & map before the next tick
 	int							ScanlineBreakpoint = -1;
 	std::vector<FWatch>			Watches;
 	FWatch						SelectedWatch;
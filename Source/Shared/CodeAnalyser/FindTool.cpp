@@ -6,6 +6,7 @@
 
 #include "UI/CodeAnalyserUI.h"
 #include "Util/Misc.h"
+#include <Debug/DebugLog.h>
 
 void HelpMarker(const char* desc)
 {
@@ -32,6 +33,7 @@ void FFindTool::Init(FCodeAnalysisState* ptrCodeAnalysis)
 	WordFinder.Init(ptrCodeAnalysis);
 	TextFinder.Init(ptrCodeAnalysis);
 	ByteSequenceFinder.Init(ptrCodeAnalysis);
+	SignatureFinder.Init(ptrCodeAnalysis);
 }
 
 void FFindTool::Reset()
@@ -40,6 +42,16 @@ void FFindTool::Reset()
 	WordFinder.Reset();
 	TextFinder.Reset();
 	ByteSequenceFinder.Reset();
+	SignatureFinder.Reset();
+}
+
+// Only allow hex digits, wildcards & spaces in byte patterns
+static int HexPatternCharFilter(ImGuiInputTextCallbackData* pData)
+{
+	const ImWchar c = pData->EventChar;
+	if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || c == '?' || c == ' ')
+		return 0;
+	return 1;
 }
 
 void FFindTool::DrawUI()
@@ -66,6 +78,11 @@ void FFindTool::DrawUI()
 			SearchType = ESearchType::SearchText;
 			ImGui::EndTabItem();
 		}
+		if (ImGui::BeginTabItem("Signatures"))
+		{
+			SearchType = ESearchType::SearchSignatures;
+			ImGui::EndTabItem();
+		}
 		ImGui::EndTabBar();
 	}
 
@@ -115,6 +132,8 @@ void FFindTool::DrawUI()
 			pCurFinder = &TextFinder;
 		else if (SearchType == ESearchType::SearchByteSequence)
 			pCurFinder = &ByteSequenceFinder;
+		else if (SearchType == ESearchType::SearchSignatures)
+			pCurFinder = &SignatureFinder;
 		else
 			pCurFinder = DataSize == ESearchDataType::SearchByte ? (FFinder*)&ByteFinder : &WordFinder;
 	}
@@ -123,7 +142,7 @@ void FFindTool::DrawUI()
 	ImGui::SetNextItemOpen(true, ImGuiCond_Once);
 	if (ImGui::TreeNode("Search Options"))
 	{
-		if (SearchType == ESearchType::SearchSingleValue || SearchType == ESearchType::SearchByteSequence)
+		if (SearchType == ESearchType::SearchSingleValue || SearchType == ESearchType::SearchByteSequence || SearchType == ESearchType::SearchSignatures)
 		{
 			if (ImGui::RadioButton("Data", Options.MemoryType == ESearchMemoryType::SearchData))
 			{
@@ -210,10 +229,27 @@ void FFindTool::DrawUI()
 	{
 		ImGui::Text("Hex Values");
 		ImGui::SameLine();
-		HelpMarker("Enter hexadecimal values to search for. For example, '1BAFCD' will search for the byte sequence {1B, AF, CD}.");
+		HelpMarker("Enter hexadecimal values to search for. For example, '1BAFCD' will search for the byte sequence {1B, AF, CD}.\n"
+			"Use '?' as a wildcard nibble. For example, '3E??CD' will match 3E followed by any byte then CD, '?F' will match any byte ending in F.");
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 16);
+		ImGui::InputText("##hexvalues", ByteSequenceFinder.SearchText, FByteSequenceFinder::kSearchTextSize, ImGuiInputTextFlags_CharsUppercase | ImGuiInputTextFlags_CallbackCharFilter, HexPatternCharFilter);
+	}
+	else if (SearchType == ESearchType::SearchSignatures)
+	{
+		ImGui::Text("Signature File");
+		ImGui::SameLine();
+		HelpMarker("File with a signature on each line - a name followed by hex values to search for, which can use '?' wildcards.\n"
+			"For example 'PlayerInit F3 21 ?? ?? CD'. Lines starting with '#' are comments.\n"
+			"All the signatures are searched for in a single pass over memory.");
 		ImGui::SameLine();
 		ImGui::SetNextItemWidth(ImGui::GetFontSize() * 16);
-		ImGui::InputText("##hexvalues", ByteSequenceFinder.SearchText, FByteSequenceFinder::kSearchTextSize, ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_CharsUppercase);
+		ImGui::InputText("##signaturefile", &SignatureFinder.SignatureFilename);
+		ImGui::SameLine();
+		if (ImGui::Button("Load"))
+			SignatureFinder.LoadSignatures(SignatureFinder.SignatureFilename.c_str());
+		ImGui::SameLine();
+		ImGui::Text("%d signatures", (int)SignatureFinder.GetNumSignatures());
 	}
 
 	// sam. I wanted to use ImGuiInputTextFlags_EnterReturnsTrue here to do the search when enter is pressed but
@@ -254,6 +290,8 @@ void FFindTool::DrawUI()
 				ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthFixed, TEXT_BASE_WIDTH * 40);
 				if (SearchType == ESearchType::SearchSingleValue)
 					ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthFixed, TEXT_BASE_WIDTH * 6);
+				else if (SearchType == ESearchType::SearchSignatures)
+					ImGui::TableSetupColumn("Signature", ImGuiTableColumnFlags_WidthFixed, TEXT_BASE_WIDTH * 24);
 				ImGui::TableSetupColumn("Comment", ImGuiTableColumnFlags_WidthStretch);
 				ImGui::TableHeadersRow();
 
@@ -311,6 +349,13 @@ void FFindTool::DrawUI()
 							}
 						}
 
+						// Signature
+						if (SearchType == ESearchType::SearchSignatures)
+						{
+							ImGui::TableNextColumn();
+							ImGui::Text("%s", SignatureFinder.GetResultSignatureName(i));
+						}
+
 						// Comment
 						ImGui::TableNextColumn();
 						if (const FDataInfo* pWriteDataInfo = pCodeAnalysis->GetDataInfoForAddress(resultAddr))
@@ -344,6 +389,18 @@ void FFindTool::DrawUI()
 			ImGui::SetTooltip("Remove unchanged results todo.");
 		}
 	}
+	else if (SearchType == ESearchType::SearchSignatures)
+	{
+		if (ImGui::Button("Label Results"))
+		{
+			SignatureFinder.LabelResults();
+		}
+
+		if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+		{
+			ImGui::SetTooltip("Add a label named after the signature to each result that doesn't already have one.");
+		}
+	}
 }
 
 void FFindTool::FixupAddressRefs()
@@ -406,13 +463,13 @@ void FFinder::ProcessMatch(FAddressRef addr, const FSearchOptions& opt)
 		{
 			if (!opt.bSearchUnaccessed)
 			{
-				if (pDataInfo->LastFrameRead == -1 && pDataInfo->LastFrameWritten == -1)
+				if (pCodeAnalysis->GetLastFrameReadForAddress(addr) == -1 && pCodeAnalysis->GetLastFrameWrittenForAddress(addr) == -1)
 					bAddResult = false;
 			}
 
 			if (!opt.bSearchUnreferenced)
 			{
-				if (pDataInfo->Reads.IsEmpty() && pDataInfo->Writes.IsEmpty())
+				if (pDataInfo->GetReads().IsEmpty() && pDataInfo->GetWrites().IsEmpty())
 				{
 					bAddResult = false;
 				}
@@ -498,37 +555,19 @@ const char* FWordFinder::GetValueString(FAddressRef addr, ENumberDisplayMode num
 //---------------------------------------------------------------------------------------------------------------------
 void FByteSequenceFinder::Find(const FSearchOptions& opt)
 {
-	const size_t strLen = strlen(SearchText);
-	// check for odd number of characters
-	if (strLen & 1)
+	// todo: display error message for invalid patterns
+	if (ParseSearchPattern(SearchText, SearchPattern) == false || SearchPattern.Size() > kMaxByteCount)
 	{
-		// todo: display error message. or maybe add leading 0?
+		SearchPattern.Clear();
 		return;
 	}
-	else
-	{
-		const char* pCurBuf = SearchText;
-		const char* pEnd = SearchText + strlen(SearchText);
-		NumSearchBytes = 0;
-
-		int res;
-		while (pCurBuf < pEnd)
-		{
-			if (sscanf(pCurBuf, "%02X", &res) == 1)
-			{
-				SearchBytes[NumSearchBytes] = (uint8_t)res;
-				NumSearchBytes++;
-			}
-			pCurBuf += 2;
-		}
-	}
 
 	FFinder::Find(opt);
 }
 
 std::vector<FAddressRef> FByteSequenceFinder::FindAllMatchesInBanks(const FSearchOptions& opt)
 {
-	return pCodeAnalysis->FindAllMemoryPatterns(SearchBytes, NumSearchBytes, opt.bSearchROM, opt.bSearchPhysicalOnly);
+	return pCodeAnalysis->FindAllMemoryPatterns(SearchPattern, opt.bSearchROM, opt.bSearchPhysicalOnly);
 }
 
 bool FByteSequenceFinder::HasValueChanged(FAddressRef addr) const
@@ -547,3 +586,84 @@ std::vector<FAddressRef> FTextFinder::FindAllMatchesInBanks(const FSearchOptions
 {
 	return pCodeAnalysis->FindAllMemoryPatterns((uint8_t*)SearchText.c_str(), SearchText.size(), opt.bSearchROM, opt.bSearchPhysicalOnly);
 }
+
+//---------------------------------------------------------------------------------------------------------------------
+bool FSignatureFinder::LoadSignatures(const char* pFilename)
+{
+	Signatures.clear();
+	Matcher.Clear();
+	Reset();
+
+	if (LoadSignatureFile(pFilename, Signatures) == false)
+	{
+		LOGERROR("Could not load signature file '%s'", pFilename);
+		return false;
+	}
+
+	// matcher indices need to line up with signature indices so drop any we can't search for
+	for (auto it = Signatures.begin(); it != Signatures.end();)
+	{
+		if (Matcher.AddPattern(it->Pattern) == -1)
+		{
+			LOGWARNING("Signature '%s' has no fixed bytes, ignoring", it->Name.c_str());
+			it = Signatures.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	Matcher.Build();
+
+	LOGINFO("Loaded %d signatures from '%s'", (int)Signatures.size(), pFilename);
+	return true;
+}
+
+void FSignatureFinder::Reset()
+{
+	FFinder::Reset();
+	ResultSignatures.clear();
+}
+
+void FSignatureFinder::Find(const FSearchOptions& opt)
+{
+	assert(pCodeAnalysis);
+
+	Reset();
+
+	const std::vector<FFoundPattern> allMatches = pCodeAnalysis->FindAllMemoryPatterns(Matcher, opt.bSearchROM, opt.bSearchPhysicalOnly);
+	for (const FFoundPattern& match : allMatches)
+	{
+		const size_t noResults = SearchResults.size();
+		ProcessMatch(match.Address, opt);
+		if (SearchResults.size() != noResults)
+			ResultSignatures.push_back(match.PatternIndex);
+	}
+}
+
+std::vector<FAddressRef> FSignatureFinder::FindAllMatchesInBanks(const FSearchOptions& opt)
+{
+	std::vector<FAddressRef> results;
+	for (const FFoundPattern& match : pCodeAnalysis->FindAllMemoryPatterns(Matcher, opt.bSearchROM, opt.bSearchPhysicalOnly))
+		results.push_back(match.Address);
+	return results;
+}
+
+int FSignatureFinder::LabelResults()
+{
+	FLabelBatchScope labelBatch(*pCodeAnalysis);
+	int noLabelsAdded = 0;
+	for (size_t resultNo = 0; resultNo < SearchResults.size(); resultNo++)
+	{
+		const FAddressRef addr = SearchResults[resultNo];
+		if (pCodeAnalysis->GetLabelForAddress(addr) != nullptr)
+			continue;
+
+		const ELabelType labelType = pCodeAnalysis->GetCodeInfoForAddress(addr) != nullptr ? ELabelType::Code : ELabelType::Data;
+		AddLabel(*pCodeAnalysis, addr, GetResultSignatureName(resultNo), labelType);
+		pCodeAnalysis->SetCodeAnalysisDirty(addr);
+		noLabelsAdded++;
+	}
+
+	return noLabelsAdded;
+}
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Util/Misc.h"
+#include "MemorySearch.h"
 
 class FCodeAnalysisState;
 
@@ -97,15 +98,35 @@ class FByteSequenceFinder : public FDataFinder
 {
 public:
 	static const int kMaxByteCount = 32;
-	static const int kSearchTextSize = (kMaxByteCount * 2) + 1;
+	static const int kSearchTextSize = (kMaxByteCount * 3) + 1;	// allow for spaces between bytes
 
 	virtual bool HasValueChanged(FAddressRef addr) const override;
 	virtual void Find(const FSearchOptions& opt) override;
 	virtual std::vector<FAddressRef> FindAllMatchesInBanks(const FSearchOptions& opt) override;
 	virtual const char* GetValueString(FAddressRef addr, ENumberDisplayMode numberMode) const override;
 	char SearchText[kSearchTextSize] = "";
-	uint8_t SearchBytes[kMaxByteCount];
-	int NumSearchBytes = 0;
+	FSearchPattern SearchPattern;
+};
+
+// Finds all the signatures from a signature list file in a single pass
+class FSignatureFinder : public FFinder
+{
+public:
+	bool LoadSignatures(const char* pFilename);
+	virtual void Reset() override;
+	virtual void Find(const FSearchOptions& opt) override;
+	virtual std::vector<FAddressRef> FindAllMatchesInBanks(const FSearchOptions& opt) override;
+	virtual const char* GetValueString(FAddressRef addr, ENumberDisplayMode numberMode) const override { return ""; }
+	const char* GetResultSignatureName(size_t index) const { return Signatures[ResultSignatures[index]].Name.c_str(); }
+	int LabelResults();	// returns number of labels added
+
+	size_t GetNumSignatures() const { return Signatures.size(); }
+
+	std::string SignatureFilename;
+private:
+	std::vector<FSignature> Signatures;
+	FMultiPatternSearch Matcher;
+	std::vector<int> ResultSignatures;	// signature index for each search result
 };
 
 enum ESearchType
@@ -113,6 +134,7 @@ enum ESearchType
 	SearchSingleValue,		// single value - byte or word
 	SearchByteSequence,	// sequence of bytes
 	SearchText,			// text string
+	SearchSignatures,	// signatures from a file
 };
 
 enum ESearchDataType
@@ -144,6 +166,7 @@ private:
 	FWordFinder WordFinder;
 	FTextFinder TextFinder;
 	FByteSequenceFinder ByteSequenceFinder;
+	FSignatureFinder SignatureFinder;
 
 	FCodeAnalysisState* pCodeAnalysis = nullptr;
 };
@@ -154,7 +154,6 @@ void FMemoryAnalyser::DrawMemoryDiffUI(void)
 				for (int rowNum = clipper.DisplayStart; rowNum < clipper.DisplayEnd; rowNum++)
 				{
 					FAddressRef changedAddr = DiffChangedLocations[rowNum];
-					const FDataInfo* pDataInfo = pCodeAnalysis->GetDataInfoForAddress(changedAddr);
 					ImGui::TableNextRow();
 					ImGui::PushID(changedAddr.Val);
 
@@ -175,7 +174,7 @@ void FMemoryAnalyser::DrawMemoryDiffUI(void)
 					// Code address that last wrote to value
 					ImGui::TableSetColumnIndex(3);
 					ImGui::Text("");
-					DrawAddressLabel(*pCodeAnalysis, viewState, pDataInfo->LastWriter);
+					DrawAddressLabel(*pCodeAnalysis, viewState, pCodeAnalysis->GetLastWriterForAddress(changedAddr));
 
 					ImGui::PopID();
 				}
@@ -0,0 +1,378 @@
+#include "MemorySearch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <queue>
+
+#include <Debug/DebugLog.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MEMORYSEARCH_SSE2 1
+#endif
+
+FSearchPattern::FSearchPattern(const uint8_t* pData, size_t dataSize)
+	: Bytes(pData, pData + dataSize)
+	, Masks(dataSize, 0xff)
+{
+}
+
+bool FSearchPattern::IsExact() const
+{
+	for (uint8_t mask : Masks)
+	{
+		if (mask != 0xff)
+			return false;
+	}
+	return true;
+}
+
+bool FSearchPattern::MatchesAt(const uint8_t* pMem) const
+{
+	// check from the end as that's where Horspool is aligned
+	for (size_t i = Bytes.size(); i-- > 0;)
+	{
+		if ((pMem[i] & Masks[i]) != Bytes[i])
+			return false;
+	}
+	return true;
+}
+
+static int HexNibble(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+bool ParseSearchPattern(const char* pText, FSearchPattern& outPattern)
+{
+	outPattern.Clear();
+
+	uint8_t byte = 0;
+	uint8_t mask = 0;
+	int noNibbles = 0;
+
+	for (const char* pChar = pText; *pChar != 0; pChar++)
+	{
+		const char c = *pChar;
+		if (c == ' ')
+			continue;
+
+		byte <<= 4;
+		mask <<= 4;
+		if (c != '?')
+		{
+			const int nibble = HexNibble(c);
+			if (nibble == -1)
+				return false;
+			byte |= nibble;
+			mask |= 0xf;
+		}
+
+		if (++noNibbles == 2)
+		{
+			outPattern.AddByte(byte, mask);
+			byte = mask = 0;
+			noNibbles = 0;
+		}
+	}
+
+	// odd number of nibbles
+	if (noNibbles != 0)
+		return false;
+
+	return outPattern.IsEmpty() == false;
+}
+
+// Scan for positions where the first one or two pattern bytes match then check the rest
+// Done 16 bytes at a time so it's either SSE2 or easy for the compiler to vectorise
+static void FindPatternVectorised(const uint8_t* pMem, size_t memSize, const FSearchPattern& pattern, std::vector<size_t>& outOffsets)
+{
+	const size_t patternSize = pattern.Size();
+	const size_t lastPos = memSize - patternSize;	// last offset the pattern can start at
+	const bool bCheckSecond = patternSize > 1;
+	const uint8_t b0 = pattern.Bytes[0], m0 = pattern.Masks[0];
+	const uint8_t b1 = bCheckSecond ? pattern.Bytes[1] : 0, m1 = bCheckSecond ? pattern.Masks[1] : 0;
+
+	size_t pos = 0;
+
+	// blocks of 16 where the second byte is also in range
+	while (pos + 16 + (bCheckSecond ? 1 : 0) <= memSize && pos + 15 <= lastPos)
+	{
+		uint32_t matchBits = 0;
+#ifdef MEMORYSEARCH_SSE2
+		const __m128i block0 = _mm_loadu_si128((const __m128i*)(pMem + pos));
+		__m128i match = _mm_cmpeq_epi8(_mm_and_si128(block0, _mm_set1_epi8((char)m0)), _mm_set1_epi8((char)b0));
+		if (bCheckSecond)
+		{
+			const __m128i block1 = _mm_loadu_si128((const __m128i*)(pMem + pos + 1));
+			match = _mm_and_si128(match, _mm_cmpeq_epi8(_mm_and_si128(block1, _mm_set1_epi8((char)m1)), _mm_set1_epi8((char)b1)));
+		}
+		matchBits = (uint32_t)_mm_movemask_epi8(match);
+#else
+		uint8_t matches[16];
+		for (int i = 0; i < 16; i++)
+			matches[i] = ((pMem[pos + i] & m0) == b0) & (bCheckSecond == false || (pMem[pos + i + 1] & m1) == b1);
+		for (int i = 0; i < 16; i++)
+			matchBits |= (uint32_t)matches[i] << i;
+#endif
+		while (matchBits != 0)
+		{
+			int bit = 0;
+			while ((matchBits & (1u << bit)) == 0)
+				bit++;
+			matchBits &= matchBits - 1;
+
+			if (patternSize <= 2 || pattern.MatchesAt(pMem + pos + bit))
+				outOffsets.push_back(pos + bit);
+		}
+		pos += 16;
+	}
+
+	// remainder
+	for (; pos <= lastPos; pos++)
+	{
+		if (pattern.MatchesAt(pMem + pos))
+			outOffsets.push_back(pos);
+	}
+}
+
+// Boyer-Moore-Horspool, with the skip table built from the masks so wildcards still work
+static void FindPatternHorspool(const uint8_t* pMem, size_t memSize, const FSearchPattern& pattern, const size_t skipTable[256], std::vector<size_t>& outOffsets)
+{
+	const size_t patternSize = pattern.Size();
+	size_t pos = 0;
+	while (pos + patternSize <= memSize)
+	{
+		const uint8_t lastByte = pMem[pos + patternSize - 1];
+		if (pattern.MatchesByte(patternSize - 1, lastByte) && pattern.MatchesAt(pMem + pos))
+			outOffsets.push_back(pos);
+		pos += skipTable[lastByte];
+	}
+}
+
+void FSinglePatternSearch::SetPattern(const FSearchPattern& pattern)
+{
+	Pattern = pattern;
+	bUseHorspool = false;
+
+	const size_t patternSize = Pattern.Size();
+	if (patternSize <= 2)
+		return;
+
+	// skip for each byte value is the distance from the last pattern position it could match to the end
+	size_t totalSkip = 0;
+	for (int value = 0; value < 256; value++)
+	{
+		size_t skip = patternSize;
+		for (size_t i = 0; i < patternSize - 1; i++)
+		{
+			if (Pattern.MatchesByte(i, (uint8_t)value))
+				skip = patternSize - 1 - i;
+		}
+		SkipTable[value] = skip;
+		totalSkip += skip;
+	}
+
+	// wildcards near the end of the pattern make Horspool degenerate so only use it if it skips well
+	bUseHorspool = totalSkip >= 256 * 4;
+}
+
+void FSinglePatternSearch::FindInMemory(const uint8_t* pMem, size_t memSize, std::vector<size_t>& outOffsets) const
+{
+	const size_t patternSize = Pattern.Size();
+	if (patternSize == 0 || patternSize > memSize)
+		return;
+
+	if (bUseHorspool)
+		FindPatternHorspool(pMem, memSize, Pattern, SkipTable, outOffsets);
+	else
+		FindPatternVectorised(pMem, memSize, Pattern, outOffsets);
+}
+
+void FindPatternInMemory(const uint8_t* pMem, size_t memSize, const FSearchPattern& pattern, std::vector<size_t>& outOffsets)
+{
+	FSinglePatternSearch search;
+	search.SetPattern(pattern);
+	search.FindInMemory(pMem, memSize, outOffsets);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FMultiPatternSearch::Clear()
+{
+	Patterns.clear();
+	Transitions.clear();
+	StateMatches.clear();
+	bBuilt = false;
+}
+
+int FMultiPatternSearch::AddPattern(const FSearchPattern& pattern)
+{
+	// find longest run of fully specified bytes
+	FAnchoredPattern anchoredPattern;
+	size_t runStart = 0;
+	for (size_t i = 0; i <= pattern.Size(); i++)
+	{
+		if (i == pattern.Size() || pattern.Masks[i] != 0xff)
+		{
+			if (i - runStart > anchoredPattern.AnchorSize)
+			{
+				anchoredPattern.AnchorOffset = runStart;
+				anchoredPattern.AnchorSize = i - runStart;
+			}
+			runStart = i + 1;
+		}
+	}
+
+	if (anchoredPattern.AnchorSize == 0)
+		return -1;
+
+	anchoredPattern.Pattern = pattern;
+	anchoredPattern.bExact = anchoredPattern.AnchorSize == pattern.Size();
+	Patterns.push_back(anchoredPattern);
+	bBuilt = false;
+	return (int)Patterns.size() - 1;
+}
+
+void FMultiPatternSearch::Build()
+{
+	Transitions.assign(256, -1);
+	StateMatches.assign(1, std::vector<int>());
+
+	// build trie of anchors
+	for (int patternNo = 0; patternNo < (int)Patterns.size(); patternNo++)
+	{
+		const FAnchoredPattern& pattern = Patterns[patternNo];
+		int state = 0;
+		for (size_t i = 0; i < pattern.AnchorSize; i++)
+		{
+			const uint8_t byte = pattern.Pattern.Bytes[pattern.AnchorOffset + i];
+			if (Transitions[state * 256 + byte] == -1)
+			{
+				Transitions[state * 256 + byte] = (int32_t)StateMatches.size();
+				StateMatches.emplace_back();
+				Transitions.resize(Transitions.size() + 256, -1);
+			}
+			state = Transitions[state * 256 + byte];
+		}
+		StateMatches[state].push_back(patternNo);
+	}
+
+	// breadth first pass to turn the trie into a DFA by following failure links
+	std::vector<int32_t> failLinks(StateMatches.size(), 0);
+	std::queue<int32_t> stateQueue;
+	for (int byte = 0; byte < 256; byte++)
+	{
+		int32_t& next = Transitions[byte];
+		if (next == -1)
+		{
+			next = 0;
+		}
+		else
+		{
+			failLinks[next] = 0;
+			stateQueue.push(next);
+		}
+	}
+
+	while (stateQueue.empty() == false)
+	{
+		const int32_t state = stateQueue.front();
+		stateQueue.pop();
+
+		// inherit matches from the longest suffix state
+		const std::vector<int>& suffixMatches = StateMatches[failLinks[state]];
+		StateMatches[state].insert(StateMatches[state].end(), suffixMatches.begin(), suffixMatches.end());
+
+		for (int byte = 0; byte < 256; byte++)
+		{
+			int32_t& next = Transitions[state * 256 + byte];
+			const int32_t failNext = Transitions[failLinks[state] * 256 + byte];
+			if (next == -1)
+			{
+				next = failNext;
+			}
+			else
+			{
+				failLinks[next] = failNext;
+				stateQueue.push(next);
+			}
+		}
+	}
+
+	bBuilt = true;
+}
+
+void FMultiPatternSearch::FindInMemory(const uint8_t* pMem, size_t memSize, std::vector<FPatternMatch>& outMatches) const
+{
+	if (bBuilt == false || Patterns.empty())
+		return;
+
+	const size_t firstMatch = outMatches.size();
+	int32_t state = 0;
+	for (size_t pos = 0; pos < memSize; pos++)
+	{
+		state = Transitions[state * 256 + pMem[pos]];
+		for (int patternNo : StateMatches[state])
+		{
+			const FAnchoredPattern& pattern = Patterns[patternNo];
+			const size_t anchorStart = pos + 1 - pattern.AnchorSize;
+			if (anchorStart < pattern.AnchorOffset)
+				continue;
+			const size_t patternStart = anchorStart - pattern.AnchorOffset;
+			if (patternStart + pattern.Pattern.Size() > memSize)
+				continue;
+			if (pattern.bExact || pattern.Pattern.MatchesAt(pMem + patternStart))
+				outMatches.push_back({ patternStart, patternNo });
+		}
+	}
+
+	// anchors can be part way through patterns so matches aren't necessarily in order
+	std::sort(outMatches.begin() + firstMatch, outMatches.end(), [](const FPatternMatch& a, const FPatternMatch& b)
+	{
+		return a.Offset != b.Offset ? a.Offset < b.Offset : a.PatternIndex < b.PatternIndex;
+	});
+}
+
+bool LoadSignatureFile(const char* pFilename, std::vector<FSignature>& outSignatures)
+{
+	std::ifstream inFileStream(pFilename);
+	if (inFileStream.is_open() == false)
+		return false;
+
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(inFileStream, line))
+	{
+		lineNo++;
+		if (line.empty() == false && line.back() == '\r')
+			line.pop_back();
+
+		const size_t nameStart = line.find_first_not_of(" \t");
+		if (nameStart == std::string::npos || line[nameStart] == '#')
+			continue;
+
+		const size_t nameEnd = line.find_first_of(" \t", nameStart);
+		FSignature signature;
+		signature.Name = line.substr(nameStart, nameEnd - nameStart);
+		std::string patternText = nameEnd == std::string::npos ? "" : line.substr(nameEnd);
+		std::replace(patternText.begin(), patternText.end(), '\t', ' ');
+
+		if (ParseSearchPattern(patternText.c_str(), signature.Pattern) == false)
+		{
+			LOGWARNING("%s(%d): invalid pattern for signature '%s'", pFilename, lineNo, signature.Name.c_str());
+			continue;
+		}
+
+		outSignatures.push_back(signature);
+	}
+
+	return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A byte pattern to search memory for
+// Each byte has a mask - only the bits set in the mask have to match, so a mask of 0 is a wildcard
+struct FSearchPattern
+{
+	FSearchPattern() = default;
+	FSearchPattern(const uint8_t* pData, size_t dataSize);
+
+	void	Clear() { Bytes.clear(); Masks.clear(); }
+	void	AddByte(uint8_t byte, uint8_t mask = 0xff) { Bytes.push_back(byte & mask); Masks.push_back(mask); }
+	size_t	Size() const { return Bytes.size(); }
+	bool	IsEmpty() const { return Bytes.empty(); }
+	bool	IsExact() const;	// no wildcards or masks
+
+	bool	MatchesByte(size_t index, uint8_t value) const { return (value & Masks[index]) == Bytes[index]; }
+	bool	MatchesAt(const uint8_t* pMem) const;
+
+	std::vector<uint8_t>	Bytes;
+	std::vector<uint8_t>	Masks;
+};
+
+// Parse a hex string into a pattern e.g. "3E??CD" or "3?FF"
+// '?' is a wildcard nibble, spaces are ignored
+bool ParseSearchPattern(const char* pText, FSearchPattern& outPattern);
+
+// Searches for a single pattern, set up once so many blocks of memory can be searched without redoing the setup
+// Single byte and word patterns use a vectorised scan, longer patterns use Boyer-Moore-Horspool
+class FSinglePatternSearch
+{
+public:
+	void	SetPattern(const FSearchPattern& pattern);	// builds the Horspool skip table
+	const FSearchPattern& GetPattern() const { return Pattern; }
+
+	// Find all offsets of the pattern in a block of memory
+	void	FindInMemory(const uint8_t* pMem, size_t memSize, std::vector<size_t>& outOffsets) const;
+
+private:
+	FSearchPattern	Pattern;
+	bool			bUseHorspool = false;
+	size_t			SkipTable[256] = {};
+};
+
+// Find all offsets of a pattern in a block of memory
+void FindPatternInMemory(const uint8_t* pMem, size_t memSize, const FSearchPattern& pattern, std::vector<size_t>& outOffsets);
+
+struct FPatternMatch
+{
+	size_t	Offset;
+	int		PatternIndex;
+};
+
+// Searches for many patterns at once in a single pass over memory using an Aho-Corasick automaton
+// Each pattern is anchored on its longest run of fully specified bytes, hits on the anchor are then checked against the whole pattern
+class FMultiPatternSearch
+{
+public:
+	void	Clear();
+	int		AddPattern(const FSearchPattern& pattern);	// returns pattern index or -1 if it has no fixed bytes to anchor on
+	void	Build();
+
+	size_t	NumPatterns() const { return Patterns.size(); }
+	const FSearchPattern& GetPattern(int index) const { return Patterns[index].Pattern; }
+
+	// matches are returned sorted by offset
+	void	FindInMemory(const uint8_t* pMem, size_t memSize, std::vector<FPatternMatch>& outMatches) const;
+
+private:
+	struct FAnchoredPattern
+	{
+		FSearchPattern	Pattern;
+		size_t			AnchorOffset = 0;
+		size_t			AnchorSize = 0;
+		bool			bExact = false;	// anchor is the whole pattern so no need to check
+	};
+
+	std::vector<FAnchoredPattern>	Patterns;
+	std::vector<int32_t>			Transitions;	// 256 per state
+	std::vector<std::vector<int>>	StateMatches;	// patterns whose anchor ends at each state
+	bool							bBuilt = false;
+};
+
+// A named pattern from a signature list
+struct FSignature
+{
+	std::string		Name;
+	FSearchPattern	Pattern;
+};
+
+// Load a signature list file
+// Each line is a name followed by a hex pattern e.g. "MusicPlayerInit F3 21 ?? ?? CD", lines starting with '#' are comments
+bool LoadSignatureFile(const char* pFilename, std::vector<FSignature>& outSignatures);
@@ -0,0 +1,94 @@
+#include "ReverseDebugger.h"
+
+void FReverseDebugger::Init(IRewindStateSource* pSource)
+{
+	pStateSource = pSource;
+	Reset();
+}
+
+void FReverseDebugger::Reset()
+{
+	Segments.clear();
+	pCurrentSegment = nullptr;
+	InstructionCount = 0;
+}
+
+void FReverseDebugger::SetEnabled(bool bEnable)
+{
+	bEnabled = bEnable;
+	if (bEnabled == false)
+		Reset();
+}
+
+// called each host frame before the emulator executes, which is the only time the machine state is consistent enough to save
+void FReverseDebugger::OnExecuteStart(const FRewindDebuggerState& debuggerState)
+{
+	if (bEnabled == false || pStateSource == nullptr)
+		return;
+
+	const size_t stateSize = pStateSource->GetRewindStateSize();
+	if (stateSize == 0)
+		return;
+
+	// nothing has executed since the last save e.g. the debugger is stopped
+	if (pCurrentSegment != nullptr && pCurrentSegment->FirstInstruction == InstructionCount)
+		return;
+
+	// reuse the oldest segment's buffers once the history is full
+	FRewindSegment segment;
+	if ((int)Segments.size() >= MaxSegments)
+	{
+		segment = std::move(Segments.front());
+		Segments.pop_front();
+		segment.PCs.clear();
+		segment.Writes.clear();
+	}
+
+	segment.FirstInstruction = InstructionCount;
+	segment.MachineState.resize(stateSize);
+	pStateSource->SaveRewindState(segment.MachineState.data());
+	segment.DebuggerState = debuggerState;
+	Segments.push_back(std::move(segment));
+	pCurrentSegment = &Segments.back();
+}
+
+// the state saved at the start of the segment is restored & the replay runs up to the instruction
+// so there needs to be a segment that started before it
+bool FReverseDebugger::CanRestoreToInstruction(uint64_t instructionNo) const
+{
+	return Segments.empty() == false && Segments.front().FirstInstruction < instructionNo && instructionNo <= InstructionCount;
+}
+
+bool FReverseDebugger::RestoreToInstruction(uint64_t instructionNo, uint64_t& outNoInstructionsToReplay, FRewindDebuggerState& outDebuggerState)
+{
+	if (CanRestoreToInstruction(instructionNo) == false)
+		return false;
+
+	while (Segments.back().FirstInstruction >= instructionNo)
+		Segments.pop_back();
+
+	// history after the restore point is recorded again as the replay runs
+	FRewindSegment& segment = Segments.back();
+	segment.PCs.clear();
+	segment.Writes.clear();
+	pCurrentSegment = &segment;
+	InstructionCount = segment.FirstInstruction;
+
+	pStateSource->LoadRewindState(segment.MachineState.data());
+	outDebuggerState = segment.DebuggerState;
+	outNoInstructionsToReplay = instructionNo - segment.FirstInstruction;
+	return true;
+}
+
+size_t FReverseDebugger::GetMemoryUsage() const
+{
+	size_t noBytes = 0;
+	for (const FRewindSegment& segment : Segments)
+	{
+		noBytes += segment.MachineState.capacity();
+		noBytes += segment.DebuggerState.CallStack.capacity() * sizeof(FCPUFunctionCall);
+		noBytes += segment.PCs.capacity() * sizeof(FAddressRef);
+		noBytes += segment.Writes.capacity() * sizeof(FRewindWrite);
+	}
+	return noBytes;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <CodeAnalyser/CodeAnalyserTypes.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Implemented by the emulator to save & load its raw machine state, this is done often so must be quick
+class IRewindStateSource
+{
+public:
+	virtual size_t	GetRewindStateSize() const { return 0; }	// 0 if not supported
+	virtual void	SaveRewindState(void* pState) {}
+	virtual void	LoadRewindState(const void* pState) {}
+};
+
+// Memory write made by an instruction
+struct FRewindWrite
+{
+	uint32_t	InstructionNo;	// index into the segment's PCs of the instruction that wrote
+	FAddressRef	Address;
+	uint8_t		Value;
+};
+
+// Debugger state that the replay would otherwise add to a second time
+struct FRewindDebuggerState
+{
+	std::vector<FCPUFunctionCall>	CallStack;
+	size_t							FrameTraceSize = 0;
+	size_t							EventTraceSize = 0;
+};
+
+// Machine state saved at the start of an execution run, followed by everything executed since
+struct FRewindSegment
+{
+	uint64_t					FirstInstruction = 0;	// instruction count when the state was saved
+	std::vector<uint8_t>		MachineState;
+	FRewindDebuggerState		DebuggerState;
+	std::vector<FAddressRef>	PCs;	// PC at the start of each instruction
+	std::vector<FRewindWrite>	Writes;
+};
+
+// Records the history needed to step backwards
+// The machine state is saved each host frame the emulator executes & every instruction's PC & memory writes are logged
+// Going back restores the last saved state before the target & the debugger replays forward to it
+// This costs a machine state copy per frame so is off until turned on in the debugger
+class FReverseDebugger
+{
+public:
+	void	Init(IRewindStateSource* pStateSource);
+	void	Reset();	// throw away history
+	void	SetEnabled(bool bEnable);
+	bool	IsEnabled() const { return bEnabled; }
+
+	// Recording
+	void	OnExecuteStart(const FRewindDebuggerState& debuggerState);
+	void	OnInstruction(FAddressRef pc)
+	{
+		if (pCurrentSegment != nullptr)
+		{
+			pCurrentSegment->PCs.push_back(pc);
+			InstructionCount++;
+		}
+	}
+	void	OnMemoryWrite(FAddressRef address, uint8_t value)
+	{
+		if (pCurrentSegment != nullptr)
+			pCurrentSegment->Writes.push_back({ (uint32_t)pCurrentSegment->PCs.size(), address, value });
+	}
+
+	// Playback
+	uint64_t	GetInstructionCount() const { return InstructionCount; }
+	bool		CanRestoreToInstruction(uint64_t instructionNo) const;
+	bool		RestoreToInstruction(uint64_t instructionNo, uint64_t& outNoInstructionsToReplay, FRewindDebuggerState& outDebuggerState);
+
+	const std::deque<FRewindSegment>&	GetSegments() const { return Segments; }
+	size_t		GetMemoryUsage() const;
+
+	int			MaxSegments = 100;
+
+private:
+	IRewindStateSource*			pStateSource = nullptr;
+	bool						bEnabled = false;
+	std::deque<FRewindSegment>	Segments;	// oldest first
+	FRewindSegment*				pCurrentSegment = nullptr;
+	uint64_t					InstructionCount = 0;
+};
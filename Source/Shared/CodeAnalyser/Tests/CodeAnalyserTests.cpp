@@ -1,9 +1,18 @@
 #include "CodeAnalyserTests.h"
 
+#include "CodeAnalyser/BreakpointCondition.h"
 #include "CodeAnalyser/CodeAnalyserTypes.h"
 #include "CodeAnalyser/CodeAnalysisPage.h"
+#include "CodeAnalyser/MemorySearch.h"
+#include "CodeAnalyser/ReverseDebugger.h"
+#include "CodeAnalyser/TraceRecorder.h"
+#include "Util/MemoryBuffer.h"
+#include "Util/SlabAllocator.h"
+#include "Util/StringPool.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
 
 TEST(CodeAnalyserTest, BasicAssertions)
 {
@@ -27,6 +36,531 @@ TEST(CodeAnalyserTest, Enums)
 	EXPECT_EQ((int)ELabelType::Text, 3);
 }
 
+// The original vector based reference tracker - used to check behaviour against
+class FLegacyReferenceTracker
+{
+public:
+	bool	HasReferenceTo(FAddressRef addrRef)
+	{
+		for (const FAddressRef& ref : References)
+		{
+			if (ref == addrRef)
+				return true;
+		}
+		return false;
+	}
+
+	void	RegisterAccess(const FAddressRef& addrRef)
+	{
+		if (HasReferenceTo(addrRef))
+			return;
+
+		if (WriteCounter < MaxEntryCount)
+			References.emplace_back(addrRef);
+		else
+			References[WriteCounter % MaxEntryCount] = addrRef;
+
+		WriteCounter++;
+	}
+
+	int		MaxEntryCount = 32;
+	int		WriteCounter = 0;
+	std::vector<FAddressRef>	References;
+};
+
+TEST(CodeAnalyserTest, ItemReferenceTracker)
+{
+	FItemReferenceTracker tracker;
+	FLegacyReferenceTracker legacyTracker;
+
+	// register enough references to go inline -> overflow -> ring buffer eviction, with duplicates
+	uint32_t seed = 1234;
+	for (int i = 0; i < 2000; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const FAddressRef ref(0, (uint16_t)((seed >> 16) % 48));
+		tracker.RegisterAccess(ref);
+		legacyTracker.RegisterAccess(ref);
+
+		ASSERT_EQ(tracker.NumReferences(), (int)legacyTracker.References.size());
+		for (int refNo = 0; refNo < tracker.NumReferences(); refNo++)
+			ASSERT_EQ(tracker.GetReferences()[refNo], legacyTracker.References[refNo]);
+	}
+
+	// copy & remove
+	FItemReferenceTracker copy = tracker;
+	const FAddressRef removeRef = copy.GetReferences()[3];
+	EXPECT_TRUE(copy.RemoveReference(removeRef));
+	EXPECT_FALSE(copy.HasReferenceTo(removeRef));
+	EXPECT_TRUE(tracker.HasReferenceTo(removeRef));
+	EXPECT_EQ(copy.NumReferences(), tracker.NumReferences() - 1);
+
+	// small case stays inline
+	FItemReferenceTracker small;
+	small.RegisterAccess(FAddressRef(1, 0x8000));
+	small.RegisterAccess(FAddressRef(1, 0x8000));
+	small.RegisterAccess(FAddressRef(1, 0x8003));
+	EXPECT_EQ(small.NumReferences(), 2);
+	small.Reset();
+	EXPECT_TRUE(small.IsEmpty());
+}
+
+TEST(CodeAnalyserTest, DataInfoSparseFields)
+{
+	FDataInfo dataInfo;
+	EXPECT_FALSE(dataInfo.HasReferences());
+	EXPECT_FALSE(dataInfo.Comment.IsSet());
+	EXPECT_TRUE(dataInfo.GetReads().IsEmpty());	// reading doesn't allocate
+	EXPECT_FALSE(dataInfo.HasReferences());
+
+	dataInfo.EditWrites().RegisterAccess(FAddressRef(0, 0x8000));
+	dataInfo.Comment = "score";
+	EXPECT_TRUE(dataInfo.HasReferences());
+	EXPECT_TRUE(dataInfo.GetReads().IsEmpty());
+
+	// copies are deep
+	FDataInfo copy = dataInfo;
+	dataInfo.EditWrites().RegisterAccess(FAddressRef(0, 0x8001));
+	dataInfo.Comment += " x";
+	EXPECT_EQ(copy.GetWrites().NumReferences(), 1);
+	EXPECT_EQ(dataInfo.GetWrites().NumReferences(), 2);
+	EXPECT_STREQ(copy.Comment.c_str(), "score");
+
+	// empty comments and reset free the storage
+	dataInfo.Comment = "";
+	EXPECT_FALSE(dataInfo.Comment.IsSet());
+	dataInfo.Reset();
+	EXPECT_FALSE(dataInfo.HasReferences());
+	EXPECT_TRUE(dataInfo.GetWrites().IsEmpty());
+}
+
+// Register accesses for every address in a 64K address space from a handful of PCs, as happens during emulation
+// returns the time taken in ms
+template <typename TrackerType>
+double RunReferenceTrackerSweep(std::vector<TrackerType>& trackers, int noCallers)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	for (int pass = 0; pass < 8; pass++)
+	{
+		for (int addr = 0; addr < 0x10000; addr++)
+		{
+			for (int caller = 0; caller < noCallers; caller++)
+				trackers[addr].RegisterAccess(FAddressRef(0, (uint16_t)(0x8000 + caller * 3)));
+		}
+	}
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+TEST(CodeAnalyserTest, ItemReferenceTrackerSweep)
+{
+	// covers the inline, overflow & full cases
+	for (int noCallers : { 2, 4, 16, 32, 40 })
+	{
+		std::vector<FLegacyReferenceTracker> legacyTrackers(0x10000);
+		std::vector<FItemReferenceTracker> trackers(0x10000);
+
+		const double legacyMs = RunReferenceTrackerSweep(legacyTrackers, noCallers);
+		const double newMs = RunReferenceTrackerSweep(trackers, noCallers);
+		printf("Reference tracker 64K sweep, %d callers: vector %.2fms, hashed %.2fms\n", noCallers, legacyMs, newMs);
+		for (int addr = 0; addr < 0x10000; addr++)
+		{
+			const FItemReferenceTracker& tracker = trackers[addr];
+			const FLegacyReferenceTracker& legacyTracker = legacyTrackers[addr];
+			ASSERT_EQ(tracker.NumReferences(), (int)legacyTracker.References.size());
+			for (int refNo = 0; refNo < tracker.NumReferences(); refNo++)
+				ASSERT_EQ(tracker.GetReferences()[refNo], legacyTracker.References[refNo]);
+		}
+		EXPECT_EQ(trackers[0x1234].NumReferences(), std::min(noCallers, (int)FItemReferenceTracker::kMaxEntryCount));
+	}
+}
+
+// Straightforward search to check the optimised one against
+static std::vector<size_t> NaivePatternSearch(const std::vector<uint8_t>& mem, const FSearchPattern& pattern)
+{
+	std::vector<size_t> offsets;
+	for (size_t pos = 0; pos + pattern.Size() <= mem.size(); pos++)
+	{
+		if (pattern.MatchesAt(&mem[pos]))
+			offsets.push_back(pos);
+	}
+	return offsets;
+}
+
+TEST(CodeAnalyserTest, MemoryPatternSearch)
+{
+	FSearchPattern pattern;
+	EXPECT_TRUE(ParseSearchPattern("3E ?? CD", pattern));
+	ASSERT_EQ(pattern.Size(), 3);
+	EXPECT_EQ(pattern.Masks[1], 0);
+	EXPECT_TRUE(ParseSearchPattern("?f", pattern));
+	EXPECT_EQ(pattern.Bytes[0], 0x0f);
+	EXPECT_EQ(pattern.Masks[0], 0x0f);
+	EXPECT_FALSE(ParseSearchPattern("3E4", pattern));
+	EXPECT_FALSE(ParseSearchPattern("3G", pattern));
+	EXPECT_FALSE(ParseSearchPattern("", pattern));
+
+	// small alphabet so there are plenty of matches & near misses
+	std::vector<uint8_t> mem(16384 + 7);
+	uint32_t seed = 5678;
+	for (auto& byte : mem)
+	{
+		seed = seed * 1664525 + 1013904223;
+		byte = (uint8_t)((seed >> 16) & 3);
+	}
+
+	const char* patterns[] = { "01", "?2", "0102", "03??", "010203", "01??03", "0001020300", "????01", "000102030001020300010203", "0?0?0?0?0?" };
+	for (const char* pText : patterns)
+	{
+		ASSERT_TRUE(ParseSearchPattern(pText, pattern));
+		FSinglePatternSearch search;	// set up once and reused for each block like the bank search does
+		search.SetPattern(pattern);
+		for (size_t memSize : { (size_t)0, (size_t)1, (size_t)15, (size_t)17, (size_t)33, mem.size() })
+		{
+			const std::vector<uint8_t> block(mem.begin(), mem.begin() + memSize);
+			std::vector<size_t> offsets;
+			FindPatternInMemory(block.data(), block.size(), pattern, offsets);
+			EXPECT_EQ(offsets, NaivePatternSearch(block, pattern)) << pText << " size " << memSize;
+
+			std::vector<size_t> reusedOffsets;
+			search.FindInMemory(block.data(), block.size(), reusedOffsets);
+			EXPECT_EQ(reusedOffsets, offsets) << pText << " size " << memSize;
+		}
+	}
+}
+
+TEST(CodeAnalyserTest, MultiPatternSearch)
+{
+	std::vector<uint8_t> mem(16384);
+	uint32_t seed = 91011;
+	for (auto& byte : mem)
+	{
+		seed = seed * 1664525 + 1013904223;
+		byte = (uint8_t)((seed >> 16) & 3);
+	}
+
+	// overlapping patterns, shared prefixes & suffixes, wildcards at either end
+	const char* patterns[] = { "0102", "010203", "0203", "03", "00??01", "??0203??", "01?2", "02030001", "????" };
+	FMultiPatternSearch matcher;
+	std::vector<int> patternIndices;
+	for (const char* pText : patterns)
+	{
+		FSearchPattern pattern;
+		ASSERT_TRUE(ParseSearchPattern(pText, pattern));
+		patternIndices.push_back(matcher.AddPattern(pattern));
+	}
+	EXPECT_EQ(patternIndices.back(), -1);	// nothing to anchor on
+	matcher.Build();
+
+	std::vector<FPatternMatch> matches;
+	matcher.FindInMemory(mem.data(), mem.size(), matches);
+
+	// check against searching for each pattern separately
+	std::vector<FPatternMatch> expected;
+	for (int patternNo = 0; patternNo < (int)matcher.NumPatterns(); patternNo++)
+	{
+		for (size_t offset : NaivePatternSearch(mem, matcher.GetPattern(patternNo)))
+			expected.push_back({ offset, patternNo });
+	}
+	std::sort(expected.begin(), expected.end(), [](const FPatternMatch& a, const FPatternMatch& b)
+	{
+		return a.Offset != b.Offset ? a.Offset < b.Offset : a.PatternIndex < b.PatternIndex;
+	});
+
+	ASSERT_EQ(matches.size(), expected.size());
+	for (size_t matchNo = 0; matchNo < matches.size(); matchNo++)
+	{
+		EXPECT_EQ(matches[matchNo].Offset, expected[matchNo].Offset);
+		EXPECT_EQ(matches[matchNo].PatternIndex, expected[matchNo].PatternIndex);
+	}
+}
+
+TEST(CodeAnalyserTest, MemoryBufferVarInts)
+{
+	const uint32_t values[] = { 0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 0xffff, 0x12345678, 0xffffffff };
+	const int32_t signedValues[] = { 0, -1, 1, -64, 64, -32768, 32767, INT32_MIN, INT32_MAX };
+
+	FMemoryBuffer buffer;
+	buffer.Init(4);	// make it grow
+	for (uint32_t value : values)
+		buffer.WriteVarInt(value);
+	for (int32_t value : signedValues)
+		buffer.WriteSignedVarInt(value);
+
+	buffer.ResetPosition();
+	for (uint32_t value : values)
+		EXPECT_EQ(buffer.ReadVarInt(), value);
+	for (int32_t value : signedValues)
+		EXPECT_EQ(buffer.ReadSignedVarInt(), value);
+	EXPECT_TRUE(buffer.Finished());
+	EXPECT_FALSE(buffer.HasReadOverrun());
+	EXPECT_EQ(buffer.ReadVarInt(), 0);	// reading past the end is flagged
+	EXPECT_TRUE(buffer.HasReadOverrun());
+	buffer.ResetPosition();
+	EXPECT_FALSE(buffer.HasReadOverrun());
+
+	// small values should only take a byte
+	FMemoryBuffer smallBuffer;
+	smallBuffer.Init();
+	smallBuffer.WriteVarInt(100);
+	smallBuffer.WriteSignedVarInt(-1);
+	EXPECT_EQ(smallBuffer.GetSize(), 2);
+}
+
+TEST(CodeAnalyserTest, SlabAllocator)
+{
+	static int liveCount = 0;
+	struct FTestItem
+	{
+		FTestItem() { liveCount++; }
+		~FTestItem() { liveCount--; }
+		std::string	Name = "test";
+	};
+
+	TSlabAllocator<FTestItem, 16> allocator;
+	std::vector<FTestItem*> items;
+	for (int i = 0; i < 40; i++)
+		items.push_back(allocator.Allocate());
+
+	EXPECT_EQ(liveCount, 40);
+	EXPECT_EQ(allocator.GetStats().NoAllocated, 40);
+	EXPECT_EQ(allocator.GetStats().NoSlabs, 3);
+	EXPECT_EQ(items[1] - items[0], 1);	// contiguous within a slab
+
+	allocator.FreeAll();
+	EXPECT_EQ(liveCount, 0);
+	EXPECT_EQ(allocator.GetStats().NoAllocated, 0);
+
+	// slabs get reused
+	FTestItem* pItem = allocator.Allocate();
+	EXPECT_EQ(pItem, items[0]);
+	EXPECT_EQ(allocator.GetStats().NoSlabs, 3);
+	EXPECT_EQ(allocator.GetStats().TotalAllocations, 41);
+}
+
+TEST(CodeAnalyserTest, StringPool)
+{
+	FInternedString empty;
+	EXPECT_TRUE(empty.empty());
+	EXPECT_STREQ(empty.c_str(), "");
+
+	FInternedString first = std::string("ld a,(hl)");
+	FInternedString second = "ld a,(hl)";
+	FInternedString other = "ret";
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(first.GetId(), second.GetId());
+	EXPECT_NE(first, other);
+	EXPECT_STREQ(first.c_str(), "ld a,(hl)");
+
+	// assigning the empty string gives the empty handle
+	second = "";
+	EXPECT_TRUE(second.empty());
+	first.clear();
+	EXPECT_EQ(first, second);
+
+	// reset frees everything but the empty string
+	FStringPool pool;
+	EXPECT_EQ(pool.Intern("ld a,(hl)"), 1);
+	EXPECT_EQ(pool.Intern("ret"), 2);
+	EXPECT_EQ(pool.GetNoStrings(), 3);
+	pool.Reset();
+	EXPECT_EQ(pool.GetNoStrings(), 1);
+	EXPECT_EQ(pool.GetNoBytes(), 0);
+	EXPECT_EQ(pool.Intern(""), 0);
+	EXPECT_EQ(pool.Intern("ret"), 1);
+	EXPECT_EQ(pool.Get(1), "ret");
+}
+
+class FTestConditionContext : public IBreakpointConditionContext
+{
+public:
+	bool GetConditionRegisterId(const char* pRegName, uint8_t& outId, bool& bOutWord) const override
+	{
+		if (strcmp(pRegName, "A") == 0)
+			return outId = 0, bOutWord = false, true;
+		if (strcmp(pRegName, "HL") == 0)
+			return outId = 1, bOutWord = true, true;
+		return false;
+	}
+	uint16_t GetConditionRegisterValue(uint8_t regId) const override { return regId == 0 ? A : HL; }
+	uint8_t GetConditionMemoryValue(uint16_t address) const override { return Memory[address]; }
+	int GetConditionFrameNo() const override { return FrameNo; }
+
+	uint8_t		A = 0;
+	uint16_t	HL = 0;
+	int			FrameNo = 0;
+	uint8_t		Memory[0x10000] = { 0 };
+};
+
+TEST(CodeAnalyserTest, BreakpointCondition)
+{
+	FTestConditionContext context;
+	context.A = 3;
+	context.HL = 0x5b00;
+	context.Memory[0x5b00] = 0x90;
+	context.FrameNo = 50;
+
+	FBreakpointCondition condition;
+	std::string error;
+	EXPECT_TRUE(condition.Compile("", context, error));
+	EXPECT_TRUE(condition.Evaluate(context, 1));	// no condition always passes
+
+	EXPECT_TRUE(condition.Compile("A == 3 && (HL) > 0x80", context, error));
+	EXPECT_TRUE(condition.Evaluate(context, 1));
+	context.Memory[0x5b00] = 0x10;
+	EXPECT_FALSE(condition.Evaluate(context, 1));
+
+	// brackets round anything other than an address are grouping
+	EXPECT_TRUE(condition.Compile("(a + 1) * 2 == 8 && [$5B00] == (HL) && ($5B00) == 16", context, error));
+	EXPECT_TRUE(condition.Evaluate(context, 1));
+
+	EXPECT_TRUE(condition.Compile("hits > 100 || frame == 50 && !(A & 1)", context, error));
+	EXPECT_FALSE(condition.Evaluate(context, 100));
+	EXPECT_TRUE(condition.Evaluate(context, 101));
+
+	// decimal numbers in brackets are values, not addresses
+	EXPECT_TRUE(condition.Compile("hits > (100)", context, error));
+	EXPECT_FALSE(condition.Evaluate(context, 100));
+	EXPECT_TRUE(condition.Evaluate(context, 101));
+
+	EXPECT_TRUE(condition.Compile("-A + 10 / 0 == -3", context, error));
+	EXPECT_TRUE(condition.Evaluate(context, 1));
+
+	EXPECT_FALSE(condition.Compile("Q == 1", context, error));
+	EXPECT_FALSE(error.empty());
+	EXPECT_FALSE(condition.Compile("(A == 1", context, error));
+	EXPECT_FALSE(condition.Compile("A ==", context, error));
+	EXPECT_FALSE(condition.Compile("$G0", context, error));
+	EXPECT_TRUE(condition.IsEmpty());
+}
+
+TEST(CodeAnalyserTest, TraceRecorder)
+{
+	const char* pFileName = "TraceRecorderTest.trace";
+	FTraceRecorder recorder;
+	ASSERT_TRUE(recorder.StartRecording(pFileName));
+
+	FAddressRef pc(1, 0x8000);
+	const FAddressRef screenAddr(2, 0x4000);
+	for (int frameNo = 10; frameNo < 13; frameNo++)
+	{
+		recorder.OnFrameStart(frameNo, pc);
+		for (int i = 0; i < 1000; i++)
+		{
+			pc.Address = (uint16_t)(0x8000 + (i % 100) * 3);
+			recorder.OnInstruction(pc);
+			if (i == 500)
+				recorder.OnMemoryWrite(screenAddr, (uint8_t)frameNo);
+		}
+		recorder.OnInstruction(FAddressRef(3, 0x0038));	// bank change
+		recorder.OnIO(0xfe, 7, true);
+		recorder.OnEvent({ 1, pc, 0xfe, 7, 100 });
+	}
+	// a stepped frame is recorded as several chunks
+	recorder.OnFrameStart(12, pc);
+	recorder.OnInstruction(FAddressRef(1, 0x9000));
+	recorder.OnMemoryWrite(screenAddr, 0xff);
+	recorder.OnFrameStart(13, pc);	// empty frame isn't written
+	recorder.StopRecording();
+	EXPECT_EQ(recorder.GetStats().NoFrames, 4);
+	EXPECT_LT(recorder.GetStats().StoredBytes, recorder.GetStats().RawBytes);
+
+	FTraceReader reader;
+	ASSERT_TRUE(reader.Open(pFileName));
+	EXPECT_EQ(reader.GetNoFrames(), 4);
+	EXPECT_EQ(reader.FindFrameIndex(13), -1);
+
+	FTraceFrame frame;
+	ASSERT_TRUE(reader.ReadFrame(reader.FindFrameIndex(11), frame));
+	EXPECT_EQ(frame.FrameNo, 11);
+	ASSERT_EQ(frame.Instructions.size(), 1001);
+	EXPECT_EQ(frame.Instructions[2], FAddressRef(1, 0x8006));
+	EXPECT_EQ(frame.Instructions.back(), FAddressRef(3, 0x0038));
+	ASSERT_EQ(frame.IOs.size(), 1);
+	EXPECT_TRUE(frame.IOs[0].bWrite);
+	EXPECT_EQ(frame.IOs[0].Port, 0xfe);
+	ASSERT_EQ(frame.Events.size(), 1);
+	EXPECT_EQ(frame.Events[0].ScanlinePos, 100);
+
+	std::vector<FTraceWrite> writes;
+	EXPECT_TRUE(reader.FindWritesToAddress(12, screenAddr, writes));
+	ASSERT_EQ(writes.size(), 2);
+	EXPECT_EQ(writes[0].PC, FAddressRef(1, 0x8000 + (500 % 100) * 3));
+	EXPECT_EQ(writes[0].Value, 12);
+	EXPECT_EQ(writes[1].PC, FAddressRef(1, 0x9000));
+	EXPECT_EQ(writes[1].Value, 0xff);
+	EXPECT_FALSE(reader.FindWritesToAddress(20, screenAddr, writes));
+
+	reader.Close();
+	remove(pFileName);
+}
+
+// machine state is a single counter
+class FTestRewindStateSource : public IRewindStateSource
+{
+public:
+	size_t	GetRewindStateSize() const override { return sizeof(Counter); }
+	void	SaveRewindState(void* pState) override { memcpy(pState, &Counter, sizeof(Counter)); }
+	void	LoadRewindState(const void* pState) override { memcpy(&Counter, pState, sizeof(Counter)); }
+
+	uint32_t	Counter = 0;
+};
+
+TEST(CodeAnalyserTest, ReverseDebugger)
+{
+	FTestRewindStateSource machine;
+	FReverseDebugger reverseDebugger;
+	reverseDebugger.Init(&machine);
+	reverseDebugger.MaxSegments = 3;
+
+	FRewindDebuggerState debuggerState;
+	reverseDebugger.OnExecuteStart(debuggerState);
+	EXPECT_TRUE(reverseDebugger.GetSegments().empty());	// off by default
+
+	// 5 runs of 10 instructions, the state is the run number
+	reverseDebugger.SetEnabled(true);
+	for (uint32_t run = 0; run < 5; run++)
+	{
+		machine.Counter = run;
+		debuggerState.EventTraceSize = run;
+		reverseDebugger.OnExecuteStart(debuggerState);
+		reverseDebugger.OnExecuteStart(debuggerState);	// nothing executed so no new segment
+		for (int i = 0; i < 10; i++)
+		{
+			reverseDebugger.OnInstruction(FAddressRef(0, (uint16_t)(run * 10 + i)));
+			reverseDebugger.OnMemoryWrite(FAddressRef(0, 0x4000), (uint8_t)i);
+		}
+	}
+
+	// oldest segments are recycled
+	const std::deque<FRewindSegment>& segments = reverseDebugger.GetSegments();
+	ASSERT_EQ(segments.size(), 3);
+	EXPECT_EQ(segments.front().FirstInstruction, 20);
+	EXPECT_EQ(segments.front().PCs.size(), 10);
+	EXPECT_EQ(segments.front().PCs[0], FAddressRef(0, 20));
+	EXPECT_EQ(segments.front().Writes.size(), 10);
+	EXPECT_EQ(reverseDebugger.GetInstructionCount(), 50);
+
+	EXPECT_FALSE(reverseDebugger.CanRestoreToInstruction(20));	// needs a segment that started before
+	EXPECT_TRUE(reverseDebugger.CanRestoreToInstruction(21));
+	EXPECT_TRUE(reverseDebugger.CanRestoreToInstruction(50));
+	EXPECT_FALSE(reverseDebugger.CanRestoreToInstruction(51));
+
+	// going back to the 5th instruction of the 4th run restores the state saved at its start
+	uint64_t noInstructionsToReplay = 0;
+	ASSERT_TRUE(reverseDebugger.RestoreToInstruction(35, noInstructionsToReplay, debuggerState));
+	EXPECT_EQ(noInstructionsToReplay, 5);
+	EXPECT_EQ(machine.Counter, 3);
+	EXPECT_EQ(debuggerState.EventTraceSize, 3);
+	EXPECT_EQ(segments.size(), 2);
+	EXPECT_TRUE(segments.back().PCs.empty());
+	EXPECT_EQ(reverseDebugger.GetInstructionCount(), 30);
+	EXPECT_FALSE(reverseDebugger.RestoreToInstruction(35, noInstructionsToReplay, debuggerState));
+
+	reverseDebugger.SetEnabled(false);
+	EXPECT_TRUE(reverseDebugger.GetSegments().empty());
+}
+
 bool RunCodeAnalyserTests(void)
 {
 	return true;
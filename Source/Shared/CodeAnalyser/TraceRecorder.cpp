@@ -0,0 +1,367 @@
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+#include "Debug/DebugLog.h"
+
+// File layout
+//
+// Header:	Magic, Version (uint32)
+// Frames:	FrameNo, RawSize, StoredSize (uint32) followed by StoredSize bytes of zlib compressed frame data
+// Index:	NoFrames (uint32) then FrameNo (uint32) & file offset (uint64) of each frame
+// Footer:	Index offset (uint64), Magic (uint32) - read first to find the index
+//
+// Frame data starts with the PC when the frame started (uint32) followed by records, each a type byte then:
+//	Instruction:	PC address delta from previous instruction (signed varint)
+//	Bank:			PC bank id for following instructions (int16)
+//	Write:			address (FAddressRef), value (uint8) - made by the last instruction
+//	IORead/IOWrite:	port (uint16), value (uint8)
+//	Event:			type (uint8), PC (FAddressRef), address (uint16), value (uint8), scanline pos (varint)
+
+static const uint32_t kTraceMagic = 0x45435254;		// 'TRCE'
+static const uint32_t kTraceIndexMagic = 0x58444954;	// 'TIDX'
+static const uint32_t kTraceVersion = 1;
+static const size_t kMaxQueuedFrames = 64;	// recording waits for the writer past this to cap memory use
+
+// long sessions go past 2GB which a long can't always hold
+static bool SeekTo(FILE* fp, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(fp, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool FTraceRecorder::StartRecording(const char* pFileName)
+{
+	StopRecording();
+
+	pFile = fopen(pFileName, "wb");
+	if (pFile == nullptr)
+	{
+		LOGERROR("Could not open trace file '%s' for writing", pFileName);
+		return false;
+	}
+
+	fwrite(&kTraceMagic, sizeof(uint32_t), 1, pFile);
+	fwrite(&kTraceVersion, sizeof(uint32_t), 1, pFile);
+
+	FileName = pFileName;
+	FileOffset = 2 * sizeof(uint32_t);
+	FrameIndex.clear();
+	Stats = FTraceRecorderStats();
+	bStopWorker = false;
+	bWriteError = false;
+	if (FrameBuffer.GetData() == nullptr)
+		FrameBuffer.Init(256 * 1024);
+	FrameBuffer.Clear();
+	FrameNo = -1;	// nothing recorded until the first frame starts
+
+	Worker = std::thread(&FTraceRecorder::WorkerThread, this);
+	LOGINFO("Recording trace to '%s'", pFileName);
+	return true;
+}
+
+void FTraceRecorder::StopRecording()
+{
+	if (pFile == nullptr)
+		return;
+
+	FlushFrame();
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bStopWorker = true;
+	}
+	FrameQueued.notify_all();
+	Worker.join();
+
+	// index & footer
+	const uint64_t indexOffset = FileOffset;
+	const uint32_t noFrames = (uint32_t)FrameIndex.size();
+	fwrite(&noFrames, sizeof(uint32_t), 1, pFile);
+	for (const auto& frame : FrameIndex)
+	{
+		const uint32_t frameNo = (uint32_t)frame.first;
+		fwrite(&frameNo, sizeof(uint32_t), 1, pFile);
+		fwrite(&frame.second, sizeof(uint64_t), 1, pFile);
+	}
+	fwrite(&indexOffset, sizeof(uint64_t), 1, pFile);
+	fwrite(&kTraceIndexMagic, sizeof(uint32_t), 1, pFile);
+
+	if (fclose(pFile) != 0)
+		bWriteError = true;
+	pFile = nullptr;
+
+	if (bWriteError)
+		LOGERROR("Error writing trace file '%s'", FileName.c_str());
+	else
+		LOGINFO("Trace '%s': %d frames, %dK compressed to %dK", FileName.c_str(), Stats.NoFrames, (int)(Stats.RawBytes / 1024), (int)(Stats.StoredBytes / 1024));
+}
+
+FTraceRecorderStats FTraceRecorder::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Stats;
+}
+
+void FTraceRecorder::OnFrameStart(int frameNo, FAddressRef pc)
+{
+	FlushFrame();
+	FrameNo = frameNo;
+	LastPC = pc;
+	FrameBuffer.Write(pc.Val);
+}
+
+void FTraceRecorder::OnEvent(const FTraceEvent& event)
+{
+	FrameBuffer.Write<uint8_t>(kRecord_Event);
+	FrameBuffer.Write(event.Type);
+	FrameBuffer.Write(event.PC.Val);
+	FrameBuffer.Write(event.Address);
+	FrameBuffer.Write(event.Value);
+	FrameBuffer.WriteVarInt(event.ScanlinePos);
+}
+
+// hand the frame over to the worker, the buffers are swapped so neither side allocates once running
+void FTraceRecorder::FlushFrame()
+{
+	const size_t kStartPCSize = sizeof(uint32_t);
+	if (FrameNo == -1 || FrameBuffer.GetSize() <= kStartPCSize)	// nothing executed
+	{
+		FrameBuffer.Clear();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(Mutex);
+	FrameWritten.wait(lock, [this]() { return Queue.size() < kMaxQueuedFrames; });
+
+	FQueuedFrame& frame = Queue.emplace_back();
+	frame.FrameNo = FrameNo;
+	frame.Data = std::move(FrameBuffer);
+	if (FreeBuffers.empty() == false)
+	{
+		FrameBuffer = std::move(FreeBuffers.back());
+		FreeBuffers.pop_back();
+	}
+	else
+	{
+		FrameBuffer.Init(frame.Data.GetSize());
+	}
+	lock.unlock();
+
+	FrameBuffer.Clear();
+	FrameQueued.notify_all();
+}
+
+void FTraceRecorder::WorkerThread()
+{
+	std::vector<uint8_t> compressedData;
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		FrameQueued.wait(lock, [this]() { return bStopWorker || Queue.empty() == false; });
+		if (Queue.empty())	// only stop once everything queued has been written
+			return;
+
+		FQueuedFrame frame = std::move(Queue.front());
+		Queue.pop_front();
+		lock.unlock();
+
+		const uLong rawSize = (uLong)frame.Data.GetSize();
+		uLongf storedSize = compressBound(rawSize);
+		compressedData.resize(storedSize);
+		bool bSuccess = compress2(compressedData.data(), &storedSize, (const Bytef*)frame.Data.GetData(), rawSize, Z_BEST_SPEED) == Z_OK;
+
+		const uint64_t fileOffset = FileOffset;
+		if (bSuccess)
+		{
+			const uint32_t header[3] = { (uint32_t)frame.FrameNo, (uint32_t)rawSize, (uint32_t)storedSize };
+			bSuccess = fwrite(header, sizeof(header), 1, pFile) == 1 && fwrite(compressedData.data(), storedSize, 1, pFile) == 1;
+			FileOffset += sizeof(header) + storedSize;
+		}
+
+		frame.Data.Clear();
+		lock.lock();
+		if (bSuccess)
+		{
+			FrameIndex.emplace_back(frame.FrameNo, fileOffset);
+			Stats.NoFrames++;
+			Stats.RawBytes += rawSize;
+			Stats.StoredBytes += storedSize;
+		}
+		else
+		{
+			bWriteError = true;	// logged on the main thread when recording stops
+		}
+		FreeBuffers.push_back(std::move(frame.Data));
+		FrameWritten.notify_all();
+	}
+}
+
+// Reader
+
+bool FTraceReader::Open(const char* pFileName)
+{
+	Close();
+
+	pFile = fopen(pFileName, "rb");
+	if (pFile == nullptr)
+		return false;
+
+	uint32_t magic = 0;
+	uint32_t versionNo = 0;
+	uint64_t indexOffset = 0;
+	uint32_t indexMagic = 0;
+	fread(&magic, sizeof(uint32_t), 1, pFile);
+	fread(&versionNo, sizeof(uint32_t), 1, pFile);
+	fseek(pFile, -(long)(sizeof(uint64_t) + sizeof(uint32_t)), SEEK_END);
+	fread(&indexOffset, sizeof(uint64_t), 1, pFile);
+	fread(&indexMagic, sizeof(uint32_t), 1, pFile);
+	if (magic != kTraceMagic || versionNo != kTraceVersion || indexMagic != kTraceIndexMagic)
+	{
+		LOGERROR("'%s' is not a trace file or wasn't finished", pFileName);
+		Close();
+		return false;
+	}
+
+	SeekTo(pFile, indexOffset);
+	uint32_t noFrames = 0;
+	fread(&noFrames, sizeof(uint32_t), 1, pFile);
+	FrameIndex.resize(noFrames);
+	for (auto& frame : FrameIndex)
+	{
+		uint32_t frameNo = 0;
+		fread(&frameNo, sizeof(uint32_t), 1, pFile);
+		fread(&frame.second, sizeof(uint64_t), 1, pFile);
+		frame.first = (int)frameNo;
+	}
+	std::sort(FrameIndex.begin(), FrameIndex.end());
+	return true;
+}
+
+void FTraceReader::Close()
+{
+	if (pFile != nullptr)
+		fclose(pFile);
+	pFile = nullptr;
+	FrameIndex.clear();
+	CachedFrameIndex = -1;
+}
+
+int FTraceReader::FindFrameIndex(int frameNo) const
+{
+	auto frameIt = std::lower_bound(FrameIndex.begin(), FrameIndex.end(), std::make_pair(frameNo, (uint64_t)0));
+	if (frameIt == FrameIndex.end() || frameIt->first != frameNo)
+		return -1;
+	return (int)(frameIt - FrameIndex.begin());
+}
+
+bool FTraceReader::ReadFrame(int frameIndex, FTraceFrame& outFrame)
+{
+	if (pFile == nullptr || frameIndex < 0 || frameIndex >= (int)FrameIndex.size())
+		return false;
+
+	uint32_t header[3] = { 0 };	// frame no, raw size, stored size
+	if (SeekTo(pFile, FrameIndex[frameIndex].second) == false || fread(header, sizeof(header), 1, pFile) != 1)
+		return false;
+
+	StoredData.resize(header[2]);
+	if (header[2] > 0 && fread(StoredData.data(), header[2], 1, pFile) != 1)
+		return false;
+
+	UncompressedData.resize(header[1]);
+	uLongf rawSize = header[1];
+	if (uncompress(UncompressedData.data(), &rawSize, StoredData.data(), header[2]) != Z_OK || rawSize != header[1])
+	{
+		LOGERROR("Trace: failed to decompress frame %d", (int)header[0]);
+		return false;
+	}
+
+	outFrame.FrameNo = (int)header[0];
+	outFrame.Instructions.clear();
+	outFrame.Writes.clear();
+	outFrame.IOs.clear();
+	outFrame.Events.clear();
+
+	RawData.Init(UncompressedData.data(), UncompressedData.size());
+	FAddressRef pc;
+	RawData.Read(pc.Val);
+	while (RawData.Finished() == false)
+	{
+		const uint8_t recordType = RawData.Read<uint8_t>();
+		switch (recordType)
+		{
+		case FTraceRecorder::kRecord_Instruction:
+			pc.Address = (uint16_t)(pc.Address + RawData.ReadSignedVarInt());
+			outFrame.Instructions.push_back(pc);
+			break;
+		case FTraceRecorder::kRecord_Bank:
+			RawData.Read(pc.BankId);
+			break;
+		case FTraceRecorder::kRecord_Write:
+		{
+			FTraceWrite& write = outFrame.Writes.emplace_back();
+			write.PC = pc;
+			RawData.Read(write.Address.Val);
+			RawData.Read(write.Value);
+		}
+		break;
+		case FTraceRecorder::kRecord_IORead:
+		case FTraceRecorder::kRecord_IOWrite:
+		{
+			FTraceIO& io = outFrame.IOs.emplace_back();
+			io.PC = pc;
+			RawData.Read(io.Port);
+			RawData.Read(io.Value);
+			io.bWrite = recordType == FTraceRecorder::kRecord_IOWrite;
+		}
+		break;
+		case FTraceRecorder::kRecord_Event:
+		{
+			FTraceEvent& event = outFrame.Events.emplace_back();
+			RawData.Read(event.Type);
+			RawData.Read(event.PC.Val);
+			RawData.Read(event.Address);
+			RawData.Read(event.Value);
+			event.ScanlinePos = (uint16_t)RawData.ReadVarInt();
+		}
+		break;
+		default:
+			LOGERROR("Trace: unknown record type %d in frame %d", recordType, outFrame.FrameNo);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// a frame number has several chunks when the emulator was stepped or stopped during it
+bool FTraceReader::FindWritesToAddress(int frameNo, FAddressRef address, std::vector<FTraceWrite>& outWrites)
+{
+	outWrites.clear();
+	const int firstFrameIndex = FindFrameIndex(frameNo);
+	if (firstFrameIndex == -1)
+		return false;
+
+	for (int frameIndex = firstFrameIndex; frameIndex < (int)FrameIndex.size() && FrameIndex[frameIndex].first == frameNo; frameIndex++)
+	{
+		// queries tend to look at the same frame repeatedly
+		if (frameIndex != CachedFrameIndex)
+		{
+			CachedFrameIndex = -1;
+			if (ReadFrame(frameIndex, CachedFrame) == false)
+				return false;
+			CachedFrameIndex = frameIndex;
+		}
+
+		for (const FTraceWrite& write : CachedFrame.Writes)
+		{
+			if (write.Address == address)
+				outWrites.push_back(write);
+		}
+	}
+	return true;
+}
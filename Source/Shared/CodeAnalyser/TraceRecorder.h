@@ -0,0 +1,162 @@
+#pragma once
+
+#include <CodeAnalyser/CodeAnalyserTypes.h>
+#include <Util/MemoryBuffer.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trace records, PC is the instruction that made the access
+
+struct FTraceWrite
+{
+	FAddressRef	PC;
+	FAddressRef	Address;
+	uint8_t		Value;
+};
+
+struct FTraceIO
+{
+	FAddressRef	PC;
+	uint16_t	Port;
+	uint8_t		Value;
+	bool		bWrite;
+};
+
+// copy of the debugger's FEvent
+struct FTraceEvent
+{
+	uint8_t		Type;
+	FAddressRef	PC;
+	uint16_t	Address;
+	uint8_t		Value;
+	uint16_t	ScanlinePos;
+};
+
+// Everything recorded for one frame
+struct FTraceFrame
+{
+	int							FrameNo = 0;
+	std::vector<FAddressRef>	Instructions;
+	std::vector<FTraceWrite>	Writes;
+	std::vector<FTraceIO>		IOs;
+	std::vector<FTraceEvent>	Events;
+};
+
+struct FTraceRecorderStats
+{
+	int		NoFrames = 0;
+	size_t	RawBytes = 0;
+	size_t	StoredBytes = 0;
+};
+
+// Streams the instruction trace to a file so long sessions can be recorded
+// Each frame is encoded into a buffer on the emulation thread & compressed & written on a worker thread
+// See TraceRecorder.cpp for the file layout
+class FTraceRecorder
+{
+public:
+	~FTraceRecorder() { StopRecording(); }
+
+	bool	StartRecording(const char* pFileName);
+	void	StopRecording();
+	bool	IsRecording() const { return pFile != nullptr; }
+	const std::string& GetFileName() const { return FileName; }
+	FTraceRecorderStats GetStats() const;
+
+	void	OnFrameStart(int frameNo, FAddressRef pc);
+	void	OnInstruction(FAddressRef pc)
+	{
+		if (pc.BankId != LastPC.BankId)
+		{
+			FrameBuffer.Write<uint8_t>(kRecord_Bank);
+			FrameBuffer.Write(pc.BankId);
+		}
+		FrameBuffer.Write<uint8_t>(kRecord_Instruction);
+		FrameBuffer.WriteSignedVarInt((int16_t)(pc.Address - LastPC.Address));	// usually a small step forward
+		LastPC = pc;
+	}
+	void	OnMemoryWrite(FAddressRef address, uint8_t value)
+	{
+		FrameBuffer.Write<uint8_t>(kRecord_Write);
+		FrameBuffer.Write(address.Val);
+		FrameBuffer.Write(value);
+	}
+	void	OnIO(uint16_t port, uint8_t value, bool bWrite)
+	{
+		FrameBuffer.Write<uint8_t>(bWrite ? kRecord_IOWrite : kRecord_IORead);
+		FrameBuffer.Write(port);
+		FrameBuffer.Write(value);
+	}
+	void	OnEvent(const FTraceEvent& event);
+
+	static const uint8_t kRecord_Instruction = 0;
+	static const uint8_t kRecord_Write = 1;
+	static const uint8_t kRecord_IORead = 2;
+	static const uint8_t kRecord_IOWrite = 3;
+	static const uint8_t kRecord_Event = 4;
+	static const uint8_t kRecord_Bank = 5;	// PC bank for following instructions
+
+private:
+	struct FQueuedFrame
+	{
+		int				FrameNo = 0;
+		FMemoryBuffer	Data;
+	};
+
+	void	FlushFrame();
+	void	WorkerThread();
+
+	FILE*					pFile = nullptr;
+	std::string				FileName;
+	FMemoryBuffer			FrameBuffer;	// frame being recorded
+	int						FrameNo = 0;
+	FAddressRef				LastPC;
+
+	std::thread				Worker;
+	mutable std::mutex		Mutex;
+	std::condition_variable	FrameQueued;
+	std::condition_variable	FrameWritten;
+	std::deque<FQueuedFrame>	Queue;
+	std::vector<FMemoryBuffer>	FreeBuffers;	// written frame buffers kept for reuse
+	bool					bStopWorker = false;
+	bool					bWriteError = false;
+
+	// owned by the worker thread until it has stopped
+	std::vector<std::pair<int, uint64_t>>	FrameIndex;	// frame number, file offset
+	uint64_t				FileOffset = 0;
+	FTraceRecorderStats		Stats;
+};
+
+// Random access to a recorded trace using the frame index at the end of the file
+class FTraceReader
+{
+public:
+	~FTraceReader() { Close(); }
+
+	bool	Open(const char* pFileName);
+	void	Close();
+	bool	IsOpen() const { return pFile != nullptr; }
+
+	int		GetNoFrames() const { return (int)FrameIndex.size(); }
+	int		GetFrameNo(int frameIndex) const { return FrameIndex[frameIndex].first; }
+	int		FindFrameIndex(int frameNo) const;	// first chunk recorded for the frame, -1 if it wasn't recorded
+	bool	ReadFrame(int frameIndex, FTraceFrame& outFrame);
+
+	// who wrote to this address in the frame
+	bool	FindWritesToAddress(int frameNo, FAddressRef address, std::vector<FTraceWrite>& outWrites);
+
+private:
+	FILE*									pFile = nullptr;
+	std::vector<std::pair<int, uint64_t>>	FrameIndex;	// sorted by frame number
+	std::vector<uint8_t>					StoredData;
+	std::vector<uint8_t>					UncompressedData;
+	FMemoryBuffer							RawData;
+	FTraceFrame								CachedFrame;
+	int										CachedFrameIndex = -1;
+};
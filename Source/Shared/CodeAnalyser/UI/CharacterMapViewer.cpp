@@ -257,9 +257,10 @@ void FCharacterMapViewer::DrawCharacterMap()
 		{
 			const int byte = (x + UIState.OffsetX) + ((y + UIState.OffsetY) * params.Stride);
 			const uint8_t val = state.ReadByte(physAddress + byte);
-			FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(physAddress + byte);
-			const int framesSinceWritten = pDataInfo->LastFrameWritten == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameWritten;
-			const int framesSinceRead = pDataInfo->LastFrameRead == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameRead;
+			const int lastFrameWritten = state.GetLastFrameWrittenForPhysicalAddress(physAddress + byte);
+			const int lastFrameRead = state.GetLastFrameReadForPhysicalAddress(physAddress + byte);
+			const int framesSinceWritten = lastFrameWritten == -1 ? 255 : state.CurrentFrameNo - lastFrameWritten;
+			const int framesSinceRead = lastFrameRead == -1 ? 255 : state.CurrentFrameNo - lastFrameRead;
 			const int wBrightVal = (255 - std::min(framesSinceWritten << 3, 255)) & 0xff;
 			const int rBrightVal = (255 - std::min(framesSinceRead << 3, 255)) & 0xff;
 
@@ -377,13 +378,13 @@ void FCharacterMapViewer::DrawCharacterMap()
 		// 
 		ImGui::Text("Address: %s", NumStr(UIState.SelectedCharAddress.Address));
 		DrawAddressLabel(state, state.GetFocussedViewState(), UIState.SelectedCharAddress);
-		FDataInfo* pDataInfo = state.GetDataInfoForAddress(UIState.SelectedCharAddress);
+		const FDataInfo* pDataInfo = state.GetDataInfoForAddress(UIState.SelectedCharAddress);
 
 		// List Data accesses
-		if (pDataInfo->Reads.IsEmpty() == false)
+		if (pDataInfo->GetReads().IsEmpty() == false)
 		{
 			ImGui::Text("Reads:");
-			for (const auto& reader : pDataInfo->Reads.GetReferences())
+			for (const auto& reader : pDataInfo->GetReads().GetReferences())
 			{
 				ShowCodeAccessorActivity(state, reader);
 
@@ -393,10 +394,10 @@ void FCharacterMapViewer::DrawCharacterMap()
 			}
 		}
 
-		if (pDataInfo->Writes.IsEmpty() == false)
+		if (pDataInfo->GetWrites().IsEmpty() == false)
 		{
 			ImGui::Text("Writes:");
-			for (const auto& writer : pDataInfo->Writes.GetReferences())
+			for (const auto& writer : pDataInfo->GetWrites().GetReferences())
 			{
 				ShowCodeAccessorActivity(state, writer);
 
@@ -562,7 +563,7 @@ public:
 			formattingOptions.CharacterSet = CharacterSet;
 			formattingOptions.RegisterItem = true;
 			FormatData(*CodeAnalysis, formattingOptions);
-			CodeAnalysis->SetCodeAnalysisDirty(formattingOptions.StartAddress);
+			CodeAnalysis->SetCodeAnalysisRangeDirty(formattingOptions.StartAddress, formattingOptions.ItemSize * formattingOptions.NoItems);
 		}
 
 		GridSquareSize = 14.0f * scale;	// to fit an 8x8 square on a scaling screen image
@@ -92,21 +92,23 @@ void FCodeAnalysisViewState::FixupAddressRefs(const FCodeAnalysisState& state)
 	}
 }
 
+// Index of first item in a list at or after an address - lists are sorted by address
+int GetFirstItemIndexAtAddress(const std::vector<FCodeAnalysisItem>& itemList, uint16_t address)
+{
+	const auto it = std::lower_bound(itemList.begin(), itemList.end(), address, 
+		[](const FCodeAnalysisItem& item, uint16_t addr) { return item.AddressRef.Address < addr; });
+	return (int)(it - itemList.begin());
+}
+
+// get index of the last item at or before an address
 int GetItemIndexForAddress(const FCodeAnalysisState &state, FAddressRef addr)
 {
 	const FCodeAnalysisBank* pBank = state.GetBank(addr.BankId);
-
-	int index = -1;
-
 	assert(pBank != nullptr);
-	
-	for (int i = 0; i < (int)pBank->ItemList.size(); i++)
-	{
-		if (pBank->ItemList[i].IsValid() && pBank->ItemList[i].AddressRef.Address > addr.Address)
-			return index;
-		index = i;
-	}
-	return -1;
+
+	const auto it = std::upper_bound(pBank->ItemList.begin(), pBank->ItemList.end(), addr.Address,
+		[](uint16_t addr, const FCodeAnalysisItem& item) { return addr < item.AddressRef.Address; });
+	return (int)(it - pBank->ItemList.begin()) - 1;
 }
 
 
@@ -370,6 +372,8 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 			LabelText = pLabelInfo->GetName();
 
 		pLabelInfo->ChangeName(LabelText.c_str());
+		state.bRebuildFilteredGlobalDataItems = true;
+		state.bRebuildFilteredGlobalFunctions = true;
 	}
 
 	if(ImGui::Checkbox("Global", &pLabelInfo->Global))
@@ -378,7 +382,8 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 			pLabelInfo->LabelType = ELabelType::Function;
 		if (pLabelInfo->LabelType == ELabelType::Function && pLabelInfo->Global == false)
 			pLabelInfo->LabelType = ELabelType::Code;
-		GenerateGlobalInfo(state);
+		RemoveLabelFromGlobalInfo(state, pLabelInfo);
+		AddLabelToGlobalInfo(state, pLabelInfo, item.AddressRef);
 	}
 
 	ImGui::Text("References:");
@@ -407,7 +412,7 @@ void DrawLabelDetails(FCodeAnalysisState &state, FCodeAnalysisViewState& viewSta
 
 		for(const auto& result : results)
 		{
-			FDataInfo* pDataInfo = state.GetDataInfoForAddress(result);
+			const FDataInfo* pDataInfo = state.GetDataInfoForAddress(result);
 
 			if(pDataInfo->DataType == EDataType::InstructionOperand)	// handle instructions differently
 				pLabelInfo->References.RegisterAccess(pDataInfo->InstructionAddress);
@@ -442,7 +447,7 @@ void DrawCommentBlockDetails(FCodeAnalysisState& state, const FCodeAnalysisItem&
 	if (pCommentBlock == nullptr)
 		return;
 
-	if (ImGui::InputTextMultiline("Comment Text", &pCommentBlock->Comment))
+	if (ImGui::InputTextMultiline("Comment Text", &pCommentBlock->Comment.Edit()))
 	{
 		if (pCommentBlock->Comment.empty() == true)
 			state.SetCommentBlockForAddress(item.AddressRef, nullptr);
@@ -625,6 +630,10 @@ void ProcessKeyCommands(FCodeAnalysisState& state, FCodeAnalysisViewState& viewS
 	{
 		state.Debugger.StepScreenWrite();
 	}
+	else if (ImGui::IsKeyPressed((ImGuiKey)state.KeyConfig[(int)EKey::StepBack]))
+	{
+		state.Debugger.StepBack();
+	}
 
 	// navigation controls
 	if(io.KeyCtrl || io.KeyShift)
@@ -680,7 +689,7 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		ImGui::SetNextItemWidth(50 * ImGui::GetFontSize());
 
 		ImGui::SetKeyboardFocusHere();
-		if (ImGui::InputText("##comment", &cursorItem.Item->Comment, ImGuiInputTextFlags_EnterReturnsTrue))
+		if (ImGui::InputText("##comment", &cursorItem.Item->Comment.Edit(), ImGuiInputTextFlags_EnterReturnsTrue))
 		{
 			ImGui::CloseCurrentPopup();
 		}
@@ -696,7 +705,7 @@ void UpdatePopups(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		ImGui::SetNextItemWidth(50 * ImGui::GetFontSize());
 
 		ImGui::SetKeyboardFocusHere();
-		if(ImGui::InputTextMultiline("##comment", &cursorItem.Item->Comment,ImVec2(), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine))
+		if(ImGui::InputTextMultiline("##comment", &cursorItem.Item->Comment.Edit(),ImVec2(), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine))
 		{
 			state.SetCodeAnalysisDirty(cursorItem.AddressRef);
 			ImGui::CloseCurrentPopup();
@@ -764,6 +773,63 @@ void ExpandCommentBlock(FCodeAnalysisState& state, FItemListBuilder& builder, FC
 	}
 }
 
+// Add the items at a bank address to the list
+// returns the address the next code or data item can start at
+int AddItemsForBankAddress(FCodeAnalysisState& state, FItemListBuilder& listBuilder, FCodeAnalysisPage& page, int bankAddr, int nextItemAddress)
+{
+	const uint16_t pageAddr = bankAddr & FCodeAnalysisPage::kPageMask;
+
+	FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
+	if (pCommentBlock != nullptr)
+		ExpandCommentBlock(state, listBuilder, pCommentBlock);
+
+	FLabelInfo* pLabelInfo = page.Labels[pageAddr];
+	if (pLabelInfo != nullptr)
+		listBuilder.ItemList.emplace_back(pLabelInfo, listBuilder.BankId, listBuilder.CurrAddr);
+
+	// check if we have gone past this item
+	if (bankAddr >= nextItemAddress)
+	{
+		FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
+		if (pCodeInfo != nullptr && pCodeInfo->bDisabled == false)
+		{
+			nextItemAddress = bankAddr + pCodeInfo->ByteSize;
+			listBuilder.ItemList.emplace_back(pCodeInfo, listBuilder.BankId, listBuilder.CurrAddr);
+		}
+		else // code and data are mutually exclusive
+		{
+			FDataInfo* pDataInfo = &page.DataInfo[pageAddr]; 
+			if (pDataInfo->DataType != EDataType::Blob && pDataInfo->DataType != EDataType::ScreenPixels)	// not sure why we want this
+				nextItemAddress = bankAddr + pDataInfo->ByteSize;
+			else
+				nextItemAddress = bankAddr + 1;
+
+			listBuilder.ItemList.emplace_back(pDataInfo, listBuilder.BankId, listBuilder.CurrAddr);
+		}
+	}
+
+	return nextItemAddress;
+}
+
+// Bank address after the end of a code or data item - -1 for other item types
+int GetItemEndBankAddress(const FCodeAnalysisBank& bank, const FCodeAnalysisItem& item)
+{
+	const int bankAddr = item.AddressRef.Address - bank.GetMappedAddress();
+
+	if (item.Item->Type == EItemType::Code)
+		return bankAddr + item.Item->ByteSize;
+
+	if (item.Item->Type == EItemType::Data)
+	{
+		const FDataInfo* pDataInfo = static_cast<const FDataInfo*>(item.Item);
+		if (pDataInfo->DataType != EDataType::Blob && pDataInfo->DataType != EDataType::ScreenPixels)
+			return bankAddr + pDataInfo->ByteSize;
+		return bankAddr + 1;
+	}
+
+	return -1;
+}
+
 void UpdateItemListForBank(FCodeAnalysisState& state, FCodeAnalysisBank& bank)
 {
 	bank.ItemList.clear();
@@ -771,49 +837,104 @@ void UpdateItemListForBank(FCodeAnalysisState& state, FCodeAnalysisBank& bank)
 	FItemListBuilder listBuilder(bank.ItemList);
 	listBuilder.BankId = bank.Id;
 
-	const int16_t page = bank.PrimaryMappedPage;
-	const uint16_t bankPhysAddr = page * FCodeAnalysisPage::kPageSize;
+	const uint16_t bankPhysAddr = bank.GetMappedAddress();
+	FCodeAnalysisPage* pPages = state.GetBankPagesForWrite(bank);
 	int nextItemAddress = 0;
 
 	for (int bankAddr = 0; bankAddr < bank.NoPages * FCodeAnalysisPage::kPageSize; bankAddr++)
 	{
-		FCodeAnalysisPage& page = bank.Pages[bankAddr >> FCodeAnalysisPage::kPageShift];
-		const uint16_t pageAddr = bankAddr & FCodeAnalysisPage::kPageMask;
 		listBuilder.CurrAddr = bankPhysAddr + bankAddr;
+		nextItemAddress = AddItemsForBankAddress(state, listBuilder, pPages[bankAddr >> FCodeAnalysisPage::kPageShift], bankAddr, nextItemAddress);
+	}
+}
+
+// A range of a bank's item list that has been replaced
+struct FItemListSplice
+{
+	int16_t	BankId = -1;
+	int		StartIndex = 0;
+	int		OldCount = 0;
+	int		NewCount = 0;
+};
+
+// Rebuild the items for the dirty pages of a bank and splice them into its item list
+// Comment lines from the replaced items go back to the bank's allocator
+void UpdateItemListForBankPages(FCodeAnalysisState& state, FCodeAnalysisBank& bank, std::vector<FItemListSplice>& splices)
+{
+	std::vector<FCodeAnalysisItem>& itemList = bank.ItemList;
+	const uint16_t bankPhysAddr = bank.GetMappedAddress();
+	const int bankSize = bank.GetSizeBytes();
+	FCodeAnalysisPage* pPages = state.GetBankPagesForWrite(bank);
+	std::vector<FCodeAnalysisItem> newItems;
+	int processedTo = 0;
+
+	int pageNo = 0;
+	while (pageNo < bank.NoPages)
+	{
+		if ((bank.DirtyPageMask & (1ull << pageNo)) == 0)
+		{
+			pageNo++;
+			continue;
+		}
 
-		FCommentBlock* pCommentBlock = page.CommentBlocks[pageAddr];
-		if (pCommentBlock != nullptr)
-			ExpandCommentBlock(state, listBuilder, pCommentBlock);
+		// find run of dirty pages
+		int endPageNo = pageNo + 1;
+		while (endPageNo < bank.NoPages && (bank.DirtyPageMask & (1ull << endPageNo)))
+			endPageNo++;
 
-		FLabelInfo* pLabelInfo = page.Labels[pageAddr];
-		if (pLabelInfo != nullptr)
-			listBuilder.ItemList.emplace_back(pLabelInfo, listBuilder.BankId, listBuilder.CurrAddr);
+		const int startAddr = std::max(pageNo * FCodeAnalysisPage::kPageSize, processedTo);
+		const int endAddr = endPageNo * FCodeAnalysisPage::kPageSize;
+		pageNo = endPageNo;
 
-		// check if we have gone past this item
-		if (bankAddr >= nextItemAddress)
+		// an item before the range might run into it
+		const int startIndex = GetFirstItemIndexAtAddress(itemList, bankPhysAddr + startAddr);
+		int nextItemAddress = startAddr;
+		for (int i = startIndex - 1; i >= 0; i--)
 		{
-			//FCodeInfo* pCodeInfo = state.GetCodeInfoForAddress(listBuilder.CurrAddr);
-			FCodeInfo* pCodeInfo = page.CodeInfo[pageAddr];
-			if (pCodeInfo != nullptr && pCodeInfo->bDisabled == false)
+			const int itemEnd = GetItemEndBankAddress(bank, itemList[i]);
+			if (itemEnd != -1)
 			{
-				nextItemAddress = bankAddr + pCodeInfo->ByteSize;
-				listBuilder.ItemList.emplace_back(pCodeInfo, listBuilder.BankId, listBuilder.CurrAddr);
+				nextItemAddress = std::max(nextItemAddress, itemEnd);
+				break;
 			}
-			else // code and data are mutually exclusive
-			{
-				//FDataInfo* pDataInfo = state.GetReadDataInfoForAddress(listBuilder.CurrAddr);
-				FDataInfo* pDataInfo = &page.DataInfo[pageAddr]; 
-				if (pDataInfo != nullptr)
-				{
-					if (pDataInfo->DataType != EDataType::Blob && pDataInfo->DataType != EDataType::ScreenPixels)	// not sure why we want this
-						nextItemAddress = bankAddr + pDataInfo->ByteSize;
-					else
-						nextItemAddress = bankAddr + 1;
+		}
 
-					listBuilder.ItemList.emplace_back(pDataInfo, listBuilder.BankId, listBuilder.CurrAddr);
-				}
-			}
+		// build new items until both lists are at the start of an item again
+		newItems.clear();
+		FItemListBuilder listBuilder(newItems);
+		listBuilder.BankId = bank.Id;
+		int endIndex = startIndex;
+		int oldItemsEnd = 0;
+		int bankAddr = startAddr;
+		while (bankAddr < bankSize)
+		{
+			while (endIndex < (int)itemList.size() && itemList[endIndex].AddressRef.Address < bankPhysAddr + bankAddr)
+				oldItemsEnd = std::max(oldItemsEnd, GetItemEndBankAddress(bank, itemList[endIndex++]));
+
+			if (bankAddr >= endAddr && bankAddr >= nextItemAddress && bankAddr >= oldItemsEnd)
+				break;
+
+			listBuilder.CurrAddr = bankPhysAddr + bankAddr;
+			nextItemAddress = AddItemsForBankAddress(state, listBuilder, pPages[bankAddr >> FCodeAnalysisPage::kPageShift], bankAddr, nextItemAddress);
+			bankAddr++;
 		}
+		if (bankAddr >= bankSize)
+			endIndex = (int)itemList.size();
+		processedTo = bankAddr;
+
+		for (int i = startIndex; i < endIndex; i++)
+		{
+			if (itemList[i].Item->Type == EItemType::CommentLine)
+				bank.CommentLineAllocator.Free(static_cast<FCommentLine*>(itemList[i].Item));
+		}
+		itemList.erase(itemList.begin() + startIndex, itemList.begin() + endIndex);
+		itemList.insert(itemList.begin() + startIndex, newItems.begin(), newItems.end());
+
+		FItemListSplice& splice = splices.emplace_back();
+		splice.BankId = bank.Id;
+		splice.StartIndex = startIndex;
+		splice.OldCount = endIndex - startIndex;
+		splice.NewCount = (int)newItems.size();
 	}
 }
 
@@ -822,47 +943,79 @@ void UpdateItemList(FCodeAnalysisState &state)
 	// build item list - not every frame please!
 	if (state.IsCodeAnalysisDataDirty() )
 	{
-		const float line_height = ImGui::GetTextLineHeight();
-		
-		state.ItemList.clear();
-		//FCommentLine::FreeAll();	// recycle comment lines
-
-		//int nextItemAddress = 0;
+		std::vector<FItemListSplice> splices;
+		bool bRebuiltBank = false;
 
 		auto& banks = state.GetBanks();
 		for (auto& bank : banks)
 		{
+			if (bank.Pages == nullptr)	// nothing to list until the bank gets used
+				continue;
+
 			if (bank.bIsDirty || bank.ItemList.empty())
 			{
 				UpdateItemListForBank(state, bank);
-				bank.bIsDirty = false;
+				bRebuiltBank = true;
+			}
+			else if (bank.DirtyPageMask != 0)
+			{
+				UpdateItemListForBankPages(state, bank, splices);
 			}
+			bank.bIsDirty = false;
+			bank.DirtyPageMask = 0;
 		}
-		int pageNo = 0;
 
-		while (pageNo < FCodeAnalysisState::kNoPagesInAddressSpace)
+		if (bRebuiltBank || state.HasMemoryBeenRemapped() || state.ItemList.empty())
 		{
-			int16_t bankId = state.GetBankFromAddress(pageNo * FCodeAnalysisPage::kPageSize);
-			FCodeAnalysisBank* pBank = state.GetBank(bankId);
-			if (pBank != nullptr)
+			// rebuild the physical address space list from the mapped banks
+			state.ItemList.clear();
+
+			int pageNo = 0;
+			while (pageNo < FCodeAnalysisState::kNoPagesInAddressSpace)
 			{
-				state.ItemList.insert(state.ItemList.end(), pBank->ItemList.begin(), pBank->ItemList.end());
-				/*const uint16_t bankAddrStart = pageNo * FCodeAnalysisPage::kPageSize;
-				for (const auto& bankItem : pBank->ItemList)
+				int16_t bankId = state.GetBankFromAddress(pageNo * FCodeAnalysisPage::kPageSize);
+				FCodeAnalysisBank* pBank = state.GetBank(bankId);
+				if (pBank != nullptr)
+				{
+					state.ItemList.insert(state.ItemList.end(), pBank->ItemList.begin(), pBank->ItemList.end());
+					pageNo += pBank->NoPages;
+				}
+				else
 				{
-					FCodeAnalysisItem& item = state.ItemList.emplace_back(bankItem);
-					item.AddressRef.Address += bankAddrStart;
-				}*/
-				pageNo += pBank->NoPages;
+					pageNo++;
+				}
 			}
-			else
+		}
+		else if (splices.empty() == false)
+		{
+			// apply the same splices to the mapped banks' section of the address space list
+			int pageNo = 0;
+			int bankListOffset = 0;
+			while (pageNo < FCodeAnalysisState::kNoPagesInAddressSpace)
 			{
-				pageNo++;
+				int16_t bankId = state.GetBankFromAddress(pageNo * FCodeAnalysisPage::kPageSize);
+				FCodeAnalysisBank* pBank = state.GetBank(bankId);
+				if (pBank != nullptr)
+				{
+					for (const FItemListSplice& splice : splices)
+					{
+						if (splice.BankId != bankId)
+							continue;
+
+						auto spliceStart = state.ItemList.begin() + bankListOffset + splice.StartIndex;
+						spliceStart = state.ItemList.erase(spliceStart, spliceStart + splice.OldCount);
+						state.ItemList.insert(spliceStart, pBank->ItemList.begin() + splice.StartIndex, pBank->ItemList.begin() + splice.StartIndex + splice.NewCount);
+					}
+					bankListOffset += (int)pBank->ItemList.size();
+					pageNo += pBank->NoPages;
+				}
+				else
+				{
+					pageNo++;
+				}
 			}
 		}
 
-		// Maybe this needs to follow the same algorithm as the main view?
-		//ImGui::SetScrollY(state.GetFocussedViewState().CursorItemIndex * line_height);
 		state.ClearDirtyStatus();
 
 		if (state.HasMemoryBeenRemapped())
@@ -1522,6 +1675,12 @@ void DrawDebuggerButtons(FCodeAnalysisState &state, FCodeAnalysisViewState& view
 		state.Debugger.StepScreenWrite();
 	}
 	ImGui::SameLine();
+	if (ImGui::Button("Step Back (F8)"))
+	{
+		state.Debugger.StepBack();
+		viewState.TrackPCFrame = true;
+	}
+	ImGui::SameLine();
 	if (ImGui::Button("<<< Trace"))
 	{
 		state.Debugger.TraceBack(viewState);
@@ -1546,9 +1705,9 @@ void DrawItemList(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 		const float currScrollY = ImGui::GetScrollY();
 		const float currWindowHeight = ImGui::GetWindowHeight();
 		const int kJumpViewOffset = 5;
-		for (int item = 0; item < (int)itemList.size(); item++)
+		for (int item = GetFirstItemIndexAtAddress(itemList, gotoAddress.Address); item < (int)itemList.size(); item++)
 		{
-			if ((itemList[item].AddressRef.Address >= gotoAddress.Address) && (viewState.GoToLabel || itemList[item].Item->Type != EItemType::Label))
+			if (viewState.GoToLabel || itemList[item].Item->Type != EItemType::Label)
 			{
 				// set cursor
 				viewState.SetCursorItem(itemList[item]);
@@ -2152,14 +2311,14 @@ void DrawFormatTab(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 		if (ImGui::Button("Format"))
 		{
 			FormatData(state, formattingOptions);
-			state.SetCodeAnalysisDirty(formattingOptions.StartAddress);
+			state.SetCodeAnalysisRangeDirty(formattingOptions.StartAddress, formattingOptions.ItemSize * formattingOptions.NoItems);
 		}
 		ImGui::SameLine();
 		if (ImGui::Button("Format & Advance"))
 		{
 			FormatData(state, formattingOptions);
+			state.SetCodeAnalysisRangeDirty(formattingOptions.StartAddress, formattingOptions.ItemSize * formattingOptions.NoItems);
 			state.AdvanceAddressRef(formattingOptions.StartAddress, formattingOptions.ItemSize * formattingOptions.NoItems);
-			state.SetCodeAnalysisDirty(formattingOptions.StartAddress);
 			viewState.GoToAddress(formattingOptions.StartAddress);
 		}
 		ImGui::SameLine();
@@ -2218,13 +2377,20 @@ void DrawFormatTab(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState)
 	}
 }
 
+// case insensitive substring search without making lower case copies
+static bool ContainsNoCase(const std::string& text, const std::string& subString)
+{
+	auto foundIt = std::search(text.begin(), text.end(), subString.begin(), subString.end(), [](unsigned char a, unsigned char b)
+	{
+		return std::tolower(a) == std::tolower(b);
+	});
+	return foundIt != text.end();
+}
+
 void GenerateFilteredLabelList(FCodeAnalysisState& state, const FLabelListFilter&filter,const std::vector<FCodeAnalysisItem>& sourceLabelList, std::vector<FCodeAnalysisItem>& filteredList)
 {
 	filteredList.clear();
 
-	std::string filterTextLower = filter.FilterText;
-	std::transform(filterTextLower.begin(), filterTextLower.end(), filterTextLower.begin(), [](unsigned char c){ return std::tolower(c); });
-
 	for (const FCodeAnalysisItem& labelItem : sourceLabelList)
 	{
 		if (labelItem.AddressRef.Address < filter.MinAddress || labelItem.AddressRef.Address > filter.MaxAddress)	// skip min address
@@ -2270,10 +2436,7 @@ void GenerateFilteredLabelList(FCodeAnalysisState& state, const FLabelListFilter
 		}
 
 		const FLabelInfo* pLabelInfo = static_cast<const FLabelInfo*>(labelItem.Item);
-		std::string labelTextLower = pLabelInfo->GetName();
-		std::transform(labelTextLower.begin(), labelTextLower.end(), labelTextLower.begin(), [](unsigned char c){ return std::tolower(c); });
-
-		if (filter.FilterText.empty() || labelTextLower.find(filterTextLower) != std::string::npos)
+		if (filter.FilterText.empty() || ContainsNoCase(pLabelInfo->GetNameString(), filter.FilterText))
 			filteredList.push_back(labelItem);
 	}
 }
@@ -215,7 +215,10 @@ void DrawCodeInfo(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 			const ImVec2 mousePos = ImGui::GetMousePos();
 			const ImVec2 dist(mousePos.x - mid.x, mousePos.y - mid.y);
 			if ((dist.x * dist.x + dist.y * dist.y) < (8 * 8))
+			{
 				pBP->bEnabled = !pBP->bEnabled;
+				debugger.MarkBreakpointsDirty();
+			}
 		}
 	}
 
@@ -259,7 +262,7 @@ void DrawCodeInfo(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState,
 			if (pCodeInfo->bSelfModifyingCode)
 			{
 				FDataInfo* pOperandData = state.GetWriteDataInfoForAddress(physAddress + i);
-				if (pOperandData->Writes.IsEmpty() == false)
+				if (pOperandData->GetWrites().IsEmpty() == false)
 				{
 					// Change the colour if this is self modifying code and the byte has been modified.
 					bByteModified = true;
@@ -374,10 +377,10 @@ void DrawCodeDetails(FCodeAnalysisState& state, FCodeAnalysisViewState& viewStat
 		for (int i = 1; i < pCodeInfo->ByteSize; i++)
 		{
 			FDataInfo* pOperandData = state.GetWriteDataInfoForAddress(physAddress + i);
-			if (pOperandData->Writes.IsEmpty() == false)
+			if (pOperandData->GetWrites().IsEmpty() == false)
 			{
 				ImGui::Text("Operand Writes:");
-				for (const auto& writer : pOperandData->Writes.GetReferences())
+				for (const auto& writer : pOperandData->GetWrites().GetReferences())
 				{
 					DrawCodeAddress(state, viewState, writer);
 				}
@@ -402,10 +402,10 @@ void EditWordDataItem(FCodeAnalysisState& state, uint16_t address)
 
 void ShowDataItemActivity(FCodeAnalysisState& state, FAddressRef addr)
 {
-	const FDataInfo* pDataInfo = state.GetDataInfoForAddress(addr);
-	//const FDataInfo* pWriteDataInfo = state.GetWriteDataInfoForAddress(addr);
-	const int framesSinceWritten = pDataInfo->LastFrameWritten == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameWritten;
-	const int framesSinceRead = pDataInfo->LastFrameRead == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameRead;
+	const int lastFrameWritten = state.GetLastFrameWrittenForAddress(addr);
+	const int lastFrameRead = state.GetLastFrameReadForAddress(addr);
+	const int framesSinceWritten = lastFrameWritten == -1 ? 255 : state.CurrentFrameNo - lastFrameWritten;
+	const int framesSinceRead = lastFrameRead == -1 ? 255 : state.CurrentFrameNo - lastFrameRead;
 	const int wBrightVal = (255 - std::min(framesSinceWritten << 2, 255)) & 0xff;
 	const int rBrightVal = (255 - std::min(framesSinceRead << 2, 255)) & 0xff;
 	float offset = 0;
@@ -714,10 +714,10 @@ void DrawDataValueGraphWord(FCodeAnalysisState& state, FAddressRef addressRef)
 }
 
 
-void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState, FDataInfo* pDataInfo)
+void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewState, FAddressRef addressRef, FDataInfo* pDataInfo)
 {
 	// List Data accesses
-	if (pDataInfo->Reads.IsEmpty() == false)
+	if (pDataInfo->GetReads().IsEmpty() == false)
 	{
 		static std::string commentTxt;
 		static bool bOverride = false;
@@ -735,7 +735,7 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 		}
 
 		ImGui::Text("Reads:");
-		for (const auto& reader : pDataInfo->Reads.GetReferences())
+		for (const auto& reader : pDataInfo->GetReads().GetReferences())
 		{
 			ShowCodeAccessorActivity(state, reader);
 
@@ -755,7 +755,7 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 		}
 	}
 
-	if (pDataInfo->Writes.IsEmpty() == false)
+	if (pDataInfo->GetWrites().IsEmpty() == false)
 	{
 		static std::string commentTxt;
 		static bool bOverride = false;
@@ -773,7 +773,7 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 		}
 
 		ImGui::Text("Writes:");
-		for (const auto& writer : pDataInfo->Writes.GetReferences())
+		for (const auto& writer : pDataInfo->GetWrites().GetReferences())
 		{
 			ShowCodeAccessorActivity(state, writer);
 
@@ -794,7 +794,7 @@ void DrawDataAccesses(FCodeAnalysisState& state, FCodeAnalysisViewState& viewSta
 	}
 
 	// last writer to address
-	const FAddressRef lastWriter = pDataInfo->LastWriter;
+	const FAddressRef lastWriter = state.GetLastWriterForAddress(addressRef);
 	if (lastWriter.IsValid())
 	{
 		ImGui::Text("Last Writer: ");
@@ -969,6 +969,6 @@ void DrawDataDetails(FCodeAnalysisState& state, FCodeAnalysisViewState& viewStat
 		break;
 	}
 
-	DrawDataAccesses(state, viewState, pDataInfo);
+	DrawDataAccesses(state, viewState, item.AddressRef, pDataInfo);
 }
 
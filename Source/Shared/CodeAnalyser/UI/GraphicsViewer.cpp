@@ -151,18 +151,19 @@ uint32_t GetHeatmapColourForMemoryAddress(const FCodeAnalysisPage& page, uint16_
 			return 0xFF00FFFF;	// yellow code
 	}
 
-	const FDataInfo& dataInfo = page.DataInfo[pageAddress];
+	const int lastFrameWritten = page.LastFrameWritten[pageAddress];
+	const int lastFrameRead = page.LastFrameRead[pageAddress];
 
-	if (dataInfo.LastFrameWritten != -1)
+	if (lastFrameWritten != -1)
 	{
-		const int framesSinceWritten = currentFrameNo - dataInfo.LastFrameWritten;
+		const int framesSinceWritten = currentFrameNo - lastFrameWritten;
 		if (framesSinceWritten < frameThreshold)
 			return 0xFF0000FF; // red
 	}
 
-	if (dataInfo.LastFrameRead != -1)
+	if (lastFrameRead != -1)
 	{
-		const int framesSinceRead = currentFrameNo - dataInfo.LastFrameRead;
+		const int framesSinceRead = currentFrameNo - lastFrameRead;
 		if (framesSinceRead < frameThreshold)
 			return 0xFF00FF00;	// green
 	}
@@ -301,7 +302,7 @@ void FGraphicsViewer::DrawMemoryBankAsGraphicsColumn(int16_t bankId, uint16_t me
 				case EBitmapFormat::Bitmap_1Bpp:
 				{
 					const uint8_t charLine = pBank->Memory[bankAddr];
-					FCodeAnalysisPage& page = pBank->Pages[bankAddr >> FCodeAnalysisPage::kPageShift];
+					const FCodeAnalysisPage& page = state.GetBankPage(*pBank, bankAddr >> FCodeAnalysisPage::kPageShift);
 					const uint32_t col = GetHeatmapColourForMemoryAddress(page, memAddr, state.CurrentFrameNo, HeatmapThreshold);
 					pGraphicsView->DrawCharLine(charLine, xPos + (xChar * 8), y, col, 0);
 
@@ -360,7 +361,7 @@ void FGraphicsViewer::DrawMemoryBankAsGraphicsColumnChars(int16_t bankId, uint16
 			case EBitmapFormat::Bitmap_1Bpp:
 			{
 				const uint8_t* pPixels = &pBank->Memory[bankAddr];
-				FCodeAnalysisPage& page = pBank->Pages[bankAddr >> FCodeAnalysisPage::kPageShift];
+				const FCodeAnalysisPage& page = state.GetBankPage(*pBank, bankAddr >> FCodeAnalysisPage::kPageShift);
 				const uint32_t col = GetHeatmapColourForMemoryAddress(page, memAddr, state.CurrentFrameNo, HeatmapThreshold);
 				const uint32_t cols[] = { 0, col};
 				pGraphicsView->Draw1BppImageAt(pPixels, xPos + (xChar * 8), y * 8, 8, 8, cols);
@@ -519,7 +520,7 @@ void FGraphicsViewer::UpdateCharacterGraphicsViewerImage(void)
 
 						const uint16_t bankAddr = address & bankSizeMask;
 						const uint8_t charLine = pBank->Memory[bankAddr];
-						FCodeAnalysisPage& page = pBank->Pages[bankAddr >> FCodeAnalysisPage::kPageShift];
+						const FCodeAnalysisPage& page = state.GetBankPage(*pBank, bankAddr >> FCodeAnalysisPage::kPageShift);
 						const uint32_t col = GetHeatmapColourForMemoryAddress(page, address, state.CurrentFrameNo, HeatmapThreshold);
 
 						if (address + graphicsUnitSize < 0xffff)
@@ -724,7 +725,7 @@ void FGraphicsViewer::DrawCharacterGraphicsViewer(void)
 		if (ImGui::CollapsingHeader("Details"))
 		{
 			const int16_t bankId = bShowPhysicalMemory ? state.GetBankFromAddress(ClickedAddress.Address) : Bank;
-			const FCodeAnalysisItem item(state.GetDataInfoForAddress(ClickedAddress), ClickedAddress);
+			const FCodeAnalysisItem item(state.EditDataInfoForAddress(ClickedAddress), ClickedAddress);
 			DrawDataDetails(state, state.GetFocussedViewState(), item);
 		}
 	}
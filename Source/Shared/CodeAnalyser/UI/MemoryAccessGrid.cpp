@@ -63,9 +63,10 @@ void FMemoryAccessGrid::DrawGrid(float x, float y)
 			if(curCharAddress.IsValid() == false)
 				continue;
 
-			FDataInfo* pDataInfo = state.GetDataInfoForAddress(curCharAddress);
-			const int framesSinceWritten = pDataInfo->LastFrameWritten == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameWritten;
-			const int framesSinceRead = pDataInfo->LastFrameRead == -1 ? 255 : state.CurrentFrameNo - pDataInfo->LastFrameRead;
+			const int lastFrameWritten = state.GetLastFrameWrittenForAddress(curCharAddress);
+			const int lastFrameRead = state.GetLastFrameReadForAddress(curCharAddress);
+			const int framesSinceWritten = lastFrameWritten == -1 ? 255 : state.CurrentFrameNo - lastFrameWritten;
+			const int framesSinceRead = lastFrameRead == -1 ? 255 : state.CurrentFrameNo - lastFrameRead;
 			const int wBrightVal = (255 - std::min(framesSinceWritten << 3, 255)) & 0xff;
 			const int rBrightVal = (255 - std::min(framesSinceRead << 3, 255)) & 0xff;
 			const float xp = pos.x + (x * rectSize);
@@ -181,12 +182,12 @@ void FMemoryAccessGrid::DrawGrid(float x, float y)
 		ImGui::Text("Address: %s", NumStr(SelectedCharAddress.Address));
 		DrawAddressLabel(state,state.GetFocussedViewState(),SelectedCharAddress);
 		// Show data reads & writes
-		FDataInfo* pDataInfo = state.GetDataInfoForAddress(SelectedCharAddress);
+		const FDataInfo* pDataInfo = state.GetDataInfoForAddress(SelectedCharAddress);
 		// List Data accesses
-		if (pDataInfo->Reads.IsEmpty() == false)
+		if (pDataInfo->GetReads().IsEmpty() == false)
 		{
 			ImGui::Text("Reads:");
-			for (const auto& reader : pDataInfo->Reads.GetReferences())
+			for (const auto& reader : pDataInfo->GetReads().GetReferences())
 			{
 				ShowCodeAccessorActivity(state, reader);
 
@@ -196,10 +197,10 @@ void FMemoryAccessGrid::DrawGrid(float x, float y)
 			}
 		}
 
-		if (pDataInfo->Writes.IsEmpty() == false)
+		if (pDataInfo->GetWrites().IsEmpty() == false)
 		{
 			ImGui::Text("Writes:");
-			for (const auto& writer : pDataInfo->Writes.GetReferences())
+			for (const auto& writer : pDataInfo->GetWrites().GetReferences())
 			{
 				ShowCodeAccessorActivity(state, writer);
 
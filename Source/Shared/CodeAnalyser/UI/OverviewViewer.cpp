@@ -55,7 +55,7 @@ void FOverviewViewer::CalculateStats()
 	for (const FCodeAnalysisBank& bank : banks)
 	{
 		// Skip unused banks
-		if(bank.bEverBeenMapped == false)
+		if(bank.bEverBeenMapped == false || bank.Pages == nullptr)
 			continue;
 
 		uint16_t bankAddress = 0;
@@ -75,9 +75,11 @@ void FOverviewViewer::CalculateStats()
 			}
 			else
 			{
-				const FDataInfo& dataInfo = bank.Pages[bankAddress >> FCodeAnalysisPage::kPageShift].DataInfo[bankAddress & FCodeAnalysisPage::kPageMask];
-				const bool bRead = dataInfo.LastFrameRead != -1;
-				const bool bWrite = dataInfo.LastFrameWritten != -1;
+				const FCodeAnalysisPage& page = bank.Pages[bankAddress >> FCodeAnalysisPage::kPageShift];
+				const uint16_t pageAddress = bankAddress & FCodeAnalysisPage::kPageMask;
+				const FDataInfo& dataInfo = page.DataInfo[pageAddress];
+				const bool bRead = page.LastFrameRead[pageAddress] != -1;
+				const bool bWrite = page.LastFrameWritten[pageAddress] != -1;
 				if(bank.bMachineROM)	// TODO: a 'read only' bool would service this better
 				{
 					Stats.ReadOnlyDataCount++;
@@ -131,7 +133,7 @@ void	FOverviewViewer::DrawBankOverview()
 		const uint16_t bankSizeBytes = pBank->GetSizeBytes();
 		while (bankAddress < bankSizeBytes)
 		{
-			const FCodeInfo* pCodeInfo = pBank->Pages[bankAddress >> FCodeAnalysisPage::kPageShift].CodeInfo[bankAddress & FCodeAnalysisPage::kPageMask];
+			const FCodeInfo* pCodeInfo = state.GetBankPage(*pBank, bankAddress >> FCodeAnalysisPage::kPageShift).CodeInfo[bankAddress & FCodeAnalysisPage::kPageMask];
 			if (pCodeInfo)
 			{
 				const int framesSinceExecuted = currentFrameNo - pCodeInfo->FrameLastExecuted;
@@ -144,20 +146,24 @@ void	FOverviewViewer::DrawBankOverview()
 			}
 			else
 			{
-				const FDataInfo& dataInfo = pBank->Pages[bankAddress >> FCodeAnalysisPage::kPageShift].DataInfo[bankAddress & FCodeAnalysisPage::kPageMask];
-				const bool bRead = dataInfo.LastFrameRead != -1;
-				const bool bWrite = dataInfo.LastFrameWritten != -1;
+				const FCodeAnalysisPage& page = state.GetBankPage(*pBank, bankAddress >> FCodeAnalysisPage::kPageShift);
+				const uint16_t pageAddress = bankAddress & FCodeAnalysisPage::kPageMask;
+				const FDataInfo& dataInfo = page.DataInfo[pageAddress];
+				const int lastFrameRead = page.LastFrameRead[pageAddress];
+				const int lastFrameWritten = page.LastFrameWritten[pageAddress];
+				const bool bRead = lastFrameRead != -1;
+				const bool bWrite = lastFrameWritten != -1;
 
 				uint32_t dataCol = 0xff000000;	// black for unknown areas
 
 				if (bWrite)
 				{
-					const int framesSinceWritten = currentFrameNo - dataInfo.LastFrameWritten;
+					const int framesSinceWritten = currentFrameNo - lastFrameWritten;
 					dataCol = (framesSinceWritten <  frameThreshold) ? 0xFF0000FF : 0xFF000080;
 				}
 				else if(bRead)
 				{
-					const int framesSinceRead = currentFrameNo - dataInfo.LastFrameRead;
+					const int framesSinceRead = currentFrameNo - lastFrameRead;
 					dataCol = (framesSinceRead < frameThreshold) ? 0xFF00FF00 - (framesSinceRead << 16) : 0xFF008000;
 				}
 
@@ -250,23 +256,25 @@ void FOverviewViewer::DrawAccessMap(FCodeAnalysisState& state, uint32_t* pPix)
 		{
 			const FDataInfo* pReadDataInfo = state.GetReadDataInfoForAddress(addr);
 			const FDataInfo* pWriteDataInfo = state.GetWriteDataInfoForAddress(addr);
-			const bool bRead = pReadDataInfo->Reads.IsEmpty() == false;
-			const bool bWrite = pWriteDataInfo->Writes.IsEmpty() == false;
+			const bool bRead = pReadDataInfo->GetReads().IsEmpty() == false;
+			const bool bWrite = pWriteDataInfo->GetWrites().IsEmpty() == false;
 			const bool bUsed = (bRead || bWrite);
 
 			uint32_t dataCol = bUsed ? 0xffff0000 : 0xff000000;
 
 
-			if (pReadDataInfo != nullptr && pReadDataInfo->LastFrameRead != -1)
+			const int lastFrameRead = state.GetLastFrameReadForPhysicalAddress(addr);
+			if (lastFrameRead != -1)
 			{
-				const int framesSinceRead = currentFrameNo - pReadDataInfo->LastFrameRead;
+				const int framesSinceRead = currentFrameNo - lastFrameRead;
 				if (framesSinceRead < frameThreshold)
 					dataCol = 0xFF00FF00;
 			}
 
-			if (pWriteDataInfo != nullptr && pWriteDataInfo->LastFrameWritten != -1)
+			const int lastFrameWritten = state.GetLastFrameWrittenForPhysicalAddress(addr);
+			if (lastFrameWritten != -1)
 			{
-				const int framesSinceWritten = currentFrameNo - pWriteDataInfo->LastFrameWritten;
+				const int framesSinceWritten = currentFrameNo - lastFrameWritten;
 				if (framesSinceWritten < frameThreshold)
 					dataCol = 0xFF0000FF;
 			}
@@ -357,19 +365,19 @@ void FOverviewViewer::DrawUtilisationMap(FCodeAnalysisState& state, uint32_t* pP
 			{
 				if (bShowActivity)
 				{
-					const FDataInfo* pReadDataInfo = state.GetDataInfoForAddress(readAddrRef);
-					const FDataInfo* pWriteDataInfo = state.GetDataInfoForAddress(writeAddrRef);
+					const int lastFrameRead = state.GetLastFrameReadForAddress(readAddrRef);
+					const int lastFrameWritten = state.GetLastFrameWrittenForAddress(writeAddrRef);
 					uint32_t drawCol = dataCol;
 
-					if (pWriteDataInfo != nullptr && pWriteDataInfo->LastFrameWritten != -1)	// Show write
+					if (lastFrameWritten != -1)	// Show write
 					{
-						const int framesSinceWritten = currentFrameNo - pWriteDataInfo->LastFrameWritten;
+						const int framesSinceWritten = currentFrameNo - lastFrameWritten;
 						if (framesSinceWritten < frameThreshold)
 							drawCol = kDataWriteCol;
 					}
-					else if (pReadDataInfo != nullptr && pReadDataInfo->LastFrameRead != -1)	// Show read
+					else if (lastFrameRead != -1)	// Show read
 					{
-						const int framesSinceRead = currentFrameNo - pReadDataInfo->LastFrameRead;
+						const int framesSinceRead = currentFrameNo - lastFrameRead;
 						if (framesSinceRead < frameThreshold)
 							drawCol = kDataReadCol;
 					}
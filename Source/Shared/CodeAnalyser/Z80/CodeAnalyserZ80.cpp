@@ -392,6 +392,47 @@ bool RegisterCodeExecutedZ80(FCodeAnalysisState& state, uint16_t pc, uint16_t ol
 	return false;
 }
 
+// Work out which instructions RegisterCodeExecutedZ80 needs to see - keep in sync with the switches above
+void ClassifyExecutedInstructionZ80(const FCodeAnalysisState& state, uint16_t pc, FDecodedInstruction& decoded)
+{
+	const uint8_t opcode = state.ReadByte(pc);
+
+	decoded.bCheckWhenExecuted = false;
+	decoded.bCheckWhenPrevious = false;
+
+	switch (opcode)
+	{
+		// stack & calls
+	case 0x31: case 0xF9:
+	case 0xC5: case 0xD5: case 0xE5: case 0xF5:
+		decoded.bCheckWhenExecuted = true;
+		break;
+	case 0xCD:
+	case 0xDC: case 0xFC: case 0xD4: case 0xC4:
+	case 0xF4: case 0xEC: case 0xE4: case 0xCC:
+		decoded.bCheckWhenExecuted = true;
+		decoded.bCheckWhenPrevious = true;
+		break;
+		// ret
+	case 0xC0: case 0xC8: case 0xC9: case 0xD0:
+	case 0xD8: case 0xE0: case 0xE8: case 0xF0: case 0xF8:
+		decoded.bCheckWhenPrevious = true;
+		break;
+	case 0xDD:
+	case 0xFD:
+	{
+		const uint8_t indexOpcode = state.ReadByte(pc + 1);
+		decoded.bCheckWhenExecuted = indexOpcode == 0xF9 || indexOpcode == 0xE5;
+	}
+	break;
+	case 0xED:
+		decoded.bCheckWhenExecuted = state.ReadByte(pc + 1) == 0x7B;
+		break;
+	default:
+		break;
+	}
+}
+
 std::vector<FMachineStateZ80*> g_FreeMachineStates;
 std::vector<FMachineStateZ80*> g_AllocatedMachineStates;
 
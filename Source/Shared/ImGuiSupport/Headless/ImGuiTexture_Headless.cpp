@@ -0,0 +1,26 @@
+#include "imgui.h"
+#include <cstdint>
+
+// Texture functions for headless builds - there is no renderer so textures are never created
+
+ImTextureID ImGui_CreateTextureRGBA(const void* pixels, int width, int height)
+{
+	return nullptr;
+}
+
+ImTextureID ImGui_CreateTexturePal8(const void* pixels, uint32_t* pPalette, int width, int height)
+{
+	return nullptr;
+}
+
+void ImGui_FreeTexture(ImTextureID texture)
+{
+}
+
+void ImGui_UpdateTextureRGBA(ImTextureID texture, const void* pixels)
+{
+}
+
+void ImGui_UpdateTextureRGBA(ImTextureID texture, const void* pixels, int srcWidth, int srcHeight)
+{
+}
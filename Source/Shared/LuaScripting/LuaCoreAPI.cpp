@@ -16,6 +16,7 @@ extern "C"
 #include "Util/GraphicsView.h"
 #include <ImGuiSupport/ImGuiScaling.h>
 #include "CodeAnalyser/UI/CodeAnalyserUI.h"
+#include "CodeAnalyser/MemorySearch.h"
 
 
 static int print(lua_State* pState)
@@ -97,7 +98,7 @@ static int SetDataItemComment(lua_State* pState)
 		size_t length = 0;
 		const char *pText = luaL_tolstring(pState,2,&length);
 
-		FDataInfo* pDataInfo = state.GetDataInfoForAddress(addrRef);
+		FDataInfo* pDataInfo = state.EditDataInfoForAddress(addrRef);
 		pDataInfo->Comment = pText;
 		//SetItemCommentText(state,,pText);
 	}
@@ -140,7 +141,7 @@ static int SetDataItemDisplayType(lua_State* pState)
 		const EDataItemDisplayType displayType = (EDataItemDisplayType)lua_tointeger(pState, 2);
 		FAddressRef addrRef = state.AddressRefFromPhysicalAddress((uint16_t)address);
 
-		FDataInfo* pDataInfo = state.GetDataInfoForAddress(addrRef);
+		FDataInfo* pDataInfo = state.EditDataInfoForAddress(addrRef);
 		pDataInfo->DisplayType = displayType;
 
 		if(displayType == EDataItemDisplayType::Pointer)
@@ -156,6 +157,54 @@ static int SetDataItemDisplayType(lua_State* pState)
 	return 0;
 }
 
+// Find all signatures from a signature list file in one pass over memory
+// returns an array of { Name, Address, Bank } tables
+static int FindSignatures(lua_State* pState)
+{
+	FEmuBase* pEmu = LuaSys::GetEmulator();
+	if (pEmu == nullptr || lua_isstring(pState, 1) == false)
+		return 0;
+
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const bool bSearchROM = lua_toboolean(pState, 2);
+	std::string fname = lua_tostring(pState, 1);
+
+	std::vector<FSignature> signatures;
+	if (LoadSignatureFile(fname.c_str(), signatures) == false)
+	{
+		// try relative to the project
+		fname = pEmu->GetGlobalConfig()->WorkspaceRoot + pEmu->GetProjectConfig()->Name + "/" + fname;
+		if (LoadSignatureFile(fname.c_str(), signatures) == false)
+			return 0;
+	}
+
+	FMultiPatternSearch matcher;
+	std::vector<int> patternSignatures;
+	for (int sigNo = 0; sigNo < (int)signatures.size(); sigNo++)
+	{
+		if (matcher.AddPattern(signatures[sigNo].Pattern) != -1)
+			patternSignatures.push_back(sigNo);
+	}
+	matcher.Build();
+
+	const std::vector<FFoundPattern> matches = state.FindAllMemoryPatterns(matcher, bSearchROM, false);
+	lua_createtable(pState, (int)matches.size(), 0);
+	for (int matchNo = 0; matchNo < (int)matches.size(); matchNo++)
+	{
+		const FFoundPattern& match = matches[matchNo];
+		lua_createtable(pState, 0, 3);
+		lua_pushstring(pState, signatures[patternSignatures[match.PatternIndex]].Name.c_str());
+		lua_setfield(pState, -2, "Name");
+		lua_pushinteger(pState, match.Address.Address);
+		lua_setfield(pState, -2, "Address");
+		lua_pushinteger(pState, match.Address.BankId);
+		lua_setfield(pState, -2, "Bank");
+		lua_rawseti(pState, -2, matchNo + 1);
+	}
+
+	return 1;
+}
+
 // Gui related
 
 static int DrawAddressLabel(lua_State* pState)
@@ -249,6 +298,7 @@ static const luaL_Reg corelib[] =
 	{"SetDataItemComment", SetDataItemComment},
 	{"SetCodeItemComment", SetCodeItemComment},
 	{"SetDataItemDisplayType", SetDataItemDisplayType},
+	{"FindSignatures", FindSignatures},
 	// UI
 	{"DrawAddressLabel", DrawAddressLabel},
 	//Graphics
@@ -7,6 +7,8 @@
 #include <CodeAnalyser/UI/GraphicsViewer.h>
 #include <CodeAnalyser/UI/CharacterMapViewer.h>
 #include <CodeAnalyser/DataTypes.h>
+#include <CodeAnalyser/CodeAnalysisBinary.h>
+#include <CodeAnalyser/CodeAnalysisJson.h>
 #include "GameConfig.h"
 
 #include "Debug/DebugLog.h"
@@ -15,6 +17,9 @@
 #include "LuaScripting/LuaSys.h"
 #include <CodeAnalyser/UI/UIColours.h>
 
+#include <chrono>
+#include <json.hpp>
+
 void FEmulatorLaunchConfig::ParseCommandline(int argc, char** argv)
 {
 	std::vector<std::string> argList;
@@ -36,10 +41,28 @@ void FEmulatorLaunchConfig::ParseCommandline(int argc, char** argv)
 			}
 			SpecificGame = *argIt;
 		}
+		else if (*argIt == std::string("-file"))
+		{
+			if (++argIt == argList.end())
+			{
+				LOGERROR("-file : No emulator file specified");
+				break;
+			}
+			SpecificEmulatorFile = *argIt;
+		}
 		else if (*argIt == std::string("-nomultiwindow"))
 		{
 			bMultiWindow = false;
 		}
+		else if (*argIt == std::string("-frames"))
+		{
+			if (++argIt == argList.end())
+			{
+				LOGERROR("-frames : No frame count specified");
+				break;
+			}
+			HeadlessFrameCount = atoi(argIt->c_str());
+		}
 
 		++argIt;
 	}
@@ -84,6 +107,22 @@ void FEmuBase::Tick()
 {
 	Colours::Tick();
 	UpdateCharacterSets(CodeAnalysis);
+	ProjectWriter.Update();
+}
+
+// Gather the analysis data for saving, the returned write functions own everything they need
+void FEmuBase::AddAnalysisToSaveBatch(FFileWriteBatch& batch, const std::string& analysisBinFName, const std::string& analysisJsonFName)
+{
+	std::shared_ptr<FAnalysisBinarySnapshot> pSnapshot = std::make_shared<FAnalysisBinarySnapshot>();
+	BuildAnalysisBinarySnapshot(CodeAnalysis, *pSnapshot);
+	batch.AddFile(analysisBinFName, [pSnapshot](FILE* fp) { return WriteAnalysisBinarySnapshot(*pSnapshot, fp); });
+
+	if (pGlobalConfig->bSaveAnalysisJson)
+	{
+		std::shared_ptr<nlohmann::json> pJson = std::make_shared<nlohmann::json>();
+		BuildAnalysisJson(CodeAnalysis, *pJson);
+		batch.AddFile(analysisJsonFName, [pJson](FILE* fp) { return WriteAnalysisJson(*pJson, fp); });
+	}
 }
 
 void FEmuBase::Reset()
@@ -91,6 +130,47 @@ void FEmuBase::Reset()
 
 }
 
+// Run the emulation for a host frame
+// In turbo mode we run whole machine frames until the time budget is used up, only the last one needs displaying
+void FEmuBase::ExecuteUIFrame(uint32_t microSeconds)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	auto elapsedMS = [startTime]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count(); };
+	int noFrames = 0;
+
+	if (bTurboMode)
+	{
+		const uint32_t frameMicroSeconds = GetMachineFrameMicroSeconds();
+		double frameMS = 0.0;
+		do
+		{
+			// display the frame if there isn't time for another one after it - that ends the loop
+			const double frameStartMS = elapsedMS();
+			bSkipFrameDisplay = frameStartMS + 2.0 * frameMS < TurboFrameBudgetMS;
+			ExecuteFrame(frameMicroSeconds);
+			frameMS = elapsedMS() - frameStartMS;
+			noFrames++;
+		} 
+		while (bSkipFrameDisplay && CodeAnalysis.Debugger.IsStopped() == false);
+		bSkipFrameDisplay = false;
+	}
+	else
+	{
+		ExecuteFrame(microSeconds);
+		noFrames = 1;
+	}
+
+	// update emulated frame rate twice a second
+	EmulatedFrameCount += noFrames;
+	EmulatedFPSTimer += ImGui::GetIO().DeltaTime;
+	if (EmulatedFPSTimer >= 0.5)
+	{
+		EmulatedFPS = (float)(EmulatedFrameCount / EmulatedFPSTimer);
+		EmulatedFrameCount = 0;
+		EmulatedFPSTimer = 0.0;
+	}
+}
+
 bool FEmuBase::DrawDockingView()
 {
 	//SCOPE_PROFILE_CPU("UI", "DrawUI", ProfCols::UI);
@@ -208,6 +288,9 @@ void FEmuBase::DrawUI()
 	if (bShowDebugLog)
 		g_ImGuiLog.Draw("Debug Log", &bShowDebugLog);
 
+	if (bShowAllocationStats)
+		DrawAllocationStatsWindow();
+
     if (bShowImGuiDemo)
         ImGui::ShowDemoWindow(&bShowImGuiDemo);
 
@@ -399,6 +482,9 @@ void FEmuBase::OptionsMenu()
 	}
 	ImGui::MenuItem("Scan Line Indicator", 0, &CodeAnalysis.pGlobalConfig->bShowScanLineIndicator);
 	ImGui::MenuItem("Enable Audio", 0, &CodeAnalysis.pGlobalConfig->bEnableAudio);
+	ImGui::MenuItem("Batch Data Access Analysis", 0, &CodeAnalysis.bRecordDataAccesses);
+	ImGui::MenuItem("Threaded Data Access Analysis", 0, &CodeAnalysis.bAnalysisThread);
+	ImGui::MenuItem("Turbo Mode", 0, &bTurboMode);
 	if (ImGui::MenuItem("Edit Mode", 0, &CodeAnalysis.bAllowEditing))
 	{
 		if(CodeAnalysis.bAllowEditing)
@@ -408,6 +494,7 @@ void FEmuBase::OptionsMenu()
 			
 	}
 	ImGui::MenuItem("Show Opcode Values", 0, &CodeAnalysis.pGlobalConfig->bShowOpcodeValues);
+	ImGui::MenuItem("Save Analysis Json", 0, &CodeAnalysis.pGlobalConfig->bSaveAnalysisJson);
 	if (ImGui::BeginMenu("Image Scale"))
 	{
 		for (int i = 0; i < 4; i++)
@@ -481,11 +568,52 @@ void FEmuBase::OptionsMenu()
 	ImGui::MenuItem("Show Config", 0, &CodeAnalysis.Config.bShowConfigWindow);
 	ImGui::MenuItem("ImGui Demo", 0, &bShowImGuiDemo);
 	ImGui::MenuItem("ImPlot Demo", 0, &bShowImPlotDemo);
+	ImGui::MenuItem("Allocation Stats", 0, &bShowAllocationStats);
 #endif // NDEBUG
 
 	OptionsMenuAdditions();
 }
 
+void FEmuBase::DrawAllocationStatsWindow()
+{
+	if (ImGui::Begin("Allocation Stats", &bShowAllocationStats))
+	{
+		auto drawStats = [](const char* pName, const FSlabAllocatorStats& stats)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", pName);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", (int)stats.NoAllocated);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", (int)stats.TotalAllocations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", (int)stats.NoSlabs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%dK", (int)(stats.BytesReserved / 1024));
+		};
+
+		if (ImGui::BeginTable("AllocationStats", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Type");
+			ImGui::TableSetupColumn("Allocated");
+			ImGui::TableSetupColumn("Total");
+			ImGui::TableSetupColumn("Slabs");
+			ImGui::TableSetupColumn("Reserved");
+			ImGui::TableHeadersRow();
+
+			drawStats("Labels", FLabelInfo::GetAllocationStats());
+			drawStats("Code Info", FCodeInfo::GetAllocationStats());
+			drawStats("Comment Blocks", FCommentBlock::GetAllocationStats());
+			ImGui::EndTable();
+		}
+
+		const FStringPool& stringPool = GetStringPool();
+		ImGui::Text("String pool: %d strings, %dK", (int)stringPool.GetNoStrings(), (int)(stringPool.GetNoBytes() / 1024));
+	}
+	ImGui::End();
+}
+
 void FEmuBase::SystemMenu()
 {
 	if (pCurrentProjectConfig && ImGui::MenuItem("Reload Emulator File"))
@@ -575,6 +703,8 @@ void FEmuBase::DrawMainMenu()
 		ImGui::SameLine(ImGui::GetWindowWidth() - 120);
 		if (CodeAnalysis.Debugger.IsStopped())
 			ImGui::Text("emu: stopped");
+		else if (bTurboMode)
+			ImGui::Text("turbo: %.0ffps", EmulatedFPS);
 		else
 			ImGui::Text("emu: %.2fms", timeMS);
 
@@ -784,6 +914,28 @@ bool FEmuBase::StartGameFromName(const char* pGameName, bool bLoadGameData)
 	return false;
 }
 
+// Create a new project from an emulator file found in one of the games lists
+bool FEmuBase::StartGameFromEmulatorFile(const char* pFileName)
+{
+	for (const auto& gamesListIt : GamesLists)
+	{
+		const FEmulatorFile* pEmuFile = gamesListIt.second.GetGame(pFileName);
+		if (pEmuFile == nullptr)
+			continue;
+
+		if (NewProjectFromEmulatorFile(*pEmuFile) == false)
+		{
+			Reset();
+			DisplayErrorMessage("Could not load emulator file '%s'", pEmuFile->FileName.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	LOGERROR("Could not find emulator file '%s'", pFileName);
+	return false;
+}
+
 void FEmuBase::GraphicsViewerSetView(FAddressRef address)
 {
 	if(pGraphicsViewer)
@@ -2,6 +2,7 @@
 
 #include "CodeAnalyser/CodeAnalyser.h"
 #include "GamesList.h"
+#include "Util/AsyncFileWriter.h"
 
 class FEmuBase;
 class FGraphicsViewer;
@@ -16,8 +17,12 @@ struct FEmulatorLaunchConfig
 	virtual void ParseCommandline(int argc, char** argv);
 
 	std::string		SpecificGame;
+	std::string		SpecificEmulatorFile;	// emulator file (snapshot, tape etc.) to create a new project from
 
 	bool		bMultiWindow = true;
+
+	// Headless batch analysis
+	int			HeadlessFrameCount = 500;	// number of frames to run before saving & exiting
 };
 
 class FViewerBase
@@ -36,13 +41,16 @@ public:
 };
 
 // Base class for emulators
-class FEmuBase : public ICPUInterface
+class FEmuBase : public ICPUInterface, public IRewindStateSource
 {
 public:
 	virtual bool	Init(const FEmulatorLaunchConfig& launchConfig);
 	virtual void    Shutdown();
 	virtual void    Tick();
 	virtual void    Reset();
+	virtual void	ExecuteFrame(uint32_t microSeconds) {}	// run emulation & analysis for a frame, no UI
+	void			ExecuteUIFrame(uint32_t microSeconds);	// run the emulation for a host frame - many machine frames in turbo mode
+	virtual uint32_t	GetMachineFrameMicroSeconds() const { return 20000; }	// length of an emulated frame, used by turbo mode
 	virtual void	AppFocusCallback(int focused){}
 
 	virtual bool	LoadLua(){ return false;}
@@ -57,6 +65,7 @@ public:
 	virtual void	OnExitEditMode(void) {}
 
 	bool			StartGameFromName(const char* pGameName, bool bLoadGame);
+	bool			StartGameFromEmulatorFile(const char* pFileName);
 
 	void			GraphicsViewerSetView(FAddressRef address);
 	void			CharacterMapViewerSetView(FAddressRef address);
@@ -111,11 +120,16 @@ protected:
 	void			DrawExportAsmModalPopup(void);
 	void			DrawReplaceGameModalPopup(void);
 	void			DrawErrorMessageModalPopup(void);
+	void			DrawAllocationStatsWindow(void);
+
+	// Project saving - snapshot on the main thread, write on ProjectWriter's thread
+	void			AddAnalysisToSaveBatch(FFileWriteBatch& batch, const std::string& analysisBinFName, const std::string& analysisJsonFName);
 
 	FGlobalConfig*		pGlobalConfig = nullptr;
 	FProjectConfig*		pCurrentProjectConfig = nullptr;
 
 	FCodeAnalysisState  CodeAnalysis;
+	FAsyncFileWriter	ProjectWriter;
 	//FGamesList			GamesList;
 	std::unordered_map<std::string, FGamesList>	GamesLists;
 	FGraphicsViewer*	pGraphicsViewer = nullptr;
@@ -130,12 +144,19 @@ protected:
 	// Assembler Export
 	uint16_t			AssemblerExportStartAddress = 0x0000;
 	uint16_t			AssemblerExportEndAddress = 0xffff;
+
+	// Turbo mode - run as many machine frames as fit in the time budget each host frame
+	bool				bTurboMode = false;
+	float				TurboFrameBudgetMS = 14.0f;
+	bool				bSkipFrameDisplay = false;	// set while running intermediate turbo frames
+	float				EmulatedFPS = 0.0f;
 	
 public:
 	bool		bShowImGuiDemo = false;
 	bool		bShowImPlotDemo = false;
 protected:
 	bool		bShowDebugLog = false;
+	bool		bShowAllocationStats = false;
 	bool		bReplaceGamePopup = false;
 	bool		bExportAsm = false;
 
@@ -146,4 +167,8 @@ protected:
 	bool				bErrorMessagePopup = false;
 
 	std::vector<FViewerBase*>	Viewers;
+
+	// emulated frame rate measurement
+	int			EmulatedFrameCount = 0;
+	double		EmulatedFPSTimer = 0.0;
 };
@@ -206,6 +206,8 @@ int RunMainLoop(FEmuBase* pEmulator, const FEmulatorLaunchConfig& launchConfig)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     pEmulator->Init(launchConfig);
+    if (launchConfig.SpecificEmulatorFile.empty() == false)
+        pEmulator->StartGameFromEmulatorFile(launchConfig.SpecificEmulatorFile.c_str());
     
     g_AppState.pEmulator = pEmulator;
 
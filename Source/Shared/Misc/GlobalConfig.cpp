@@ -24,6 +24,8 @@ void FGlobalConfig::ReadFromJson(const json& jsonConfigFile)
 		bShowScanLineIndicator = jsonConfigFile["ShowScanlineIndicator"];
 	if (jsonConfigFile.contains("ShowOpcodeValues"))
 		bShowOpcodeValues = jsonConfigFile["ShowOpcodeValues"];
+	if (jsonConfigFile.contains("SaveAnalysisJson"))
+		bSaveAnalysisJson = jsonConfigFile["SaveAnalysisJson"];
 	LastGame = jsonConfigFile["LastGame"];
 	NumberDisplayMode = (ENumberDisplayMode)jsonConfigFile["NumberMode"];
 	if (jsonConfigFile.contains("BranchLinesDisplayMode"))
@@ -74,6 +76,7 @@ void FGlobalConfig::WriteToJson(json& jsonConfigFile) const
 	jsonConfigFile["EnableAudio"] = bEnableAudio;
 	jsonConfigFile["ShowScanlineIndicator"] = bShowScanLineIndicator;
 	jsonConfigFile["ShowOpcodeValues"] = bShowOpcodeValues;
+	jsonConfigFile["SaveAnalysisJson"] = bSaveAnalysisJson;
 	jsonConfigFile["LastGame"] = LastGame;
 	jsonConfigFile["NumberMode"] = (int)NumberDisplayMode;
 	jsonConfigFile["BranchLinesDisplayMode"] = BranchLinesDisplayMode;
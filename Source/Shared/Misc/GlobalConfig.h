@@ -11,6 +11,7 @@ struct FGlobalConfig
 	bool				bEnableAudio;
 	bool				bShowScanLineIndicator = false;
 	bool				bShowOpcodeValues = false;
+	bool				bSaveAnalysisJson = false;	// also export analysis as json when saving, binary is always saved
 	ENumberDisplayMode	NumberDisplayMode = ENumberDisplayMode::HexAitch;
 	int					BranchLinesDisplayMode = 1;
 	std::string			LastGame;
@@ -0,0 +1,101 @@
+// Headless main loop for batch analysis
+// Runs the emulator at full speed for a fixed number of frames with no window, renderer or audio device.
+// The project (including Analysis.json & AnalysisState.bin) is saved when the emulator is shut down.
+
+#include "imgui.h"
+#include <implot.h>
+
+#include "Misc/EmuBase.h"
+#include "Debug/DebugLog.h"
+
+#include <chrono>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#define SOKOL_IMPL
+#define SOKOL_DUMMY_BACKEND
+#include "sokol_audio.h"
+
+// All the supported machines are PAL
+static const uint32_t kFrameMicroSeconds = 20000;
+
+int RunMainLoop(FEmuBase* pEmulator, const FEmulatorLaunchConfig& launchConfig)
+{
+	// Setup audio - the emulators need a valid sample rate
+	saudio_desc audioDesc = {};
+	saudio_setup(&audioDesc);
+
+	// Setup Dear ImGui context - no platform or renderer backend
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImPlot::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(1280.0f, 720.0f);
+	io.DeltaTime = kFrameMicroSeconds / 1000000.0f;
+
+	if (pEmulator->Init(launchConfig) == false)
+	{
+		LOGERROR("Failed to initialise emulator");
+		return 1;
+	}
+
+	if (launchConfig.SpecificEmulatorFile.empty() == false)
+	{
+		if (pEmulator->StartGameFromEmulatorFile(launchConfig.SpecificEmulatorFile.c_str()) == false)
+		{
+			LOGERROR("Failed to load emulator file '%s'", launchConfig.SpecificEmulatorFile.c_str());
+			pEmulator->Shutdown();
+			return 1;
+		}
+	}
+
+	// Loading a project breaks into the debugger
+	FDebugger& debugger = pEmulator->GetCodeAnalysis().Debugger;
+	if (debugger.IsStopped())
+		debugger.Continue();
+
+	// Font atlas needs building before ImGui::NewFrame() will run
+	unsigned char* pFontPixels = nullptr;
+	int fontWidth = 0, fontHeight = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pFontPixels, &fontWidth, &fontHeight);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	int frameNo = 0;
+	for (; frameNo < launchConfig.HeadlessFrameCount; frameNo++)
+	{
+		// Analysis code can make ImGui calls so keep a frame active
+		ImGui::NewFrame();
+		pEmulator->ExecuteFrame(kFrameMicroSeconds);
+		ImGui::EndFrame();
+
+		// Stop if a breakpoint has been hit
+		if (debugger.IsStopped())
+		{
+			LOGWARNING("Debugger stopped at frame %d", frameNo);
+			break;
+		}
+	}
+
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	const double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	LOGINFO("Ran %d frames in %.2f seconds (%.1f fps)", frameNo, seconds, seconds > 0.0 ? frameNo / seconds : 0.0);
+
+	pEmulator->Shutdown();	// saves project
+
+	saudio_shutdown();
+
+	ImPlot::DestroyContext();
+	ImGui::DestroyContext();
+
+	return 0;
+}
+
+void SetWindowTitle(const char* pTitle)
+{
+}
+
+void SetWindowIcon(const char* pIconFile)
+{
+}
@@ -0,0 +1,161 @@
+#include "AsyncFileWriter.h"
+#include "MemoryBuffer.h"
+
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
+#include "Debug/DebugLog.h"
+
+void FFileWriteBatch::AddFile(const std::string& fileName, std::shared_ptr<FMemoryBuffer> pBuffer)
+{
+	AddFile(fileName, [pBuffer](FILE* fp)
+	{
+		return pBuffer->GetSize() == 0 || fwrite(pBuffer->GetData(), pBuffer->GetSize(), 1, fp) == 1;
+	});
+}
+
+bool WriteFileAtomic(const std::string& fileName, const std::function<bool(FILE*)>& writeFunc, size_t* pBytesWritten, std::string* pErrorMessage)
+{
+	const std::string tempFileName = fileName + ".tmp";
+	FILE* fp = fopen(tempFileName.c_str(), "wb");
+	if (fp == nullptr)
+	{
+		if (pErrorMessage != nullptr)
+			*pErrorMessage = "Could not open '" + tempFileName + "' for writing";
+		return false;
+	}
+
+	bool bSuccess = writeFunc(fp);
+	const long noBytes = ftell(fp);
+	if (fclose(fp) != 0)
+		bSuccess = false;
+
+	std::error_code error;
+	if (bSuccess)
+	{
+		std::filesystem::rename(tempFileName, fileName, error);	// replaces the existing file
+		if (error && pErrorMessage != nullptr)
+			*pErrorMessage = "Could not rename '" + tempFileName + "' to '" + fileName + "': " + error.message();
+	}
+	else if (pErrorMessage != nullptr)
+	{
+		*pErrorMessage = "Error writing '" + tempFileName + "'";
+	}
+
+	if (bSuccess == false || error)
+	{
+		std::filesystem::remove(tempFileName, error);
+		return false;
+	}
+
+	if (pBytesWritten != nullptr)
+		*pBytesWritten = noBytes > 0 ? (size_t)noBytes : 0;
+	return true;
+}
+
+FAsyncFileWriter::FAsyncFileWriter()
+{
+	Worker = std::thread(&FAsyncFileWriter::WorkerThread, this);
+}
+
+FAsyncFileWriter::~FAsyncFileWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bShutdown = true;
+	}
+	BatchAdded.notify_all();
+	Worker.join();
+	Update();
+}
+
+void FAsyncFileWriter::QueueBatch(FFileWriteBatch&& batch)
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Batches.push_back(std::move(batch));
+	}
+	BatchAdded.notify_all();
+}
+
+void FAsyncFileWriter::Update()
+{
+	std::vector<std::string> infoMessages;
+	std::vector<std::string> errorMessages;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		infoMessages.swap(PendingInfoMessages);
+		errorMessages.swap(PendingErrorMessages);
+	}
+
+	for (const std::string& message : errorMessages)
+		LOGERROR("%s", message.c_str());
+	for (const std::string& message : infoMessages)
+		LOGINFO("%s", message.c_str());
+}
+
+bool FAsyncFileWriter::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return bWriting || Batches.empty() == false;
+}
+
+void FAsyncFileWriter::WaitUntilIdle()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	BatchDone.wait(lock, [this]() { return bWriting == false && Batches.empty(); });
+}
+
+FFileWriteStats FAsyncFileWriter::GetLastBatchStats() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return LastBatchStats;
+}
+
+void FAsyncFileWriter::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		BatchAdded.wait(lock, [this]() { return bShutdown || Batches.empty() == false; });
+		if (Batches.empty())	// only shut down once everything queued has been written
+			return;
+
+		FFileWriteBatch batch = std::move(Batches.front());
+		Batches.pop_front();
+		bWriting = true;
+		lock.unlock();
+
+		FFileWriteStats stats;
+		std::vector<std::string> errorMessages;
+		stats.SnapshotTimeMS = batch.SnapshotTimeMS;
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		for (const FFileWriteJob& job : batch.Jobs)
+		{
+			size_t noBytes = 0;
+			std::string errorMessage;
+			if (WriteFileAtomic(job.FileName, job.WriteFunc, &noBytes, &errorMessage))
+			{
+				stats.NoFilesWritten++;
+				stats.NoBytesWritten += noBytes;
+			}
+			else
+			{
+				stats.NoFilesFailed++;
+				errorMessages.push_back(errorMessage);
+			}
+		}
+		stats.WriteTimeMS = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		char message[256];
+		snprintf(message, sizeof(message), "Saved '%s': %d files, %d bytes. Snapshot %.1fms, write %.1fms", batch.Name.c_str(), stats.NoFilesWritten, (int)stats.NoBytesWritten, stats.SnapshotTimeMS, stats.WriteTimeMS);
+
+		lock.lock();
+		PendingInfoMessages.push_back(message);
+		PendingErrorMessages.insert(PendingErrorMessages.end(), errorMessages.begin(), errorMessages.end());
+		LastBatchStats = stats;
+		bWriting = false;
+		BatchDone.notify_all();
+	}
+}
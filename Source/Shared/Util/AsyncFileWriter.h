@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FMemoryBuffer;
+
+// A file to write, the write function runs on the writer thread so must only use data it owns
+struct FFileWriteJob
+{
+	std::string					FileName;
+	std::function<bool(FILE*)>	WriteFunc;
+};
+
+// A group of files that are written & reported on together, e.g. a project save
+struct FFileWriteBatch
+{
+	void	AddFile(const std::string& fileName, std::function<bool(FILE*)> writeFunc) { Jobs.push_back({ fileName, std::move(writeFunc) }); }
+	void	AddFile(const std::string& fileName, std::shared_ptr<FMemoryBuffer> pBuffer);
+
+	std::string					Name;
+	std::vector<FFileWriteJob>	Jobs;
+	float						SnapshotTimeMS = 0.0f;	// time taken to gather the data on the calling thread
+};
+
+struct FFileWriteStats
+{
+	int		NoFilesWritten = 0;
+	int		NoFilesFailed = 0;
+	size_t	NoBytesWritten = 0;
+	float	SnapshotTimeMS = 0.0f;
+	float	WriteTimeMS = 0.0f;
+};
+
+// Write a file via a temp file which is renamed over the original once complete
+// so a failed or interrupted write never leaves a half written file behind
+// Doesn't log so it can be used from any thread, the reason for failure is put in pErrorMessage
+bool WriteFileAtomic(const std::string& fileName, const std::function<bool(FILE*)>& writeFunc, size_t* pBytesWritten = nullptr, std::string* pErrorMessage = nullptr);
+
+// Writes batches of files on a background thread so saving doesn't stall the UI
+class FAsyncFileWriter
+{
+public:
+	FAsyncFileWriter();
+	~FAsyncFileWriter();	// finishes any queued batches
+
+	void			QueueBatch(FFileWriteBatch&& batch);
+	void			Update();	// call from the main thread to log the results of finished batches
+	bool			IsBusy() const;
+	void			WaitUntilIdle();	// call before reading back any files that might be queued
+	FFileWriteStats	GetLastBatchStats() const;
+
+private:
+	void			WorkerThread();
+
+	std::thread					Worker;
+	std::deque<FFileWriteBatch>	Batches;
+	mutable std::mutex			Mutex;
+	std::condition_variable		BatchAdded;
+	std::condition_variable		BatchDone;
+	bool						bWriting = false;
+	bool						bShutdown = false;
+	FFileWriteStats				LastBatchStats;
+	std::vector<std::string>	PendingInfoMessages;	// logging isn't thread safe so it's done in Update
+	std::vector<std::string>	PendingErrorMessages;
+};
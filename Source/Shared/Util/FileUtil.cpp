@@ -1,5 +1,6 @@
 #include "FileUtil.h"
 #include <string.h>
+#include <filesystem>
 
 #undef UNICODE 
 #undef _UNICODE 
@@ -89,6 +90,19 @@ bool FileExists(const char *pFilename)
 	return true;
 }
 
+bool IsFileNewerThan(const char* pFilename, const char* pOtherFilename)
+{
+	std::error_code error;
+	const auto fileTime = std::filesystem::last_write_time(pFilename, error);
+	if (error)
+		return false;
+	const auto otherFileTime = std::filesystem::last_write_time(pOtherFilename, error);
+	if (error)
+		return true;
+
+	return fileTime > otherFileTime;
+}
+
 char *LoadTextFile(const char *pFilename)
 {
 	FILE* fp = fopen(pFilename, "rt");
@@ -34,6 +34,7 @@ bool EnumerateDirectory(const char *dir, FDirFileList &outDirListing);
 bool EnsureDirectoryExists(const char *pDirectory);	// Ensure a directory exists creating it if it doesn't, returns if it was created
 
 bool FileExists(const char *pFilename);
+bool IsFileNewerThan(const char* pFilename, const char* pOtherFilename);	// a file that doesn't exist is never newer
 char *LoadTextFile(const char *pFilename);
 bool SaveTextFile(const char* pFileName, const char* pText);
 void *LoadBinaryFile(const char *pFilename, size_t &byteCount);
@@ -12,6 +12,27 @@ FMemoryBuffer::~FMemoryBuffer()
 		free(BasePtr);
 }
 
+FMemoryBuffer& FMemoryBuffer::operator=(FMemoryBuffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (AllocationSize != 0)
+			free(BasePtr);
+
+		bReadOnly = other.bReadOnly;
+		bReadOverrun = other.bReadOverrun;
+		AllocationSize = other.AllocationSize;
+		CurrentSize = other.CurrentSize;
+		ReadPosition = other.ReadPosition;
+		BasePtr = other.BasePtr;
+
+		other.AllocationSize = 0;
+		other.CurrentSize = 0;
+		other.ReadPosition = 0;
+		other.BasePtr = nullptr;
+	}
+	return *this;
+}
 
 void FMemoryBuffer::Init(size_t initialSize)
 {
@@ -21,11 +42,13 @@ void FMemoryBuffer::Init(size_t initialSize)
 	BasePtr = malloc(initialSize);
 	AllocationSize = initialSize;
 	CurrentSize = 0;
+	ReadPosition = 0;
+	bReadOverrun = false;
 }
 
 void FMemoryBuffer::Init(const void *pData, size_t dataSize)
 {
-	Init(dataSize);
+	Init(dataSize > 0 ? dataSize : 1);
 	CurrentSize = dataSize;
 	memcpy(BasePtr,pData, dataSize);
 }
@@ -36,7 +59,8 @@ void	FMemoryBuffer::WriteBytes(const void* pData, size_t noBytes)
 
 	if (CurrentSize + noBytes > AllocationSize)
 	{
-		AllocationSize = AllocationSize * 2;	// double allocation
+		while (CurrentSize + noBytes > AllocationSize)
+			AllocationSize = AllocationSize * 2;	// double allocation
 		BasePtr = realloc(BasePtr, AllocationSize);
 	}
 
@@ -54,6 +78,7 @@ bool FMemoryBuffer::ReadBytes(void* Dest, size_t noBytes)
 	}
 	else
 	{
+		bReadOverrun = true;
 		return false;
 	}
 }
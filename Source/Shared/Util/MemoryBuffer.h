@@ -2,17 +2,35 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 
 class FMemoryBuffer
 {
 public:
+	FMemoryBuffer() = default;
+	FMemoryBuffer(FMemoryBuffer&& other) noexcept { *this = std::move(other); }
+	FMemoryBuffer(const FMemoryBuffer&) = delete;
+	FMemoryBuffer& operator=(FMemoryBuffer&& other) noexcept;
+	FMemoryBuffer& operator=(const FMemoryBuffer&) = delete;
 	~FMemoryBuffer();
 	void	Init(size_t initialSize = 1024);
 	void	Init(const void* pData, size_t dataSize);
 	bool	Finished() const { return ReadPosition == CurrentSize; }
-	void	ResetPosition() { ReadPosition = 0; }
+	const void*	GetData() const { return BasePtr; }
+	size_t	GetSize() const { return CurrentSize; }
+	size_t	GetBytesRemaining() const { return CurrentSize - ReadPosition; }
+	bool	HasReadOverrun() const { return bReadOverrun; }	// a read has gone past the end since Init/ResetPosition
+	void	ResetPosition() { ReadPosition = 0; bReadOverrun = false; }
+	void	Clear() { CurrentSize = 0; ReadPosition = 0; bReadOverrun = false; }	// keeps the allocation for reuse
 	void	WriteBytes(const void* pData, size_t noBytes);
 	bool	ReadBytes(void* Dest, size_t noBytes);
+	bool	SkipBytes(size_t noBytes)
+	{
+		if (ReadPosition + noBytes > CurrentSize)
+			return false;
+		ReadPosition += noBytes;
+		return true;
+	}
 
 	template <class T>
 	void	Write(T item) { WriteBytes(&item, sizeof(T)); }
@@ -22,11 +40,42 @@ public:
 		WriteBytes(str.c_str(), str.size());
 	}
 
+	// LEB128 style variable length integers - small values take a single byte
+	void	WriteVarInt(uint32_t value)
+	{
+		uint8_t bytes[5];
+		int noBytes = 0;
+		while (value >= 0x80)
+		{
+			bytes[noBytes++] = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		bytes[noBytes++] = (uint8_t)value;
+		WriteBytes(bytes, noBytes);
+	}
+	void	WriteSignedVarInt(int32_t value) { WriteVarInt(((uint32_t)value << 1) ^ (uint32_t)(value >> 31)); }	// zigzag encoded
+
 	template <class T>
 	bool	Read(T& item) { return ReadBytes(&item, sizeof(T)); }
 	template <class T>
 	T	Read() { T item;  ReadBytes(&item, sizeof(T)); return item; }
 
+	uint32_t	ReadVarInt()
+	{
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			uint8_t byte = 0;
+			if (ReadBytes(&byte, 1) == false)
+				break;
+			value |= (uint32_t)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+	int32_t	ReadSignedVarInt() { const uint32_t value = ReadVarInt(); return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
 	std::string	ReadString(int noChars)
 	{
 		std::string str;
@@ -48,6 +97,7 @@ public:
 	bool SaveToFile(const char* pFileName) const;
 private:
 	bool	bReadOnly = false;
+	bool	bReadOverrun = false;
 	size_t	AllocationSize = 0;
 	size_t	CurrentSize = 0;
 	size_t	ReadPosition = 0;
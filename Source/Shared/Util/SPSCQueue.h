@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock free single producer/single consumer ring buffer
+// Push must only be called from one thread & Pop from one other thread
+template <class T>
+class FSPSCQueue
+{
+public:
+	FSPSCQueue(size_t capacity = 1 << 16)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		Buffer.resize(size);
+		Mask = size - 1;
+	}
+
+	bool	Push(const T& item)
+	{
+		const size_t head = Head.load(std::memory_order_relaxed);
+		if (head - Tail.load(std::memory_order_acquire) > Mask)
+			return false;	// full
+
+		Buffer[head & Mask] = item;
+		Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool	Pop(T& outItem)
+	{
+		const size_t tail = Tail.load(std::memory_order_relaxed);
+		if (tail == Head.load(std::memory_order_acquire))
+			return false;	// empty
+
+		outItem = Buffer[tail & Mask];
+		Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool	IsEmpty() const { return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire); }
+	size_t	GetCapacity() const { return Buffer.size(); }
+
+private:
+	std::vector<T>		Buffer;
+	size_t				Mask = 0;
+	alignas(64) std::atomic<size_t>	Head = 0;	// written by producer
+	alignas(64) std::atomic<size_t>	Tail = 0;	// written by consumer
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Allocation counters for the debug UI
+struct FSlabAllocatorStats
+{
+	size_t	NoAllocated = 0;		// objects currently allocated
+	size_t	NoSlabs = 0;			// slabs owned, including free ones kept for reuse
+	size_t	BytesReserved = 0;		// memory held in slabs
+	size_t	TotalAllocations = 0;	// allocations since startup
+};
+
+// Allocates objects of one type from large contiguous slabs
+// Allocation is a pointer bump & objects can't be freed individually - FreeAll destroys everything at once
+// Slabs are kept after FreeAll so loading the next project doesn't have to allocate them again
+// The type's constructor & destructor can be private if it makes this a friend
+template <class T, int kItemsPerSlab = 1024>
+class TSlabAllocator
+{
+public:
+	TSlabAllocator() = default;
+	TSlabAllocator(const TSlabAllocator&) = delete;
+	TSlabAllocator& operator=(const TSlabAllocator&) = delete;
+	~TSlabAllocator()
+	{
+		FreeAll();
+		for (T* pSlab : Slabs)
+			::operator delete(pSlab);
+	}
+
+	T* Allocate()
+	{
+		if (CurrentSlab == Slabs.size())
+			Slabs.push_back(static_cast<T*>(::operator new(sizeof(T) * kItemsPerSlab)));
+
+		T* pItem = new (&Slabs[CurrentSlab][NoUsedInSlab]) T;
+		if (++NoUsedInSlab == kItemsPerSlab)
+		{
+			CurrentSlab++;
+			NoUsedInSlab = 0;
+		}
+
+		NoAllocated++;
+		TotalAllocations++;
+		return pItem;
+	}
+
+	// destroy all objects, the slabs are kept for reuse
+	void FreeAll()
+	{
+		for (size_t slabNo = 0; slabNo <= CurrentSlab && slabNo < Slabs.size(); slabNo++)
+		{
+			const int noUsed = slabNo == CurrentSlab ? NoUsedInSlab : kItemsPerSlab;
+			T* pSlab = Slabs[slabNo];
+			for (int itemNo = 0; itemNo < noUsed; itemNo++)
+				pSlab[itemNo].~T();
+		}
+
+		CurrentSlab = 0;
+		NoUsedInSlab = 0;
+		NoAllocated = 0;
+	}
+
+	FSlabAllocatorStats GetStats() const
+	{
+		FSlabAllocatorStats stats;
+		stats.NoAllocated = NoAllocated;
+		stats.NoSlabs = Slabs.size();
+		stats.BytesReserved = Slabs.size() * sizeof(T) * kItemsPerSlab;
+		stats.TotalAllocations = TotalAllocations;
+		return stats;
+	}
+
+private:
+	std::vector<T*>	Slabs;
+	size_t			CurrentSlab = 0;
+	int				NoUsedInSlab = 0;
+	size_t			NoAllocated = 0;
+	size_t			TotalAllocations = 0;
+};
@@ -0,0 +1,40 @@
+#include "StringPool.h"
+
+FStringPool::FStringPool()
+{
+	Reset();
+}
+
+void FStringPool::Reset()
+{
+	Index.clear();
+	Strings.clear();
+	NoBytes = 0;
+	NoInternCalls = 0;
+
+	Strings.emplace_back();	// id 0 is the empty string
+	Index[Strings.back()] = 0;
+}
+
+uint32_t FStringPool::Intern(std::string_view str)
+{
+	NoInternCalls++;
+	if (str.empty())
+		return 0;
+
+	auto indexIt = Index.find(str);
+	if (indexIt != Index.end())
+		return indexIt->second;
+
+	const uint32_t id = (uint32_t)Strings.size();
+	Strings.emplace_back(str);
+	Index[Strings.back()] = id;
+	NoBytes += str.size() + 1;
+	return id;
+}
+
+FStringPool& GetStringPool()
+{
+	static FStringPool pool;
+	return pool;
+}
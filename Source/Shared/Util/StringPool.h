@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Stores a single copy of each string, strings are referred to by a 32 bit id
+// Id 0 is always the empty string
+// Strings are only removed by Reset, which FCodeAnalysisState::Init calls once all the labels & code info have been freed
+// Main thread only - it isn't thread safe, so the analysis worker thread mustn't intern or look up strings
+class FStringPool
+{
+public:
+	FStringPool();
+
+	void				Reset();	// invalidates every id apart from 0
+	uint32_t			Intern(std::string_view str);
+	const std::string&	Get(uint32_t id) const { return Strings[id]; }
+
+	size_t	GetNoStrings() const { return Strings.size(); }
+	size_t	GetNoBytes() const { return NoBytes; }
+	size_t	GetNoInternCalls() const { return NoInternCalls; }
+private:
+	std::deque<std::string>						Strings;	// deque so the views in the index stay valid
+	std::unordered_map<std::string_view, uint32_t>	Index;
+	size_t	NoBytes = 0;
+	size_t	NoInternCalls = 0;
+};
+
+FStringPool& GetStringPool();
+
+// Handle to a string in the global string pool - 4 bytes rather than a std::string per item
+// Has enough of the std::string interface to drop in where strings are set & read as a whole
+class FInternedString
+{
+public:
+	FInternedString() = default;
+	FInternedString(std::string_view str) : Id(GetStringPool().Intern(str)) {}
+	FInternedString(const std::string& str) : Id(GetStringPool().Intern(str)) {}
+	FInternedString(const char* pStr) : Id(GetStringPool().Intern(pStr)) {}
+
+	FInternedString& operator=(std::string_view str) { Id = GetStringPool().Intern(str); return *this; }
+	FInternedString& operator=(const std::string& str) { Id = GetStringPool().Intern(str); return *this; }
+	FInternedString& operator=(const char* pStr) { Id = GetStringPool().Intern(pStr); return *this; }
+
+	bool operator==(const FInternedString& other) const { return Id == other.Id; }
+	bool operator!=(const FInternedString& other) const { return Id != other.Id; }
+
+	const std::string&	GetString() const { return GetStringPool().Get(Id); }
+	const char*			c_str() const { return GetString().c_str(); }
+	size_t				size() const { return GetString().size(); }
+	bool				empty() const { return Id == 0; }
+	void				clear() { Id = 0; }
+	uint32_t			GetId() const { return Id; }
+
+private:
+	uint32_t	Id = 0;
+};
@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+FThreadPool::FThreadPool(int noThreads)
+{
+	if (noThreads == 0)
+		noThreads = (int)std::thread::hardware_concurrency() - 1;	// leave one for the calling thread
+
+	for (int threadNo = 0; threadNo < noThreads; threadNo++)
+		Workers.emplace_back(&FThreadPool::WorkerThread, this);
+}
+
+FThreadPool::~FThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		bShutdown = true;
+	}
+	JobAdded.notify_all();
+
+	for (std::thread& worker : Workers)
+		worker.join();
+}
+
+void FThreadPool::ParallelFor(int noJobs, const std::function<void(int)>& func)
+{
+	if (noJobs <= 0)
+		return;
+
+	auto pRemaining = std::make_shared<std::atomic<int>>(noJobs);
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (int jobNo = 0; jobNo < noJobs; jobNo++)
+		{
+			Jobs.push_back([this, jobNo, &func, pRemaining]()
+			{
+				func(jobNo);
+				if (--(*pRemaining) == 0)
+				{
+					std::lock_guard<std::mutex> doneLock(Mutex);
+					JobDone.notify_all();
+				}
+			});
+		}
+	}
+	JobAdded.notify_all();
+
+	// help out until our jobs are done
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (*pRemaining > 0)
+	{
+		if (RunQueuedJob(lock) == false)
+			JobDone.wait(lock, [&pRemaining]() { return *pRemaining == 0; });
+	}
+}
+
+void FThreadPool::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		JobAdded.wait(lock, [this]() { return bShutdown || Jobs.empty() == false; });
+		if (bShutdown)
+			return;
+
+		RunQueuedJob(lock);
+	}
+}
+
+// Run the next job with the lock released, returns false if there wasn't one
+bool FThreadPool::RunQueuedJob(std::unique_lock<std::mutex>& lock)
+{
+	if (Jobs.empty())
+		return false;
+
+	std::function<void()> job = std::move(Jobs.front());
+	Jobs.pop_front();
+
+	lock.unlock();
+	job();
+	lock.lock();
+	return true;
+}
+
+FThreadPool& GetSharedThreadPool()
+{
+	static FThreadPool threadPool;
+	return threadPool;
+}
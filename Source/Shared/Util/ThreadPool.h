@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Simple pool of worker threads for splitting up long running jobs
+class FThreadPool
+{
+public:
+	FThreadPool(int noThreads = 0);	// 0 = one per hardware thread
+	~FThreadPool();
+
+	int		GetNoThreads() const { return (int)Workers.size(); }
+
+	// Run func(jobNo) for each job across the pool & wait for them all to finish
+	// The calling thread helps out so this is safe to call with an empty pool
+	void	ParallelFor(int noJobs, const std::function<void(int)>& func);
+
+private:
+	void	WorkerThread();
+	bool	RunQueuedJob(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread>			Workers;
+	std::deque<std::function<void()>>	Jobs;
+	std::mutex							Mutex;
+	std::condition_variable				JobAdded;
+	std::condition_variable				JobDone;
+	bool								bShutdown = false;
+};
+
+// Pool shared by the analysis tools
+FThreadPool& GetSharedThreadPool();
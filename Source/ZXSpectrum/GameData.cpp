@@ -11,6 +11,7 @@
 #include "GameViewers/GameViewer.h"
 #include "Debug/DebugLog.h"
 #include "Util/Misc.h"
+#include "Util/MemoryBuffer.h"
 #include <Util/GraphicsView.h>
 #include "ZXSpectrumGameConfig.h"
 #if 0
@@ -293,7 +294,7 @@ void SaveDataInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAd
 			int noReads = 0;
 			const long noReadsFilePos = ftell(fp);
 			fwrite(&noReads, sizeof(int), 1, fp);
-			for (const auto& ref : pDataInfo->Reads.GetReferences())
+			for (const auto& ref : pDataInfo->GetReads().GetReferences())
 			{
 				const uint16_t refAddr = ref.Address;
 				if (refAddr >= startAddress && refAddr <= endAddress)
@@ -312,7 +313,7 @@ void SaveDataInfoBin(const FCodeAnalysisState& state, FILE* fp, uint16_t startAd
 			int noWrites = 0;
 			const long noWritesFilePos = ftell(fp);
 			fwrite(&noWrites, sizeof(int), 1, fp);
-			for (const auto& ref : pDataInfo->Writes.GetReferences())
+			for (const auto& ref : pDataInfo->GetWrites().GetReferences())
 			{
 				const uint16_t refAddr = ref.Address;
 				if (refAddr >= startAddress && refAddr <= endAddress)
@@ -390,7 +391,7 @@ void LoadDataInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_
 				uint16_t dataAddr;
 				fread(&dataAddr, sizeof(uint16_t), 1, fp);
 				if (dataAddr >= startAddress && dataAddr <= endAddress)
-					pDataInfo->Reads.RegisterAccess(state.AddressRefFromPhysicalAddress(dataAddr));
+					pDataInfo->EditReads().RegisterAccess(state.AddressRefFromPhysicalAddress(dataAddr));
 				else
 					LOGWARNING("LoadDataInfoBin: Address %x outside of range", dataAddr);
 			}
@@ -404,7 +405,7 @@ void LoadDataInfoBin(FCodeAnalysisState& state, FILE* fp, int versionNo, uint16_
 				uint16_t dataAddr;
 				fread(&dataAddr, sizeof(uint16_t), 1, fp);
 				if (dataAddr >= startAddress && dataAddr <= endAddress)
-					pDataInfo->Writes.RegisterAccess(state.AddressRefFromPhysicalAddress(dataAddr));
+					pDataInfo->EditWrites().RegisterAccess(state.AddressRefFromPhysicalAddress(dataAddr));
 				else
 					LOGWARNING("LoadDataInfoBin: Address %x outside of range", dataAddr);
 			}
@@ -760,7 +761,7 @@ const uint32_t kMachineStateVersion = 5;
 
 static zx_t g_SaveSlot;
 
-void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FILE* fp)
+void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer)
 {
 	FCodeAnalysisState& state = pSpectrumEmu->GetCodeAnalysis();
 	FZXSpectrumGameConfig& config = *(FZXSpectrumGameConfig*)pSpectrumEmu->pActiveGame->pConfig;
@@ -794,21 +795,21 @@ void SaveMachineState(FSpectrumEmu* pSpectrumEmu, FILE* fp)
 	}
 #endif
 	// write magic
-	fwrite(&kMachineStateMagic, sizeof(kMachineStateMagic), 1, fp);
-	fwrite(&kMachineStateVersion, sizeof(kMachineStateVersion), 1, fp);
+	buffer.Write(kMachineStateMagic);
+	buffer.Write(kMachineStateVersion);
     
     // save backup state in edit mode
     if(state.bAllowEditing)
     {
         const uint32_t snapshotVersion = ZX_SNAPSHOT_VERSION;
-        fwrite(&snapshotVersion, sizeof(snapshotVersion), 1, fp);
-        fwrite(&pSpectrumEmu->BackupState, sizeof(zx_t), 1, fp);
+        buffer.Write(snapshotVersion);
+        buffer.WriteBytes(&pSpectrumEmu->BackupState, sizeof(zx_t));
     }
     else
     {
         const uint32_t snapshotVersion = zx_save_snapshot(&pSpectrumEmu->ZXEmuState,&g_SaveSlot);
-        fwrite(&snapshotVersion, sizeof(snapshotVersion), 1, fp);
-        fwrite(&g_SaveSlot, sizeof(zx_t), 1, fp);
+        buffer.Write(snapshotVersion);
+        buffer.WriteBytes(&g_SaveSlot, sizeof(zx_t));
     }
 	return;
 }
@@ -849,15 +850,11 @@ bool LoadMachineState(FSpectrumEmu* pSpectrumEmu, FILE* fp)
 	return bSuccess;
 }
 
-bool SaveGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
+// machine state is written to a buffer so the file can be written out on another thread
+void SaveGameState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer)
 {
-	FILE* fp = fopen(fname, "wb");
-	if (fp == NULL)
-		return false;
-	SaveMachineState(pSpectrumEmu, fp);
-	fclose(fp);
-
-	return true;
+	buffer.Init(sizeof(zx_t) + 64);
+	SaveMachineState(pSpectrumEmu, buffer);
 }
 
 bool LoadGameState(FSpectrumEmu* pSpectrumEmu, const char* fname)
@@ -2,6 +2,7 @@
 
 class FCodeAnalysisState;
 class FSpectrumEmu;
+class FMemoryBuffer;
 
 //bool SaveGameData(FSpectrumEmu* pSpectrumEmu, const char* fname);
 bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname);
@@ -9,5 +10,5 @@ bool LoadGameData(FSpectrumEmu* pSpectrumEmu, const char* fname);
 bool SaveROMData(const FCodeAnalysisState& state, const char* fname);
 bool LoadROMData(FCodeAnalysisState& state, const char* fname);
 
-bool SaveGameState(FSpectrumEmu* pSpectrumEmu, const char* fname);
+void SaveGameState(FSpectrumEmu* pSpectrumEmu, FMemoryBuffer& buffer);
 bool LoadGameState(FSpectrumEmu* pSpectrumEmu, const char* fname);
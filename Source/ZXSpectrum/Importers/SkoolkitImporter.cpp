@@ -294,6 +294,8 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 	if (fp == nullptr)
 		return false;
 
+	FLabelBatchScope labelBatch(state);	// rebuild the global label lists once at the end
+
 	char blockDirective = kSkoolkitDirectiveNone;
 	char subBlockDirective = kSkoolkitDirectiveNone;
 
@@ -349,10 +351,11 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 			// instruction comment continuation
 			if (LastItem.IsValid())
 			{
-				if (LastItem.Item->Comment.back() != '\n')
-					LastItem.Item->Comment += "\n";
-				LastItem.Item->Comment += trimmed.substr(2);
-				RemoveCarriageReturn(LastItem.Item->Comment);
+				std::string& comment = LastItem.Item->Comment.Edit();
+				if (comment.back() != '\n')
+					comment += "\n";
+				comment += trimmed.substr(2);
+				RemoveCarriageReturn(comment);
 			}
 			continue;
 		}
@@ -545,7 +548,7 @@ bool ImportSkoolKitFile(FCodeAnalysisState& state, const char* pTextFileName, FS
 				pBlock = AddCommentBlock(state, state.AddressRefFromPhysicalAddress(instruction.Address));
 			else
 			{
-				std::string commentExcerpt = pBlock->Comment.substr(0, 1024);
+				std::string commentExcerpt = pBlock->Comment.Get().substr(0, 1024);
 				RemoveCarriageReturn(commentExcerpt);
 				LOGWARNING("SkoolkitImporter: Replacing existing comment block: '%s'", commentExcerpt.c_str());
 			}
@@ -14,10 +14,9 @@ int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEm
 	FCodeInfo* pCodeInfo = codeAnalysis.GetCodeInfoForPhysicalAddress(pc);
 	const FAddressRef PCaddrRef = codeAnalysis.AddressRefFromPhysicalAddress(pc);
 
-	// increment counters
-	//pEmu->MemStats.ExecCount[pc]++;
-	//const int op_len = DisasmLen(pEmu, pc);
-	for (int i = 0; i < pCodeInfo->ByteSize; i++) 
+	// increment counters - pc may not have been analysed yet so count a single byte
+	const int opLen = pCodeInfo != nullptr ? pCodeInfo->ByteSize : 1;
+	for (int i = 0; i < opLen; i++)
 		pEmu->MemStats.ExecCount[(pc + i) & 0xFFFF]++;
 
 	if (bRead)
@@ -25,44 +24,48 @@ int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEm
 	if (bWrite)
 		pEmu->MemStats.WriteCount[addr]++;
 
-	// See if we can find a handler
-	for (auto& handler : pEmu->MemoryAccessHandlers)
+	FMemoryHandlerIndex& handlerIndex = pEmu->MemoryHandlerIndex;
+	if (handlerIndex.bDirty)
+		handlerIndex.Build(pEmu->MemoryAccessHandlers);
+
+	// See if we can find a handler - execute handlers are indexed by pc, read/write handlers by address
+	static const std::vector<int> kNoHandlers;
+	const MemoryAccessType accessType = bRead ? MemoryAccessType::Read : MemoryAccessType::Write;
+	const bool bExecHandlers = handlerIndex.HasHandlers(MemoryAccessType::Execute, pc);
+	const bool bAccessHandlers = (bRead || bWrite) && handlerIndex.HasHandlers(accessType, addr);
+	if (bExecHandlers == false && bAccessHandlers == false)
+		return 0;
+
+	const std::vector<int>& execHandlers = bExecHandlers ? handlerIndex.GetPageHandlers(MemoryAccessType::Execute, pc) : kNoHandlers;
+	const std::vector<int>& accessHandlers = bAccessHandlers ? handlerIndex.GetPageHandlers(accessType, addr) : kNoHandlers;
+
+	// merge the two lists so handlers get called in the order they were added
+	size_t execNo = 0, accessNo = 0;
+	while (execNo < execHandlers.size() || accessNo < accessHandlers.size())
 	{
+		int handlerNo;
+		if (accessNo == accessHandlers.size() || (execNo < execHandlers.size() && execHandlers[execNo] < accessHandlers[accessNo]))
+			handlerNo = execHandlers[execNo++];
+		else
+			handlerNo = accessHandlers[accessNo++];
+
+		FMemoryAccessHandler& handler = pEmu->MemoryAccessHandlers[handlerNo];
 		if (handler.bEnabled == false)
 			continue;
 
-		bool bCallHandler = false;
-
-		if (handler.Type == MemoryAccessType::Execute)	// Execution
-		{
-			if (pc >= handler.MemStart && pc <= handler.MemEnd)
-				bCallHandler = true;
-		}
-		else // Memory access
-		{
-			if (addr >= handler.MemStart && addr <= handler.MemEnd)
-			{
-				bool bExecute = false;
+		const uint16_t handlerAddr = handler.Type == MemoryAccessType::Execute ? pc : addr;
+		if (handlerAddr < handler.MemStart || handlerAddr > handler.MemEnd)
+			continue;
 
-				if (handler.Type == MemoryAccessType::Read && bRead)
-					bCallHandler = true;
-				else if (handler.Type == MemoryAccessType::Write && bWrite)
-					bCallHandler = true;
-			}
-		}
+		// update handler stats
+		handler.TotalCount++;
+		handler.Callers.RegisterAccess(PCaddrRef);
+		//handler.AddressCounts.RegisterAccess(addr);
+		if (handler.pHandlerFunction != nullptr)
+			handler.pHandlerFunction(handler, pEmu->pActiveGame, pc, pins);
 
-		if (bCallHandler)
-		{
-			// update handler stats
-			handler.TotalCount++;
-			handler.Callers.RegisterAccess(PCaddrRef);
-			//handler.AddressCounts.RegisterAccess(addr);
-			if (handler.pHandlerFunction != nullptr)
-				handler.pHandlerFunction(handler, pEmu->pActiveGame, pc, pins);
-
-			if (handler.bBreak)
-				return 128;	// TODO: sort out trap ids
-		}
+		if (handler.bBreak)
+			return 128;	// TODO: sort out trap ids
 	}
 	
 	assert(!(bRead == true && bWrite == true));
@@ -73,6 +76,32 @@ int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEm
 
 
 
+void FMemoryHandlerIndex::Build(const std::vector<FMemoryAccessHandler>& handlers)
+{
+	for (int type = 0; type < kNoAccessTypes; type++)
+	{
+		PageBits[type] = 0;
+		for (int pageNo = 0; pageNo < kNoPages; pageNo++)
+			PageHandlers[type][pageNo].clear();
+	}
+
+	for (int handlerNo = 0; handlerNo < (int)handlers.size(); handlerNo++)
+	{
+		const FMemoryAccessHandler& handler = handlers[handlerNo];
+		if (handler.MemEnd < handler.MemStart)
+			continue;
+
+		const int type = (int)handler.Type;
+		for (int pageNo = handler.MemStart >> kPageShift; pageNo <= (handler.MemEnd >> kPageShift); pageNo++)
+		{
+			PageBits[type] |= 1ull << pageNo;
+			PageHandlers[type][pageNo].push_back(handlerNo);
+		}
+	}
+
+	bDirty = false;
+}
+
 EMemoryUse DetermineAddressMemoryUse(const FMemoryStats &memStats, uint16_t addr, bool &smc)
 {
 	const bool bCode = memStats.ExecCount[addr] > 0;
@@ -63,6 +63,24 @@ struct FMemoryAccessHandler
 
 
 
+// Which handlers cover each 1K page, so the common case of no handler is a single bit test
+// Needs rebuilding when handlers are added or removed - enabling/disabling doesn't
+struct FMemoryHandlerIndex
+{
+	static const int kPageShift = 10;
+	static const int kNoPages = 65536 >> kPageShift;
+	static const int kNoAccessTypes = 3;
+
+	void	Build(const std::vector<FMemoryAccessHandler>& handlers);
+	bool	HasHandlers(MemoryAccessType type, uint16_t address) const { return (PageBits[(int)type] >> (address >> kPageShift)) & 1; }
+	const std::vector<int>&	GetPageHandlers(MemoryAccessType type, uint16_t address) const { return PageHandlers[(int)type][address >> kPageShift]; }
+
+	bool	bDirty = true;
+private:
+	uint64_t			PageBits[kNoAccessTypes] = { 0 };	// bit per page
+	std::vector<int>	PageHandlers[kNoAccessTypes][kNoPages];	// indices of handlers overlapping each page, in handler order
+};
+
 int MemoryHandlerTrapFunction(uint16_t pc, int ticks, uint64_t pins, FSpectrumEmu* pEmu);
 
 void AnalyseMemory(FMemoryStats &memStats);
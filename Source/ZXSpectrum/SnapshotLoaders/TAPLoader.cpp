@@ -27,73 +27,56 @@ bool LoadTAPFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize
 	FMemoryBuffer tapBuffer;
 	tapBuffer.Init(pData, dataSize);
 
+	FTapeDeck& tapeDeck = pEmu->TapeDeck;
+	tapeDeck.Eject();
+
 	LOGINFO("TAP started:");
 
-	// TODO: This is a basic POC reader, we could store it a much nicer way
 	while (tapBuffer.Finished() == false)
 	{
+		// each block is flag byte, data & checksum
+		FTapeBlock block;
 		const uint16_t blockLength = tapBuffer.Read<uint16_t>();
-		const uint8_t flags = tapBuffer.Read<uint8_t>();
-		
-		LOGINFO("");	// line space
-		if (flags == 0)	// 0 Indicates Header
+		block.Data.resize(blockLength);
+		if (blockLength == 0 || tapBuffer.ReadBytes(block.Data.data(), blockLength) == false)
+		{
+			LOGWARNING("TAP: truncated block %d", tapeDeck.GetNoBlocks());
+			break;
+		}
+
+		const uint8_t flags = block.Data[0];
+		if (flags == 0 && blockLength >= 18)	// 0 Indicates Header
 		{
-			LOGINFO("TAP Header");
 			// Block Types
 			// 0 : Program
 			// 1 : Number Array
 			// 2 : Character Array
 			// 3 : Code
-			const uint8_t blockType = tapBuffer.Read<uint8_t>();
+			const uint8_t blockType = block.Data[1];
 			char fileName[11];
-			memset(fileName,0,11);
-			tapBuffer.ReadBytes(fileName, 10);
-			const uint16_t dataBlockLength = tapBuffer.Read<uint16_t>();
-			
-
-			if(blockType == 0)
-			{
-				// For Programs:
-				// Param 1 : Autostart line number (or >32768 if no line number was given)
-				// Param 2 : Start of variable area relative to start of program
-				LOGINFO("Program: %s", fileName);
-				const uint16_t autoLineNumber = tapBuffer.Read<uint16_t>();
-				const uint16_t startOfVariableArea = tapBuffer.Read<uint16_t>();
-				LOGINFO("Autostart line number: %d", autoLineNumber);
-				LOGINFO("Start of variable area: %d", startOfVariableArea);
-			}
-			else if(blockType == 3)
-			{
-				// For Code:
-				// Param 1 : Start address of code block
-				// Param 2 : 32768
-				LOGINFO("Code: %s", fileName);
-				const uint16_t startAddress = tapBuffer.Read<uint16_t>();
-				const uint16_t param2 = tapBuffer.Read<uint16_t>();
-				LOGINFO("Start address: 0x%04X", startAddress);
-				LOGINFO("Param2: %d",param2);
-			}
-
-			const uint8_t checksum = tapBuffer.Read<uint8_t>();
-			LOGINFO("checksum = %d",checksum);
-		}
-		else if (flags == 0xff)	// 0xff indicates data
-		{
-			uint16_t dataLength = blockLength - 2;
-			uint8_t* pData = new uint8_t[dataLength];
-			tapBuffer.ReadBytes(pData, dataLength);
-			const uint8_t checksum = tapBuffer.Read<uint8_t>();
-			delete[] pData;
+			memset(fileName, 0, 11);
+			memcpy(fileName, &block.Data[2], 10);
+			const uint16_t param1 = block.Data[14] | (block.Data[15] << 8);
 
-			LOGINFO("TAP Data");
-			LOGINFO("Loaded %d bytes",dataLength);
+			if (blockType == 0)
+				LOGINFO("Program: %s, autostart line: %d", fileName, param1);	// >32768 if no line number was given
+			else if (blockType == 3)
+				LOGINFO("Code: %s, start address: 0x%04X", fileName, param1);
+			else
+				LOGINFO("Header type %d: %s", blockType, fileName);
 		}
 		else
 		{
-			// TODO: error
+			LOGINFO("TAP Data: %d bytes", blockLength - 2);
 		}
+
+		tapeDeck.AddBlock(block);
 	}
 
 	LOGINFO("TAP: Done");
-	return false;
-}
\ No newline at end of file
+	if (tapeDeck.GetNoBlocks() == 0)
+		return false;
+
+	tapeDeck.Play();
+	return true;
+}
@@ -16,12 +16,33 @@ enum class ETZXBlockId
 {
 	StandardSpeed	= 0x10,
 	TurboSpeed		= 0x11,
-
+	PureTone		= 0x12,
+	PulseSequence	= 0x13,
+	PureData		= 0x14,
+	DirectRecording	= 0x15,
+	Pause			= 0x20,
+	GroupStart		= 0x21,
+	GroupEnd		= 0x22,
+	JumpToBlock		= 0x23,
+	LoopStart		= 0x24,
+	LoopEnd			= 0x25,
+	CallSequence	= 0x26,
+	ReturnFromSequence	= 0x27,
+	SelectBlock		= 0x28,
+	StopTape48K		= 0x2A,
+	TextDescription	= 0x30,
+	Message			= 0x31,
 	ArchiveInfo		= 0x32,
+	HardwareType	= 0x33,
+	EmulationInfo	= 0x34,	// deprecated
+	CustomInfo		= 0x35,
+	Snapshot		= 0x40,	// deprecated
+	Glue			= 0x5A,
 };
 
 struct FTZXBlockBase
 {
+	virtual ~FTZXBlockBase() {}
 	ETZXBlockId	Type;
 };
 
@@ -69,21 +90,42 @@ bool LoadTZXFile(FSpectrumEmu* pEmu, const char* fName)
 	return bSuccess;
 }
 
+static uint32_t Read24(FMemoryBuffer& buffer)
+{
+	uint8_t bytes[3] = { 0 };
+	buffer.ReadBytes(bytes, 3);
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+}
+
+static bool ReadTapeBlockData(FMemoryBuffer& buffer, uint32_t length, FTapeBlock& block)
+{
+	block.Data.resize(length);
+	return length != 0 && buffer.ReadBytes(block.Data.data(), length);
+}
+
 bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize)
 {
 	FMemoryBuffer tzxBuffer;
 	tzxBuffer.Init(pData, dataSize);
 
 	FTZXFile	tzxFile;
+	FTapeDeck& tapeDeck = pEmu->TapeDeck;
+	tapeDeck.Eject();
 
 	char tzxSignature[7];
 
 	tzxBuffer.ReadBytes(tzxSignature, 7);
+	if (memcmp(tzxSignature, "ZXTape!", 7) != 0)
+	{
+		LOGERROR("TZX Loader: not a TZX file");
+		return false;
+	}
 	const uint8_t endTextMarker = tzxBuffer.Read<uint8_t>();
 	const uint8_t majorVersion = tzxBuffer.Read<uint8_t>();
 	const uint8_t minorVersion = tzxBuffer.Read<uint8_t>();
 
-	while (tzxBuffer.Finished() == false)
+	bool bOk = true;
+	while (bOk && tzxBuffer.Finished() == false)
 	{
 		const ETZXBlockId blockId = (ETZXBlockId)tzxBuffer.Read<uint8_t>();
 
@@ -91,13 +133,67 @@ bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize
 		{
 		case ETZXBlockId::StandardSpeed:
 			{
-				LOGINFO("TZX Loader: Standard Speed Block");
+				FTapeBlock block;
+				tzxBuffer.SkipBytes(2);	// pause after block
+				const uint16_t length = tzxBuffer.Read<uint16_t>();
+				bOk = ReadTapeBlockData(tzxBuffer, length, block);
+				if (bOk)
+					tapeDeck.AddBlock(block);
+				LOGINFO("TZX Loader: Standard Speed Block, %d bytes", length);
 			}
 			break;
 		case ETZXBlockId::TurboSpeed:
-			LOGINFO("TZX Loader: Turbo Speed Block");
+		case ETZXBlockId::PureData:
+			{
+				// we don't emulate the pulses so only the data is used
+				FTapeBlock block;
+				block.bStandardSpeed = false;
+				tzxBuffer.SkipBytes(blockId == ETZXBlockId::TurboSpeed ? 0x0F : 0x07);	// timings, used bits & pause
+				const uint32_t length = Read24(tzxBuffer);
+				bOk = ReadTapeBlockData(tzxBuffer, length, block);
+				if (bOk)
+					tapeDeck.AddBlock(block);
+				LOGINFO("TZX Loader: %s Block, %d bytes", blockId == ETZXBlockId::TurboSpeed ? "Turbo Speed" : "Pure Data", length);
+			}
+			break;
+		case ETZXBlockId::PureTone:
+			bOk = tzxBuffer.SkipBytes(4);
+			break;
+		case ETZXBlockId::PulseSequence:
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint8_t>() * 2);
+			break;
+		case ETZXBlockId::DirectRecording:
+			tzxBuffer.SkipBytes(5);
+			bOk = tzxBuffer.SkipBytes(Read24(tzxBuffer));
+			LOGWARNING("TZX Loader: Direct recording blocks are not supported");
+			break;
+		case ETZXBlockId::Pause:
+		case ETZXBlockId::JumpToBlock:
+		case ETZXBlockId::LoopStart:
+			bOk = tzxBuffer.SkipBytes(2);
+			break;
+		case ETZXBlockId::CallSequence:
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint16_t>() * 2);
+			break;
+		case ETZXBlockId::ReturnFromSequence:
+			break;
+		case ETZXBlockId::SelectBlock:
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint16_t>());
+			break;
+		case ETZXBlockId::GroupStart:
+		case ETZXBlockId::TextDescription:
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint8_t>());
+			break;
+		case ETZXBlockId::GroupEnd:
+		case ETZXBlockId::LoopEnd:
+			break;
+		case ETZXBlockId::StopTape48K:
+			bOk = tzxBuffer.SkipBytes(4);
+			break;
+		case ETZXBlockId::Message:
+			tzxBuffer.SkipBytes(1);
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint8_t>());
 			break;
-
 		case ETZXBlockId::ArchiveInfo:
 			{
 				LOGINFO("TZX Loader: Archive Info");
@@ -106,11 +202,39 @@ bool LoadTZXFromMemory(FSpectrumEmu* pEmu, const uint8_t* pData, size_t dataSize
 				tzxFile.Blocks.push_back(pArchiveBlock);
 			}
 			break;
+		case ETZXBlockId::HardwareType:
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint8_t>() * 3);
+			break;
+		case ETZXBlockId::EmulationInfo:
+			bOk = tzxBuffer.SkipBytes(8);
+			break;
+		case ETZXBlockId::Snapshot:
+			tzxBuffer.SkipBytes(1);
+			bOk = tzxBuffer.SkipBytes(Read24(tzxBuffer));
+			break;
+		case ETZXBlockId::CustomInfo:
+			tzxBuffer.SkipBytes(16);
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint32_t>());
+			break;
+		case ETZXBlockId::Glue:
+			bOk = tzxBuffer.SkipBytes(9);
+			break;
 		default:
+			// unknown blocks - the spec says any new blocks will start with a DWORD length
 			LOGWARNING("TZX Loader: Unrecognised block Id: 0x%0X", (uint8_t)blockId);
+			bOk = tzxBuffer.SkipBytes(tzxBuffer.Read<uint32_t>());
 		}
-
 	}
 
-	return false;
+	for (FTZXBlockBase* pBlock : tzxFile.Blocks)
+		delete pBlock;
+
+	if (bOk == false)
+		LOGWARNING("TZX Loader: file is truncated");
+
+	if (tapeDeck.GetNoBlocks() == 0)
+		return false;
+
+	tapeDeck.Play();
+	return true;
 }
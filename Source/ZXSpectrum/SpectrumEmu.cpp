@@ -23,6 +23,7 @@
 
 #include "zx-roms.h"
 #include <algorithm>
+#include <chrono>
 #include <sokol_audio.h>
 #include "SkoolkitSupport.h"
 #include "Debug/DebugLog.h"
@@ -36,6 +37,8 @@
 #include "App.h"
 #include <CodeAnalyser/CodeAnalysisState.h>
 #include "CodeAnalyser/CodeAnalysisJson.h"
+#include "CodeAnalyser/CodeAnalysisBinary.h"
+#include "Util/MemoryBuffer.h"
 #include "ZXSpectrumGameConfig.h"
 
 #include "LuaScripting/LuaSys.h"
@@ -110,6 +113,28 @@ const uint8_t* FSpectrumEmu::GetMemPtr(uint16_t address) const
 void FSpectrumEmu::WriteByte(uint16_t address, uint8_t value)
 {
 	mem_wr(&ZXEmuState.mem, address, value);
+
+	const int ramBank = GetRAMBankForAddress(address);
+	if (ramBank != -1)
+		FrameTraceViewer.MarkRAMWritten(ramBank, address & 0x3fff);
+}
+
+// Get which of the ram[] banks an address maps to
+int FSpectrumEmu::GetRAMBankForAddress(uint16_t address) const
+{
+	const int slot = address >> 14;
+	if (slot == 0)
+		return -1;	// ROM
+
+	if (ZXEmuState.type == ZX_TYPE_48K)
+		return slot - 1;
+
+	if (slot == 1)
+		return 5;
+	else if (slot == 2)
+		return 2;
+	else
+		return ZXEmuState.last_mem_config & 7;
 }
 
 
@@ -278,6 +303,10 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 			const FAddressRef addrRef = state.AddressRefFromPhysicalAddress(addr);
 			const FAddressRef pcAddrRef = state.AddressRefFromPhysicalAddress(pc);
 			state.SetLastWriterForAddress(addr, pcAddrRef);
+
+			const int ramBank = GetRAMBankForAddress(addr);
+			if (ramBank != -1)
+				FrameTraceViewer.MarkRAMWritten(ramBank, addr & 0x3fff);
 			
 			if (addr >= kScreenPixMemStart && addr <= kScreenPixMemEnd)
 			{
@@ -393,6 +422,12 @@ uint64_t FSpectrumEmu::Z80Tick(int num, uint64_t pins)
 	return pins;
 }
 
+static uint64_t TapeTrapCB(uint64_t pins, void* pUserData)
+{
+	FSpectrumEmu* pEmu = (FSpectrumEmu*)pUserData;
+	return pEmu->TapeDeck.TrapTick(pins);
+}
+
 static uint64_t Z80TickThunk(int num, uint64_t pins, void* user_data)
 {
 	FSpectrumEmu* pEmu = (FSpectrumEmu*)user_data;
@@ -569,6 +604,7 @@ bool FSpectrumEmu::InitForModel(ESpectrumModel model)
     desc.debug.stopped = CodeAnalysis.Debugger.GetDebuggerStoppedPtr();
 
     zx_init(&ZXEmuState, &desc);
+	ZXSetTrapCallback(TapeTrapCB, this);
     
     // Clear UI
    /* memset(&UIZX, 0, sizeof(ui_zx_t));
@@ -695,6 +731,7 @@ bool FSpectrumEmu::Init(const FEmulatorLaunchConfig& config)
 
 	SpectrumViewer.Init(this);
 	FrameTraceViewer.Init(this);
+	TapeDeck.Init(this);
 
 	CodeAnalysis.ViewState[0].Enabled = true;	// always have first view enabled
 
@@ -805,6 +842,7 @@ void FSpectrumEmu::Shutdown()
 	
 	if (RZXManager.GetReplayMode() == EReplayMode::Off)
 		SaveProject();	// save on close
+	ProjectWriter.WaitUntilIdle();
 
 	// Save Global Config - move to function?
 	if (pActiveGame != nullptr)
@@ -825,8 +863,10 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 	assert(pGameConfig != nullptr);
 	FZXSpectrumGameConfig *pSpectrumGameConfig = (FZXSpectrumGameConfig*)pGameConfig;
 	
+	ProjectWriter.WaitUntilIdle();	// make sure any save in progress has finished before reading files back
+
 	// reset systems
-	MemoryAccessHandlers.clear();	// remove old memory handlers
+	ClearMemoryHandlers();	// remove old memory handlers
 	ResetMemoryStats(MemStats);
 	FrameTraceViewer.Reset();
 	pGraphicsViewer->Reset();
@@ -869,6 +909,7 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 		const std::string root = pGlobalConfig->WorkspaceRoot;
 
 		std::string analysisJsonFName = root + "AnalysisJson/" + pGameConfig->Name + ".json";
+		std::string analysisBinFName = root + "AnalysisBin/" + pGameConfig->Name + ".abin";
 		std::string graphicsSetsJsonFName = root + "GraphicsSets/" + pGameConfig->Name + ".json";
 		std::string analysisStateFName = root + "AnalysisState/" + pGameConfig->Name + ".astate";
 		std::string saveStateFName = root + "SaveStates/" + pGameConfig->Name + ".state";
@@ -878,6 +919,7 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 		if (FileExists((gameRoot + "Config.json").c_str()))	
 		{
 			analysisJsonFName = gameRoot + "Analysis.json";
+			analysisBinFName = gameRoot + "Analysis.abin";
 			graphicsSetsJsonFName = gameRoot + "GraphicsSets.json";
 			analysisStateFName = gameRoot + "AnalysisState.bin";
 			saveStateFName = gameRoot + "SaveState.bin";
@@ -894,11 +936,8 @@ bool FSpectrumEmu::LoadProject(FProjectConfig* pGameConfig, bool bLoadGameData /
 			bLoadSnapshot = false;
 		}
 
-		if (FileExists(analysisJsonFName.c_str()))
-		{
-			ImportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+		if (ImportAnalysisBinaryOrJson(CodeAnalysis, analysisBinFName.c_str(), analysisJsonFName.c_str()))
 			ImportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
-		}
 
 		pGraphicsViewer->LoadGraphicsSets(graphicsSetsJsonFName.c_str());
 
@@ -993,6 +1032,7 @@ bool FSpectrumEmu::SaveProject()
 		const std::string root = pGlobalConfig->WorkspaceRoot + pGameConfig->Name + "/";
 		const std::string configFName = root + "Config.json";
 		const std::string analysisJsonFName = root + "Analysis.json";
+		const std::string analysisBinFName = root + "Analysis.abin";
 		const std::string graphicsSetsJsonFName = root + "GraphicsSets.json";
 		const std::string analysisStateFName = root + "AnalysisState.bin";
 		const std::string saveStateFName = root + "SaveState.bin";
@@ -1002,12 +1042,14 @@ bool FSpectrumEmu::SaveProject()
 		const std::string configFName = root + "Configs/" + pGameConfig->Name + ".json";
 		//const std::string dataFName = root + "GameData/" + pGameConfig->Name + ".bin";
 		const std::string analysisJsonFName = root + "AnalysisJson/" + pGameConfig->Name + ".json";
+		const std::string analysisBinFName = root + "AnalysisBin/" + pGameConfig->Name + ".abin";
 		const std::string graphicsSetsJsonFName = root + "GraphicsSets/" + pGameConfig->Name + ".json";
 		const std::string analysisStateFName = root + "AnalysisState/" + pGameConfig->Name + ".astate";
 		const std::string saveStateFName = root + "SaveStates/" + pGameConfig->Name + ".state";
 		EnsureDirectoryExists(std::string(root + "Configs").c_str());
 		EnsureDirectoryExists(std::string(root + "GameData").c_str());
 		EnsureDirectoryExists(std::string(root + "AnalysisJson").c_str());
+		EnsureDirectoryExists(std::string(root + "AnalysisBin").c_str());
 		EnsureDirectoryExists(std::string(root + "GraphicsSets").c_str());
 		EnsureDirectoryExists(std::string(root + "AnalysisState").c_str());
 		EnsureDirectoryExists(std::string(root + "SaveStates").c_str());
@@ -1027,8 +1069,17 @@ bool FSpectrumEmu::SaveProject()
 		//SaveGameData(this, dataFName.c_str());		// The Past
 
 		// The Future
-		SaveGameState(this, saveStateFName.c_str());
-		ExportAnalysisJson(CodeAnalysis, analysisJsonFName.c_str());
+		// snapshot the machine state & analysis here, the files get written on the project writer thread
+		const auto snapshotStartTime = std::chrono::high_resolution_clock::now();
+		FFileWriteBatch saveBatch;
+		saveBatch.Name = pGameConfig->Name;
+		std::shared_ptr<FMemoryBuffer> pSaveState = std::make_shared<FMemoryBuffer>();
+		SaveGameState(this, *pSaveState);
+		saveBatch.AddFile(saveStateFName, pSaveState);
+		AddAnalysisToSaveBatch(saveBatch, analysisBinFName, analysisJsonFName);
+		saveBatch.SnapshotTimeMS = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - snapshotStartTime).count();
+		ProjectWriter.QueueBatch(std::move(saveBatch));
+
 		ExportAnalysisState(CodeAnalysis, analysisStateFName.c_str());
 		pGraphicsViewer->SaveGraphicsSets(graphicsSetsJsonFName.c_str());
 	}
@@ -1051,6 +1102,9 @@ bool FSpectrumEmu::LoadEmulatorFile(const FEmulatorFile* pSnapshot)
 	const std::string fileName = findIt->second.GetRootDir() + pSnapshot->FileName;
 	const char* pFileName = fileName.c_str();
 
+	FrameTraceViewer.ForceKeyFrame();
+	TapeDeck.Eject();
+
 	switch (pSnapshot->Type)
 	{
 	case EEmuFileType::Z80:
@@ -1189,6 +1243,8 @@ void FSpectrumEmu::SystemMenuAdditions(void)
 
 void FSpectrumEmu::OptionsMenuAdditions(void)
 {
+	ImGui::MenuItem("Flash Load Tapes", 0, &TapeDeck.bFlashLoad);
+	ImGui::MenuItem("Fast Load Tapes", 0, &TapeDeck.bFastLoad);
 }
 
 void FSpectrumEmu::WindowsMenuAdditions(void)
@@ -1726,6 +1782,77 @@ bool GetIOInputFunc(uint16_t port, uint8_t* pInVal, void* pUserData)
 }
 
 
+// Run the emulator & code analysis for a frame - no UI
+void FSpectrumEmu::ExecuteFrame(uint32_t microSeconds)
+{
+	CodeAnalysis.OnFrameStart();
+	StoreRegisters_Z80(CodeAnalysis);
+#if ENABLE_CAPTURES
+	const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+	uint32_t ticks_executed = 0;
+	while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
+	{
+		ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
+
+		if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
+		{
+			const uint16_t PC = GetPC();
+			FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
+			if (pMachineState == nullptr)
+			{
+				pMachineState = AllocateMachineState(CodeAnalysis);
+				CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
+			}
+
+			CaptureMachineState(pMachineState, this);
+			UIZX.dbg.dbg.z80->trap_id = 0;
+			_ui_dbg_continue(&UIZX.dbg);
+		}
+	}
+	clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
+	kbd_update(&ZXEmuState.kbd);
+#else
+	if (RZXManager.GetReplayMode() == EReplayMode::Playback)
+	{
+		if (RZXFetchesRemaining <= 0)
+			RZXFetchesRemaining += RZXManager.Update();
+		const uint32_t fetchesProcessed = ZXExeEmu_UseFetchCount(&ZXEmuState, RZXFetchesRemaining, GetIOInputFunc, this);
+		RZXFetchesRemaining -= fetchesProcessed;
+	}
+	else
+	{
+		TapeDeck.FrameTick();
+		ZXExeEmu(&ZXEmuState, microSeconds);
+	}
+#endif
+	/*if (RZXManager.GetReplayMode() == EReplayMode::Playback)
+	{
+		assert(ZXEmuState.valid);
+		uint32_t icount = RZXManager.Update();
+
+		uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+		uint32_t ticks_executed = z80_exec(&ZXEmuState.cpu, ticks_to_run);
+		clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
+		kbd_update(&ZXEmuState.kbd);
+	}
+	else
+	{
+		uint32_t frameTicks = ZXEmuState.frame_scan_lines* ZXEmuState.scanline_period;
+		//zx_exec(&ZXEmuState, microSeconds);
+
+		//uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
+		//frameTicks = ticks_to_run;
+		ZXEmuState.clk.ticks_to_run = frameTicks;
+		const uint32_t ticksExecuted = z80_exec(&ZXEmuState.cpu, frameTicks);
+		clk_ticks_executed(&ZXEmuState.clk, ticksExecuted);
+		kbd_update(&ZXEmuState.kbd);
+	}*/
+	FrameTraceViewer.CaptureFrame(bSkipFrameDisplay == false);
+	//FrameScreenPixWrites.clear();
+	//FrameScreenAttrWrites.clear();
+	CodeAnalysis.OnFrameEnd();
+}
+
 void FSpectrumEmu::Tick()
 {
 	FEmuBase::Tick();
@@ -1740,71 +1867,7 @@ void FSpectrumEmu::Tick()
 		//const float frameTime = min(1000000.0f / 50, 32000.0f) * ExecSpeedScale;
 		const uint32_t microSeconds = std::max(static_cast<uint32_t>(frameTime), uint32_t(1));
 
-		CodeAnalysis.OnFrameStart();
-		StoreRegisters_Z80(CodeAnalysis);
-#if ENABLE_CAPTURES
-		const uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-		uint32_t ticks_executed = 0;
-		while (UIZX.dbg.dbg.z80->trap_id != kCaptureTrapId && ticks_executed < ticks_to_run)
-		{
-			ticks_executed += z80_exec(&ZXEmuState.cpu, ticks_to_run - ticks_executed);
-
-			if (UIZX.dbg.dbg.z80->trap_id == kCaptureTrapId)
-			{
-				const uint16_t PC = GetPC();
-				FMachineState* pMachineState = CodeAnalysis.GetMachineState(PC);
-				if (pMachineState == nullptr)
-				{
-					pMachineState = AllocateMachineState(CodeAnalysis);
-					CodeAnalysis.SetMachineStateForAddress(PC, pMachineState);
-				}
-
-				CaptureMachineState(pMachineState, this);
-				UIZX.dbg.dbg.z80->trap_id = 0;
-				_ui_dbg_continue(&UIZX.dbg);
-			}
-		}
-		clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
-		kbd_update(&ZXEmuState.kbd);
-#else
-		if (RZXManager.GetReplayMode() == EReplayMode::Playback)
-		{
-			if (RZXFetchesRemaining <= 0)
-				RZXFetchesRemaining += RZXManager.Update();
-			const uint32_t fetchesProcessed = ZXExeEmu_UseFetchCount(&ZXEmuState, RZXFetchesRemaining, GetIOInputFunc, this);
-			RZXFetchesRemaining -= fetchesProcessed;
-		}
-		else
-		{
-			ZXExeEmu(&ZXEmuState, microSeconds);
-		}
-#endif
-		/*if (RZXManager.GetReplayMode() == EReplayMode::Playback)
-		{
-			assert(ZXEmuState.valid);
-			uint32_t icount = RZXManager.Update();
-
-			uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-			uint32_t ticks_executed = z80_exec(&ZXEmuState.cpu, ticks_to_run);
-			clk_ticks_executed(&ZXEmuState.clk, ticks_executed);
-			kbd_update(&ZXEmuState.kbd);
-		}
-		else
-		{
-			uint32_t frameTicks = ZXEmuState.frame_scan_lines* ZXEmuState.scanline_period;
-			//zx_exec(&ZXEmuState, microSeconds);
-
-			//uint32_t ticks_to_run = clk_ticks_to_run(&ZXEmuState.clk, microSeconds);
-			//frameTicks = ticks_to_run;
-			ZXEmuState.clk.ticks_to_run = frameTicks;
-			const uint32_t ticksExecuted = z80_exec(&ZXEmuState.cpu, frameTicks);
-			clk_ticks_executed(&ZXEmuState.clk, ticksExecuted);
-			kbd_update(&ZXEmuState.kbd);
-		}*/
-		FrameTraceViewer.CaptureFrame();
-		//FrameScreenPixWrites.clear();
-		//FrameScreenAttrWrites.clear();
-		CodeAnalysis.OnFrameEnd();
+		ExecuteUIFrame(microSeconds);
 	}
 
 	//UpdateCharacterSets(CodeAnalysis);
@@ -1835,6 +1898,25 @@ void    FSpectrumEmu::OnEnterEditMode(void)
 void    FSpectrumEmu::OnExitEditMode(void)
 {
     zx_load_snapshot(&ZXEmuState, ZX_SNAPSHOT_VERSION, &BackupState);
+	FrameTraceViewer.ForceKeyFrame();
+}
+
+void	FSpectrumEmu::SaveRewindState(void* pState)
+{
+	zx_save_snapshot(&ZXEmuState, (zx_t*)pState);
+}
+
+void	FSpectrumEmu::LoadRewindState(const void* pState)
+{
+	zx_load_snapshot(&ZXEmuState, ZX_SNAPSHOT_VERSION, (zx_t*)pState);
+
+	if (ZXEmuState.type == ZX_TYPE_128)
+	{
+		const uint8_t memConfig = ZXEmuState.last_mem_config;
+		SetROMBank(memConfig & (1 << 4) ? 1 : 0);
+		SetRAMBank(3, memConfig & 0x7);
+	}
+	FrameTraceViewer.ForceKeyFrame();
 }
 
 
@@ -2193,6 +2275,7 @@ bool FSpectrumEmu::LoadMachineSnapshot(int snapshotNo)
 		if(snapshot.bValid == false)
 			return false;
 		zx_load_snapshot(&ZXEmuState, ZX_SNAPSHOT_VERSION, &snapshot.State);
+		FrameTraceViewer.ForceKeyFrame();
 		return true;
 	}
 
@@ -32,6 +32,7 @@
 #include <string>
 #include "Viewers/SpriteViewer.h"
 #include "MemoryHandlers.h"
+#include "TapeDeck.h"
 //#include "Disassembler.h"
 //#include "FunctionHandlers.h"
 #include "CodeAnalyser/CodeAnalyser.h"
@@ -99,9 +100,14 @@ public:
     bool    InitForModel(ESpectrumModel model);
 	void	Shutdown() override;
 	void	Tick() override;
+	void	ExecuteFrame(uint32_t microSeconds) override;
+	uint32_t	GetMachineFrameMicroSeconds() const override { return GetCurrentSpectrumModel() == ESpectrumModel::Spectrum128K ? 19992 : 19968; }	// 70908 T @ 3.5469MHz, 69888 T @ 3.5MHz
 	void	Reset() override;
     void    OnEnterEditMode(void) override;
     void    OnExitEditMode(void) override;
+	size_t	GetRewindStateSize() const override { return sizeof(zx_t); }
+	void	SaveRewindState(void* pState) override;
+	void	LoadRewindState(const void* pState) override;
 
 	bool	LoadLua() override;
     
@@ -153,10 +159,17 @@ public:
     ESpectrumModel  GetCurrentSpectrumModel() const { return ZXEmuState.type == ZX_TYPE_128 ? ESpectrumModel::Spectrum128K : ESpectrumModel::Spectrum48K;}
 	void SetROMBank(int bankNo);
 	void SetRAMBank(int slot, int bankNo);
+	int	 GetRAMBankForAddress(uint16_t address) const;	// -1 for ROM
 
 	void AddMemoryHandler(const FMemoryAccessHandler& handler)
 	{
 		MemoryAccessHandlers.push_back(handler);
+		MemoryHandlerIndex.bDirty = true;
+	}
+	void ClearMemoryHandlers()
+	{
+		MemoryAccessHandlers.clear();
+		MemoryHandlerIndex.bDirty = true;
 	}
 
 	const FZXSpectrumConfig* GetZXSpectrumGlobalConfig() { return (const FZXSpectrumConfig*)pGlobalConfig; }
@@ -218,6 +231,7 @@ public:
 	// Memory handling
 	std::string							SelectedMemoryHandler;
 	std::vector< FMemoryAccessHandler>	MemoryAccessHandlers;
+	FMemoryHandlerIndex					MemoryHandlerIndex;
 
 	FMemoryStats	MemStats;
 
@@ -231,6 +245,8 @@ public:
 	FRZXManager		RZXManager;
 	int				RZXFetchesRemaining = 0;
 
+	FTapeDeck		TapeDeck;
+
 private:
 	//std::vector<FViewerBase*>	Viewers;
 
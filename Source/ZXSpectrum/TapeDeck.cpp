@@ -0,0 +1,190 @@
+#include "TapeDeck.h"
+
+#include "SpectrumEmu.h"
+#include "ZXChipsImpl.h"
+#include "CodeAnalyser/CodeAnalyser.h"
+#include <Debug/DebugLog.h>
+
+#include <algorithm>
+
+// ROM LD-BYTES entry point - A: flag byte, F carry: load/verify, IX: destination, DE: length
+static const uint16_t kLDBytesAddress = 0x0556;
+
+static const int kBootFrames = 150;		// frames to wait for the ROM to get to BASIC/menu
+static const int kKeyPressFrames = 3;	// frames to hold each key & gap between keys
+
+void FTapeDeck::Eject()
+{
+	Stop();
+	Blocks.clear();
+	CurrentBlock = 0;
+}
+
+void FTapeDeck::Play()
+{
+	if (Blocks.empty())
+		return;
+
+	// the tape signal isn't emulated so blocks can only be loaded by the trap
+	if (bFlashLoad == false)
+	{
+		LOGWARNING("Tape: turn on 'Flash Load Tapes' to play a tape");
+		return;
+	}
+
+	zx_t& zx = pSpectrumEmu->ZXEmuState;
+	zx_reset(&zx);
+	if (zx.type == ZX_TYPE_128)	// the reset pages in ROM 0 & RAM 0, the analyser's mapping needs to follow
+	{
+		pSpectrumEmu->SetROMBank(0);
+		pSpectrumEmu->SetRAMBank(3, 0);
+	}
+	pSpectrumEmu->FrameTraceViewer.ForceKeyFrame();
+
+	// 48K: LOAD "" (J is LOAD in K mode) - 128K: Tape Loader is the default menu option
+	KeysToType.clear();
+	if (zx.type == ZX_TYPE_48K)
+		KeysToType = { 'j', '"', '"', 0x0D };
+	else
+		KeysToType = { 0x0D };
+	TypingFrameCounter = -kBootFrames;
+
+	CurrentBlock = 0;
+	bPlaying = true;
+
+	bForcedFastMode = bFastLoad;
+	if (bForcedFastMode)
+	{
+		bOldTurboMode = pSpectrumEmu->bTurboMode;
+		bOldRecordDataAccesses = pSpectrumEmu->GetCodeAnalysis().bRecordDataAccesses;
+		pSpectrumEmu->bTurboMode = true;
+		pSpectrumEmu->GetCodeAnalysis().bRecordDataAccesses = true;
+	}
+
+	LOGINFO("Tape: playing %d blocks", (int)Blocks.size());
+}
+
+void FTapeDeck::Stop()
+{
+	if (bPlaying == false)
+		return;
+
+	bPlaying = false;
+	KeysToType.clear();
+
+	if (bForcedFastMode)	// the setting may have changed while playing
+	{
+		bForcedFastMode = false;
+		pSpectrumEmu->bTurboMode = bOldTurboMode;
+		pSpectrumEmu->GetCodeAnalysis().bRecordDataAccesses = bOldRecordDataAccesses;
+	}
+}
+
+void FTapeDeck::FrameTick()
+{
+	if (bPlaying && bFlashLoad == false)	// turned off while playing, nothing would load the rest
+		Stop();
+
+	if (bPlaying == false || KeysToType.empty())
+		return;
+
+	zx_t& zx = pSpectrumEmu->ZXEmuState;
+	const int frame = TypingFrameCounter++;
+	if (frame < 0)
+		return;	// still booting
+
+	if (frame == 0)
+	{
+		zx_key_down(&zx, KeysToType.front());
+	}
+	else if (frame == kKeyPressFrames)
+	{
+		zx_key_up(&zx, KeysToType.front());
+	}
+	else if (frame == kKeyPressFrames * 2)
+	{
+		KeysToType.erase(KeysToType.begin());
+		TypingFrameCounter = 0;
+	}
+}
+
+// LD-BYTES is in the 48K ROM, which is ROM 1 on the 128K
+bool FTapeDeck::IsLoaderROMPaged() const
+{
+	const int romNo = pSpectrumEmu->ZXEmuState.type == ZX_TYPE_128 ? 1 : 0;
+	return pSpectrumEmu->CurROMBank == pSpectrumEmu->ROMBanks[romNo];
+}
+
+uint64_t FTapeDeck::TrapTick(uint64_t pins)
+{
+	if (bPlaying == false || bFlashLoad == false || Z80_GET_ADDR(pins) != kLDBytesAddress || IsLoaderROMPaged() == false)
+		return pins;
+
+	z80_t& cpu = pSpectrumEmu->ZXEmuState.cpu;
+	const bool bSuccess = FlashLoadBlock();
+
+	// leave the routine the way LD-BYTES does
+	if (bSuccess)
+		cpu.f |= Z80_CF;
+	else
+		cpu.f &= ~Z80_CF;
+	cpu.iff1 = cpu.iff2 = true;
+
+	// return to caller
+	const uint16_t returnAddress = pSpectrumEmu->ReadWord(cpu.sp);
+	cpu.sp += 2;
+
+	if (CurrentBlock >= (int)Blocks.size())
+	{
+		LOGINFO("Tape: finished");
+		Stop();
+	}
+
+	return z80_prefetch(&cpu, returnAddress);
+}
+
+// Copy the next block into memory, returns false if LD-BYTES would have failed
+bool FTapeDeck::FlashLoadBlock()
+{
+	if (CurrentBlock >= (int)Blocks.size())
+		return false;
+
+	z80_t& cpu = pSpectrumEmu->ZXEmuState.cpu;
+	FCodeAnalysisState& state = pSpectrumEmu->GetCodeAnalysis();
+	const FTapeBlock& block = Blocks[CurrentBlock++];
+	const bool bLoad = (cpu.f & Z80_CF) != 0;	// carry clear means VERIFY
+
+	if (block.Data.size() < 2 || block.Data[0] != cpu.a)
+		return false;	// wrong block type, the ROM will skip it & try the next
+
+	const int noDataBytes = (int)block.Data.size() - 2;	// without flag & checksum
+	const int noBytes = std::min((int)cpu.de, std::max(noDataBytes, 0));
+	uint8_t parity = block.Data[0];
+
+	for (int i = 0; i < noBytes; i++)
+	{
+		const uint8_t value = block.Data[1 + i];
+		const uint16_t address = cpu.ix + i;
+		parity ^= value;
+
+		if (bLoad)
+		{
+			pSpectrumEmu->WriteByte(address, value);
+			if (state.bRegisterDataAccesses)
+				RegisterDataWrite(state, kLDBytesAddress, address, value);	// attribute the data to the ROM loader
+		}
+		else if (pSpectrumEmu->ReadByte(address) != value)
+		{
+			return false;
+		}
+	}
+
+	cpu.ix += noBytes;
+	cpu.de -= noBytes;
+
+	if (cpu.de != 0)
+		return false;	// block was too short
+
+	parity ^= block.Data[1 + noBytes];	// checksum
+	return parity == 0;
+}
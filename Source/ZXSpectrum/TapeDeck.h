@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class FSpectrumEmu;
+
+// A block as it appears on tape - flag byte, data & checksum
+struct FTapeBlock
+{
+	std::vector<uint8_t>	Data;
+	bool					bStandardSpeed = true;	// turbo blocks can only be flash loaded if the loader uses the ROM routine
+};
+
+// Virtual tape deck
+// Blocks are flash loaded by trapping the ROM LD-BYTES routine, there is no pulse level tape emulation
+class FTapeDeck
+{
+public:
+	void	Init(FSpectrumEmu* pEmu) { pSpectrumEmu = pEmu; }
+	void	Eject();
+	void	AddBlock(const FTapeBlock& block) { Blocks.push_back(block); }
+
+	void	Play();			// reset the machine & type LOAD ""
+	void	Stop();
+	bool	IsPlaying() const { return bPlaying; }
+	void	FrameTick();	// call before each machine frame
+
+	uint64_t	TrapTick(uint64_t pins);	// call when an instruction is about to be fetched
+
+	int		GetNoBlocks() const { return (int)Blocks.size(); }
+	int		GetCurrentBlock() const { return CurrentBlock; }
+
+	bool	bFlashLoad = true;
+	bool	bFastLoad = true;	// run in turbo mode with batched analysis while the tape plays
+
+private:
+	bool	IsLoaderROMPaged() const;
+	bool	FlashLoadBlock();
+
+	FSpectrumEmu*			pSpectrumEmu = nullptr;
+	std::vector<FTapeBlock>	Blocks;
+	int						CurrentBlock = 0;
+	bool					bPlaying = false;
+
+	// typing LOAD "" after reset
+	std::vector<int>		KeysToType;
+	int						TypingFrameCounter = 0;
+
+	// settings to restore when the tape stops
+	bool					bForcedFastMode = false;
+	bool					bOldTurboMode = false;
+	bool					bOldRecordDataAccesses = false;
+};
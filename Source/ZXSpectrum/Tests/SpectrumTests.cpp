@@ -7,7 +7,13 @@
 
 #include <gtest/gtest.h>
 #include "../SnapshotLoaders/SNALoader.h"
+#include "../SnapshotLoaders/TZXLoader.h"
 #include "../ZXChipsImpl.h"
+#include "CodeAnalyser/CodeAnalysisBinary.h"
+#include "CodeAnalyser/UI/CodeAnalyserUI.h"
+
+#include <chrono>
+#include <filesystem>
 
 // Demonstrate some basic assertions.
 TEST(ZXSpectrumTest, BasicAssertions) 
@@ -18,6 +24,75 @@ TEST(ZXSpectrumTest, BasicAssertions)
 	EXPECT_EQ(7 * 6, 42);
 }
 
+// Handlers should be found on every page they overlap, in the order they were added
+TEST(ZXSpectrumTest, MemoryHandlerIndex)
+{
+	std::vector<FMemoryAccessHandler> handlers(4);
+	handlers[0].Type = MemoryAccessType::Write;		handlers[0].MemStart = 0x4000; handlers[0].MemEnd = 0x5aff;
+	handlers[1].Type = MemoryAccessType::Execute;	handlers[1].MemStart = 0x8000; handlers[1].MemEnd = 0x8000;
+	handlers[2].Type = MemoryAccessType::Write;		handlers[2].MemStart = 0x5800; handlers[2].MemEnd = 0x5bff;
+	handlers[3].Type = MemoryAccessType::Read;		handlers[3].MemStart = 0xfc00; handlers[3].MemEnd = 0xffff;
+
+	FMemoryHandlerIndex index;
+	EXPECT_TRUE(index.bDirty);
+	index.Build(handlers);
+	EXPECT_FALSE(index.bDirty);
+
+	EXPECT_TRUE(index.HasHandlers(MemoryAccessType::Write, 0x4000));
+	EXPECT_TRUE(index.HasHandlers(MemoryAccessType::Write, 0x5bff));
+	EXPECT_FALSE(index.HasHandlers(MemoryAccessType::Write, 0x3fff));
+	EXPECT_FALSE(index.HasHandlers(MemoryAccessType::Write, 0x5c00));
+	EXPECT_FALSE(index.HasHandlers(MemoryAccessType::Read, 0x4000));
+	EXPECT_TRUE(index.HasHandlers(MemoryAccessType::Execute, 0x8000));
+	EXPECT_TRUE(index.HasHandlers(MemoryAccessType::Read, 0xffff));
+
+	const std::vector<int>& overlap = index.GetPageHandlers(MemoryAccessType::Write, 0x5900);
+	ASSERT_EQ(overlap.size(), 2);
+	EXPECT_EQ(overlap[0], 0);
+	EXPECT_EQ(overlap[1], 2);
+
+	const std::vector<int>& single = index.GetPageHandlers(MemoryAccessType::Write, 0x4400);
+	ASSERT_EQ(single.size(), 1);
+	EXPECT_EQ(single[0], 0);
+
+	// rebuilding drops handlers that have gone
+	handlers.erase(handlers.begin());
+	index.Build(handlers);
+	EXPECT_FALSE(index.HasHandlers(MemoryAccessType::Write, 0x4000));
+	ASSERT_EQ(index.GetPageHandlers(MemoryAccessType::Write, 0x5900).size(), 1);
+	EXPECT_EQ(index.GetPageHandlers(MemoryAccessType::Write, 0x5900)[0], 1);
+}
+
+// Compacted instruction traces should decode back to the original, including bank changes & steps that don't fit in a byte
+TEST(ZXSpectrumTest, CompactInstructionTrace)
+{
+	std::vector<FAddressRef> trace;
+	for (int i = 0; i < 1000; i++)
+		trace.emplace_back(2, (uint16_t)(0x8000 + i * 2));
+	trace.emplace_back(2, 0x8000);		// jump back
+	trace.emplace_back(0, 0x0038);		// bank change
+	trace.emplace_back(0, 0x0038 + 127);
+	trace.emplace_back(0, 0x0038);		// -127
+	trace.emplace_back(0, 0x0038 + 128);
+	trace.emplace_back(0, 0x0038);		// -128 is the escape byte
+	trace.emplace_back(5, 0xffff);
+	trace.emplace_back(5, 0x0000);		// wrap
+	trace.emplace_back();				// invalid address
+
+	FCompactInstructionTrace compact;
+	compact.Encode(trace);
+	EXPECT_EQ(compact.GetNoInstructions(), (int)trace.size());
+	EXPECT_LT(compact.GetMemorySize(), trace.size() * sizeof(FAddressRef));
+
+	std::vector<FAddressRef> decoded;
+	compact.Decode(decoded);
+	EXPECT_EQ(decoded, trace);
+
+	compact.Encode({});
+	compact.Decode(decoded);
+	EXPECT_TRUE(decoded.empty());
+}
+
 class FSpectrumEmuTest : public ::testing::Test
 {
 protected:
@@ -62,6 +137,388 @@ TEST_F(FSpectrumEmuTest, SnapshotLoaderTest)
 
 };
 
+// Data accesses recorded & processed at the end of the frame, or applied on the analysis thread, should give the same analysis as registering them immediately
+TEST_F(FSpectrumEmuTest, DataAccessRecording)
+{
+	ASSERT_NE(pEmu, nullptr);
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const int kNoFrames = 50;
+
+	struct FAccessStats
+	{
+		std::vector<int>	ReadCounts;
+		std::vector<int>	WriteCounts;
+		std::vector<std::vector<FAddressRef>>	Readers;
+		std::vector<std::vector<FAddressRef>>	Writers;
+		double				FPS = 0;
+	};
+
+	auto runFrames = [&](bool bRecord, bool bThreaded)
+	{
+		pEmu->OnExitEditMode();	// restore the machine so every run emulates the same frames
+		ResetReferenceInfo(state);
+		for (int addr = 0; addr < (1 << 16); addr += FCodeAnalysisPage::kPageSize)
+		{
+			state.GetReadPage(addr)->ResetDataAccessStats();
+			state.GetWritePage(addr)->ResetDataAccessStats();
+		}
+
+		FAccessStats stats;
+		state.bAnalysisThread = bThreaded;
+		state.bRecordDataAccesses = bRecord;
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		for (int frameNo = 0; frameNo < kNoFrames; frameNo++)
+			pEmu->ExecuteFrame(20000);
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		stats.FPS = kNoFrames / std::chrono::duration<double>(endTime - startTime).count();
+		EXPECT_EQ(state.AnalysisPipeline.IsRunning(), bThreaded);
+		state.bRecordDataAccesses = false;
+		state.bAnalysisThread = false;
+		state.AnalysisPipeline.Stop();
+
+		for (int addr = 0; addr < (1 << 16); addr++)
+		{
+			const uint16_t pageAddr = addr & FCodeAnalysisPage::kPageMask;
+			stats.ReadCounts.push_back(state.GetReadPage(addr)->ReadCount[pageAddr]);
+			stats.WriteCounts.push_back(state.GetWritePage(addr)->WriteCount[pageAddr]);
+			const FItemReferenceTracker& reads = state.GetReadDataInfoForAddress(addr)->GetReads();
+			const FItemReferenceTracker& writes = state.GetWriteDataInfoForAddress(addr)->GetWrites();
+			stats.Readers.emplace_back(reads.begin(), reads.end());
+			stats.Writers.emplace_back(writes.begin(), writes.end());
+		}
+		return stats;
+	};
+
+	pEmu->OnEnterEditMode();	// backup machine state
+	runFrames(false, false);	// analyse the code first so every run sees the same code items
+	const FAccessStats immediate = runFrames(false, false);
+	const FAccessStats recorded = runFrames(true, false);
+	EXPECT_TRUE(state.DataAccessRecords.empty());	// all processed by OnFrameEnd
+	const FAccessStats threaded = runFrames(false, true);
+
+	EXPECT_EQ(recorded.ReadCounts, immediate.ReadCounts);
+	EXPECT_EQ(recorded.WriteCounts, immediate.WriteCounts);
+	EXPECT_EQ(recorded.Readers, immediate.Readers);
+	EXPECT_EQ(recorded.Writers, immediate.Writers);
+
+	EXPECT_EQ(threaded.ReadCounts, immediate.ReadCounts);
+	EXPECT_EQ(threaded.WriteCounts, immediate.WriteCounts);
+	EXPECT_EQ(threaded.Readers, immediate.Readers);
+	EXPECT_EQ(threaded.Writers, immediate.Writers);
+
+	printf("Data access registration: immediate %.1f fps, recorded %.1f fps, threaded %.1f fps\n", immediate.FPS, recorded.FPS, threaded.FPS);
+}
+
+// Running the analysis on the worker thread should give the same reads, writes & SMC flags as running it immediately once the frame has synced
+TEST_F(FSpectrumEmuTest, ThreadedAnalysis)
+{
+	ASSERT_NE(pEmu, nullptr);
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	ASSERT_TRUE(LoadSNAFile(pEmu, "Tests/testminimal.sna"));
+	const int kNoFrames = 10;
+
+	// self modifying loop at the snapshot's PC, the LD writes the operand of the first instruction
+	const uint8_t smcLoop[] =
+	{
+		0x3E, 0x00,			// 8001: LD A,0
+		0x3C,				// 8003: INC A
+		0x32, 0x02, 0x80,	// 8004: LD (8002),A
+		0x18, 0xF8,			// 8007: JR 8001
+	};
+	for (int i = 0; i < (int)sizeof(smcLoop); i++)
+		pEmu->WriteByte(0x8001 + i, smcLoop[i]);
+
+	struct FAnalysisStats
+	{
+		std::vector<int>	ReadCounts;
+		std::vector<int>	WriteCounts;
+		std::vector<std::vector<FAddressRef>>	Readers;
+		std::vector<std::vector<FAddressRef>>	Writers;
+		std::vector<uint16_t>	SMCAddresses;
+	};
+
+	auto runFrames = [&](bool bThreaded)
+	{
+		pEmu->OnExitEditMode();	// restore the machine so every run emulates the same frames
+		ResetReferenceInfo(state);
+		for (int addr = 0; addr < (1 << 16); addr += FCodeAnalysisPage::kPageSize)
+		{
+			state.GetReadPage(addr)->ResetDataAccessStats();
+			state.GetWritePage(addr)->ResetDataAccessStats();
+		}
+
+		state.bAnalysisThread = bThreaded;
+		for (int frameNo = 0; frameNo < kNoFrames; frameNo++)
+			pEmu->ExecuteFrame(20000);
+		EXPECT_EQ(state.AnalysisPipeline.IsRunning(), bThreaded);
+		EXPECT_TRUE(state.DeferredSMCChecks.empty());	// all rechecked by OnFrameEnd
+		state.bAnalysisThread = false;
+		state.AnalysisPipeline.Stop();
+
+		FAnalysisStats stats;
+		for (int addr = 0; addr < (1 << 16); addr++)
+		{
+			const uint16_t pageAddr = addr & FCodeAnalysisPage::kPageMask;
+			stats.ReadCounts.push_back(state.GetReadPage(addr)->ReadCount[pageAddr]);
+			stats.WriteCounts.push_back(state.GetWritePage(addr)->WriteCount[pageAddr]);
+			const FItemReferenceTracker& reads = state.GetReadDataInfoForAddress(addr)->GetReads();
+			const FItemReferenceTracker& writes = state.GetWriteDataInfoForAddress(addr)->GetWrites();
+			stats.Readers.emplace_back(reads.begin(), reads.end());
+			stats.Writers.emplace_back(writes.begin(), writes.end());
+
+			const FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(addr);
+			if (pCodeInfo != nullptr && pCodeInfo->bSelfModifyingCode)
+				stats.SMCAddresses.push_back(addr);
+		}
+		return stats;
+	};
+
+	pEmu->OnEnterEditMode();	// backup machine state
+	runFrames(false);	// analyse the code first so both runs see the same code items
+	const FAnalysisStats immediate = runFrames(false);
+	const FAnalysisStats threaded = runFrames(true);
+
+	EXPECT_NE(std::find(immediate.SMCAddresses.begin(), immediate.SMCAddresses.end(), 0x8001), immediate.SMCAddresses.end());
+	EXPECT_EQ(threaded.SMCAddresses, immediate.SMCAddresses);
+	EXPECT_EQ(threaded.ReadCounts, immediate.ReadCounts);
+	EXPECT_EQ(threaded.WriteCounts, immediate.WriteCounts);
+	EXPECT_EQ(threaded.Readers, immediate.Readers);
+	EXPECT_EQ(threaded.Writers, immediate.Writers);
+}
+
+// Analysis exported to the binary format should import back the same
+TEST_F(FSpectrumEmuTest, AnalysisBinaryRoundTrip)
+{
+	ASSERT_NE(pEmu, nullptr);
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const FAddressRef labelAddr = state.AddressRefFromPhysicalAddress(0x8000);
+	const FAddressRef codeAddr = state.AddressRefFromPhysicalAddress(0x8010);
+	const FAddressRef dataAddr = state.AddressRefFromPhysicalAddress(0x9000);
+
+	FLabelInfo* pLabel = AddLabel(state, labelAddr, "roundtrip_label", ELabelType::Function);
+	pLabel->Global = true;
+	pLabel->Comment = "label comment";
+
+	FCodeInfo* pCodeInfo = FCodeInfo::Allocate();
+	pCodeInfo->ByteSize = 3;
+	pCodeInfo->OperandType = EOperandType::Pointer;
+	pCodeInfo->Comment = "code comment";
+	state.SetCodeInfoForAddress(codeAddr, pCodeInfo);
+
+	FDataInfo* pDataInfo = state.EditDataInfoForAddress(dataAddr);
+	pDataInfo->DataType = EDataType::Word;
+	pDataInfo->ByteSize = 2;
+	pDataInfo->bGameState = true;
+	pDataInfo->Comment = "data comment";
+
+	const char* kFileName = "Tests/roundtrip.abin";
+	ASSERT_TRUE(ExportAnalysisBinary(state, kFileName));
+
+	// clear the items then load them back
+	state.SetLabelForAddress(labelAddr, nullptr);
+	state.SetCodeInfoForAddress(codeAddr, nullptr);
+	state.EditDataInfoForAddress(dataAddr)->Reset();
+	const bool bImported = ImportAnalysisBinary(state, kFileName);
+	ASSERT_TRUE(bImported);
+
+	const FLabelInfo* pLoadedLabel = state.GetLabelForAddress(labelAddr);
+	ASSERT_NE(pLoadedLabel, nullptr);
+	EXPECT_STREQ(pLoadedLabel->GetName(), "roundtrip_label");
+	EXPECT_EQ(pLoadedLabel->LabelType, ELabelType::Function);
+	EXPECT_TRUE(pLoadedLabel->Global);
+	EXPECT_STREQ(pLoadedLabel->Comment.c_str(), "label comment");
+
+	const FCodeInfo* pLoadedCodeInfo = state.GetCodeInfoForAddress(codeAddr);
+	ASSERT_NE(pLoadedCodeInfo, nullptr);
+	EXPECT_EQ(pLoadedCodeInfo->ByteSize, 3);
+	EXPECT_EQ(pLoadedCodeInfo->OperandType, EOperandType::Pointer);
+	EXPECT_STREQ(pLoadedCodeInfo->Comment.c_str(), "code comment");
+
+	const FDataInfo* pLoadedDataInfo = state.GetDataInfoForAddress(dataAddr);
+	EXPECT_EQ(pLoadedDataInfo->DataType, EDataType::Word);
+	EXPECT_EQ(pLoadedDataInfo->ByteSize, 2);
+	EXPECT_TRUE(pLoadedDataInfo->bGameState);
+	EXPECT_STREQ(pLoadedDataInfo->Comment.c_str(), "data comment");
+
+	// a truncated file should fail without adding anything
+	state.SetLabelForAddress(labelAddr, nullptr);
+	std::filesystem::resize_file(kFileName, std::filesystem::file_size(kFileName) / 2);
+	EXPECT_FALSE(ImportAnalysisBinary(state, kFileName));
+	EXPECT_EQ(state.GetLabelForAddress(labelAddr), nullptr);
+	remove(kFileName);
+}
+
+// Flow control blocks don't start with a DWORD length, the data block after them should still be found
+TEST_F(FSpectrumEmuTest, TZXFlowControlBlocks)
+{
+	const std::vector<uint8_t> tzxData =
+	{
+		'Z', 'X', 'T', 'a', 'p', 'e', '!', 0x1A, 1, 20,
+		0x10, 0xE8, 0x03, 0x03, 0x00, 0x00, 0x01, 0x01,		// standard speed block, 3 bytes
+		0x24, 0x02, 0x00,									// loop start
+		0x25,												// loop end
+		0x23, 0x01, 0x00,									// jump to block
+		0x26, 0x02, 0x00, 0x01, 0x00, 0x02, 0x00,			// call sequence of 2
+		0x27,												// return from sequence
+		0x28, 0x05, 0x00, 0x01, 0x01, 0x00, 0x01, 'A',		// select block
+		0x2B, 0x01, 0x00, 0x00, 0x00, 0x01,					// set signal level - unknown, DWORD length
+		0x10, 0xE8, 0x03, 0x02, 0x00, 0xFF, 0xFF,			// standard speed block, 2 bytes
+	};
+
+	ASSERT_TRUE(LoadTZXFromMemory(pEmu, tzxData.data(), tzxData.size()));
+	EXPECT_EQ(pEmu->TapeDeck.GetNoBlocks(), 2);
+	pEmu->TapeDeck.Stop();
+}
+
+// The data breakpoint bitmap should match the breakpoint list after every change, without waiting for a new frame
+TEST_F(FSpectrumEmuTest, DataBreakpointMap)
+{
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	FDebugger& debugger = state.Debugger;
+
+	auto checkMap = [&state, &debugger]()
+	{
+		debugger.UpdateBreakpointMasks();
+		EXPECT_FALSE(debugger.AreBreakpointsDirty());
+		for (int addr = 0x4000; addr < 0x10000; addr++)
+		{
+			const FAddressRef addrRef = state.AddressRefFromPhysicalAddress((uint16_t)addr);
+			ASSERT_EQ(debugger.GetDataBreakpointMap().IsSet(addrRef), debugger.FindDataBreakpoint(addrRef) != -1) << "address " << addr;
+		}
+	};
+
+	const FAddressRef bp1 = state.AddressRefFromPhysicalAddress(0x5b00);
+	const FAddressRef bp2 = state.AddressRefFromPhysicalAddress(0x8000);
+	EXPECT_TRUE(debugger.AddDataBreakpoint(bp1, 4));
+	EXPECT_TRUE(debugger.AreBreakpointsDirty());
+	EXPECT_TRUE(debugger.AddDataBreakpoint(bp2, 100));
+	checkMap();
+	EXPECT_TRUE(debugger.GetDataBreakpointMap().IsSet(state.AddressRefFromPhysicalAddress(0x5b03)));
+	EXPECT_FALSE(debugger.GetDataBreakpointMap().IsSet(state.AddressRefFromPhysicalAddress(0x5b04)));
+
+	// disable
+	debugger.GetBreakpointForAddress(bp2)->bEnabled = false;
+	debugger.MarkBreakpointsDirty();
+	checkMap();
+	EXPECT_FALSE(debugger.GetDataBreakpointMap().IsSet(bp2));
+
+	// move & remove
+	EXPECT_TRUE(debugger.ChangeBreakpointAddress(bp2, state.AddressRefFromPhysicalAddress(0x9000)));
+	debugger.GetBreakpointForAddress(state.AddressRefFromPhysicalAddress(0x9000))->bEnabled = true;
+	EXPECT_TRUE(debugger.RemoveBreakpoint(bp1));
+	EXPECT_TRUE(debugger.AreBreakpointsDirty());
+	checkMap();
+	EXPECT_FALSE(debugger.GetDataBreakpointMap().IsSet(bp1));
+	EXPECT_TRUE(debugger.GetDataBreakpointMap().IsSet(state.AddressRefFromPhysicalAddress(0x9000)));
+}
+
+
+// Rebuilding a dirty page should hand the comment lines it replaces back to the bank's allocator
+TEST_F(FSpectrumEmuTest, CommentLineRecycling)
+{
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const FAddressRef commentAddr = state.AddressRefFromPhysicalAddress(0x8000);
+	FCodeAnalysisBank* pBank = state.GetBank(commentAddr.BankId);
+	ASSERT_NE(pBank, nullptr);
+
+	FCommentBlock* pCommentBlock = FCommentBlock::Allocate();
+	pCommentBlock->Comment = "first line\nsecond line";
+	state.SetCommentBlockForAddress(commentAddr, pCommentBlock);
+	pBank->bIsDirty = true;
+	state.SetCodeAnalysisDirty(commentAddr);
+	UpdateItemList(state);
+	const size_t noAllocated = pBank->CommentLineAllocator.GetNoAllocated();
+	EXPECT_GE(noAllocated, 2);
+
+	for (int i = 0; i < 10; i++)
+	{
+		state.SetCodeAnalysisDirty(commentAddr);
+		UpdateItemList(state);
+		EXPECT_EQ(pBank->CommentLineAllocator.GetNoAllocated(), noAllocated);
+	}
+
+	int noCommentLines = 0;
+	for (const FCodeAnalysisItem& item : pBank->ItemList)
+	{
+		if (item.Item->Type == EItemType::CommentLine)
+			noCommentLines++;
+	}
+	EXPECT_EQ(noCommentLines, (int)noAllocated);
+}
+
+// Frame memory rebuilt from a keyframe & the deltas since should match the RAM at the end of the frame
+TEST_F(FSpectrumEmuTest, FrameTraceReconstruction)
+{
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	FFrameTraceViewer& viewer = pEmu->FrameTraceViewer;
+	const int noBanks = viewer.GetNoRAMBanks();
+	const int kNoFrames = 60;	// past the next keyframe
+
+	struct FFrameSnapshot
+	{
+		int							FrameIndex = -1;
+		std::vector<uint8_t>		RAM;
+		std::vector<FAddressRef>	InstructionTrace;
+	};
+	std::vector<FFrameSnapshot> snapshots(kNoFrames);
+
+	for (FFrameSnapshot& snapshot : snapshots)
+	{
+		pEmu->ExecuteFrame(20000);
+		snapshot.FrameIndex = viewer.GetLastCapturedFrameIndex();
+		snapshot.RAM.assign(&pEmu->ZXEmuState.ram[0][0], &pEmu->ZXEmuState.ram[0][0] + noBanks * kTraceRAMBankSize);
+		snapshot.InstructionTrace = state.Debugger.GetFrameTrace();
+	}
+
+	std::vector<uint8_t> frameMemory(kNoTraceRAMBanks * kTraceRAMBankSize);
+	std::vector<FAddressRef> frameTrace;
+	for (const FFrameSnapshot& snapshot : snapshots)
+	{
+		ASSERT_TRUE(viewer.GetFrameMemory(snapshot.FrameIndex, (uint8_t(*)[kTraceRAMBankSize])frameMemory.data()));
+		ASSERT_TRUE(std::equal(snapshot.RAM.begin(), snapshot.RAM.end(), frameMemory.begin())) << "frame " << snapshot.FrameIndex;
+
+		viewer.GetFrameInstructionTrace(snapshot.FrameIndex, frameTrace);
+		ASSERT_EQ(frameTrace, snapshot.InstructionTrace) << "frame " << snapshot.FrameIndex;
+	}
+}
+
+// A cached instruction decode should be redone when the instruction's bytes change without being flagged as SMC
+TEST_F(FSpectrumEmuTest, DecodedInstructionCache)
+{
+	FCodeAnalysisState& state = pEmu->GetCodeAnalysis();
+	const uint16_t kCodeAddr = 0x8000;
+	auto writeInstruction = [&](std::initializer_list<uint8_t> bytes)
+	{
+		uint16_t addr = kCodeAddr;
+		for (uint8_t byte : bytes)
+			pEmu->WriteByte(addr++, byte);
+	};
+
+	writeInstruction({ 0xC3, 0x00, 0x90 });	// JP 9000
+	RunStaticCodeAnalysis(state, kCodeAddr);
+	FCodeInfo* pCodeInfo = state.GetCodeInfoForPhysicalAddress(kCodeAddr);
+	ASSERT_NE(pCodeInfo, nullptr);
+	EXPECT_TRUE(pCodeInfo->Decoded.bValid);
+	EXPECT_TRUE(pCodeInfo->Decoded.bHasJump);
+	EXPECT_EQ(pCodeInfo->Decoded.JumpAddress, 0x9000);
+
+	// change the operand
+	writeInstruction({ 0xC3, 0x00, 0xA0 });	// JP A000
+	RunStaticCodeAnalysis(state, kCodeAddr);
+	EXPECT_TRUE(pCodeInfo->Decoded.bValid);
+	EXPECT_EQ(pCodeInfo->Decoded.JumpAddress, 0xA000);
+	EXPECT_EQ(pCodeInfo->Decoded.Bytes[2], 0xA0);
+	EXPECT_EQ(pCodeInfo->OperandAddress.Address, 0xA000);
+
+	// change the opcode
+	writeInstruction({ 0x21, 0x34, 0x12 });	// LD HL,1234
+	RunStaticCodeAnalysis(state, kCodeAddr);
+	EXPECT_TRUE(pCodeInfo->Decoded.bValid);
+	EXPECT_FALSE(pCodeInfo->Decoded.bHasJump);
+	EXPECT_TRUE(pCodeInfo->Decoded.bHasPointerRef);
+	EXPECT_EQ(pCodeInfo->Decoded.PointerAddress, 0x1234);
+	EXPECT_EQ(pCodeInfo->OperandAddress.Address, 0x1234);
+}
 
 // needed to get it compiling
 //void SetWindowTitle(const char* pTitle) {}
@@ -72,4 +529,3 @@ int main(int argc, char* argv[])
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
 }
-
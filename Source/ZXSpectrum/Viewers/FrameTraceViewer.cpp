@@ -10,6 +10,58 @@
 
 #include "CodeAnalyser/UI/UIColours.h"
 
+static const uint8_t kTraceEscapeByte = 0x80;	// a step of -128
+
+void FCompactInstructionTrace::Encode(const std::vector<FAddressRef>& trace)
+{
+	Data.clear();
+	Data.reserve(trace.size());	// a byte each for most instructions
+	NoInstructions = (int)trace.size();
+
+	FAddressRef lastAddr;
+	for (const FAddressRef& addr : trace)
+	{
+		const int step = (int)addr.Address - (int)lastAddr.Address;
+		if (addr.BankId == lastAddr.BankId && step > -128 && step < 128)
+		{
+			Data.push_back((uint8_t)(int8_t)step);
+		}
+		else
+		{
+			Data.push_back(kTraceEscapeByte);
+			Data.push_back((uint8_t)(addr.BankId & 0xff));
+			Data.push_back((uint8_t)(addr.BankId >> 8));
+			Data.push_back((uint8_t)(addr.Address & 0xff));
+			Data.push_back((uint8_t)(addr.Address >> 8));
+		}
+		lastAddr = addr;
+	}
+}
+
+void FCompactInstructionTrace::Decode(std::vector<FAddressRef>& outTrace) const
+{
+	outTrace.clear();
+	outTrace.reserve(NoInstructions);
+
+	FAddressRef lastAddr;
+	size_t pos = 0;
+	while (pos < Data.size())
+	{
+		if (Data[pos] == kTraceEscapeByte)
+		{
+			lastAddr.BankId = (int16_t)(Data[pos + 1] | (Data[pos + 2] << 8));
+			lastAddr.Address = (uint16_t)(Data[pos + 3] | (Data[pos + 4] << 8));
+			pos += 5;
+		}
+		else
+		{
+			lastAddr.Address = (uint16_t)(lastAddr.Address + (int8_t)Data[pos]);
+			pos++;
+		}
+		outTrace.push_back(lastAddr);
+	}
+}
+
 void FFrameTraceViewer::Init(FSpectrumEmu* pEmu)
 {
 	pSpectrumEmu = pEmu;
@@ -17,12 +69,12 @@ void FFrameTraceViewer::Init(FSpectrumEmu* pEmu)
 
 	// Init Frame Trace
 	for (int i = 0; i < kNoFramesInTrace; i++)
-	{
-		FrameTrace[i].Texture = ImGui_CreateTextureRGBA(pSpectrumEmu->SpectrumViewer.GetFrameBuffer(), dispInfo.frame.dim.width, dispInfo.frame.dim.height);
 		FrameTrace[i].CPUState = malloc(sizeof(z80_t));
-	}
+	for (int i = 0; i < kNoTraceImages; i++)
+		TraceImages[i] = ImGui_CreateTextureRGBA(pSpectrumEmu->SpectrumViewer.GetFrameBuffer(), dispInfo.frame.dim.width, dispInfo.frame.dim.height);
 
 	ShowWritesView = new FZXGraphicsView(320, 256);
+	pScratchMemory = new uint8_t[kNoTraceRAMBanks][kTraceRAMBankSize];
 }
 
 void FFrameTraceViewer::Reset()
@@ -30,68 +82,203 @@ void FFrameTraceViewer::Reset()
 	for (int i = 0; i < kNoFramesInTrace; i++)
 	{
 		auto& frame = FrameTrace[i];
-		frame.InstructionTrace.clear();
-		frame.FrameEvents.clear();
+		frame.InstructionTrace.Clear();
 		frame.FrameOverview.clear();
 		frame.MemoryDiffs.clear();
+		frame.PageIndices.clear();
+		frame.PageData.clear();
+		frame.bValid = false;
+		frame.ImageNo = -1;
+		frame.bKeyFrame = false;
 	}
+
+	CurrentTraceFrame = 0;
+	FramesSinceKeyFrame = 0;
+	bForceKeyFrame = true;
+	memset(DirtyPageMasks, 0, sizeof(DirtyPageMasks));
 }
 
 void	FFrameTraceViewer::Shutdown()
 {
 	for (int i = 0; i < kNoFramesInTrace; i++)
-	{
-		ImGui_FreeTexture(FrameTrace[i].Texture);
-		FrameTrace[i].Texture = nullptr;
 		free(FrameTrace[i].CPUState);
+	for (int i = 0; i < kNoTraceImages; i++)
+	{
+		ImGui_FreeTexture(TraceImages[i]);
+		TraceImages[i] = nullptr;
 	}
 
 	delete ShowWritesView;
 	ShowWritesView = nullptr;
+	delete[] pScratchMemory;
+	pScratchMemory = nullptr;
 }
 
+int FFrameTraceViewer::GetNoRAMBanks() const
+{
+	return pSpectrumEmu->ZXEmuState.type == ZX_TYPE_48K ? 3 : 8;
+}
 
-void FFrameTraceViewer::CaptureFrame()
+size_t FFrameTraceViewer::GetTraceMemorySize() const
+{
+	size_t size = 0;
+	for (int i = 0; i < kNoFramesInTrace; i++)
+	{
+		size += FrameTrace[i].PageData.capacity() + FrameTrace[i].PageIndices.capacity();
+		size += FrameTrace[i].InstructionTrace.GetMemorySize();
+	}
+	return size;
+}
+
+// Store either all the RAM pages or just the ones written to since the last capture
+void FFrameTraceViewer::StorePages(FSpeccyFrameTrace& frame, bool bKeyFrame)
+{
+	const uint8_t (*pRAM)[kTraceRAMBankSize] = pSpectrumEmu->ZXEmuState.ram;
+
+	// don't want a delta frame hanging on to keyframe sized buffers
+	if (frame.bKeyFrame && bKeyFrame == false)
+	{
+		frame.PageData.clear();
+		frame.PageData.shrink_to_fit();
+	}
+
+	frame.bKeyFrame = bKeyFrame;
+	frame.PageIndices.clear();
+	frame.PageData.clear();
+
+	const int noBanks = GetNoRAMBanks();
+	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	{
+		const uint16_t pageMask = bKeyFrame ? 0xffff : DirtyPageMasks[bankNo];
+		if (pageMask == 0)
+			continue;
+
+		for (int pageNo = 0; pageNo < kTracePagesPerBank; pageNo++)
+		{
+			if ((pageMask & (1 << pageNo)) == 0)
+				continue;
+
+			const uint8_t* pPage = &pRAM[bankNo][pageNo * kTracePageSize];
+			frame.PageIndices.push_back((uint8_t)(bankNo * kTracePagesPerBank + pageNo));
+			frame.PageData.insert(frame.PageData.end(), pPage, pPage + kTracePageSize);
+		}
+	}
+
+	memset(DirtyPageMasks, 0, sizeof(DirtyPageMasks));
+}
+
+// The oldest frame is about to be overwritten so the frame after it takes over its keyframe
+// The keyframe's buffer has the next frame's written pages copied on top & is then handed over, so this only costs the pages written
+bool FFrameTraceViewer::PassOnKeyFrame(FSpeccyFrameTrace& keyFrame, FSpeccyFrameTrace& nextFrame)
+{
+	for (size_t pageNo = 0; pageNo < nextFrame.PageIndices.size(); pageNo++)
+	{
+		// keyframes store every page in order
+		const int pageIndex = nextFrame.PageIndices[pageNo];
+		if (pageIndex >= (int)keyFrame.PageIndices.size())
+			return false;
+		memcpy(&keyFrame.PageData[pageIndex * kTracePageSize], &nextFrame.PageData[pageNo * kTracePageSize], kTracePageSize);
+	}
+
+	std::swap(keyFrame.PageData, nextFrame.PageData);
+	std::swap(keyFrame.PageIndices, nextFrame.PageIndices);
+	nextFrame.bKeyFrame = true;
+	keyFrame.bKeyFrame = false;
+	return true;
+}
+
+void* FFrameTraceViewer::GetFrameImage(const FSpeccyFrameTrace& frame) const
+{
+	if (frame.ImageNo == -1 || NoImagesCaptured - frame.ImageNo > kNoTraceImages)	// none or since reused
+		return nullptr;
+	return TraceImages[frame.ImageNo % kNoTraceImages];
+}
+
+// Rebuild a frame's memory from the last keyframe & the deltas since
+bool FFrameTraceViewer::GetFrameMemory(int frameIndex, uint8_t outBanks[kNoTraceRAMBanks][kTraceRAMBankSize]) const
+{
+	int keyFrameIndex = frameIndex;
+	int noDeltas = 0;
+	while (FrameTrace[keyFrameIndex].bKeyFrame == false)
+	{
+		if (FrameTrace[keyFrameIndex].bValid == false || ++noDeltas == kNoFramesInTrace)
+			return false;
+		keyFrameIndex = keyFrameIndex == 0 ? kNoFramesInTrace - 1 : keyFrameIndex - 1;
+	}
+
+	for (int i = 0; i <= noDeltas; i++)
+	{
+		const FSpeccyFrameTrace& frame = FrameTrace[(keyFrameIndex + i) % kNoFramesInTrace];
+		for (size_t pageNo = 0; pageNo < frame.PageIndices.size(); pageNo++)
+		{
+			const int pageIndex = frame.PageIndices[pageNo];
+			uint8_t* pDest = &outBanks[pageIndex / kTracePagesPerBank][(pageIndex % kTracePagesPerBank) * kTracePageSize];
+			memcpy(pDest, &frame.PageData[pageNo * kTracePageSize], kTracePageSize);
+		}
+	}
+
+	return true;
+}
+
+
+void FFrameTraceViewer::CaptureFrame(bool bCaptureImage)
 {
 	// set up new trace frame
 	FCodeAnalysisState& codeAnalysis = pSpectrumEmu->GetCodeAnalysis();
 	FSpeccyFrameTrace& frame = FrameTrace[CurrentTraceFrame];
-	ImGui_UpdateTextureRGBA(frame.Texture, pSpectrumEmu->SpectrumViewer.GetFrameBuffer());
-	frame.InstructionTrace = codeAnalysis.Debugger.GetFrameTrace();	// copy frame trace - use method?
-	frame.FrameEvents = codeAnalysis.Debugger.GetEventTrace();
+	frame.ImageNo = -1;
+	if (bCaptureImage)	// skipped for intermediate turbo frames
+	{
+		frame.ImageNo = NoImagesCaptured++;
+		ImGui_UpdateTextureRGBA(TraceImages[frame.ImageNo % kNoTraceImages], pSpectrumEmu->SpectrumViewer.GetFrameBuffer());
+	}
+	frame.InstructionTrace.Encode(codeAnalysis.Debugger.GetFrameTrace());
 	frame.FrameOverview.clear();
 
-	// copy memory
-	const int noBanks = pSpectrumEmu->ZXEmuState.type == ZX_TYPE_48K ? 3:8;
-	for (int i = 0; i < noBanks; i++)
-		memcpy(frame.MemoryBanks[i], pSpectrumEmu->ZXEmuState.ram[i], 16 * 1024);
+	// The frame after this one will be rebuilt from this one's memory so it needs to become a keyframe before we overwrite it
+	// The oldest frame is always a keyframe, otherwise its own keyframe has already gone
+	FSpeccyFrameTrace& nextFrame = FrameTrace[(CurrentTraceFrame + 1) % kNoFramesInTrace];
+	if (nextFrame.bValid && nextFrame.bKeyFrame == false)
+	{
+		if (frame.bValid == false || frame.bKeyFrame == false || PassOnKeyFrame(frame, nextFrame) == false)
+			nextFrame.bValid = false;
+	}
+
+	// store memory - only the pages that have been written to, unless it's time for a keyframe
+	const bool bKeyFrame = bForceKeyFrame || ++FramesSinceKeyFrame >= kKeyFrameInterval;
+	StorePages(frame, bKeyFrame);
+	frame.bValid = true;
+	if (bKeyFrame)
+	{
+		FramesSinceKeyFrame = 0;
+		bForceKeyFrame = false;
+	}
 
 	frame.MemoryBankRegister = pSpectrumEmu->ZXEmuState.last_mem_config;
 
 	// get CPU state
 	memcpy(frame.CPUState, &pSpectrumEmu->ZXEmuState.cpu, sizeof(z80_t));
 
-	// Generate diffs
-	const int prevFrameIndex = CurrentTraceFrame == 0 ? kNoFramesInTrace - 1 : CurrentTraceFrame - 1;
-	const FSpeccyFrameTrace& prevFrame = FrameTrace[prevFrameIndex];
-
 	// Not used atm
-	//GenerateMemoryDiff(frame, prevFrame, frame.MemoryDiffs);
+	//GenerateMemoryDiff(CurrentTraceFrame, frame.MemoryDiffs);
 
 	if (++CurrentTraceFrame == kNoFramesInTrace)
 		CurrentTraceFrame = 0;
 }
 
 
-void FFrameTraceViewer::RestoreFrame(const FSpeccyFrameTrace& frame)
+void FFrameTraceViewer::RestoreFrame(int frameIndex)
 {
+	const FSpeccyFrameTrace& frame = FrameTrace[frameIndex];
+	if (frame.bValid == false)
+		return;
+
 	// restore CPU regs
 	memcpy(&pSpectrumEmu->ZXEmuState.cpu, frame.CPUState, sizeof(z80_t));
 
 	// restore memory
-	const int noBanks = pSpectrumEmu->ZXEmuState.type == ZX_TYPE_48K ? 3 : 8;
-	for (int i = 0; i < noBanks; i++)
-		memcpy(pSpectrumEmu->ZXEmuState.ram[i],frame.MemoryBanks[i],  16 * 1024);
+	GetFrameMemory(frameIndex, pSpectrumEmu->ZXEmuState.ram);
+	ForceKeyFrame();	// memory has jumped so the next frame can't be a delta
 
 	// restore bank setup
 	if (pSpectrumEmu->ZXEmuState.type == ZX_TYPE_128)
@@ -145,7 +332,7 @@ void FFrameTraceViewer::Draw()
 		DrawFrameScreenWritePixels(FrameTrace[frameNo]);
 
 		if (RestoreOnScrub)
-			RestoreFrame(FrameTrace[frameNo]);
+			RestoreFrame(frameNo);
 	}
 	else
 	{
@@ -154,11 +341,12 @@ void FFrameTraceViewer::Draw()
 			frameNo += kNoFramesInTrace;
 	}
 	const FSpeccyFrameTrace& frame = FrameTrace[frameNo];
+	frame.InstructionTrace.Decode(DecodedInstructionTrace);
 	
 
 	if (ImGui::Button("Restore"))
 	{
-		RestoreFrame(frame);
+		RestoreFrame(frameNo);
 
 		// continue running
 		codeAnalysis.Debugger.Continue();
@@ -168,10 +356,24 @@ void FFrameTraceViewer::Draw()
 	}
 	ImGui::SameLine();
 	ImGui::Checkbox("Restore On Scrub", &RestoreOnScrub);
+	ImGui::SameLine();
+	ImGui::Text("Trace Memory: %dK", (int)(GetTraceMemorySize() / 1024));
 	
 	ImVec2 uv0(0, 0);
 	ImVec2 uv1(320.0f / 512.0f, 1.0f);
-	ImGui::Image(frame.Texture, ImVec2(320, 256), uv0, uv1);
+	void* pFrameImage = GetFrameImage(frame);
+	if (pFrameImage != nullptr)
+	{
+		ImGui::Image(pFrameImage, ImVec2(320, 256), uv0, uv1);
+	}
+	else
+	{
+		ImDrawList* dl = ImGui::GetWindowDrawList();
+		const ImVec2 pos = ImGui::GetCursorScreenPos();
+		dl->AddRect(pos, ImVec2(pos.x + 320, pos.y + 256), 0xff808080);
+		dl->AddText(ImVec2(pos.x + 8, pos.y + 8), 0xffffffff, "No image captured for this frame");
+		ImGui::Dummy(ImVec2(320, 256));
+	}
 	ImGui::SameLine();
 
 	ShowWritesView->Draw();
@@ -216,13 +418,13 @@ void	FFrameTraceViewer::DrawInstructionTrace(const FSpeccyFrameTrace& frame)
 	FCodeAnalysisViewState& viewState = state.GetFocussedViewState();
 	const float line_height = ImGui::GetTextLineHeight();
 	ImGuiListClipper clipper;
-	clipper.Begin((int)frame.InstructionTrace.size(), line_height);
+	clipper.Begin((int)DecodedInstructionTrace.size(), line_height);
 
 	while (clipper.Step())
 	{
 		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
 		{
-			const FAddressRef instAddr = frame.InstructionTrace[i];
+			const FAddressRef instAddr = DecodedInstructionTrace[i];
 
 			ImGui::PushID(i);
 
@@ -262,9 +464,9 @@ void	FFrameTraceViewer::GenerateTraceOverview(FSpeccyFrameTrace& frame)
 {
 	FCodeAnalysisState& state = pSpectrumEmu->GetCodeAnalysis();
 	frame.FrameOverview.clear();
-	for (int i = 0; i < frame.InstructionTrace.size(); i++)
+	for (int i = 0; i < DecodedInstructionTrace.size(); i++)
 	{
-		const FAddressRef instAddr = frame.InstructionTrace[i];
+		const FAddressRef instAddr = DecodedInstructionTrace[i];
 
 		// TODO: find closest global label
 		int labelOffset = 0;
@@ -314,24 +516,33 @@ void	FFrameTraceViewer::GenerateTraceOverview(FSpeccyFrameTrace& frame)
 	}
 }
 
-void FFrameTraceViewer::GenerateMemoryDiff(const FSpeccyFrameTrace& frame, const FSpeccyFrameTrace& otherFrame, std::vector<FMemoryDiff>& outDiff)
+void FFrameTraceViewer::GenerateMemoryDiff(int frameIndex, std::vector<FMemoryDiff>& outDiff)
 {
 	outDiff.clear();
 
-	// diff RAM with previous frame
-	// skip ROM & screen memory
+	// diff RAM with previous frame - only pages stored for this frame can have changed
 	// might want to exclude stack (once we determine where it is)
-	const int noBanks = pSpectrumEmu->ZXEmuState.type == ZX_TYPE_48K ? 3 : 8;
-	for (int bankNo = 0; bankNo < noBanks; bankNo++)
+	const int prevFrameIndex = frameIndex == 0 ? kNoFramesInTrace - 1 : frameIndex - 1;
+	const FSpeccyFrameTrace& frame = FrameTrace[frameIndex];
+	if (GetFrameMemory(prevFrameIndex, pScratchMemory) == false)
+		return;
+
+	for (size_t pageNo = 0; pageNo < frame.PageIndices.size(); pageNo++)
 	{
-		for (int addr = 0; addr < 16 * 1024; addr++)
+		const int bankNo = frame.PageIndices[pageNo] / kTracePagesPerBank;
+		const int pageAddr = (frame.PageIndices[pageNo] % kTracePagesPerBank) * kTracePageSize;
+		const uint8_t* pNewPage = &frame.PageData[pageNo * kTracePageSize];
+		const uint8_t* pOldPage = &pScratchMemory[bankNo][pageAddr];
+
+		for (int addr = 0; addr < kTracePageSize; addr++)
 		{
-			if (frame.MemoryBanks[bankNo][addr] != otherFrame.MemoryBanks[bankNo][addr])
+			if (pNewPage[addr] != pOldPage[addr])
 			{
 				FMemoryDiff diff;
-				diff.Address = addr;
-				diff.NewVal = frame.MemoryBanks[bankNo][addr];
-				diff.OldVal = otherFrame.MemoryBanks[bankNo][addr];
+				diff.Bank = bankNo;
+				diff.Address = pageAddr + addr;
+				diff.NewVal = pNewPage[addr];
+				diff.OldVal = pOldPage[addr];
 				outDiff.push_back(diff);
 			}
 		}
@@ -42,15 +42,39 @@ struct FMemoryDiff
 	uint8_t		NewVal;
 };
 
+// Memory is stored as a keyframe every so often & then just the pages written to for the frames in between
+static const int kNoTraceRAMBanks = 8;	// 8 x 16K banks
+static const int kTraceRAMBankSize = 16 * 1024;
+static const int kTracePageShift = 10;	// 1K pages
+static const int kTracePageSize = 1 << kTracePageShift;
+static const int kTracePagesPerBank = kTraceRAMBankSize / kTracePageSize;
+
+// Instruction trace stored as byte sized steps from the previous instruction's address, most steps are small
+// Steps that don't fit or change bank are an escape byte followed by the full address ref
+class FCompactInstructionTrace
+{
+public:
+	void	Encode(const std::vector<FAddressRef>& trace);
+	void	Decode(std::vector<FAddressRef>& outTrace) const;
+	void	Clear() { Data.clear(); NoInstructions = 0; }
+	int		GetNoInstructions() const { return NoInstructions; }
+	size_t	GetMemorySize() const { return Data.capacity(); }
+private:
+	std::vector<uint8_t>	Data;
+	int						NoInstructions = 0;
+};
+
 struct FSpeccyFrameTrace
 {
-	void*					Texture = nullptr;
-	uint8_t					MemoryBanks[8][16 * 1024];	// 8 x 16K banks
+	int						ImageNo = -1;		// capture number of the screen image, -1 if none was captured e.g. turbo mode
+	bool					bValid = false;
+	bool					bKeyFrame = false;	// has all pages rather than just those written to this frame
+	std::vector<uint8_t>	PageIndices;		// bank * kTracePagesPerBank + page, for each page in PageData
+	std::vector<uint8_t>	PageData;			// page contents at end of frame
 	uint8_t					MemoryBankRegister = 0;
 	void*					CPUState = nullptr;
-	std::vector<FAddressRef>	InstructionTrace;
+	FCompactInstructionTrace	InstructionTrace;
 	std::vector<FMemoryAccess>	ScreenPixWrites;
-	std::vector<FEvent>			FrameEvents;
 
 	std::vector<FFrameOverviewItem>	FrameOverview;
 	std::vector<FMemoryDiff>	MemoryDiffs;
@@ -62,13 +86,25 @@ public:
 	void	Init(FSpectrumEmu* pEmu);
 	void	Reset();
 	void	Shutdown();
-	void	CaptureFrame();
+	void	CaptureFrame(bool bCaptureImage = true);
 	void	Draw();
+
+	// Memory changes need to be tracked for the next frame's delta
+	void	MarkRAMWritten(int bankNo, uint16_t bankAddr) { DirtyPageMasks[bankNo] |= (uint16_t)(1 << (bankAddr >> kTracePageShift)); }
+	void	ForceKeyFrame() { bForceKeyFrame = true; }	// for when memory has been changed without tracking
+	size_t	GetTraceMemorySize() const;
+	int		GetLastCapturedFrameIndex() const { return CurrentTraceFrame == 0 ? kNoFramesInTrace - 1 : CurrentTraceFrame - 1; }
+	bool	GetFrameMemory(int frameIndex, uint8_t outBanks[kNoTraceRAMBanks][kTraceRAMBankSize]) const;
+	void	GetFrameInstructionTrace(int frameIndex, std::vector<FAddressRef>& outTrace) const { FrameTrace[frameIndex].InstructionTrace.Decode(outTrace); }
+	int		GetNoRAMBanks() const;
 private:
-	void	RestoreFrame(const FSpeccyFrameTrace& frame);
-	void	DrawInstructionTrace(const FSpeccyFrameTrace& frame);
-	void	GenerateTraceOverview(FSpeccyFrameTrace& frame);
-	void	GenerateMemoryDiff(const FSpeccyFrameTrace& frameA, const FSpeccyFrameTrace& frameB, std::vector<FMemoryDiff>& outDiff);
+	void	StorePages(FSpeccyFrameTrace& frame, bool bKeyFrame);
+	bool	PassOnKeyFrame(FSpeccyFrameTrace& keyFrame, FSpeccyFrameTrace& nextFrame);
+	void*	GetFrameImage(const FSpeccyFrameTrace& frame) const;
+	void	RestoreFrame(int frameIndex);
+	void	DrawInstructionTrace(const FSpeccyFrameTrace& frame);	// uses the decoded trace
+	void	GenerateTraceOverview(FSpeccyFrameTrace& frame);	// uses the decoded trace
+	void	GenerateMemoryDiff(int frameIndex, std::vector<FMemoryDiff>& outDiff);
 	void	DrawTraceOverview(const FSpeccyFrameTrace& frame);
 	void	DrawFrameScreenWritePixels(const FSpeccyFrameTrace& frame, int lastIndex = -1);
 	void	DrawScreenWrites(const FSpeccyFrameTrace& frame);
@@ -79,8 +115,17 @@ private:
 	int					ShowFrame = 0;
 	int					CurrentTraceFrame = 0;
 	bool				RestoreOnScrub = false;
-	static const int	kNoFramesInTrace = 300;
+	static const int	kNoFramesInTrace = 1500;	// 30 seconds
+	static const int	kKeyFrameInterval = 50;
+	static const int	kNoTraceImages = 300;	// screen images are only kept for the most recent frames
 	FSpeccyFrameTrace	FrameTrace[kNoFramesInTrace];
+	void*				TraceImages[kNoTraceImages] = { nullptr };
+	int					NoImagesCaptured = 0;
+	int					FramesSinceKeyFrame = 0;
+	bool				bForceKeyFrame = true;
+	uint16_t			DirtyPageMasks[kNoTraceRAMBanks] = { 0 };	// pages written to since last capture, bit per page
+	uint8_t				(*pScratchMemory)[kTraceRAMBankSize] = nullptr;	// for rebuilding frames
+	std::vector<FAddressRef>	DecodedInstructionTrace;	// instruction trace of the frame being viewed
 
 	int		SelectedTraceLine = -1;
 	int		PixelWriteline = -1;
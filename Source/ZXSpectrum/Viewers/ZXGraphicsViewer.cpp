@@ -39,7 +39,7 @@ void FZXGraphicsViewer::UpdateScreenPixelImage(void)
 		for (int x = 0; x < ScreenWidth / 8; x++)
 		{
 			const uint8_t charLine = pBank->Memory[bankAddr];
-			const FCodeAnalysisPage& page = pBank->Pages[bankAddr >> 10];
+			const FCodeAnalysisPage& page = state.GetBankPage(*pBank, bankAddr >> 10);
 			uint32_t inkCol = 0xffffffff;
 			uint32_t paperCol = 0xff000000;
 			
@@ -70,6 +70,15 @@ uint64_t ReadInputIOTick(uint64_t pins, GetIOInput ioInputCB, void* pUserData)
 	return pins;
 }
 
+static ZXTrapCallback g_TrapCallback = NULL;
+static void* g_TrapUserData = NULL;
+
+void ZXSetTrapCallback(ZXTrapCallback trapCB, void* pUserData)
+{
+	g_TrapCallback = trapCB;
+	g_TrapUserData = pUserData;
+}
+
 uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds) 
 {
 	CHIPS_ASSERT(sys && sys->valid);
@@ -83,6 +92,8 @@ uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds)
 		{
 			pins = _zx_tick(sys, pins);
 			pins = FloatingBusTick(sys, pins);
+			if (g_TrapCallback && z80_opdone(&sys->cpu))
+				pins = g_TrapCallback(pins, g_TrapUserData);
 		}
 	}
 	else 
@@ -92,6 +103,8 @@ uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds)
 		{
 			pins = _zx_tick(sys, pins);
 			pins = FloatingBusTick(sys, pins);
+			if (g_TrapCallback && z80_opdone(&sys->cpu))
+				pins = g_TrapCallback(pins, g_TrapUserData);
 			sys->debug.callback.func(sys->debug.callback.user_data, pins);
 		}
 	}
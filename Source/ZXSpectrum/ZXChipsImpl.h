@@ -16,9 +16,11 @@ extern "C" {
 #endif
 	
 typedef bool(*GetIOInput)(uint16_t port, uint8_t* pInVal, void* pUserData);
+typedef uint64_t(*ZXTrapCallback)(uint64_t pins, void* pUserData);	// called before each instruction, can redirect PC with z80_prefetch
 
 void ZXDecodeScreen(zx_t* pZX);
 uint32_t ZXExeEmu(zx_t* sys, uint32_t micro_seconds);
+void ZXSetTrapCallback(ZXTrapCallback trapCB, void* pUserData);
 uint32_t ZXExeEmu_UseFetchCount(zx_t* sys, uint32_t noFetches, GetIOInput ioInputCB, void* pUserData);
 
 #ifdef __cplusplus